@@ -0,0 +1,202 @@
+#pragma once
+
+#include "pcie_types.h"
+#include "symbol_index.h"
+#include "thread_util.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace pcie {
+
+/**
+ * Latest top of book for one symbol, host byte order
+ */
+struct BBOQuote {
+    SymbolKey symbol;
+    uint32_t bid_price;       // Fixed-point, 4 decimal places
+    uint32_t bid_size;
+    uint32_t ask_price;       // Fixed-point, 4 decimal places
+    uint32_t ask_size;
+    uint32_t rx_timestamp;    // FPGA cycle count when ITCH received
+    uint32_t tx_timestamp;    // FPGA cycle count when packet sent
+    uint64_t host_time_ns;    // steady_clock when the record was read
+    uint64_t updates;         // Records seen for this symbol
+    bool stale;               // Restored from a snapshot, no live update yet
+
+    Price4 get_bid_px() const { return Price4::from_raw(bid_price); }
+    Price4 get_ask_px() const { return Price4::from_raw(ask_price); }
+};
+
+/**
+ * Per-Symbol BBO Cache
+ * Fixed-capacity table holding the latest BBO per symbol, one cache line
+ * per entry so readers of different symbols never share a line.
+ *
+ * One writer (the thread reading C2H) updates entries; any number of
+ * reader threads take consistent snapshots without locks. Each entry is
+ * a seqlock: the writer makes the sequence odd, stores the fields and
+ * makes it even again; a reader retries if the sequence was odd or moved
+ * while it copied.
+ */
+class BBOCache {
+public:
+    explicit BBOCache(size_t capacity = 4096)
+        : index_(capacity), entries_(std::make_unique<Entry[]>(capacity)) {}
+
+    BBOCache(const BBOCache&) = delete;
+    BBOCache& operator=(const BBOCache&) = delete;
+
+    /**
+     * Record a BBO (writer thread only)
+     * @return false if the symbol is new and the table is full
+     */
+    bool update(const BBOData& bbo, uint64_t host_time_ns) {
+        return store(bbo.get_symbol_key(), __builtin_bswap32(bbo.bid_price), bbo.get_bid_size(),
+                     __builtin_bswap32(bbo.ask_price), bbo.get_ask_size(),
+                     bbo.get_rx_timestamp(), bbo.get_tx_timestamp(), host_time_ns);
+    }
+
+    // Decoded record; T1/T4 are stored as the rx/tx timestamps
+    bool update(const BBORecord& rec, uint64_t host_time_ns) {
+        return store(rec.symbol, rec.bid_price, rec.bid_size, rec.ask_price, rec.ask_size,
+                     rec.ts_t1, rec.ts_t4, host_time_ns);
+    }
+
+    /**
+     * Seed a symbol from a restored snapshot (writer thread only)
+     * The entry reads as stale until the next live update replaces it.
+     */
+    bool warm(const BBOQuote& quote) {
+        return store(quote.symbol, quote.bid_price, quote.bid_size, quote.ask_price,
+                     quote.ask_size, quote.rx_timestamp, quote.tx_timestamp,
+                     quote.host_time_ns, true);
+    }
+
+    /**
+     * Consistent snapshot of the latest BBO for a symbol (any thread)
+     * @return false if the symbol has not been seen
+     */
+    bool get(SymbolKey symbol, BBOQuote& quote) const {
+        uint32_t slot = index_.find(symbol);
+        if (slot == SymbolIndex::NOT_FOUND) return false;
+        read_slot(slot, quote);
+        return quote.updates != 0;  // Slot claimed, first write not finished
+    }
+
+    /**
+     * Snapshot by slot id (0..size()-1), for iterating the whole table
+     */
+    void read_slot(uint32_t slot, BBOQuote& quote) const {
+        const Entry& e = entries_[slot];
+        quote.symbol = index_.key_at(slot);
+
+        for (;;) {
+            uint32_t before = e.seq.load(std::memory_order_acquire);
+            if (before & 1) {
+                __builtin_ia32_pause();  // Writer mid-update
+                continue;
+            }
+
+            quote.bid_price = e.bid_price.load(std::memory_order_relaxed);
+            quote.bid_size = e.bid_size.load(std::memory_order_relaxed);
+            quote.ask_price = e.ask_price.load(std::memory_order_relaxed);
+            quote.ask_size = e.ask_size.load(std::memory_order_relaxed);
+            quote.rx_timestamp = e.rx_timestamp.load(std::memory_order_relaxed);
+            quote.tx_timestamp = e.tx_timestamp.load(std::memory_order_relaxed);
+            quote.host_time_ns = e.host_time_ns.load(std::memory_order_relaxed);
+            quote.updates = e.updates.load(std::memory_order_relaxed);
+            quote.stale = e.stale.load(std::memory_order_relaxed) != 0;
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (e.seq.load(std::memory_order_relaxed) == before) return;
+        }
+    }
+
+    /**
+     * Forget every quote (writer thread only, while no update runs)
+     * Symbols keep their slots, since the index is insert-only, so size()
+     * still counts them; get() reports each as unseen until its next
+     * update. Concurrent readers stay safe: each entry is reset through
+     * its seqlock.
+     */
+    void clear() {
+        size_t used = index_.size();
+        for (size_t slot = 0; slot < used; slot++) {
+            Entry& e = entries_[slot];
+            uint32_t seq = e.seq.load(std::memory_order_relaxed);
+            e.seq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            e.bid_price.store(0, std::memory_order_relaxed);
+            e.bid_size.store(0, std::memory_order_relaxed);
+            e.ask_price.store(0, std::memory_order_relaxed);
+            e.ask_size.store(0, std::memory_order_relaxed);
+            e.rx_timestamp.store(0, std::memory_order_relaxed);
+            e.tx_timestamp.store(0, std::memory_order_relaxed);
+            e.stale.store(0, std::memory_order_relaxed);
+            e.host_time_ns.store(0, std::memory_order_relaxed);
+            e.updates.store(0, std::memory_order_relaxed);
+
+            e.seq.store(seq + 2, std::memory_order_release);
+        }
+        dropped_.store(0, std::memory_order_relaxed);
+    }
+
+    size_t size() const { return index_.size(); }
+    size_t capacity() const { return index_.capacity(); }
+
+    // Updates rejected because the table was full
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    bool store(SymbolKey symbol, uint32_t bid_price, uint32_t bid_size,
+               uint32_t ask_price, uint32_t ask_size,
+               uint32_t rx_timestamp, uint32_t tx_timestamp, uint64_t host_time_ns,
+               bool stale = false) {
+        uint32_t slot = index_.find_or_insert(symbol);
+        if (slot == SymbolIndex::NOT_FOUND) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        Entry& e = entries_[slot];
+        uint32_t seq = e.seq.load(std::memory_order_relaxed);
+        e.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        e.bid_price.store(bid_price, std::memory_order_relaxed);
+        e.bid_size.store(bid_size, std::memory_order_relaxed);
+        e.ask_price.store(ask_price, std::memory_order_relaxed);
+        e.ask_size.store(ask_size, std::memory_order_relaxed);
+        e.rx_timestamp.store(rx_timestamp, std::memory_order_relaxed);
+        e.tx_timestamp.store(tx_timestamp, std::memory_order_relaxed);
+        e.stale.store(stale ? 1 : 0, std::memory_order_relaxed);
+        e.host_time_ns.store(host_time_ns, std::memory_order_relaxed);
+        bump(e.updates);
+
+        e.seq.store(seq + 2, std::memory_order_release);
+        return true;
+    }
+
+    struct alignas(64) Entry {
+        std::atomic<uint32_t> seq{0};
+        std::atomic<uint32_t> bid_price{0};
+        std::atomic<uint32_t> bid_size{0};
+        std::atomic<uint32_t> ask_price{0};
+        std::atomic<uint32_t> ask_size{0};
+        std::atomic<uint32_t> rx_timestamp{0};
+        std::atomic<uint32_t> tx_timestamp{0};
+        std::atomic<uint32_t> stale{0};
+        std::atomic<uint64_t> host_time_ns{0};
+        std::atomic<uint64_t> updates{0};
+    };
+    static_assert(sizeof(Entry) == 64, "BBOCache entry must be one cache line");
+
+    SymbolIndex index_;
+    std::unique_ptr<Entry[]> entries_;
+    std::atomic<uint64_t> dropped_{0};
+};
+
+}  // namespace pcie
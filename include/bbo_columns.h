@@ -0,0 +1,132 @@
+#pragma once
+
+#include "pcie_types.h"
+#include "symbol_index.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pcie {
+
+/**
+ * Columnar BBO Batch
+ * The same fields as BBORecord, one contiguous array per field, for
+ * consumers that scan a few fields across many records (spreads, sizes,
+ * latencies). A scan touches only the columns it reads, and the loops
+ * over them vectorise. All columns always have the same length.
+ *
+ * Filled by XDMAWrapper::read_columns() or append(); reused across
+ * batches with clear(), which keeps the capacity.
+ */
+struct BBOColumns {
+    std::vector<uint64_t> symbol;      // SymbolKey::raw()
+    std::vector<uint32_t> bid_price;   // Fixed-point, 4 decimal places
+    std::vector<uint32_t> bid_size;
+    std::vector<uint32_t> ask_price;   // Fixed-point, 4 decimal places
+    std::vector<uint32_t> ask_size;
+    std::vector<uint32_t> spread;
+    std::vector<uint32_t> ts_t1;       // ITCH parse / rx_timestamp
+    std::vector<uint32_t> ts_t2;
+    std::vector<uint32_t> ts_t3;
+    std::vector<uint32_t> ts_t4;       // TX start / tx_timestamp
+    std::vector<uint32_t> flags;
+
+    size_t size() const { return symbol.size(); }
+    bool empty() const { return symbol.empty(); }
+
+    void clear();
+    void reserve(size_t count);
+
+    // Transpose decoded records onto the end of the columns
+    void append(const BBORecord* records, size_t count);
+
+    // Reassemble one row
+    BBORecord record(size_t i) const;
+
+    SymbolKey symbol_at(size_t i) const { return SymbolKey::from_raw(symbol[i]); }
+};
+
+/**
+ * Spread summary over a batch
+ */
+struct SpreadSummary {
+    size_t count = 0;
+    Price4 min;
+    Price4 max;
+    double mean = 0.0;   // Dollars
+};
+
+SpreadSummary summarize_spreads(const BBOColumns& cols);
+
+/**
+ * T1 -> T4 latency of every row in FPGA cycles
+ * @param out At least cols.size() entries
+ */
+void latency_cycles(const BBOColumns& cols, uint32_t* out);
+
+/**
+ * Latency distribution over a batch, FPGA cycles (4 ns each)
+ * Nearest-rank percentiles, same convention as the benchmarks.
+ */
+struct LatencySummary {
+    size_t count = 0;
+    uint32_t min = 0;
+    uint32_t p50 = 0;
+    uint32_t p90 = 0;
+    uint32_t p99 = 0;
+    uint32_t p999 = 0;
+    uint32_t max = 0;
+    double mean = 0.0;
+};
+
+LatencySummary summarize_latency(const BBOColumns& cols);
+
+/**
+ * As above, computing the cycles in a caller-owned buffer that keeps its
+ * capacity across batches. The T1 -> T4 difference and min/max/sum pass
+ * vectorise; the percentile selection is a scalar nth_element.
+ */
+LatencySummary summarize_latency(const BBOColumns& cols, std::vector<uint32_t>& scratch);
+
+/**
+ * Per-symbol aggregates over a batch
+ */
+struct SymbolGroup {
+    SymbolKey symbol;
+    uint32_t count = 0;
+    uint32_t last = 0;         // Row of the newest update
+    uint32_t min_spread = UINT32_MAX;
+    uint32_t max_spread = 0;
+    uint64_t spread_sum = 0;
+    uint64_t bid_volume = 0;   // Sum of bid_size
+    uint64_t ask_volume = 0;   // Sum of ask_size
+
+    double mean_spread() const {
+        return count ? static_cast<double>(spread_sum) / count / Price4::SCALE : 0.0;
+    }
+};
+
+/**
+ * Group rows by symbol, groups in order of first appearance
+ * @param groups Cleared, then one entry per symbol
+ * @param group_of_row Optional; receives each row's index into groups
+ * @param max_symbols Rows beyond this many distinct symbols get UINT32_MAX
+ * @return Number of groups
+ */
+size_t group_by_symbol(const BBOColumns& cols, std::vector<SymbolGroup>& groups,
+                       std::vector<uint32_t>* group_of_row = nullptr,
+                       size_t max_symbols = 4096);
+
+/**
+ * As above with a caller-owned index, cleared on entry, so repeated
+ * batches allocate nothing; its capacity plays the part of max_symbols.
+ * A row of the same symbol as the row before it reuses that group
+ * without a probe. The hash probe and the per-group accumulation stay
+ * scalar: rows scatter into groups, and doing that in SIMD lanes would
+ * need conflict detection (AVX-512CD) this code does not assume.
+ */
+size_t group_by_symbol(const BBOColumns& cols, std::vector<SymbolGroup>& groups,
+                       std::vector<uint32_t>* group_of_row, SymbolIndex& index);
+
+}  // namespace pcie
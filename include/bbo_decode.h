@@ -0,0 +1,61 @@
+#pragma once
+
+#include "pcie_types.h"
+
+#include <cstddef>
+
+namespace pcie {
+
+/**
+ * Batch Decode Kernels
+ * SCALAR runs everywhere; SSSE3 and AVX2 byte-shuffle whole records.
+ * All kernels produce bit-identical output.
+ */
+enum class DecodeKernel {
+    SCALAR,
+    SSSE3,
+    AVX2
+};
+
+const char* decode_kernel_name(DecodeKernel kernel);
+
+/**
+ * Best kernel the running CPU supports (detected once)
+ */
+DecodeKernel best_decode_kernel();
+
+/**
+ * Check whether the running CPU can execute a kernel
+ */
+bool decode_kernel_supported(DecodeKernel kernel);
+
+/**
+ * Decode raw C2H bytes into native records in one pass
+ * Byte-swaps BBO36 fields, normalises symbol padding, maps timestamps to
+ * T1-T4 and checks BBO48 padding (FLAG_BAD_PADDING).
+ * @param wire Packed wire records (no alignment requirement)
+ * @param count Number of records
+ * @param out Output records
+ * @param format Wire format of the input
+ * @return Number of BBO48 records with a padding mismatch (0 for BBO36)
+ */
+size_t decode_bbo_batch(const void* wire, size_t count, BBORecord* out, WireFormat format);
+
+/**
+ * Same, with an explicit kernel (tests and benchmarks)
+ * Unsupported kernels fall back to SCALAR.
+ */
+size_t decode_bbo_batch(const void* wire, size_t count, BBORecord* out, WireFormat format,
+                        DecodeKernel kernel);
+
+/**
+ * Encode native records into a wire format (inverse of decode_bbo_batch)
+ * Scalar; for generators and tests. BBO36 carries T1/T4 as rx/tx
+ * timestamps, BBO48 gets BBOPacket::PADDING.
+ * @param in Records to encode
+ * @param count Number of records
+ * @param wire Output, count * wire_record_size(format) bytes (no alignment requirement)
+ */
+void encode_bbo_batch(const BBORecord* in, size_t count, void* wire, WireFormat format);
+
+}  // namespace pcie
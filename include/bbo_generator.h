@@ -0,0 +1,96 @@
+#pragma once
+
+#include "pcie_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pcie {
+
+/**
+ * Synthetic BBO Generator
+ * The host-side stand-in for the card's record stream (GeneratorConfig):
+ *
+ *   MARKET        A universe of config.symbols names (GEN00000, ...), at
+ *                 most MAX_SYMBOLS so every name is distinct. Each
+ *                 update picks a symbol by Zipf popularity (alias table, so
+ *                 O(1) per record at any universe size) and moves its bid
+ *                 one tick down, nowhere or up, with a spread of 1-3 ticks.
+ *                 T1 advances by a random gap around the configured rate;
+ *                 T2/T3/T4 follow the pipeline stages of bbo_cdc_fifo and
+ *                 bbo_axi_stream, with the read and TX sides serialised so
+ *                 a burst faster than the link queues as it would on the
+ *                 card. T4 never goes backwards.
+ *   TEST_PATTERN  Byte-exact with order_book_pcie_top TEST_MODE 2 once
+ *                 encoded as BBO48.
+ *
+ * Deterministic for a given config. Not thread-safe: one per stream.
+ */
+class BBOGenerator {
+public:
+    // Pipeline stage latencies in 250 MHz cycles (base + up to JITTER - 1)
+    static constexpr uint32_t PARSE_CYCLES = 12;      // T1 -> T2: ITCH parse to CDC FIFO write
+    static constexpr uint32_t CDC_CYCLES = 6;         // T2 -> T3: 2-FF pointer sync and read
+    static constexpr uint32_t TX_CYCLES = 3;          // T3 -> T4: latch into the AXI-S framer
+    static constexpr uint32_t JITTER_CYCLES = 4;
+    static constexpr uint32_t PACKET_BEATS = 6;       // One BBO48 packet on the 64-bit stream
+    static constexpr uint32_t FPGA_HZ = 250000000;
+    static constexpr uint32_t DEFAULT_GAP_CYCLES = 16;   // Mean T1 gap with rate 0
+    static constexpr uint32_t MAX_SYMBOLS = 100000;      // GEN00000..GEN99999
+
+    static constexpr uint32_t TEST_BID = 15000;
+    static constexpr uint32_t TEST_ASK = 15100;
+    static constexpr uint32_t TEST_BID_SIZE = 100;
+    static constexpr uint32_t TEST_ASK_SIZE = 200;
+
+    // A universe beyond MAX_SYMBOLS is clamped to it; transports reject one
+    explicit BBOGenerator(const GeneratorConfig& config);
+
+    /**
+     * Next records of the stream (ignores config.records)
+     */
+    void next(BBORecord* out, size_t count);
+
+    /**
+     * Next records, encoded straight into the wire format
+     * @param wire count * wire_record_size(format) bytes
+     */
+    void next_wire(void* wire, size_t count, WireFormat format);
+
+    uint64_t produced() const { return produced_; }
+    const std::vector<SymbolKey>& symbols() const { return symbols_; }
+
+    /**
+     * Share of updates each symbol gets (sums to 1)
+     */
+    std::vector<double> popularity() const;
+
+private:
+    uint64_t random() {
+        // xorshift64*
+        rng_ ^= rng_ >> 12;
+        rng_ ^= rng_ << 25;
+        rng_ ^= rng_ >> 27;
+        return rng_ * 0x2545F4914F6CDD1DULL;
+    }
+
+    uint32_t pick_symbol();
+    void next_market(BBORecord& r);
+    void next_test(BBORecord& r);
+
+    GeneratorConfig config_;
+    uint64_t rng_;
+    uint64_t produced_ = 0;
+    std::vector<SymbolKey> symbols_;
+    std::vector<uint32_t> bids_;         // Walk state, one per symbol
+    std::vector<uint32_t> accept_;       // Alias table: keep i with accept_[i] / 2^32
+    std::vector<uint32_t> alias_;        // ... else take alias_[i]
+    uint32_t gap_span_;                  // T1 gap drawn from [1, gap_span_]
+    uint32_t next_rr_ = 0;               // Round-robin position (zipf_s 0)
+    uint32_t t1_ = 0;
+    uint32_t t3_ = 0;
+    uint32_t t4_ = 0;
+};
+
+}  // namespace pcie
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "pcie_types.h"
+#include "bbo_cache.h"
+#include "thread_util.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pcie {
+
+/**
+ * Memory-Mapped Book Snapshot
+ * Checkpoints the per-symbol BBO cache to a file so a restarted process
+ * can warm-start with a usable book instead of waiting for quiet symbols
+ * to tick.
+ *
+ * The file holds two snapshot halves and a generation counter. A
+ * checkpoint fills the half the current generation does not point at,
+ * then bumps the generation (release) to publish it, so a crash or a
+ * concurrent reader never sees a half-written book: it either gets the
+ * new generation or the previous intact one. Timestamps are stored as
+ * wall-clock time so ages survive the restart.
+ *
+ * One thread checkpoints at a time; load() may run in any process.
+ */
+class BookSnapshot {
+public:
+    static constexpr uint64_t MAGIC = 0x3150414E534F4242ULL;   // "BBOSNAP1"
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    BookSnapshot() = default;
+    ~BookSnapshot();
+
+    BookSnapshot(const BookSnapshot&) = delete;
+    BookSnapshot& operator=(const BookSnapshot&) = delete;
+
+    /**
+     * Map a snapshot file, creating it if missing or unusable
+     * A valid existing file keeps its contents. One made with a smaller
+     * capacity is rebuilt at this capacity, keeping its latest generation;
+     * a larger one keeps its own.
+     * @param capacity Symbols per snapshot the file must hold
+     */
+    PCIeError open(const std::string& path, size_t capacity);
+    void close();
+    bool is_open() const { return map_ != nullptr; }
+
+    /**
+     * Write every cached symbol and publish it as the next generation
+     * Symbols beyond capacity() are left out, warned about on the first
+     * occurrence and counted in skipped().
+     * @return The new generation, 0 if not open
+     */
+    uint64_t checkpoint(const BBOCache& cache);
+
+    /**
+     * Seed a cache from the latest published generation; entries are
+     * marked stale until live data refreshes them
+     * @param generation Optional; receives the generation loaded
+     * @return Number of symbols restored
+     */
+    size_t load(BBOCache& cache, uint64_t* generation = nullptr) const;
+
+    // Latest published generation (0 = never checkpointed)
+    uint64_t generation() const;
+
+    size_t capacity() const { return capacity_; }
+
+    // Symbols left out of checkpoints for lack of capacity, summed over all
+    uint64_t skipped() const { return skipped_.load(std::memory_order_relaxed); }
+
+private:
+    struct FileHeader;
+    struct HalfHeader;
+    struct Entry;
+
+    FileHeader* header() const;
+    HalfHeader* half(uint64_t generation) const;
+    Entry* entries(uint64_t generation) const;
+    static size_t file_size(size_t capacity);
+    PCIeError map_file(const std::string& path, size_t capacity);
+    // Copy of the latest published half; returns its generation, 0 if none
+    uint64_t read_published(std::vector<Entry>& copy, int64_t* wall_time_ns = nullptr) const;
+
+    void* map_ = nullptr;
+    size_t map_size_ = 0;
+    size_t capacity_ = 0;
+    int fd_ = -1;
+    std::mutex write_mutex_;
+    std::atomic<uint64_t> skipped_{0};   // Written under write_mutex_
+};
+
+}  // namespace pcie
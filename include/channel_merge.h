@@ -0,0 +1,172 @@
+#pragma once
+
+#include "pcie_types.h"
+#include "thread_util.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace pcie {
+
+/**
+ * Multi-Channel Delivery Order
+ */
+enum class MergeOrder {
+    TIMESTAMP,     // One stream ordered by extended T4 across channels
+    PER_CHANNEL    // Each channel's own order only; no holding back
+};
+
+struct MultiChannelConfig {
+    MergeOrder order = MergeOrder::TIMESTAMP;
+    size_t ring_capacity = 4096;      // Records buffered per channel
+    size_t batch_records = 64;        // Records per C2H read
+    uint32_t merge_window_us = 200;   // Longest a record waits for an idle channel
+};
+
+/**
+ * Record in flight from a channel reader to the dispatcher (one cache line)
+ */
+struct ChannelRecord {
+    BBORecord record;
+    uint64_t host_time_ns;    // steady_clock when the reader decoded it
+};
+
+/**
+ * Multi-Channel Statistics
+ */
+struct ChannelStats {
+    uint64_t records = 0;     // Records decoded by the reader
+    uint64_t reads = 0;       // C2H read() calls that returned data
+    uint64_t ring_full = 0;   // Times the reader waited for the dispatcher
+    uint64_t read_failures = 0;  // Failed C2H reads, also in TransferStats::transfers_failed
+    bool finished = false;    // Reader stopped (EOF or error)
+};
+
+struct MultiChannelStats {
+    std::vector<ChannelStats> channels;
+    uint64_t delivered = 0;       // Records handed to dispatch
+    uint64_t window_flushes = 0;  // Delivered while a channel was still empty
+    uint64_t late = 0;            // Delivered behind a later T4 already out
+};
+
+/**
+ * K-Way Timestamp Merge
+ * Orders records from several C2H channels by FPGA T4. T4 is a 32-bit
+ * cycle counter (17 s at 250 MHz), so each record's T4 is first extended
+ * to 64 bits against the newest T4 delivered: the nearest value to that
+ * watermark with the same low 32 bits. All channels share the FPGA clock,
+ * so this stays right across wraps as long as channels are within half a
+ * wrap of each other.
+ *
+ * Each channel contributes its oldest record (head). The smallest head is
+ * delivered once every open channel has a head, so nothing earlier can
+ * still arrive, or once it has waited merge_window without one, so an
+ * idle channel does not stall the rest. A record that then turns up with
+ * an older T4 is delivered anyway and counted as late.
+ *
+ * Single thread: the dispatcher owns the merge.
+ */
+class ChannelMerge {
+public:
+    ChannelMerge(size_t channels, uint64_t window_ns)
+        : heads_(channels), window_ns_(window_ns) {}
+
+    ChannelMerge(const ChannelMerge&) = delete;
+    ChannelMerge& operator=(const ChannelMerge&) = delete;
+
+    /**
+     * Channel will produce nothing more; stop waiting for it
+     */
+    void close(size_t channel) { heads_[channel].closed = true; }
+
+    /**
+     * Deliver everything the ordering rules allow
+     * @param pop bool(size_t channel, ChannelRecord&): next record of a channel
+     * @param sink void(size_t channel, const ChannelRecord&)
+     * @return Records delivered
+     */
+    template <typename Pop, typename Sink>
+    size_t poll(uint64_t now_ns, Pop&& pop, Sink&& sink) {
+        size_t delivered = 0;
+        for (;;) {
+            size_t best = heads_.size();
+            bool waiting = false;    // Some open channel has no head
+
+            for (size_t ch = 0; ch < heads_.size(); ch++) {
+                Head& h = heads_[ch];
+                if (!h.valid) {
+                    if (pop(ch, h.item)) {
+                        h.valid = true;
+                        h.ext_t4 = extend(h.item.record.ts_t4);
+                    } else {
+                        if (!h.closed) waiting = true;
+                        continue;
+                    }
+                }
+                if (best == heads_.size() || h.ext_t4 < heads_[best].ext_t4) best = ch;
+            }
+
+            if (best == heads_.size()) break;
+            Head& h = heads_[best];
+            if (waiting) {
+                // Readers stamp records after now_ns may have been taken
+                if (h.item.host_time_ns + window_ns_ > now_ns) break;
+                bump(window_flushes_);
+            }
+
+            if (started_ && h.ext_t4 < watermark_) {
+                bump(late_);
+            } else {
+                watermark_ = h.ext_t4;
+                started_ = true;
+            }
+            h.valid = false;
+            sink(best, h.item);
+            bump(delivered_);
+            delivered++;
+        }
+        return delivered;
+    }
+
+    // No record held back
+    bool empty() const {
+        for (const Head& h : heads_) {
+            if (h.valid) return false;
+        }
+        return true;
+    }
+
+    // Any thread
+    uint64_t delivered() const { return delivered_.load(std::memory_order_relaxed); }
+    uint64_t window_flushes() const { return window_flushes_.load(std::memory_order_relaxed); }
+    uint64_t late() const { return late_.load(std::memory_order_relaxed); }
+
+    /**
+     * 64-bit T4 nearest the watermark (the first record starts one wrap up
+     * so a slightly older second record does not underflow)
+     */
+    uint64_t extend(uint32_t t4) const {
+        if (!started_) return (1ULL << 32) | t4;
+        int32_t delta = static_cast<int32_t>(t4 - static_cast<uint32_t>(watermark_));
+        return watermark_ + static_cast<int64_t>(delta);
+    }
+
+private:
+    struct Head {
+        ChannelRecord item;
+        uint64_t ext_t4 = 0;
+        bool valid = false;
+        bool closed = false;
+    };
+
+    std::vector<Head> heads_;
+    uint64_t window_ns_;
+    uint64_t watermark_ = 0;
+    bool started_ = false;
+    std::atomic<uint64_t> delivered_{0};
+    std::atomic<uint64_t> window_flushes_{0};
+    std::atomic<uint64_t> late_{0};
+};
+
+}  // namespace pcie
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "pcie_types.h"
+#include "symbol_index.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace pcie {
+
+/**
+ * Conflation Statistics
+ */
+struct ConflationStats {
+    uint64_t published = 0;   // Updates offered by the producer
+    uint64_t delivered = 0;   // Updates handed to the consumer
+    uint64_t conflated = 0;   // Updates overwritten before delivery
+    uint64_t rejected = 0;    // Updates for new symbols with the table full
+    size_t pending = 0;       // Dirty symbols awaiting drain
+};
+
+/**
+ * Per-Symbol Conflation Buffer
+ * Coalesces updates per symbol for consumers that fall behind. The
+ * producer overwrites the symbol's slot; the first update after a drain
+ * also appends the slot to a dirty list. The consumer drains the dirty
+ * list and gets the newest BBO of each symbol, in the order the symbols
+ * were first dirtied.
+ *
+ * Memory is one slot plus one dirty-list entry per symbol, so a burst of
+ * any length never grows it. One producer thread, one or more consumers.
+ */
+class ConflationBuffer {
+public:
+    explicit ConflationBuffer(size_t max_symbols = 4096)
+        : index_(max_symbols),
+          slots_(std::make_unique<BBOData[]>(max_symbols)),
+          dirty_(std::make_unique<bool[]>(max_symbols)),
+          order_(std::make_unique<uint32_t[]>(max_symbols)),
+          capacity_(max_symbols) {}
+
+    ConflationBuffer(const ConflationBuffer&) = delete;
+    ConflationBuffer& operator=(const ConflationBuffer&) = delete;
+
+    /**
+     * Offer an update (producer thread only)
+     * @return false if the symbol is new and the table is full
+     */
+    bool publish(const BBOData& bbo) {
+        // Producer is the index's only writer, so the lookup needs no lock
+        uint32_t slot = index_.find_or_insert(bbo.get_symbol_key());
+
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.published++;
+            if (slot == SymbolIndex::NOT_FOUND) {
+                stats_.rejected++;
+                return false;
+            }
+
+            slots_[slot] = bbo;
+            if (dirty_[slot]) {
+                stats_.conflated++;
+            } else {
+                // Each slot is on the list at most once, so it cannot overflow
+                dirty_[slot] = true;
+                order_[(head_ + count_) % capacity_] = slot;
+                wake = (count_++ == 0);
+            }
+        }
+
+        if (wake) ready_.notify_one();
+        return true;
+    }
+
+    /**
+     * Take the newest BBO of up to max_count dirty symbols
+     * @param out Cleared, then filled oldest-dirtied first
+     * @param timeout_ms Wait this long for an update if none is pending
+     * @return Number of BBOs delivered
+     */
+    size_t drain(std::vector<BBOData>& out, size_t max_count, uint32_t timeout_ms = 0) {
+        out.clear();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (count_ == 0 && timeout_ms > 0) {
+            ready_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                            [this] { return count_ != 0; });
+        }
+
+        size_t n = std::min(count_, max_count);
+        out.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            uint32_t slot = order_[head_];
+            head_ = (head_ + 1) % capacity_;
+            dirty_[slot] = false;
+            out.push_back(slots_[slot]);
+        }
+        count_ -= n;
+        stats_.delivered += n;
+        return n;
+    }
+
+    ConflationStats get_stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ConflationStats stats = stats_;
+        stats.pending = count_;
+        return stats;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    SymbolIndex index_;
+    std::unique_ptr<BBOData[]> slots_;   // Newest update per symbol
+    std::unique_ptr<bool[]> dirty_;      // Slot is on the dirty list
+    std::unique_ptr<uint32_t[]> order_;  // Dirty list (ring of slot ids)
+    size_t capacity_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    ConflationStats stats_;
+};
+
+}  // namespace pcie
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "pcie_types.h"
+#include "symbol_index.h"
+#include "thread_util.h"
+
+#include <emmintrin.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace pcie {
+
+/**
+ * Fields that count as a change (DedupMode::FIELDS)
+ */
+enum DedupField : uint32_t {
+    DEDUP_BID_PRICE = 0x01,
+    DEDUP_BID_SIZE  = 0x02,
+    DEDUP_ASK_PRICE = 0x04,
+    DEDUP_ASK_SIZE  = 0x08,
+    DEDUP_SPREAD    = 0x10,
+
+    DEDUP_PRICES    = DEDUP_BID_PRICE | DEDUP_ASK_PRICE,
+    DEDUP_TOP       = DEDUP_PRICES | DEDUP_BID_SIZE | DEDUP_ASK_SIZE | DEDUP_SPREAD
+};
+
+enum class DedupMode {
+    PAYLOAD,    // First 32 bytes identical (quote fields and T1/rx): exact repeats only
+    FIELDS      // Selected quote fields unchanged; timestamps ignored
+};
+
+struct DedupConfig {
+    DedupMode mode = DedupMode::FIELDS;
+    uint32_t fields = DEDUP_TOP;
+    size_t max_symbols = 4096;
+};
+
+/**
+ * Dedup Statistics
+ */
+struct DedupStats {
+    uint64_t seen = 0;         // Records offered
+    uint64_t passed = 0;       // Records that changed something
+    uint64_t suppressed = 0;   // Records dropped as unchanged
+    uint64_t untracked = 0;    // Passed because the symbol table was full
+};
+
+/**
+ * Duplicate / No-Change BBO Filter
+ * Compares each record with the previous record of its symbol and drops
+ * it when nothing selected has changed, so downstream work follows real
+ * top-of-book changes instead of the raw message rate.
+ *
+ * Records are compared in BBORecord form: the first 32 bytes (symbol,
+ * the five quote fields, T1/rx) against the stored copy with one byte
+ * mask, two SSE2 compares and a movemask per record. BBOData shares those
+ * offsets and is byte-swapped to host order in registers first, so one
+ * instance can follow a stream that switches between BBOData and
+ * BBORecord paths without a spurious change.
+ *
+ * One writer thread calls accept(); stats may be read from any thread.
+ */
+class DedupFilter {
+public:
+    explicit DedupFilter(const DedupConfig& config = DedupConfig())
+        : config_(config),
+          mask_(byte_mask(config)),
+          index_(config.max_symbols),
+          prev_(std::make_unique<Prev[]>(config.max_symbols)) {}
+
+    DedupFilter(const DedupFilter&) = delete;
+    DedupFilter& operator=(const DedupFilter&) = delete;
+
+    /**
+     * @return true to dispatch the record, false if it is a no-change repeat
+     */
+    bool accept(const BBOData& bbo) {
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(&bbo);
+        SymbolKey symbol = bbo.get_symbol_key();
+        __m128i lo = bswap32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+        __m128i hi = bswap32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16)));
+        // Normalised key in bytes 0-7, as BBORecord holds it
+        lo = _mm_castpd_si128(_mm_move_sd(_mm_castsi128_pd(lo),
+                                          _mm_castsi128_pd(_mm_cvtsi64_si128(
+                                              static_cast<int64_t>(symbol.raw())))));
+        return accept_image(symbol, lo, hi);
+    }
+
+    bool accept(const BBORecord& rec) {
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(&rec);
+        return accept_image(rec.symbol, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)),
+                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16)));
+    }
+
+    /**
+     * Records suppressed for one symbol
+     */
+    uint64_t suppressed(SymbolKey symbol) const {
+        uint32_t slot = index_.find(symbol);
+        return slot == SymbolIndex::NOT_FOUND ? 0
+             : prev_[slot].suppressed.load(std::memory_order_relaxed);
+    }
+
+    DedupStats get_stats() const {
+        DedupStats s;
+        s.seen = seen_.load(std::memory_order_relaxed);
+        s.suppressed = suppressed_.load(std::memory_order_relaxed);
+        s.untracked = untracked_.load(std::memory_order_relaxed);
+        s.passed = s.seen - s.suppressed;
+        return s;
+    }
+
+    const DedupConfig& config() const { return config_; }
+
+private:
+    struct alignas(64) Prev {
+        uint8_t bytes[32];
+        bool valid = false;
+        std::atomic<uint64_t> suppressed{0};
+    };
+
+    // Bit i set = byte i of the record takes part in the compare
+    static uint32_t byte_mask(const DedupConfig& config) {
+        if (config.mode == DedupMode::PAYLOAD) return 0xFFFFFFFFu;
+
+        // Symbol bytes always match (same slot); quote fields at 8..27
+        uint32_t mask = 0;
+        for (uint32_t f = 0; f < 5; f++) {
+            if (config.fields & (1u << f)) mask |= 0xFu << (8 + 4 * f);
+        }
+        return mask;
+    }
+
+    // Byte swap each 32-bit lane (SSE2 has no pshufb)
+    static __m128i bswap32(__m128i v) {
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+    }
+
+    // lo/hi: bytes 0-31 of the record in BBORecord layout
+    bool accept_image(SymbolKey symbol, __m128i lo, __m128i hi) {
+        bump(seen_);
+
+        uint32_t slot = index_.find_or_insert(symbol);
+        if (slot == SymbolIndex::NOT_FOUND) {
+            bump(untracked_);
+            return true;
+        }
+
+        Prev& p = prev_[slot];
+        if (p.valid) {
+            __m128i plo = _mm_load_si128(reinterpret_cast<const __m128i*>(p.bytes));
+            __m128i phi = _mm_load_si128(reinterpret_cast<const __m128i*>(p.bytes + 16));
+            uint32_t same = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(lo, plo))) |
+                            static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(hi, phi))) << 16;
+            if ((same & mask_) == mask_) {
+                bump(p.suppressed);
+                bump(suppressed_);
+                return false;
+            }
+        }
+
+        _mm_store_si128(reinterpret_cast<__m128i*>(p.bytes), lo);
+        _mm_store_si128(reinterpret_cast<__m128i*>(p.bytes + 16), hi);
+        p.valid = true;
+        return true;
+    }
+
+    DedupConfig config_;
+    uint32_t mask_;
+    SymbolIndex index_;
+    std::unique_ptr<Prev[]> prev_;
+    std::atomic<uint64_t> seen_{0};
+    std::atomic<uint64_t> suppressed_{0};
+    std::atomic<uint64_t> untracked_{0};
+};
+
+}  // namespace pcie
@@ -0,0 +1,361 @@
+#pragma once
+
+#include "pcie_types.h"
+#include "symbol_index.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace pcie {
+
+/**
+ * Consolidated top of book for one symbol, host byte order
+ * A side with no quote on any device has price 0 and device NO_DEVICE.
+ */
+struct NBBOQuote {
+    static constexpr uint32_t NO_DEVICE = UINT32_MAX;
+
+    SymbolKey symbol;
+    uint32_t bid_price;       // Fixed-point, 4 decimal places
+    uint32_t bid_size;        // Size on the device holding the best bid
+    uint32_t bid_device;      // Device holding the best bid
+    uint32_t ask_price;       // Fixed-point, 4 decimal places
+    uint32_t ask_size;
+    uint32_t ask_device;
+    uint64_t version;         // Consolidated changes for this symbol
+
+    Price4 get_bid_px() const { return Price4::from_raw(bid_price); }
+    Price4 get_ask_px() const { return Price4::from_raw(ask_price); }
+
+    bool has_bid() const { return bid_device != NO_DEVICE; }
+    bool has_ask() const { return ask_device != NO_DEVICE; }
+
+    // Best bid at or through the best ask across devices
+    bool locked() const { return has_bid() && has_ask() && bid_price == ask_price; }
+    bool crossed() const { return has_bid() && has_ask() && bid_price > ask_price; }
+};
+
+/**
+ * Cross-Device Consolidated BBO (NBBO) Engine
+ * Merges the BBO streams of several cards (one per venue feed) into the
+ * best bid and offer per symbol, recording which device holds each side.
+ *
+ * Each device's latest quote per symbol is kept, and an update touches
+ * only its own symbol: it either improves on the consolidated side,
+ * refreshes the holder's size, or (when the holder backs off) rescans
+ * that symbol's quotes across devices - bounded by the device count, not
+ * the stream. Price ties keep the device that reached the price first.
+ *
+ * Any thread may feed any device (typically each device's stream
+ * thread); writers to the same symbol serialise on its entry. Readers
+ * take lock-free snapshots through a per-symbol seqlock, and changes()
+ * advances on every consolidated change so pollers can skip idle
+ * intervals.
+ */
+class NBBOEngine {
+public:
+    static constexpr uint32_t MAX_DEVICES = 16;
+
+    explicit NBBOEngine(uint32_t num_devices, size_t max_symbols = 4096)
+        : num_devices_(num_devices < 1 ? 1 : (num_devices > MAX_DEVICES ? MAX_DEVICES : num_devices)),
+          index_(max_symbols),
+          entries_(std::make_unique<Entry[]>(max_symbols)),
+          venues_(std::make_unique<Venue[]>(max_symbols * num_devices_)) {}
+
+    NBBOEngine(const NBBOEngine&) = delete;
+    NBBOEngine& operator=(const NBBOEngine&) = delete;
+
+    /**
+     * Apply one device's BBO
+     * @return true if the consolidated quote for the symbol changed
+     */
+    bool update(uint32_t device, const BBOData& bbo) {
+        return apply(device, bbo.get_symbol_key(),
+                     __builtin_bswap32(bbo.bid_price), bbo.get_bid_size(),
+                     __builtin_bswap32(bbo.ask_price), bbo.get_ask_size());
+    }
+
+    bool update(uint32_t device, const BBORecord& rec) {
+        return apply(device, rec.symbol, rec.bid_price, rec.bid_size,
+                     rec.ask_price, rec.ask_size);
+    }
+
+    /**
+     * Withdraw every quote of a device (feed lost or closed)
+     * Symbols it held are rescanned over the remaining devices.
+     */
+    void clear_device(uint32_t device) {
+        if (device >= num_devices_) return;
+        size_t n = index_.size();
+        for (uint32_t slot = 0; slot < n; slot++) {
+            Entry& e = entries_[slot];
+            lock(e);
+            Venue& v = venue(slot, device);
+            v = Venue{};
+            bool changed = false;
+            if (e.bid_device == device) changed |= rescan_bid(slot, e);
+            if (e.ask_device == device) changed |= rescan_ask(slot, e);
+            unlock(e, changed);
+        }
+    }
+
+    /**
+     * Consistent snapshot of a symbol's consolidated quote (any thread)
+     * @return false if no device has quoted the symbol
+     */
+    bool get(SymbolKey symbol, NBBOQuote& quote) const {
+        uint32_t slot = index_.find(symbol);
+        if (slot == SymbolIndex::NOT_FOUND) return false;
+        read_slot(slot, quote);
+        return quote.version != 0;
+    }
+
+    /**
+     * Snapshot by slot id (0..size()-1), for iterating the whole table
+     */
+    void read_slot(uint32_t slot, NBBOQuote& quote) const {
+        const Entry& e = entries_[slot];
+        quote.symbol = index_.key_at(slot);
+
+        for (;;) {
+            uint32_t before = e.seq.load(std::memory_order_acquire);
+            if (before & 1) {
+                __builtin_ia32_pause();  // Writer mid-update
+                continue;
+            }
+
+            quote.bid_price = e.pub_bid_price.load(std::memory_order_relaxed);
+            quote.bid_size = e.pub_bid_size.load(std::memory_order_relaxed);
+            quote.bid_device = e.pub_bid_device.load(std::memory_order_relaxed);
+            quote.ask_price = e.pub_ask_price.load(std::memory_order_relaxed);
+            quote.ask_size = e.pub_ask_size.load(std::memory_order_relaxed);
+            quote.ask_device = e.pub_ask_device.load(std::memory_order_relaxed);
+            quote.version = e.version.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (e.seq.load(std::memory_order_relaxed) == before) return;
+        }
+    }
+
+    // Total consolidated changes across all symbols
+    uint64_t changes() const { return changes_.load(std::memory_order_acquire); }
+
+    // Updates rejected because the symbol table was full or the device invalid
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    size_t size() const { return index_.size(); }
+    size_t capacity() const { return index_.capacity(); }
+    uint32_t num_devices() const { return num_devices_; }
+
+private:
+    // One device's latest quote for one symbol (guarded by the entry lock)
+    struct Venue {
+        uint32_t bid_price = 0;     // 0 = no bid
+        uint32_t bid_size = 0;
+        uint32_t ask_price = 0;     // 0 = no ask
+        uint32_t ask_size = 0;
+        uint64_t bid_since = 0;     // Arrival order of the current bid price
+        uint64_t ask_since = 0;
+    };
+
+    struct alignas(64) Entry {
+        // Odd while a writer holds the entry; writers CAS even -> odd
+        std::atomic<uint32_t> seq{0};
+
+        // Writer-side state (guarded by seq)
+        uint32_t bid_device = NBBOQuote::NO_DEVICE;
+        uint32_t ask_device = NBBOQuote::NO_DEVICE;
+        uint64_t arrivals = 0;      // Orders venue updates for tie-breaks
+
+        // Published copy for readers
+        std::atomic<uint32_t> pub_bid_price{0};
+        std::atomic<uint32_t> pub_bid_size{0};
+        std::atomic<uint32_t> pub_bid_device{NBBOQuote::NO_DEVICE};
+        std::atomic<uint32_t> pub_ask_price{0};
+        std::atomic<uint32_t> pub_ask_size{0};
+        std::atomic<uint32_t> pub_ask_device{NBBOQuote::NO_DEVICE};
+        std::atomic<uint64_t> version{0};
+    };
+    static_assert(sizeof(Entry) == 64, "NBBOEngine entry must be one cache line");
+
+    Venue& venue(uint32_t slot, uint32_t device) {
+        return venues_[static_cast<size_t>(slot) * num_devices_ + device];
+    }
+
+    uint32_t lookup(SymbolKey symbol) {
+        uint32_t slot = index_.find(symbol);
+        if (slot != SymbolIndex::NOT_FOUND) return slot;
+
+        // SymbolIndex has a single writer; new symbols are rare
+        std::lock_guard<std::mutex> guard(insert_mutex_);
+        return index_.find_or_insert(symbol);
+    }
+
+    static void lock(Entry& e) {
+        for (;;) {
+            uint32_t seq = e.seq.load(std::memory_order_relaxed);
+            if (!(seq & 1) &&
+                e.seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+                break;
+            }
+            __builtin_ia32_pause();
+        }
+        // Readers must not see published stores before the odd sequence
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void unlock(Entry& e, bool changed) {
+        if (changed) {
+            e.version.store(e.version.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+        }
+        e.seq.store(e.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        if (changed) changes_.fetch_add(1, std::memory_order_release);
+    }
+
+    // Best bid over devices: highest price, then earliest to reach it
+    bool rescan_bid(uint32_t slot, Entry& e) {
+        uint32_t best = NBBOQuote::NO_DEVICE;
+        for (uint32_t d = 0; d < num_devices_; d++) {
+            const Venue& v = venue(slot, d);
+            if (v.bid_price == 0) continue;
+            if (best == NBBOQuote::NO_DEVICE) {
+                best = d;
+                continue;
+            }
+            const Venue& b = venue(slot, best);
+            if (v.bid_price > b.bid_price ||
+                (v.bid_price == b.bid_price && v.bid_since < b.bid_since)) {
+                best = d;
+            }
+        }
+        e.bid_device = best;
+        return publish_bid(slot, e);
+    }
+
+    // Best ask over devices: lowest price, then earliest to reach it
+    bool rescan_ask(uint32_t slot, Entry& e) {
+        uint32_t best = NBBOQuote::NO_DEVICE;
+        for (uint32_t d = 0; d < num_devices_; d++) {
+            const Venue& v = venue(slot, d);
+            if (v.ask_price == 0) continue;
+            if (best == NBBOQuote::NO_DEVICE) {
+                best = d;
+                continue;
+            }
+            const Venue& b = venue(slot, best);
+            if (v.ask_price < b.ask_price ||
+                (v.ask_price == b.ask_price && v.ask_since < b.ask_since)) {
+                best = d;
+            }
+        }
+        e.ask_device = best;
+        return publish_ask(slot, e);
+    }
+
+    // Copy the holder's bid to the published fields; true if it changed
+    bool publish_bid(uint32_t slot, Entry& e) {
+        uint32_t price = 0, size = 0;
+        if (e.bid_device != NBBOQuote::NO_DEVICE) {
+            price = venue(slot, e.bid_device).bid_price;
+            size = venue(slot, e.bid_device).bid_size;
+        }
+        if (price == e.pub_bid_price.load(std::memory_order_relaxed) &&
+            size == e.pub_bid_size.load(std::memory_order_relaxed) &&
+            e.bid_device == e.pub_bid_device.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        e.pub_bid_price.store(price, std::memory_order_relaxed);
+        e.pub_bid_size.store(size, std::memory_order_relaxed);
+        e.pub_bid_device.store(e.bid_device, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool publish_ask(uint32_t slot, Entry& e) {
+        uint32_t price = 0, size = 0;
+        if (e.ask_device != NBBOQuote::NO_DEVICE) {
+            price = venue(slot, e.ask_device).ask_price;
+            size = venue(slot, e.ask_device).ask_size;
+        }
+        if (price == e.pub_ask_price.load(std::memory_order_relaxed) &&
+            size == e.pub_ask_size.load(std::memory_order_relaxed) &&
+            e.ask_device == e.pub_ask_device.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        e.pub_ask_price.store(price, std::memory_order_relaxed);
+        e.pub_ask_size.store(size, std::memory_order_relaxed);
+        e.pub_ask_device.store(e.ask_device, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool apply(uint32_t device, SymbolKey symbol, uint32_t bid_price, uint32_t bid_size,
+               uint32_t ask_price, uint32_t ask_size) {
+        if (device >= num_devices_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        uint32_t slot = lookup(symbol);
+        if (slot == SymbolIndex::NOT_FOUND) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        Entry& e = entries_[slot];
+        lock(e);
+
+        Venue& v = venue(slot, device);
+        uint64_t arrival = ++e.arrivals;
+        if (bid_price != v.bid_price) v.bid_since = arrival;
+        if (ask_price != v.ask_price) v.ask_since = arrival;
+        uint32_t old_bid = v.bid_price;
+        uint32_t old_ask = v.ask_price;
+        v.bid_price = bid_price;
+        v.bid_size = bid_size;
+        v.ask_price = ask_price;
+        v.ask_size = ask_size;
+
+        bool changed = false;
+
+        // Bid side
+        if (e.bid_device == device) {
+            // Holder improved or held: still best. Backed off: rescan.
+            changed |= (bid_price >= old_bid && bid_price != 0)
+                ? publish_bid(slot, e) : rescan_bid(slot, e);
+        } else if (bid_price != 0 &&
+                   (e.bid_device == NBBOQuote::NO_DEVICE ||
+                    bid_price > venue(slot, e.bid_device).bid_price)) {
+            e.bid_device = device;
+            changed |= publish_bid(slot, e);
+        }
+
+        // Ask side
+        if (e.ask_device == device) {
+            changed |= (ask_price <= old_ask && ask_price != 0)
+                ? publish_ask(slot, e) : rescan_ask(slot, e);
+        } else if (ask_price != 0 &&
+                   (e.ask_device == NBBOQuote::NO_DEVICE ||
+                    ask_price < venue(slot, e.ask_device).ask_price)) {
+            e.ask_device = device;
+            changed |= publish_ask(slot, e);
+        }
+
+        // First quote makes the symbol visible to get() even if both sides are empty
+        if (e.version.load(std::memory_order_relaxed) == 0) changed = true;
+
+        unlock(e, changed);
+        return changed;
+    }
+
+    uint32_t num_devices_;
+    SymbolIndex index_;
+    std::mutex insert_mutex_;
+    std::unique_ptr<Entry[]> entries_;
+    std::unique_ptr<Venue[]> venues_;
+    std::atomic<uint64_t> changes_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+}  // namespace pcie
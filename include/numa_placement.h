@@ -0,0 +1,95 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace pcie {
+
+/**
+ * Where the streaming path runs relative to the card
+ */
+struct NumaPlacement {
+    int device_node = -1;          // Node of the PCIe slot (-1 = unknown / single node)
+    int node = -1;                 // Node buffers are allocated on (-1 = OS default)
+    std::vector<int> cpus;         // Streaming thread affinity (empty = not pinned)
+    bool remote = false;           // Caller picked a node or CPU away from the card
+    const char* source = "none";   // "device", "config" or "none"
+    std::vector<std::string> warnings;
+};
+
+/**
+ * NUMA Topology
+ * Node -> CPU map read from /sys/devices/system/node, and the placement
+ * decision made from it: buffers on the card's node and streaming
+ * threads on that node's CPUs, unless the caller asks otherwise, in
+ * which case a remote choice is kept but flagged.
+ */
+class NumaTopology {
+public:
+    static constexpr int NUMA_AUTO = -2;   // Follow the card
+    static constexpr int NUMA_NONE = -1;   // Leave placement to the OS
+
+    explicit NumaTopology(const std::string& node_root = "/sys/devices/system/node");
+
+    size_t nodes() const { return node_cpus_.size(); }
+    const std::vector<int>& cpus(int node) const;
+    int node_of_cpu(int cpu) const;     // -1 if unknown
+
+    /**
+     * Decide placement
+     * @param device_node numa_node of the card (-1 = unknown)
+     * @param device_cpus local_cpulist of the card
+     * @param requested_node NUMA_AUTO, NUMA_NONE or a node id
+     * @param requested_cpus Explicit affinity (empty = the node's CPUs)
+     */
+    NumaPlacement place(int device_node, const std::vector<int>& device_cpus,
+                        int requested_node, const std::vector<int>& requested_cpus) const;
+
+    // "0-3,8,10-11" <-> {0,1,2,3,8,10,11}
+    static std::vector<int> parse_cpulist(const std::string& list);
+    static std::string format_cpulist(const std::vector<int>& cpus);
+
+private:
+    std::vector<std::vector<int>> node_cpus_;   // Indexed by node id
+};
+
+/**
+ * Restrict the calling thread to a CPU set
+ * @return false if the set is empty or the kernel refused it
+ */
+bool pin_current_thread(const std::vector<int>& cpus);
+
+/**
+ * Node holding the page at addr (the page must have been touched)
+ * @return -1 if unknown
+ */
+int memory_node(const void* addr);
+
+/**
+ * Scoped Memory Node
+ * Makes the calling thread prefer one node for new pages until the scope
+ * ends, then restores its previous policy. Memory allocated and first
+ * touched inside the scope (a table zeroed by its constructor, a buffer
+ * filled by the thread that reads into it) lands on that node. Falls
+ * back to the kernel's choice when the node is full. No-op for node < 0
+ * or without NUMA support.
+ */
+class ScopedMemoryNode {
+public:
+    explicit ScopedMemoryNode(int node);
+    ~ScopedMemoryNode();
+
+    ScopedMemoryNode(const ScopedMemoryNode&) = delete;
+    ScopedMemoryNode& operator=(const ScopedMemoryNode&) = delete;
+
+    bool active() const { return active_; }
+
+private:
+    static constexpr unsigned long MAX_NODES = 1024;
+
+    bool active_ = false;
+    int saved_mode_ = 0;
+    unsigned long saved_mask_[MAX_NODES / (8 * sizeof(unsigned long))] = {};
+};
+
+}  // namespace pcie
@@ -3,6 +3,10 @@
 #include <cstdint>
 #include <cstring>
 #include <string>
+#include <vector>
+
+#include "price4.h"
+#include "symbol_key.h"
 
 namespace pcie {
 
@@ -22,17 +26,30 @@ struct BBOData {
     uint32_t rx_timestamp;    // FPGA cycle count when ITCH received (big-endian)
     uint32_t tx_timestamp;    // FPGA cycle count when packet sent (big-endian)
 
-    // Convert from network byte order to host
+    // Fixed-point prices (integer math, use on per-record paths)
+    Price4 get_bid_px() const {
+        return Price4::from_raw(__builtin_bswap32(bid_price));
+    }
+
+    Price4 get_ask_px() const {
+        return Price4::from_raw(__builtin_bswap32(ask_price));
+    }
+
+    Price4 get_spread_px() const {
+        return Price4::from_raw(__builtin_bswap32(spread));
+    }
+
+    // Convert from network byte order to host (floating point, for display)
     double get_bid_price() const {
-        return static_cast<double>(__builtin_bswap32(bid_price)) / 10000.0;
+        return get_bid_px().to_double();
     }
 
     double get_ask_price() const {
-        return static_cast<double>(__builtin_bswap32(ask_price)) / 10000.0;
+        return get_ask_px().to_double();
     }
 
     double get_spread() const {
-        return static_cast<double>(__builtin_bswap32(spread)) / 10000.0;
+        return get_spread_px().to_double();
     }
 
     uint32_t get_bid_size() const {
@@ -68,29 +85,114 @@ struct BBOData {
         return static_cast<double>(cycles) * 0.004;  // 4 ns per cycle = 0.004 μs
     }
 
+    // Symbol as an 8-byte key (no allocation, use on per-record paths)
+    SymbolKey get_symbol_key() const {
+        return SymbolKey::from_bytes(symbol);
+    }
+
     // Get symbol as std::string (trimmed)
     std::string get_symbol() const {
-        char sym[9];
-        std::memcpy(sym, symbol, 8);
-        sym[8] = '\0';
-
-        // Trim trailing spaces
-        int len = 7;
-        while (len >= 0 && sym[len] == ' ') {
-            sym[len] = '\0';
-            len--;
-        }
-
-        return std::string(sym);
+        return std::string(get_symbol_key().view());
     }
 };
 #pragma pack(pop)
 
 static_assert(sizeof(BBOData) == 36, "BBOData must be 36 bytes");
 
+/**
+ * BBO Packet (48 bytes)
+ * Wire format of bbo_axi_stream.vhd: 44 data bytes plus 4 bytes padding,
+ * sent as six 64-bit AXI-Stream beats. Fields are little-endian (first
+ * field in the low half of each beat); the symbol may be NUL-padded.
+ */
+#pragma pack(push, 1)
+struct BBOPacket {
+    static constexpr uint32_t PADDING = 0xDEADBEEF;
+
+    char symbol[8];           // Stock ticker (ASCII)
+    uint32_t bid_price;       // Fixed-point, 4 decimal places
+    uint32_t bid_size;
+    uint32_t ask_price;       // Fixed-point, 4 decimal places
+    uint32_t ask_size;
+    uint32_t spread;
+    uint32_t ts_t1;           // ITCH parse
+    uint32_t ts_t2;           // CDC FIFO write
+    uint32_t ts_t3;           // BBO FIFO read
+    uint32_t ts_t4;           // TX start
+    uint32_t padding;         // PADDING
+};
+#pragma pack(pop)
+
+static_assert(sizeof(BBOPacket) == 48, "BBOPacket must be 48 bytes");
+
+/**
+ * C2H Wire Formats
+ */
+enum class WireFormat : uint8_t {
+    BBO36,    // BBOData, big-endian, rx/tx timestamps
+    BBO48     // BBOPacket, little-endian, T1-T4 timestamps
+};
+
+inline constexpr size_t wire_record_size(WireFormat format) {
+    return format == WireFormat::BBO48 ? sizeof(BBOPacket) : sizeof(BBOData);
+}
+
+/**
+ * Native BBO Record (48 bytes)
+ * Host byte order, produced by the batch decoder from either wire format.
+ * From BBO36, ts_t1/ts_t4 hold rx/tx_timestamp and ts_t2/ts_t3 are zero.
+ */
+struct alignas(16) BBORecord {
+    static constexpr uint32_t FLAG_WIRE48 = 0x01;        // Decoded from BBOPacket
+    static constexpr uint32_t FLAG_BAD_PADDING = 0x02;   // BBOPacket padding mismatch
+
+    SymbolKey symbol;
+    uint32_t bid_price;       // Fixed-point, 4 decimal places
+    uint32_t bid_size;
+    uint32_t ask_price;       // Fixed-point, 4 decimal places
+    uint32_t ask_size;
+    uint32_t spread;
+    uint32_t ts_t1;           // ITCH parse / rx_timestamp
+    uint32_t ts_t2;           // CDC FIFO write
+    uint32_t ts_t3;           // BBO FIFO read
+    uint32_t ts_t4;           // TX start / tx_timestamp
+    uint32_t flags;
+
+    Price4 get_bid_px() const { return Price4::from_raw(bid_price); }
+    Price4 get_ask_px() const { return Price4::from_raw(ask_price); }
+    Price4 get_spread_px() const { return Price4::from_raw(spread); }
+
+    // T1 -> T4 in FPGA cycles (unsigned subtraction handles wraparound)
+    uint32_t get_fpga_latency_cycles() const { return ts_t4 - ts_t1; }
+
+    // 250 MHz (4 ns per cycle) for Gen2
+    double get_fpga_latency_us() const {
+        return static_cast<double>(get_fpga_latency_cycles()) * 0.004;
+    }
+
+    // Legacy 36-byte big-endian form for BBOCallback consumers
+    BBOData to_bbo_data() const {
+        BBOData bbo;
+        symbol.to_bytes(bbo.symbol);
+        bbo.bid_price = __builtin_bswap32(bid_price);
+        bbo.bid_size = __builtin_bswap32(bid_size);
+        bbo.ask_price = __builtin_bswap32(ask_price);
+        bbo.ask_size = __builtin_bswap32(ask_size);
+        bbo.spread = __builtin_bswap32(spread);
+        bbo.rx_timestamp = __builtin_bswap32(ts_t1);
+        bbo.tx_timestamp = __builtin_bswap32(ts_t4);
+        return bbo;
+    }
+};
+
+static_assert(sizeof(BBORecord) == 48, "BBORecord must be 48 bytes");
+
 /**
  * Control Register Structure
  * Mapped via /dev/xdma0_user mmap
+ * The eight 8-byte symbol filter slots span 0x10-0x4F, so slots 6 and 7
+ * share 0x40-0x48 with the read-only timestamp and latency registers:
+ * only slots 0-5 are free-standing filter storage.
  */
 struct ControlRegisters {
     static constexpr uint32_t VERSION_OFFSET = 0x00;
@@ -98,10 +200,17 @@ struct ControlRegisters {
     static constexpr uint32_t STATUS_OFFSET = 0x08;
     static constexpr uint32_t BBO_COUNT_OFFSET = 0x0C;
     static constexpr uint32_t SYMBOL_FILTER_0_OFFSET = 0x10;
+    static constexpr uint32_t SYMBOL_FILTER_SLOTS = 8;   // 8 bytes each
     static constexpr uint32_t RX_TIMESTAMP_OFFSET = 0x40;
     static constexpr uint32_t TX_TIMESTAMP_OFFSET = 0x44;
     static constexpr uint32_t LATENCY_US_OFFSET = 0x48;
 
+    // Filter word that is really a timestamp/latency register
+    static constexpr bool is_status_word(uint32_t offset) {
+        return offset == RX_TIMESTAMP_OFFSET || offset == TX_TIMESTAMP_OFFSET ||
+               offset == LATENCY_US_OFFSET;
+    }
+
     // Control register bits
     static constexpr uint32_t CTRL_ENABLE = 0x01;
     static constexpr uint32_t CTRL_RESET = 0x02;
@@ -121,6 +230,193 @@ struct XDMADevicePaths {
     static constexpr const char* USER = "/dev/xdma0_user";
     static constexpr const char* CONTROL = "/dev/xdma0_control";
     static constexpr const char* EVENTS_0 = "/dev/xdma0_events_0";
+
+    // XDMA IP supports up to four C2H and four H2C channels
+    static constexpr uint32_t MAX_C2H_CHANNELS = 4;
+
+    static std::string c2h(uint32_t channel, uint32_t device = 0) {
+        return "/dev/xdma" + std::to_string(device) + "_c2h_" + std::to_string(channel);
+    }
+    static std::string h2c(uint32_t channel, uint32_t device = 0) {
+        return "/dev/xdma" + std::to_string(device) + "_h2c_" + std::to_string(channel);
+    }
+};
+
+/**
+ * Transport Backends
+ * Where XDMAWrapper::open() takes its C2H stream, H2C sink and register
+ * BAR from (see transport.h).
+ */
+enum class TransportKind : uint8_t {
+    XDMA,         // Driver nodes: c2h_path, h2c_path, user_path (mmapped), events_path
+    FILE,         // c2h_path is a regular file (replayed once) or FIFO; h2c_path and
+                  // user_path are used when set, else H2C is discarded and the BAR emulated
+    SHM,          // POSIX shared-memory segment shm_name laid out by ShmFeed
+    GENERATOR     // Synthetic records made in-process; BAR emulated, H2C discarded
+};
+
+inline const char* transport_kind_string(TransportKind kind) {
+    switch (kind) {
+        case TransportKind::XDMA: return "xdma";
+        case TransportKind::FILE: return "file";
+        case TransportKind::SHM: return "shm";
+        case TransportKind::GENERATOR: return "generator";
+        default: return "unknown";
+    }
+}
+
+/**
+ * Generator Patterns
+ */
+enum class GeneratorPattern : uint8_t {
+    MARKET,          // Symbol universe, Zipf popularity, random-walk prices, pipelined T1-T4
+    TEST_PATTERN     // order_book_pcie_top TEST_MODE 2: TESTAAPL 1.5000/1.5100, T1-T4 = packet count
+};
+
+/**
+ * Generator Configuration
+ * Synthetic C2H records for the generator transport and bbo_feed (see
+ * bbo_generator.h), encoded in the configured wire format.
+ */
+struct GeneratorConfig {
+    GeneratorPattern pattern = GeneratorPattern::MARKET;
+    uint32_t symbols = 8;            // Universe GEN00000, GEN00001, ..., at most 100000
+    double zipf_s = 0.0;             // Popularity exponent, 0 = round-robin over the universe
+    uint32_t start_price = 1000000;  // Walk start of GEN00000 ($100.0000), +$1 per symbol mod 1000
+    uint32_t tick = 100;             // Walk step and minimum spread ($0.01)
+    uint64_t records = 0;            // Stream ends after this many, 0 = never
+    uint64_t rate = 0;               // Target records/s, 0 = as fast as it is read
+    uint32_t pool_records = 0;       // Replay a pre-encoded pool of this many, 0 = generate each
+    uint32_t seed = 1;               // Channel i of a multi-channel stream uses seed + i
+};
+
+/**
+ * Injected C2H Faults
+ * Classes of misbehaviour the fault-injecting transport wrapper
+ * (FaultSource, see transport.h) plays back on the host.
+ */
+enum class FaultKind : uint8_t {
+    SHORT_READ,     // Read returns part of what arrived; the rest comes on later reads
+    INTERRUPTED,    // Read returns nothing before its timeout, errno EINTR
+    WOULD_BLOCK,    // Read returns nothing before its timeout, errno EAGAIN
+    STALL,          // Nothing arrives for the fault's duration
+    LINK_DOWN,      // Reads fail with EIO for the fault's duration
+    COUNT
+};
+
+inline const char* fault_kind_string(FaultKind kind) {
+    switch (kind) {
+        case FaultKind::SHORT_READ: return "short read";
+        case FaultKind::INTERRUPTED: return "EINTR";
+        case FaultKind::WOULD_BLOCK: return "EAGAIN";
+        case FaultKind::STALL: return "stall";
+        case FaultKind::LINK_DOWN: return "link down";
+        default: return "unknown";
+    }
+}
+
+/**
+ * One scheduled fault: fires on the at_read'th read (0-based) of a channel
+ */
+struct FaultEvent {
+    uint64_t at_read = 0;
+    FaultKind kind = FaultKind::SHORT_READ;
+    uint32_t duration_ms = 0;       // STALL and LINK_DOWN; 0 = the config's default
+};
+
+/**
+ * Fault Injection Configuration
+ * Wraps whichever C2H source the transport opened. Each read draws at
+ * most one fault, scheduled events first. No fault loses or repeats
+ * data: held-back bytes arrive on later reads, and an outage delays
+ * the stream without dropping any of it.
+ */
+struct FaultConfig {
+    double short_read = 0.0;        // Probability per read of each class
+    double interrupted = 0.0;
+    double would_block = 0.0;
+    double stall = 0.0;
+    double link_down = 0.0;
+    uint32_t stall_ms = 20;
+    uint32_t link_down_ms = 50;
+    std::vector<FaultEvent> schedule;
+    uint32_t seed = 1;              // Channel i of a multi-channel stream uses seed + i
+
+    bool enabled() const {
+        return short_read > 0.0 || interrupted > 0.0 || would_block > 0.0 || stall > 0.0 ||
+               link_down > 0.0 || !schedule.empty();
+    }
+};
+
+/**
+ * Fault Injection Statistics
+ * A fault has recovered when a later read returns data; its recovery
+ * time runs from the fault clearing (the faulted read returning, or the
+ * outage ending) to that read. Faults that pile up before data returns
+ * all recover at that read, each timed from its own clearing.
+ */
+struct FaultClassStats {
+    uint64_t injected = 0;
+    uint64_t recovered = 0;
+    uint64_t total_recovery_ns = 0;
+    uint64_t max_recovery_ns = 0;
+
+    double avg_recovery_us() const {
+        return recovered ? static_cast<double>(total_recovery_ns) / static_cast<double>(recovered) / 1000.0
+                         : 0.0;
+    }
+};
+
+struct FaultStats {
+    uint64_t reads = 0;
+    FaultClassStats kinds[static_cast<size_t>(FaultKind::COUNT)];
+
+    const FaultClassStats& operator[](FaultKind kind) const {
+        return kinds[static_cast<size_t>(kind)];
+    }
+
+    // Sum of several sources' stats
+    FaultStats& operator+=(const FaultStats& other) {
+        reads += other.reads;
+        for (size_t k = 0; k < static_cast<size_t>(FaultKind::COUNT); k++) {
+            FaultClassStats& c = kinds[k];
+            c.injected += other.kinds[k].injected;
+            c.recovered += other.kinds[k].recovered;
+            c.total_recovery_ns += other.kinds[k].total_recovery_ns;
+            if (other.kinds[k].max_recovery_ns > c.max_recovery_ns) c.max_recovery_ns = other.kinds[k].max_recovery_ns;
+        }
+        return *this;
+    }
+};
+
+/**
+ * XDMA Device Configuration
+ * Node paths and BAR mapping size used by XDMAWrapper::open().
+ * Defaults address card 0. Any node may point at a regular file or FIFO
+ * instead (file-backed BAR, pipe-backed C2H) to run without a card, or
+ * another transport can stand in for the driver altogether.
+ */
+struct XDMADeviceConfig {
+    std::string c2h_path = XDMADevicePaths::C2H_0;
+    std::string h2c_path = XDMADevicePaths::H2C_0;
+    std::string user_path = XDMADevicePaths::USER;
+    std::string events_path = XDMADevicePaths::EVENTS_0;
+    size_t user_map_size = 4096;   // 4KB page
+    bool require_driver = true;    // Fail open() when the xdma module is absent
+    size_t max_symbols = 4096;     // Capacity of the per-symbol tables
+    WireFormat wire_format = WireFormat::BBO36;  // Record layout on C2H (read_records)
+    std::string snapshot_path;     // Book snapshot file; empty = no warm start
+    uint32_t snapshot_interval_ms = 1000;  // Checkpoint period, 0 = only on close()
+    std::vector<std::string> c2h_channels;  // start_multichannel_streaming(); empty = c2h_path
+    int numa_node = -2;            // Buffer node: -2 = the card's (sysfs), -1 = OS default
+    std::vector<int> stream_cpus;  // Streaming thread affinity; empty = the node's CPUs
+    TransportKind transport = TransportKind::XDMA;
+    std::string shm_name;          // TransportKind::SHM segment, e.g. "/bbo_feed"
+    GeneratorConfig generator;     // TransportKind::GENERATOR
+    uint32_t status_poll_ms = 100; // STATUS_FIFO_FULL check period while reading, 0 = never
+    uint32_t read_retry_max_ms = 50;       // Streaming: longest back-off between retries of a failed read
+    uint32_t read_error_limit_ms = 10000;  // Streaming: stop after reads failed this long, 0 = never
+    FaultConfig faults;            // Fault injection on C2H (testing), off unless set
 };
 
 /**
@@ -130,13 +426,14 @@ struct TransferStats {
     uint64_t bytes_transferred;
     uint64_t transfers_completed;
     uint64_t transfers_failed;
+    uint64_t fifo_overflows;      // STATUS_FIFO_FULL raised (sticky until CTRL_RESET)
     double avg_latency_us;
     double min_latency_us;
     double max_latency_us;
 
     TransferStats()
         : bytes_transferred(0), transfers_completed(0), transfers_failed(0),
-          avg_latency_us(0.0), min_latency_us(1e9), max_latency_us(0.0) {}
+          fifo_overflows(0), avg_latency_us(0.0), min_latency_us(1e9), max_latency_us(0.0) {}
 
     void update_latency(double latency_us) {
         if (latency_us < min_latency_us) min_latency_us = latency_us;
@@ -161,7 +458,8 @@ enum class PCIeError {
     TIMEOUT,
     LINK_DOWN,
     BUFFER_OVERFLOW,
-    INVALID_PARAMETER
+    INVALID_PARAMETER,
+    BUSY
 };
 
 inline const char* pcie_error_string(PCIeError err) {
@@ -176,8 +474,32 @@ inline const char* pcie_error_string(PCIeError err) {
         case PCIeError::LINK_DOWN: return "PCIe link is down";
         case PCIeError::BUFFER_OVERFLOW: return "Buffer overflow";
         case PCIeError::INVALID_PARAMETER: return "Invalid parameter";
+        case PCIeError::BUSY: return "Device busy";
         default: return "Unknown error";
     }
 }
 
+/**
+ * Reset Sequence Report
+ * Filled in by XDMAWrapper::reset() / reset_async()
+ *
+ * The blackout window runs from the moment dispatch is paused until the
+ * streaming thread is released again; no callbacks fire inside it.
+ */
+struct ResetReport {
+    PCIeError error;
+    bool was_streaming;         // Streaming thread was paused and resumed
+    bool running_confirmed;     // STATUS_RUNNING observed before the deadline
+    uint64_t drained_bytes;     // C2H bytes discarded while draining
+    uint64_t drained_records;   // Whole BBO records discarded
+    uint32_t status_polls;      // Register polls spent waiting on the core
+    double blackout_us;         // Dispatch paused -> dispatch resumed
+    double reset_us;            // CTRL_RESET asserted -> core back up
+
+    ResetReport()
+        : error(PCIeError::SUCCESS), was_streaming(false), running_confirmed(false),
+          drained_bytes(0), drained_records(0), status_polls(0),
+          blackout_us(0.0), reset_us(0.0) {}
+};
+
 }  // namespace pcie
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cfloat>
+#include <cmath>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace pcie {
+
+/**
+ * Fixed-Point Price (4 decimal places)
+ * Raw value is price x 10000, exactly as the FPGA carries it. Arithmetic
+ * and comparison are integer operations, so equal prices compare equal
+ * and nothing on the per-record path touches floating point. Held in 64
+ * bits so sums and differences of 32-bit wire prices cannot overflow.
+ */
+class Price4 {
+public:
+    static constexpr int64_t SCALE = 10000;
+
+    constexpr Price4() : raw_(0) {}
+
+    static constexpr Price4 from_raw(int64_t raw) {
+        Price4 p;
+        p.raw_ = raw;
+        return p;
+    }
+
+    // 150 dollars and 2500 ten-thousandths -> 150.2500
+    static constexpr Price4 from_parts(int64_t whole, int64_t ten_thousandths = 0) {
+        return from_raw(whole * SCALE + ten_thousandths);
+    }
+
+    // Rounds half away from zero, saturating at the int64 range (NaN -> 0);
+    // for config and tests, not per-record use
+    static Price4 from_double(double price) {
+        double scaled = price * SCALE;
+        double mag = std::fabs(scaled);
+        if (!(mag == mag)) return Price4();
+        if (mag >= 0x1.0p63) return from_raw(scaled < 0 ? INT64_MIN : INT64_MAX);
+
+        // The product can land an ulp short of a decimal half
+        // (150.00005 -> 1500000.4999999998); a few ulps of slack keep it a half
+        double half = 0.5;
+        if (mag < 0x1.0p40) half += mag * 4 * DBL_EPSILON;
+        return from_raw(static_cast<int64_t>(scaled < 0 ? scaled - half : scaled + half));
+    }
+
+    constexpr int64_t raw() const { return raw_; }
+
+    // Same rounding as the legacy BBOData::get_*_price() getters
+    constexpr double to_double() const {
+        return static_cast<double>(raw_) / static_cast<double>(SCALE);
+    }
+
+    constexpr Price4 operator+(Price4 o) const { return from_raw(raw_ + o.raw_); }
+    constexpr Price4 operator-(Price4 o) const { return from_raw(raw_ - o.raw_); }
+    constexpr Price4 operator-() const { return from_raw(-raw_); }
+    constexpr Price4 operator*(int64_t n) const { return from_raw(raw_ * n); }
+    constexpr Price4 operator/(int64_t n) const { return from_raw(raw_ / n); }
+    constexpr Price4& operator+=(Price4 o) { raw_ += o.raw_; return *this; }
+    constexpr Price4& operator-=(Price4 o) { raw_ -= o.raw_; return *this; }
+
+    constexpr auto operator<=>(const Price4&) const = default;
+
+    // Midpoint, truncated toward zero to a whole tick
+    static constexpr Price4 mid(Price4 a, Price4 b) {
+        return from_raw((a.raw_ + b.raw_) / 2);
+    }
+
+    /**
+     * Format as "-123.4500" without allocating
+     * @return Characters written (excluding the terminator), truncated to fit
+     */
+    size_t format(char* buf, size_t len) const {
+        if (len == 0) return 0;
+
+        char tmp[24];
+        size_t pos = sizeof(tmp);
+        uint64_t mag = raw_ < 0 ? 0 - static_cast<uint64_t>(raw_) : static_cast<uint64_t>(raw_);
+
+        for (int i = 0; i < 4; i++) {
+            tmp[--pos] = static_cast<char>('0' + mag % 10);
+            mag /= 10;
+        }
+        tmp[--pos] = '.';
+        do {
+            tmp[--pos] = static_cast<char>('0' + mag % 10);
+            mag /= 10;
+        } while (mag != 0);
+        if (raw_ < 0) tmp[--pos] = '-';
+
+        size_t n = sizeof(tmp) - pos;
+        if (n >= len) n = len - 1;
+        std::memcpy(buf, tmp + pos, n);
+        buf[n] = '\0';
+        return n;
+    }
+
+    std::string to_string() const {
+        char buf[24];
+        return std::string(buf, format(buf, sizeof(buf)));
+    }
+
+private:
+    int64_t raw_;
+};
+
+static_assert(sizeof(Price4) == 8, "Price4 must be 8 bytes");
+static_assert(Price4::from_parts(150, 2500) > Price4::from_parts(150, 2499),
+              "Price4 compares as integers");
+
+// Share count; already integral on the wire, named for intent
+using Qty = uint32_t;
+
+/**
+ * Bulk conversion to double for the few consumers that need it (model
+ * inputs, plotting). Contiguous, branch-free loops the compiler vectorises;
+ * results are bit-identical to Price4::to_double().
+ */
+inline void to_double(const Price4* __restrict in, double* __restrict out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = static_cast<double>(in[i].raw()) / static_cast<double>(Price4::SCALE);
+    }
+}
+
+// Straight from host-order 32-bit wire prices (e.g. a column of raw fields)
+inline void to_double(const uint32_t* __restrict raw, double* __restrict out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = static_cast<double>(raw[i]) / static_cast<double>(Price4::SCALE);
+    }
+}
+
+}  // namespace pcie
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "pcie_types.h"
+#include "symbol_index.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace pcie {
+
+/**
+ * Derived quote values for one update, computed once per record
+ * Prices are Price4 (4 decimal places); ratios are scaled integers.
+ * One-sided quotes (bid or ask price 0) leave mid, microprice and
+ * spread_cbps at 0 and two_sided false.
+ */
+struct DerivedQuote {
+    SymbolKey symbol;
+    Price4 mid;                  // (bid + ask) / 2, truncated to a tick
+    Price4 microprice;           // Size-weighted: (bid * ask_size + ask * bid_size) / total size
+    int32_t spread_cbps;         // Spread over mid, hundredths of a basis point
+    int32_t imbalance;           // (bid_size - ask_size) / total size, x 10000 (-10000..10000)
+    Price4 ewma_spread;          // Per-symbol EWMA of the spread
+    uint64_t ewma_interval_ns;   // Per-symbol EWMA of time between updates (0 until 2 updates)
+    uint32_t quote_rate_x100;    // Updates per second x 100, from ewma_interval_ns
+    uint64_t updates;            // Updates seen for this symbol
+    bool two_sided;
+
+    double get_spread_bps() const { return spread_cbps / 100.0; }
+    double get_imbalance() const { return imbalance / 10000.0; }
+    double get_quote_rate() const { return quote_rate_x100 / 100.0; }
+};
+
+/**
+ * EWMA smoothing, as alpha = 1 / 2^shift
+ */
+struct QuoteAnalyticsConfig {
+    size_t max_symbols = 4096;
+    uint32_t spread_shift = 4;     // alpha 1/16
+    uint32_t interval_shift = 4;   // alpha 1/16
+};
+
+/**
+ * Incremental Per-Symbol Quote Analytics
+ * Computes mid, microprice, spread in basis points and size imbalance
+ * for each record, and keeps rolling EWMAs of spread and quote rate per
+ * symbol. All integer arithmetic: the EWMAs are held with 16 fractional
+ * bits and updated by shift, so results are exact and reproducible.
+ *
+ * Per-symbol state lives in flat arrays indexed by SymbolIndex slot.
+ * One writer thread (the stream thread); results go out with the record.
+ */
+class QuoteAnalytics {
+public:
+    explicit QuoteAnalytics(const QuoteAnalyticsConfig& config = QuoteAnalyticsConfig())
+        : config_(config),
+          index_(config.max_symbols),
+          state_(std::make_unique<SymbolState[]>(config.max_symbols)) {}
+
+    QuoteAnalytics(const QuoteAnalytics&) = delete;
+    QuoteAnalytics& operator=(const QuoteAnalytics&) = delete;
+
+    /**
+     * Derive values for one update and fold it into the symbol's EWMAs
+     * @param host_time_ns Arrival time (steady_clock), drives the quote rate
+     * @return false if the symbol is new and the table is full (out still
+     *         holds the per-record values, without EWMAs)
+     */
+    bool update(const BBOData& bbo, uint64_t host_time_ns, DerivedQuote& out) {
+        return apply(bbo.get_symbol_key(), __builtin_bswap32(bbo.bid_price), bbo.get_bid_size(),
+                     __builtin_bswap32(bbo.ask_price), bbo.get_ask_size(), host_time_ns, out);
+    }
+
+    bool update(const BBORecord& rec, uint64_t host_time_ns, DerivedQuote& out) {
+        return apply(rec.symbol, rec.bid_price, rec.bid_size, rec.ask_price, rec.ask_size,
+                     host_time_ns, out);
+    }
+
+    /**
+     * Per-record values only, no per-symbol state
+     */
+    static void derive(SymbolKey symbol, uint32_t bid_price, uint32_t bid_size,
+                       uint32_t ask_price, uint32_t ask_size, DerivedQuote& out) {
+        out = DerivedQuote{};
+        out.symbol = symbol;
+
+        uint64_t total = static_cast<uint64_t>(bid_size) + ask_size;
+        if (total != 0) {
+            int64_t diff = static_cast<int64_t>(bid_size) - static_cast<int64_t>(ask_size);
+            out.imbalance = static_cast<int32_t>(diff * 10000 / static_cast<int64_t>(total));
+        }
+
+        out.two_sided = bid_price != 0 && ask_price != 0;
+        if (!out.two_sided) return;
+
+        Price4 bid = Price4::from_raw(bid_price);
+        Price4 ask = Price4::from_raw(ask_price);
+        out.mid = Price4::mid(bid, ask);
+
+        if (total != 0) {
+            // 32x32-bit products: 128-bit sum cannot overflow
+            unsigned __int128 num = static_cast<unsigned __int128>(bid_price) * ask_size +
+                                    static_cast<unsigned __int128>(ask_price) * bid_size;
+            out.microprice = Price4::from_raw(static_cast<int64_t>(num / total));
+        } else {
+            out.microprice = out.mid;
+        }
+
+        // Crossed books give a negative spread
+        int64_t spread = static_cast<int64_t>(ask_price) - static_cast<int64_t>(bid_price);
+        if (out.mid.raw() != 0) {
+            out.spread_cbps = static_cast<int32_t>(spread * 1000000 / out.mid.raw());
+        }
+    }
+
+    size_t size() const { return index_.size(); }
+    size_t capacity() const { return index_.capacity(); }
+
+private:
+    static constexpr int FRAC_BITS = 16;
+
+    struct SymbolState {
+        int64_t ewma_spread = 0;       // Raw price units << FRAC_BITS
+        uint64_t ewma_interval = 0;    // Nanoseconds << FRAC_BITS
+        uint64_t last_ns = 0;
+        uint64_t updates = 0;
+        uint64_t spread_samples = 0;   // Two-sided updates
+    };
+
+    bool apply(SymbolKey symbol, uint32_t bid_price, uint32_t bid_size,
+               uint32_t ask_price, uint32_t ask_size, uint64_t host_time_ns,
+               DerivedQuote& out) {
+        derive(symbol, bid_price, bid_size, ask_price, ask_size, out);
+
+        uint32_t slot = index_.find_or_insert(symbol);
+        if (slot == SymbolIndex::NOT_FOUND) return false;
+        SymbolState& s = state_[slot];
+
+        // Spread EWMA over two-sided quotes only
+        if (out.two_sided) {
+            int64_t spread = (static_cast<int64_t>(ask_price) - static_cast<int64_t>(bid_price))
+                             << FRAC_BITS;
+            s.ewma_spread = (s.spread_samples++ == 0)
+                ? spread : s.ewma_spread + ((spread - s.ewma_spread) >> config_.spread_shift);
+        }
+
+        if (s.updates > 0 && host_time_ns > s.last_ns) {
+            uint64_t interval = (host_time_ns - s.last_ns) << FRAC_BITS;
+            if (s.ewma_interval == 0) {
+                s.ewma_interval = interval;
+            } else if (interval >= s.ewma_interval) {
+                s.ewma_interval += (interval - s.ewma_interval) >> config_.interval_shift;
+            } else {
+                s.ewma_interval -= (s.ewma_interval - interval) >> config_.interval_shift;
+            }
+        }
+        s.last_ns = host_time_ns;
+        s.updates++;
+
+        out.ewma_spread = Price4::from_raw(s.ewma_spread >> FRAC_BITS);
+        out.ewma_interval_ns = s.ewma_interval >> FRAC_BITS;
+        if (out.ewma_interval_ns != 0) {
+            uint64_t rate = 100'000'000'000ULL / out.ewma_interval_ns;
+            out.quote_rate_x100 = rate > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(rate);
+        }
+        out.updates = s.updates;
+        return true;
+    }
+
+    QuoteAnalyticsConfig config_;
+    SymbolIndex index_;
+    std::unique_ptr<SymbolState[]> state_;
+};
+
+}  // namespace pcie
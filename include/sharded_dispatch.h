@@ -0,0 +1,167 @@
+#pragma once
+
+#include "numa_placement.h"
+#include "pcie_types.h"
+#include "spsc_ring.h"
+#include "thread_util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace pcie {
+
+struct ShardedDispatchConfig {
+    uint32_t workers = 4;
+    size_t ring_capacity = 4096;     // Records buffered per worker
+    std::vector<int> cpus;           // Worker i pinned to cpus[i % size]; empty = not pinned
+};
+
+/**
+ * Sharded Dispatch Statistics
+ */
+struct ShardStats {
+    uint64_t records = 0;     // Records handled by the worker
+    uint64_t ring_full = 0;   // Times the producer waited on this worker
+};
+
+struct ShardedDispatchStats {
+    std::vector<ShardStats> workers;
+    uint64_t submitted = 0;
+};
+
+/**
+ * Symbol-Sharded Dispatcher
+ * Spreads handler work over N worker threads without losing per-symbol
+ * order: each symbol hashes to one worker, fed by its own SPSC ring, so
+ * all updates of a symbol run on the same thread in arrival order.
+ * Different symbols run concurrently; a handler keeping per-symbol state
+ * needs no lock as long as it only touches its own symbols.
+ *
+ * One producer thread calls submit(); a full ring blocks it (back-
+ * pressure onto the C2H read) rather than dropping. A hot symbol bounds
+ * the speedup: it can never use more than one worker.
+ */
+class ShardedDispatcher {
+public:
+    using Handler = std::function<void(uint32_t worker, const BBORecord&)>;
+
+    ShardedDispatcher(const ShardedDispatchConfig& config, Handler handler)
+        : handler_(std::move(handler)) {
+        uint32_t n = std::max<uint32_t>(config.workers, 1);
+        for (uint32_t i = 0; i < n; i++) {
+            shards_.push_back(std::make_unique<Shard>(config.ring_capacity));
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            int cpu = config.cpus.empty() ? -1 : config.cpus[i % config.cpus.size()];
+            shards_[i]->worker = std::thread([this, i, cpu]() { run(i, cpu); });
+        }
+    }
+
+    ~ShardedDispatcher() { stop(); }
+
+    ShardedDispatcher(const ShardedDispatcher&) = delete;
+    ShardedDispatcher& operator=(const ShardedDispatcher&) = delete;
+
+    uint32_t workers() const { return static_cast<uint32_t>(shards_.size()); }
+
+    // Multiply-shift onto [0, workers): no division on the per-record path
+    uint32_t shard_of(SymbolKey symbol) const {
+        uint64_t h = static_cast<uint32_t>(symbol.hash());
+        return static_cast<uint32_t>((h * shards_.size()) >> 32);
+    }
+
+    /**
+     * Producer thread only
+     */
+    void submit(const BBORecord& rec) {
+        Shard& s = *shards_[shard_of(rec.symbol)];
+        if (!s.ring.try_push(rec)) {
+            bump(s.ring_full);
+            while (!s.ring.try_push(rec)) std::this_thread::yield();
+        }
+        s.submitted++;
+        bump(submitted_);
+    }
+
+    /**
+     * Wait until every record submitted so far has been handled
+     * (producer thread only)
+     */
+    void flush() {
+        for (auto& s : shards_) {
+            while (s->handled.load(std::memory_order_acquire) < s->submitted) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    /**
+     * Handle what is queued, then join the workers
+     */
+    void stop() {
+        if (stopping_.exchange(true)) return;
+        for (auto& s : shards_) {
+            if (s->worker.joinable()) s->worker.join();
+        }
+    }
+
+    // Any thread
+    ShardedDispatchStats stats() const {
+        ShardedDispatchStats out;
+        for (const auto& s : shards_) {
+            ShardStats st;
+            st.records = s->handled.load(std::memory_order_relaxed);
+            st.ring_full = s->ring_full.load(std::memory_order_relaxed);
+            out.workers.push_back(st);
+        }
+        out.submitted = submitted_.load(std::memory_order_relaxed);
+        return out;
+    }
+
+private:
+    struct Shard {
+        SpscRing<BBORecord> ring;
+        std::thread worker;
+        uint64_t submitted = 0;                  // Producer-owned
+        std::atomic<uint64_t> ring_full{0};      // Producer-owned
+        alignas(64) std::atomic<uint64_t> handled{0};   // Worker-owned
+
+        explicit Shard(size_t capacity) : ring(capacity) {}
+    };
+
+    void run(uint32_t index, int cpu) {
+        if (cpu >= 0) pin_current_thread({cpu});
+        Shard& s = *shards_[index];
+        BBORecord rec;
+        IdleBackoff idle;
+
+        for (;;) {
+            if (s.ring.try_pop(rec)) {
+                if (handler_) handler_(index, rec);
+                s.handled.store(s.handled.load(std::memory_order_relaxed) + 1,
+                                std::memory_order_release);
+                idle.reset();
+                continue;
+            }
+            // stop() drains: only leave once the ring is seen empty after it
+            if (stopping_.load(std::memory_order_acquire)) {
+                if (s.ring.empty()) break;
+                continue;
+            }
+            idle.wait();
+        }
+    }
+
+    Handler handler_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<bool> stopping_{false};
+};
+
+}  // namespace pcie
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "symbol_key.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace pcie {
+
+/**
+ * Symbol Index
+ * Fixed-capacity, open-addressed (linear probing) map from SymbolKey to a
+ * dense slot id 0..capacity-1. Per-symbol tables index their own arrays
+ * with the slot id, so they stay flat and allocation-free after setup.
+ *
+ * One writer thread inserts; any thread may look up concurrently without
+ * locks. Entries are never removed. The probe table is kept at most half
+ * full, so lookups stay short even at capacity.
+ */
+class SymbolIndex {
+public:
+    static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+
+    explicit SymbolIndex(size_t capacity)
+        : capacity_(capacity ? capacity : 1) {
+        size_t table = 16;
+        while (table < capacity_ * 2) table <<= 1;
+        mask_ = table - 1;
+        keys_ = std::make_unique<std::atomic<uint64_t>[]>(table);
+        ids_ = std::make_unique<uint32_t[]>(table);
+        slot_keys_ = std::make_unique<uint64_t[]>(capacity_);
+        for (size_t i = 0; i < table; i++) {
+            keys_[i].store(EMPTY, std::memory_order_relaxed);
+        }
+    }
+
+    SymbolIndex(const SymbolIndex&) = delete;
+    SymbolIndex& operator=(const SymbolIndex&) = delete;
+
+    // Any thread
+    uint32_t find(SymbolKey key) const {
+        for (size_t pos = key.hash() & mask_;; pos = (pos + 1) & mask_) {
+            uint64_t k = keys_[pos].load(std::memory_order_acquire);
+            if (k == key.raw()) return ids_[pos];
+            if (k == EMPTY) return NOT_FOUND;
+        }
+    }
+
+    // Writer thread only. Returns the existing or new slot, NOT_FOUND when full.
+    uint32_t find_or_insert(SymbolKey key) {
+        size_t pos = key.hash() & mask_;
+        for (;; pos = (pos + 1) & mask_) {
+            uint64_t k = keys_[pos].load(std::memory_order_relaxed);
+            if (k == key.raw()) return ids_[pos];
+            if (k == EMPTY) break;
+        }
+
+        size_t id = size_.load(std::memory_order_relaxed);
+        if (id >= capacity_) return NOT_FOUND;
+
+        // Publish the id before the key so a reader that sees the key sees the id
+        slot_keys_[id] = key.raw();
+        ids_[pos] = static_cast<uint32_t>(id);
+        keys_[pos].store(key.raw(), std::memory_order_release);
+        size_.store(id + 1, std::memory_order_release);
+        return static_cast<uint32_t>(id);
+    }
+
+    // Key owning a slot; valid for any id below size()
+    SymbolKey key_at(uint32_t id) const {
+        return SymbolKey::from_raw(slot_keys_[id]);
+    }
+
+    size_t size() const { return size_.load(std::memory_order_acquire); }
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * Drop every entry, keeping the allocation (no concurrent readers)
+     * For an index reused as per-batch scratch. Costs O(size()) while the
+     * table is sparse rather than a pass over the whole probe table.
+     */
+    void clear() {
+        size_t used = size_.load(std::memory_order_relaxed);
+        size_t table = mask_ + 1;
+        if (used * 8 < table) {
+            // Locate every key before emptying any, so no probe chain breaks
+            for (size_t id = 0; id < used; id++) {
+                size_t pos = SymbolKey::from_raw(slot_keys_[id]).hash() & mask_;
+                while (keys_[pos].load(std::memory_order_relaxed) != slot_keys_[id]) {
+                    pos = (pos + 1) & mask_;
+                }
+                slot_keys_[id] = pos;
+            }
+            for (size_t id = 0; id < used; id++) {
+                keys_[slot_keys_[id]].store(EMPTY, std::memory_order_relaxed);
+            }
+        } else {
+            for (size_t i = 0; i < table; i++) {
+                keys_[i].store(EMPTY, std::memory_order_relaxed);
+            }
+        }
+        size_.store(0, std::memory_order_release);
+    }
+
+private:
+    // Normalised keys never contain a zero byte, so 0 is free as a sentinel
+    static constexpr uint64_t EMPTY = 0;
+
+    size_t capacity_;
+    size_t mask_ = 0;
+    std::unique_ptr<std::atomic<uint64_t>[]> keys_;
+    std::unique_ptr<uint32_t[]> ids_;
+    std::unique_ptr<uint64_t[]> slot_keys_;
+    std::atomic<size_t> size_{0};
+};
+
+}  // namespace pcie
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+namespace pcie {
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "SymbolKey packs ticker bytes in little-endian order");
+
+/**
+ * Symbol Key
+ * The 8 ticker bytes loaded as one uint64_t, byte 0 in the low bits, so
+ * the in-memory layout is the wire layout.
+ *
+ * Padding is normalised to spaces on construction: space-padded symbols
+ * (36-byte BBO, filter registers) and NUL-padded ones (48-byte packet)
+ * produce the same key. Equality and hashing are single integer ops;
+ * ordering matches string order. Nothing here allocates.
+ */
+class SymbolKey {
+public:
+    static constexpr uint64_t SPACES = 0x2020202020202020ULL;
+
+    constexpr SymbolKey() : value_(SPACES) {}
+
+    // From a literal or short string: "AAPL" -> "AAPL    " (truncated at 8)
+    constexpr explicit SymbolKey(std::string_view symbol) : value_(pack(symbol)) {}
+    constexpr explicit SymbolKey(const char* symbol) : SymbolKey(std::string_view(symbol)) {}
+
+    // From 8 raw bytes as they appear on the wire or in a filter register pair
+    static SymbolKey from_bytes(const void* bytes) {
+        uint64_t raw;
+        std::memcpy(&raw, bytes, sizeof(raw));
+        return from_raw(raw);
+    }
+
+    static constexpr SymbolKey from_raw(uint64_t raw) {
+        SymbolKey key;
+        key.value_ = normalize(raw);
+        return key;
+    }
+
+    constexpr uint64_t raw() const { return value_; }
+
+    void to_bytes(void* out) const {
+        std::memcpy(out, &value_, sizeof(value_));
+    }
+
+    // Length without trailing padding (0-8)
+    constexpr size_t size() const {
+        uint64_t significant = value_ ^ SPACES;  // Non-zero bytes are not padding
+        return significant ? 8 - static_cast<size_t>(__builtin_clzll(significant)) / 8 : 0;
+    }
+
+    constexpr bool empty() const { return value_ == SPACES; }
+
+    // Trimmed view into this key's own storage; valid while the key lives
+    std::string_view view() const {
+        return std::string_view(reinterpret_cast<const char*>(&value_), size());
+    }
+
+    constexpr size_t hash() const {
+        // Fibonacci multiply, fold the well-mixed high half down
+        uint64_t h = value_ * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+
+    friend constexpr bool operator==(SymbolKey a, SymbolKey b) { return a.value_ == b.value_; }
+    friend constexpr bool operator!=(SymbolKey a, SymbolKey b) { return a.value_ != b.value_; }
+    friend constexpr bool operator<(SymbolKey a, SymbolKey b) {
+        // Byte 0 is least significant in memory, most significant in string order
+        return __builtin_bswap64(a.value_) < __builtin_bswap64(b.value_);
+    }
+
+private:
+    static constexpr uint64_t normalize(uint64_t raw) {
+        // 0x80 in every byte that is exactly zero, then 0x80 >> 2 == ' '
+        constexpr uint64_t LOW7 = 0x7F7F7F7F7F7F7F7FULL;
+        uint64_t zero_bytes = ~(((raw & LOW7) + LOW7) | raw | LOW7);
+        return raw | (zero_bytes >> 2);
+    }
+
+    static constexpr uint64_t pack(std::string_view symbol) {
+        uint64_t raw = 0;
+        for (size_t i = 0; i < 8; i++) {
+            uint8_t c = (i < symbol.size()) ? static_cast<uint8_t>(symbol[i]) : ' ';
+            raw |= static_cast<uint64_t>(c) << (8 * i);
+        }
+        return normalize(raw);
+    }
+
+    uint64_t value_;
+};
+
+static_assert(sizeof(SymbolKey) == 8, "SymbolKey must be 8 bytes");
+static_assert(SymbolKey("AAPL").size() == 4, "SymbolKey trims trailing padding");
+static_assert(SymbolKey("AAPL") == SymbolKey::from_raw(0x000000004C504141ULL),
+              "NUL and space padding compare equal");
+
+struct SymbolKeyHash {
+    size_t operator()(SymbolKey key) const { return key.hash(); }
+};
+
+}  // namespace pcie
+
+template <>
+struct std::hash<pcie::SymbolKey> {
+    size_t operator()(pcie::SymbolKey key) const { return key.hash(); }
+};
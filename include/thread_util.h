@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace pcie {
+
+/**
+ * Thread Helpers
+ * Shared by the stream, reader, dispatch and worker threads.
+ */
+
+// steady_clock in nanoseconds, the time base of host timestamps and stats
+inline uint64_t steady_ns() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Single writer: a plain increment, no locked read-modify-write
+inline void bump(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+/**
+ * Idle Back-off
+ * For polling loops with nothing to do: yields for the first 64 empty
+ * polls, then sleeps 20 us per poll until reset() on the next work.
+ */
+class IdleBackoff {
+public:
+    void reset() { polls_ = 0; }
+
+    void wait() {
+        if (polls_++ < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+    }
+
+private:
+    uint32_t polls_ = 0;
+};
+
+}  // namespace pcie
@@ -0,0 +1,492 @@
+#pragma once
+
+#include "pcie_types.h"
+#include "bbo_generator.h"
+#include "thread_util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+#include <poll.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace pcie {
+
+/**
+ * Shared-Memory Feed Layout
+ * One segment per stream, in this order:
+ *   header   - one page (below)
+ *   BAR      - bar_bytes, the register page
+ *   H2C      - h2c_bytes, a window write_data() copies into at its offset
+ *   C2H ring - ring_bytes (power of two) of wire records
+ *
+ * The C2H ring is single-producer (ShmFeed) single-consumer (the
+ * wrapper): head and tail count bytes ever written and read, each
+ * advanced by its own side only. A producer that sets closed ends the
+ * stream once the ring is empty.
+ */
+struct ShmFeedHeader {
+    static constexpr uint32_t MAGIC = 0x4D484242;   // "BBHM"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t SIZE = 4096;
+
+    uint32_t magic;
+    uint32_t version;
+    uint64_t bar_bytes;
+    uint64_t h2c_bytes;
+    uint64_t ring_bytes;
+    alignas(64) std::atomic<uint64_t> head;      // Producer-owned
+    alignas(64) std::atomic<uint64_t> tail;      // Consumer-owned
+    alignas(64) std::atomic<uint32_t> closed;    // Producer-owned
+};
+
+static_assert(sizeof(ShmFeedHeader) <= ShmFeedHeader::SIZE, "ShmFeedHeader must fit its page");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory ring needs lock-free atomics");
+
+/**
+ * Mapped shared-memory segment (unmapped on destruction)
+ */
+struct ShmSegment {
+    uint8_t* base = nullptr;
+    size_t size = 0;
+
+    ShmFeedHeader* header() const { return reinterpret_cast<ShmFeedHeader*>(base); }
+    uint8_t* bar() const { return base + ShmFeedHeader::SIZE; }
+    uint8_t* h2c() const { return bar() + header()->bar_bytes; }
+    uint8_t* ring() const { return h2c() + header()->h2c_bytes; }
+
+    static size_t total_size(size_t bar_bytes, size_t h2c_bytes, size_t ring_bytes) {
+        return ShmFeedHeader::SIZE + bar_bytes + h2c_bytes + ring_bytes;
+    }
+
+    ShmSegment() = default;
+    ~ShmSegment();
+    ShmSegment(const ShmSegment&) = delete;
+    ShmSegment& operator=(const ShmSegment&) = delete;
+};
+
+/**
+ * C2H Sources
+ * Every source has the same read contract:
+ *   read(buf, len, timeout_ms) -> bytes read (> 0), 0 if nothing arrived
+ *   within timeout_ms (0 = don't wait), -1 on error or end of stream.
+ * A read may end mid-record; callers carry the tail as they do for the
+ * driver.
+ */
+
+/**
+ * File-descriptor source: xdma C2H node, FIFO or regular file
+ */
+class FdSource {
+public:
+    FdSource() = default;
+    explicit FdSource(int fd) : fd_(fd) {}
+    ~FdSource() { close(); }
+
+    FdSource(FdSource&& other) noexcept : fd_(other.fd_) { other.fd_ = -1; }
+    FdSource& operator=(FdSource&& other) noexcept {
+        if (this != &other) {
+            close();
+            fd_ = other.fd_;
+            other.fd_ = -1;
+        }
+        return *this;
+    }
+
+    bool is_open() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+
+    void close() {
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+    }
+
+    ssize_t read(void* buf, size_t len, uint32_t timeout_ms) {
+        struct pollfd pfd;
+        pfd.fd = fd_;
+        pfd.events = POLLIN;
+        int ret = poll(&pfd, 1, static_cast<int>(timeout_ms));
+        if (ret < 0) return errno == EINTR ? 0 : -1;
+        if (ret == 0) return 0;
+
+        ssize_t n = ::read(fd_, buf, len);
+        if (n < 0) return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+        if (n == 0) return -1;  // End of stream
+        return n;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+/**
+ * Shared-memory ring source (consumer side of ShmFeed)
+ */
+class ShmSource {
+public:
+    ShmSource() = default;
+    explicit ShmSource(std::shared_ptr<ShmSegment> segment)
+        : segment_(std::move(segment)),
+          header_(segment_->header()),
+          ring_(segment_->ring()),
+          mask_(header_->ring_bytes - 1) {}
+
+    bool is_open() const { return header_ != nullptr; }
+
+    ssize_t read(void* buf, size_t len, uint32_t timeout_ms) {
+        uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        uint64_t head = header_->head.load(std::memory_order_acquire);
+        if (head == tail) {
+            head = wait(tail, timeout_ms);
+            if (head == tail) {
+                return header_->closed.load(std::memory_order_acquire) ? -1 : 0;
+            }
+        }
+
+        size_t n = std::min<uint64_t>(len, head - tail);
+        size_t offset = tail & mask_;
+        size_t first = std::min<size_t>(n, mask_ + 1 - offset);
+        std::memcpy(buf, ring_ + offset, first);
+        std::memcpy(static_cast<uint8_t*>(buf) + first, ring_, n - first);
+        header_->tail.store(tail + n, std::memory_order_release);
+        return static_cast<ssize_t>(n);
+    }
+
+private:
+    // No descriptor to poll: spin briefly, then back off until data,
+    // the producer closing, or the timeout
+    uint64_t wait(uint64_t tail, uint32_t timeout_ms) const {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        IdleBackoff idle;
+        for (;;) {
+            uint64_t head = header_->head.load(std::memory_order_acquire);
+            if (head != tail || header_->closed.load(std::memory_order_acquire) ||
+                std::chrono::steady_clock::now() >= deadline) {
+                return head;
+            }
+            idle.wait();
+        }
+    }
+
+    std::shared_ptr<ShmSegment> segment_;
+    ShmFeedHeader* header_ = nullptr;
+    const uint8_t* ring_ = nullptr;
+    uint64_t mask_ = 0;
+};
+
+/**
+ * In-process generator source (GeneratorConfig, see BBOGenerator)
+ * With rate 0 every read is filled; otherwise records are released on a
+ * schedule from the first read (a reader that falls behind gets the
+ * backlog at once, so the average holds), and a read waits up to its
+ * timeout for the next one. pool_records replays a pre-encoded pool with
+ * its timestamps moved on each lap, which costs little more than memcpy.
+ */
+class GeneratorSource {
+public:
+    GeneratorSource() = default;
+    GeneratorSource(const GeneratorConfig& config, WireFormat format);
+
+    bool is_open() const { return record_size_ != 0; }
+    uint64_t produced() const { return produced_; }
+
+    ssize_t read(void* buf, size_t len, uint32_t timeout_ms);
+
+private:
+    uint64_t due(uint32_t timeout_ms);
+    void fill(uint8_t* out, size_t count);
+
+    GeneratorConfig config_;
+    WireFormat format_ = WireFormat::BBO36;
+    size_t record_size_ = 0;
+    uint64_t produced_ = 0;
+    std::unique_ptr<BBOGenerator> generator_;
+    std::vector<uint8_t> pool_;
+    size_t pool_next_ = 0;               // Next pool record
+    uint32_t pool_span_ = 0;             // Cycles one lap moves the timestamps on
+    uint32_t pool_offset_ = 0;           // Added to the pool's timestamps this lap
+    std::chrono::steady_clock::time_point start_;
+    bool started_ = false;
+    uint8_t stage_[sizeof(BBOPacket)];   // Record split across reads
+    size_t stage_off_ = 0;
+    size_t stage_len_ = 0;
+};
+
+/**
+ * Fault-injecting wrapper around another source (FaultConfig)
+ * Plays short reads, EINTR / EAGAIN wake-ups, stalls and link-down
+ * outages over the source it wraps, under the same read contract:
+ * EINTR and EAGAIN come back as an early 0 with errno set, as FdSource
+ * reports them, and a link-down read fails with -1 and errno EIO. Data
+ * the wrapped source produced is never dropped or repeated. Stats are
+ * counted per fault class, with the time each took to recover.
+ */
+struct FaultInner;
+
+class FaultSource {
+public:
+    FaultSource();
+    FaultSource(std::unique_ptr<FaultInner> inner, const FaultConfig& config);
+    ~FaultSource();
+
+    FaultSource(FaultSource&&) noexcept;
+    FaultSource& operator=(FaultSource&&) noexcept;
+
+    bool is_open() const;
+    FaultStats stats() const;
+
+    ssize_t read(void* buf, size_t len, uint32_t timeout_ms);
+
+private:
+    struct Counters;
+
+    uint64_t random() {
+        // xorshift64*
+        rng_ ^= rng_ >> 12;
+        rng_ ^= rng_ << 25;
+        rng_ ^= rng_ >> 27;
+        return rng_ * 0x2545F4914F6CDD1DULL;
+    }
+
+    FaultEvent draw();
+    void begin(FaultKind kind, uint64_t clear_ns);
+    void recovered(uint64_t now_ns);
+
+    std::unique_ptr<FaultInner> inner_;
+    FaultConfig config_;
+    uint64_t rng_ = 0;
+    uint64_t reads_ = 0;
+    size_t next_event_ = 0;               // Next schedule entry (sorted by read)
+    FaultKind outage_ = FaultKind::COUNT; // STALL or LINK_DOWN in progress
+    uint64_t outage_end_ns_ = 0;
+    // Faults of each class not yet recovered: count, earliest and summed clear times
+    uint32_t open_[static_cast<size_t>(FaultKind::COUNT)] = {};
+    uint64_t first_clear_ns_[static_cast<size_t>(FaultKind::COUNT)] = {};
+    uint64_t sum_clear_ns_[static_cast<size_t>(FaultKind::COUNT)] = {};
+    uint64_t last_clear_ns_ = 0;
+    std::vector<uint8_t> held_;           // Bytes a short read held back
+    size_t held_off_ = 0;
+    std::unique_ptr<Counters> counters_;
+};
+
+using C2HSource = std::variant<FdSource, ShmSource, GeneratorSource, FaultSource>;
+
+/**
+ * Read from whichever backend the source holds
+ * One jump on the variant index per call; each backend's read is inlined
+ * behind it, so the hot path has no virtual call. Loops that read many
+ * times can std::visit once outside the loop instead.
+ */
+inline ssize_t read_c2h(C2HSource& source, void* buf, size_t len, uint32_t timeout_ms) {
+    return std::visit([&](auto& s) { return s.read(buf, len, timeout_ms); }, source);
+}
+
+inline bool c2h_is_open(const C2HSource& source) {
+    return std::visit([](const auto& s) { return s.is_open(); }, source);
+}
+
+/**
+ * Wrap source in a FaultSource (config.faults, seed + index) when fault
+ * injection is configured; otherwise leave it as it is
+ */
+void wrap_faults(const XDMADeviceConfig& config, size_t index, C2HSource& source);
+
+/**
+ * H2C Sinks
+ * write(data, size, offset) -> PCIeError
+ */
+
+// xdma H2C node or a capture file: written at offset in card memory
+class FdSink {
+public:
+    FdSink() = default;
+    explicit FdSink(int fd) : fd_(fd) {}
+    ~FdSink() { if (fd_ >= 0) ::close(fd_); }
+
+    FdSink(FdSink&& other) noexcept : fd_(other.fd_) { other.fd_ = -1; }
+    FdSink& operator=(FdSink&& other) noexcept {
+        if (this != &other) {
+            if (fd_ >= 0) ::close(fd_);
+            fd_ = other.fd_;
+            other.fd_ = -1;
+        }
+        return *this;
+    }
+
+    PCIeError write(const void* data, size_t size, uint64_t offset) {
+        if (lseek(fd_, static_cast<off_t>(offset), SEEK_SET) < 0) {
+            return PCIeError::WRITE_FAILED;
+        }
+        ssize_t n = ::write(fd_, data, size);
+        if (n < 0 || static_cast<size_t>(n) != size) {
+            return PCIeError::WRITE_FAILED;
+        }
+        return PCIeError::SUCCESS;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+// Shared-memory H2C window: bounds-checked copy at offset
+class MemorySink {
+public:
+    MemorySink() = default;
+    MemorySink(uint8_t* base, size_t size) : base_(base), size_(size) {}
+
+    PCIeError write(const void* data, size_t size, uint64_t offset) {
+        if (offset > size_ || size > size_ - offset) {
+            return PCIeError::INVALID_PARAMETER;
+        }
+        std::memcpy(base_ + offset, data, size);
+        std::atomic_thread_fence(std::memory_order_release);
+        return PCIeError::SUCCESS;
+    }
+
+private:
+    uint8_t* base_ = nullptr;
+    size_t size_ = 0;
+};
+
+// No card memory behind it: writes succeed and are dropped
+class NullSink {
+public:
+    PCIeError write(const void*, size_t, uint64_t) { return PCIeError::SUCCESS; }
+};
+
+using H2CSink = std::variant<NullSink, FdSink, MemorySink>;
+
+/**
+ * Register BAR
+ * Always a plain word array, so register access costs the same load or
+ * store on every backend: the mmapped user node or file, a page of the
+ * shared-memory segment, or emulated memory (STATUS reads running and
+ * link up).
+ */
+class RegisterBar {
+public:
+    RegisterBar() = default;
+    ~RegisterBar() { release(); }
+
+    RegisterBar(const RegisterBar&) = delete;
+    RegisterBar& operator=(const RegisterBar&) = delete;
+
+    PCIeError map(int fd, size_t size);
+    void emulate(size_t size);
+    void borrow(volatile uint32_t* regs, size_t size);
+    void release();
+
+    volatile uint32_t* regs() const { return regs_; }
+    size_t size() const { return size_; }
+
+private:
+    volatile uint32_t* regs_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::unique_ptr<uint32_t[]> emulated_;
+};
+
+/**
+ * Transport
+ * The C2H source, H2C sink and register BAR of one open device, chosen
+ * by XDMADeviceConfig::transport. open() prints the reason for a failure
+ * and leaves nothing open. With config.faults set, open() and
+ * open_channel() wrap each C2H source in a FaultSource.
+ */
+struct Transport {
+    TransportKind kind = TransportKind::XDMA;
+    C2HSource c2h;
+    H2CSink h2c;
+    RegisterBar bar;
+    int events_fd = -1;                    // XDMA only, optional
+    std::shared_ptr<ShmSegment> shm;       // SHM only
+
+    Transport() = default;
+    ~Transport() { close(); }
+    Transport(const Transport&) = delete;
+    Transport& operator=(const Transport&) = delete;
+
+    PCIeError open(const XDMADeviceConfig& config);
+    void close();
+
+    bool is_open() const { return c2h_is_open(c2h) && bar.regs() != nullptr; }
+
+    PCIeError write_h2c(const void* data, size_t size, uint64_t offset) {
+        return std::visit([&](auto& s) { return s.write(data, size, offset); }, h2c);
+    }
+
+    /**
+     * Open another C2H stream of the same kind (multi-channel streaming)
+     * @param path Device node or file (XDMA, FILE), segment name (SHM);
+     *             GENERATOR ignores it and seeds channel index apart
+     */
+    static PCIeError open_channel(const XDMADeviceConfig& config, const std::string& path,
+                                  size_t index, C2HSource& out);
+
+    // Name an extra channel is matched against to reuse c2h (channel 0)
+    static const std::string& primary_channel(const XDMADeviceConfig& config) {
+        return config.transport == TransportKind::SHM ? config.shm_name : config.c2h_path;
+    }
+};
+
+/**
+ * Shared-Memory Feed (producer side)
+ * Creates the segment a TransportKind::SHM wrapper opens, and plays the
+ * card: writes wire records into the C2H ring, owns the register page
+ * and sees what the host writes to H2C. For simulators and replay tools
+ * in another process, or a thread of the same one.
+ */
+class ShmFeed {
+public:
+    ShmFeed() = default;
+    ~ShmFeed() { destroy(); }
+
+    ShmFeed(const ShmFeed&) = delete;
+    ShmFeed& operator=(const ShmFeed&) = delete;
+
+    /**
+     * Create (or replace) the named segment
+     * @param name POSIX shm name, e.g. "/bbo_feed"
+     * @param ring_bytes C2H ring size, rounded up to a power of two
+     * @return OPEN_FAILED or MMAP_FAILED on failure
+     */
+    PCIeError create(const std::string& name, size_t ring_bytes = 1 << 20,
+                     size_t bar_bytes = 4096, size_t h2c_bytes = 65536);
+
+    /**
+     * Unmap and unlink the segment
+     */
+    void destroy();
+
+    /**
+     * Append to the C2H ring, all or nothing so records are never torn
+     * @param timeout_ms Wait for room (0 = don't wait)
+     * @return false if there was no room in time
+     */
+    bool write(const void* data, size_t size, uint32_t timeout_ms = 0);
+
+    /**
+     * End the stream: the reader sees end of stream once it drains
+     */
+    void close_stream();
+
+    size_t pending() const;
+    volatile uint32_t* registers() const;
+    const uint8_t* h2c() const;
+    const std::string& name() const { return name_; }
+
+private:
+    std::string name_;
+    std::unique_ptr<ShmSegment> segment_;
+};
+
+}  // namespace pcie
@@ -0,0 +1,260 @@
+#pragma once
+
+#include "numa_placement.h"
+#include "pcie_types.h"
+#include "thread_util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pcie {
+
+struct WorkStealingConfig {
+    uint32_t workers = 4;
+    size_t batch_records = 64;       // Records per task
+    size_t max_pending = 256;        // Tasks queued before submit() waits
+    std::vector<int> cpus;           // Worker i pinned to cpus[i % size]; empty = not pinned
+};
+
+/**
+ * Work-Stealing Statistics
+ */
+struct WorkerStats {
+    uint64_t tasks = 0;        // Tasks run (own and stolen)
+    uint64_t records = 0;
+    uint64_t steals = 0;       // Tasks taken from another worker's queue
+    uint64_t busy_ns = 0;      // Time inside the handler
+    double utilisation = 0.0;  // busy_ns / time since the executor started
+};
+
+struct WorkStealingStats {
+    std::vector<WorkerStats> workers;
+    uint64_t submitted = 0;    // Tasks
+    uint64_t elapsed_ns = 0;
+};
+
+/**
+ * Work-Stealing Executor
+ * For handlers that need no ordering but cost very different amounts
+ * per record. The producer packages records into batches (tasks) and
+ * deals them round-robin onto per-worker queues. A worker runs its own
+ * queue oldest first; once empty it steals the newest task from the
+ * longest other queue, so a burst of expensive batches on one worker is
+ * spread over the idle ones instead of queueing behind it.
+ *
+ * Tasks are whole batches, so each queue is a short mutex-guarded deque
+ * touched once per batch; the producer feeds every queue, which rules
+ * out an owner-only lock-free deque. Batch buffers are recycled, and at
+ * most max_pending tasks are queued before submit() back-pressures the
+ * producer.
+ *
+ * One producer thread calls acquire()/submit()/flush().
+ */
+class WorkStealingExecutor {
+public:
+    using Handler = std::function<void(uint32_t worker, const BBORecord* records, size_t count)>;
+
+    WorkStealingExecutor(const WorkStealingConfig& config, Handler handler)
+        : handler_(std::move(handler)),
+          batch_records_(std::max<size_t>(config.batch_records, 1)),
+          max_pending_(std::max<size_t>(config.max_pending, 1)),
+          start_ns_(steady_ns()) {
+        uint32_t n = std::max<uint32_t>(config.workers, 1);
+        for (uint32_t i = 0; i < n; i++) {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            int cpu = config.cpus.empty() ? -1 : config.cpus[i % config.cpus.size()];
+            workers_[i]->thread = std::thread([this, i, cpu]() { run(i, cpu); });
+        }
+    }
+
+    ~WorkStealingExecutor() { stop(); }
+
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+    uint32_t workers() const { return static_cast<uint32_t>(workers_.size()); }
+    size_t batch_records() const { return batch_records_; }
+
+    /**
+     * Empty batch buffer with room for batch_records (recycled)
+     */
+    std::vector<BBORecord> acquire() {
+        std::vector<BBORecord> batch;
+        {
+            std::lock_guard<std::mutex> lock(spare_mutex_);
+            if (!spare_.empty()) {
+                batch = std::move(spare_.back());
+                spare_.pop_back();
+            }
+        }
+        batch.clear();
+        batch.reserve(batch_records_);
+        return batch;
+    }
+
+    /**
+     * Queue a batch; waits while max_pending tasks are queued
+     */
+    void submit(std::vector<BBORecord>&& batch) {
+        if (batch.empty()) {
+            recycle(std::move(batch));
+            return;
+        }
+        while (pending_.load(std::memory_order_acquire) >= static_cast<int64_t>(max_pending_)) {
+            std::this_thread::yield();
+        }
+        pending_.fetch_add(1, std::memory_order_acq_rel);
+
+        Worker& w = *workers_[next_];
+        next_ = (next_ + 1) % workers_.size();
+        {
+            std::lock_guard<std::mutex> lock(w.mutex);
+            w.queue.push_back(std::move(batch));
+            w.depth.store(w.queue.size(), std::memory_order_relaxed);
+        }
+        bump(submitted_);
+    }
+
+    /**
+     * Wait until every submitted task has run
+     */
+    void flush() {
+        while (pending_.load(std::memory_order_acquire) > 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * Run what is queued, then join the workers
+     */
+    void stop() {
+        if (stopping_.exchange(true)) return;
+        for (auto& w : workers_) {
+            if (w->thread.joinable()) w->thread.join();
+        }
+    }
+
+    // Any thread
+    WorkStealingStats stats() const {
+        WorkStealingStats out;
+        out.elapsed_ns = steady_ns() - start_ns_;
+        for (const auto& w : workers_) {
+            WorkerStats st;
+            st.tasks = w->tasks.load(std::memory_order_relaxed);
+            st.records = w->records.load(std::memory_order_relaxed);
+            st.steals = w->steals.load(std::memory_order_relaxed);
+            st.busy_ns = w->busy_ns.load(std::memory_order_relaxed);
+            st.utilisation = out.elapsed_ns > 0
+                ? static_cast<double>(st.busy_ns) / static_cast<double>(out.elapsed_ns) : 0.0;
+            out.workers.push_back(st);
+        }
+        out.submitted = submitted_.load(std::memory_order_relaxed);
+        return out;
+    }
+
+private:
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::deque<std::vector<BBORecord>> queue;   // guarded by mutex
+        std::atomic<size_t> depth{0};               // queue.size(), read unlocked by thieves
+        std::thread thread;
+
+        // Worker-owned
+        std::atomic<uint64_t> tasks{0};
+        std::atomic<uint64_t> records{0};
+        std::atomic<uint64_t> steals{0};
+        std::atomic<uint64_t> busy_ns{0};
+    };
+
+    // Own queue: oldest first
+    bool pop_local(Worker& w, std::vector<BBORecord>& task) {
+        if (w.depth.load(std::memory_order_relaxed) == 0) return false;
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (w.queue.empty()) return false;
+        task = std::move(w.queue.front());
+        w.queue.pop_front();
+        w.depth.store(w.queue.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+    // Longest other queue, newest task (the one its owner would reach last)
+    bool steal(uint32_t self, std::vector<BBORecord>& task) {
+        size_t n = workers_.size();
+        Worker* victim = nullptr;
+        size_t deepest = 0;
+        for (size_t k = 1; k < n; k++) {
+            Worker& w = *workers_[(self + k) % n];
+            size_t depth = w.depth.load(std::memory_order_relaxed);
+            if (depth > deepest) {
+                deepest = depth;
+                victim = &w;
+            }
+        }
+        if (!victim) return false;
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if (victim->queue.empty()) return false;
+        task = std::move(victim->queue.back());
+        victim->queue.pop_back();
+        victim->depth.store(victim->queue.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+    void recycle(std::vector<BBORecord>&& batch) {
+        std::lock_guard<std::mutex> lock(spare_mutex_);
+        if (spare_.size() < max_pending_ + workers_.size()) spare_.push_back(std::move(batch));
+    }
+
+    void run(uint32_t index, int cpu) {
+        if (cpu >= 0) pin_current_thread({cpu});
+        Worker& w = *workers_[index];
+        std::vector<BBORecord> task;
+        IdleBackoff idle;
+
+        for (;;) {
+            bool own = pop_local(w, task);
+            if (own || steal(index, task)) {
+                uint64_t t0 = steady_ns();
+                if (handler_) handler_(index, task.data(), task.size());
+                bump(w.busy_ns, steady_ns() - t0);
+                bump(w.tasks);
+                bump(w.records, task.size());
+                if (!own) bump(w.steals);
+                recycle(std::move(task));
+                task = std::vector<BBORecord>();
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+                idle.reset();
+                continue;
+            }
+            // stop() drains: only leave once nothing is queued anywhere
+            if (stopping_.load(std::memory_order_acquire) &&
+                pending_.load(std::memory_order_acquire) == 0) {
+                break;
+            }
+            idle.wait();
+        }
+    }
+
+    Handler handler_;
+    size_t batch_records_;
+    size_t max_pending_;
+    uint64_t start_ns_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    size_t next_ = 0;                           // Producer-owned
+    std::atomic<int64_t> pending_{0};           // Queued or running
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<bool> stopping_{false};
+    std::mutex spare_mutex_;
+    std::vector<std::vector<BBORecord>> spare_;  // guarded by spare_mutex_
+};
+
+}  // namespace pcie
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "xdma_wrapper.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pcie {
+
+/**
+ * Pool Device State
+ */
+enum class PoolDeviceState : uint8_t {
+    CLOSED,      // Not open
+    UP,          // Open, link up, being read while streaming
+    LINK_DOWN,   // STATUS_LINK_UP clear: reads suspended until it returns
+    FAILED       // Open or read failed, or C2H ended: reopened every reopen_ms
+};
+
+inline const char* pool_device_state_string(PoolDeviceState state) {
+    switch (state) {
+        case PoolDeviceState::CLOSED: return "closed";
+        case PoolDeviceState::UP: return "up";
+        case PoolDeviceState::LINK_DOWN: return "link down";
+        case PoolDeviceState::FAILED: return "failed";
+        default: return "unknown";
+    }
+}
+
+struct DevicePoolConfig {
+    size_t ring_capacity = 4096;     // Records buffered per device
+    size_t batch_records = 64;       // Records per C2H read
+    uint32_t link_check_ms = 100;    // STATUS_LINK_UP poll period per device
+    uint32_t reopen_ms = 1000;       // Retry period for a failed device, 0 = never
+};
+
+/**
+ * Per-Device Health
+ */
+struct PoolDeviceHealth {
+    uint32_t device = 0;             // Index in the pool, as passed to the callback
+    std::string name;                // PCI slot, or the C2H node without one
+    PoolDeviceState state = PoolDeviceState::CLOSED;
+    PCIeError last_error = PCIeError::SUCCESS;
+    uint64_t records = 0;            // Records read from the card
+    uint64_t reads = 0;              // C2H reads that returned data
+    uint64_t ring_full = 0;          // Times the reader waited for the dispatcher
+    uint64_t failures = 0;           // Times the device left UP
+    uint64_t reopens = 0;            // Successful reopens after a failure
+    uint64_t idle_ms = UINT64_MAX;   // Since the last record (UINT64_MAX = none yet)
+};
+
+struct DevicePoolStats {
+    std::vector<PoolDeviceHealth> devices;
+    uint64_t delivered = 0;          // Records handed to the callback
+    size_t up = 0;                   // Devices currently UP
+};
+
+/**
+ * XDMA Device Pool
+ * Drives several cards from one process. open() takes every device
+ * XDMADeviceDiscovery enumerates (or an explicit config list), each
+ * opened as its own XDMAWrapper with its own cache and NUMA placement.
+ *
+ * While streaming, every device has a reader thread, pinned to that
+ * card's CPUs, doing bulk read_records() into a per-device SPSC ring.
+ * One dispatch thread takes records round-robin off the rings and calls
+ * the callback with the device index, so callbacks never run
+ * concurrently. Cards run on separate clocks, so records are not ordered
+ * across devices, and nothing waits on a quiet or failed card: a device
+ * whose link drops, whose read fails or whose C2H ends only empties its
+ * own ring. Failed devices are closed and reopened every reopen_ms; a
+ * reopened device starts with a fresh cache (or its snapshot).
+ *
+ * Usage:
+ *   XDMADevicePool pool;
+ *   if (pool.open() != PCIeError::SUCCESS) {
+ *       // No card could be opened
+ *   }
+ *   pool.start_streaming([](uint32_t device, const BBORecord& rec) {
+ *       printf("card %u: %s\n", device, std::string(rec.symbol.view()).c_str());
+ *   });
+ */
+class XDMADevicePool {
+public:
+    using RecordCallback = std::function<void(uint32_t device, const BBORecord&)>;
+
+    XDMADevicePool();
+    ~XDMADevicePool();
+
+    XDMADevicePool(const XDMADevicePool&) = delete;
+    XDMADevicePool& operator=(const XDMADevicePool&) = delete;
+
+    /**
+     * Open every enumerated device
+     * Paths come from discovery; everything else from base. A snapshot
+     * path gets a ".<index>" suffix per device.
+     * @return DEVICE_NOT_FOUND if nothing was enumerated, OPEN_FAILED if
+     *         no device opened; devices that fail are kept and retried
+     */
+    PCIeError open();
+    PCIeError open_enumerated(const XDMADeviceConfig& base);
+
+    /**
+     * Open one device per config (device index = position in the list)
+     */
+    PCIeError open(const std::vector<XDMADeviceConfig>& configs);
+
+    void close();
+
+    size_t size() const;
+
+    /**
+     * Direct access for register work (filters, enable, reset)
+     * Not while streaming: the reader owns the C2H channel and may reopen
+     * the device underneath.
+     */
+    XDMAWrapper& device(uint32_t index);
+
+    /**
+     * Unified Stream
+     * @return DEVICE_NOT_FOUND before open(), BUSY if already streaming
+     */
+    PCIeError start_streaming(RecordCallback callback,
+                              const DevicePoolConfig& config = DevicePoolConfig());
+    void stop_streaming();
+    bool is_streaming() const;
+
+    /**
+     * Latest BBO of a symbol on one card
+     * Safe from any thread while streaming, including across a reopen.
+     */
+    bool get_latest(uint32_t device, SymbolKey symbol, BBOQuote& quote) const;
+
+    /**
+     * Health and Statistics
+     * Safe from any thread while streaming.
+     */
+    PoolDeviceHealth get_health(uint32_t device) const;
+    DevicePoolStats get_stats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> pImpl;
+};
+
+}  // namespace pcie
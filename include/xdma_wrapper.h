@@ -1,9 +1,19 @@
 #pragma once
 
 #include "pcie_types.h"
+#include "bbo_cache.h"
+#include "bbo_columns.h"
+#include "channel_merge.h"
+#include "conflation_buffer.h"
+#include "dedup_filter.h"
+#include "numa_placement.h"
+#include "quote_analytics.h"
+#include "sharded_dispatch.h"
+#include "work_stealing.h"
 #include <string>
 #include <memory>
 #include <functional>
+#include <future>
 #include <atomic>
 #include <thread>
 #include <vector>
@@ -38,6 +48,10 @@ namespace pcie {
 class XDMAWrapper {
 public:
     using BBOCallback = std::function<void(const BBOData&)>;
+    using AnalyticsCallback = std::function<void(const BBOData&, const DerivedQuote&)>;
+    using ChannelCallback = std::function<void(uint32_t channel, const BBORecord&)>;
+    using ShardCallback = ShardedDispatcher::Handler;
+    using BatchCallback = WorkStealingExecutor::Handler;
 
     XDMAWrapper();
     ~XDMAWrapper();
@@ -52,9 +66,15 @@ public:
 
     /**
      * Open XDMA device files
+     * config.transport picks the backend here, once: the driver nodes, a
+     * file or FIFO, a shared-memory feed or the in-process generator (see
+     * transport.h). Everything above it behaves the same on each; reads
+     * reach the backend through a variant, never a virtual call.
+     * @param config Node paths (default: /dev/xdma0_*) and transport
      * @return PCIeError::SUCCESS on success
      */
     PCIeError open();
+    PCIeError open(const XDMADeviceConfig& config);
 
     /**
      * Close all device files
@@ -69,9 +89,12 @@ public:
 
     /**
      * Read a single BBO update from C2H channel
+     * A record a short read leaves incomplete is kept and completed by
+     * the next call.
      * @param bbo Output BBO data structure
      * @param timeout_ms Timeout in milliseconds (0 = non-blocking)
-     * @return PCIeError::SUCCESS on success
+     * @return PCIeError::SUCCESS on success, TIMEOUT when no whole record
+     *         arrived, READ_FAILED on error or end of stream
      */
     PCIeError read_bbo(BBOData& bbo, uint32_t timeout_ms = 1000);
 
@@ -80,10 +103,34 @@ public:
      * @param bbos Output vector of BBO data
      * @param max_count Maximum number of BBOs to read
      * @param timeout_ms Timeout in milliseconds
-     * @return Number of BBOs read, -1 on error
+     * @return Number of BBOs read, -1 on error (after any records read
+     *         before it have been returned)
      */
     int read_bbos(std::vector<BBOData>& bbos, size_t max_count, uint32_t timeout_ms = 1000);
 
+    /**
+     * Bulk read and decode into native records
+     * One read() of up to max_count records in the configured wire format,
+     * decoded in a single batch pass (best SIMD kernel for the CPU). A
+     * trailing partial record is kept and completed by the next call, so
+     * do not interleave with read_bbo() on the same channel.
+     * @param out Output records (at least max_count)
+     * @param max_count Maximum number of records to read
+     * @param timeout_ms Timeout in milliseconds (0 = don't wait)
+     * @return Number of records decoded (0 on timeout), -1 on error or
+     *         end of stream
+     */
+    int read_records(BBORecord* out, size_t max_count, uint32_t timeout_ms = 1000);
+
+    /**
+     * Bulk read into a columnar batch
+     * Same read and decode as read_records(), transposed onto the end of
+     * cols (not cleared, so several reads can build one batch).
+     * @return Number of records appended (0 on timeout), -1 on error or
+     *         end of stream
+     */
+    int read_columns(BBOColumns& cols, size_t max_count, uint32_t timeout_ms = 1000);
+
     /**
      * Write data to H2C channel
      * @param data Pointer to data buffer
@@ -97,18 +144,34 @@ public:
      * Control Register Access
      */
     PCIeError set_enabled(bool enable);
-    PCIeError reset();
     bool get_enabled() const;
     uint32_t get_status() const;
     uint32_t get_bbo_count() const;
     uint32_t get_version() const;
 
+    /**
+     * Reset Sequence
+     * Pauses dispatch, drains C2H to a record boundary (at most 256KB),
+     * pulses CTRL_RESET, polls until the core is back up, restores filters
+     * and enable state, then resumes dispatch. reset() blocks until the
+     * sequence completes; reset_async() runs it on a helper thread. Keep the
+     * returned future: destroying it waits for the sequence to finish.
+     * @param timeout_ms Bound on each wait within the sequence
+     */
+    PCIeError reset();
+    [[nodiscard]] std::future<ResetReport> reset_async(uint32_t timeout_ms = 100);
+    ResetReport get_last_reset_report() const;
+
     /**
      * Symbol Filter Configuration
+     * Slots 6 and 7 overlap the timestamp and latency registers (see
+     * ControlRegisters); reset() restores slots 0-5 and the last word of 7.
      * @param index Filter slot (0-7)
      * @param symbol 8-character symbol (space-padded)
      */
+    PCIeError set_symbol_filter(uint32_t index, SymbolKey symbol);
     PCIeError set_symbol_filter(uint32_t index, const std::string& symbol);
+    SymbolKey get_symbol_filter_key(uint32_t index) const;
     std::string get_symbol_filter(uint32_t index) const;
 
     /**
@@ -121,15 +184,149 @@ public:
     /**
      * Streaming Mode
      * Starts background thread that calls callback for each BBO
+     * Failed reads are retried with back-off (config.read_retry_max_ms) in
+     * every stream mode; streaming stops at end of stream, or once reads
+     * have failed for config.read_error_limit_ms.
      */
     PCIeError start_streaming(BBOCallback callback);
     void stop_streaming();
     bool is_streaming() const;
 
+    /**
+     * Conflated Delivery
+     * Alternative to start_streaming() for consumers that fall behind.
+     * Updates are coalesced per symbol; drain_conflated() returns the
+     * newest BBO of each dirty symbol, oldest-dirtied first. Memory stays
+     * bounded by max_symbols however long the burst. Each start replaces
+     * the buffer; a drain_conflated() already waiting on the old one
+     * returns from it at its timeout.
+     * Stop with stop_streaming().
+     */
+    PCIeError start_conflated_streaming();
+    size_t drain_conflated(std::vector<BBOData>& bbos, size_t max_count, uint32_t timeout_ms = 0);
+    ConflationStats get_conflation_stats() const;
+
+    /**
+     * Streaming with Derived Quotes
+     * Like start_streaming(), but each BBO arrives with its DerivedQuote
+     * (mid, microprice, spread bps, imbalance, per-symbol EWMAs) computed
+     * once on the stream thread. EWMA state starts fresh each session.
+     * Stop with stop_streaming().
+     */
+    PCIeError start_analytics_streaming(AnalyticsCallback callback,
+                                        const QuoteAnalyticsConfig& config = QuoteAnalyticsConfig());
+
+    /**
+     * Multi-Channel Streaming
+     * Reads every node in config.c2h_channels (c2h_path when empty;
+     * segment names for the shared-memory transport), each on its own
+     * reader thread with its own buffer and SPSC ring, decoding
+     * config.wire_format. One dispatch thread takes records off the rings
+     * in extended-T4 order across channels (MergeOrder::TIMESTAMP) or as
+     * each channel delivers them (PER_CHANNEL), updates the cache, applies
+     * dedup and calls the callback, so callbacks never run concurrently.
+     * Streaming ends when stopped or when every channel has ended.
+     * Stop with stop_streaming().
+     * @return OPEN_FAILED if a channel node cannot be opened
+     */
+    PCIeError start_multichannel_streaming(ChannelCallback callback,
+                                           const MultiChannelConfig& config = MultiChannelConfig());
+    MultiChannelStats get_multichannel_stats() const;
+
+    /**
+     * Symbol-Sharded Streaming
+     * For handlers too heavy for one thread. The stream thread bulk-reads
+     * records (read_records()), updates the cache, applies dedup and hands
+     * each record to one of config.workers threads chosen by symbol hash,
+     * so every symbol keeps its FIFO order while different symbols are
+     * handled in parallel. The callback receives the worker index and runs
+     * concurrently across workers. Workers are pinned to config.cpus, or
+     * to the NUMA placement's CPUs when that is empty. Queued records are
+     * handled before stop_streaming() returns and before a reset pauses.
+     * Stop with stop_streaming().
+     */
+    PCIeError start_sharded_streaming(ShardCallback callback,
+                                      const ShardedDispatchConfig& config = ShardedDispatchConfig());
+    ShardedDispatchStats get_sharded_stats() const;
+
+    /**
+     * Parallel Streaming (work stealing)
+     * For order-independent handlers with uneven cost per record. The
+     * stream thread bulk-reads up to config.batch_records at a time,
+     * updates the cache, applies dedup and submits each read as one task;
+     * idle workers steal queued tasks from busy ones. The callback gets a
+     * batch and the worker index, runs concurrently across workers, and
+     * sees records in no particular order across batches. Workers are
+     * pinned like sharded workers. Queued tasks run before
+     * stop_streaming() returns and before a reset pauses.
+     * Stop with stop_streaming().
+     */
+    PCIeError start_parallel_streaming(BatchCallback callback,
+                                       const WorkStealingConfig& config = WorkStealingConfig());
+    WorkStealingStats get_parallel_stats() const;
+
+    /**
+     * No-Change Suppression
+     * When enabled, the stream thread drops records that leave the
+     * selected fields of their symbol unchanged, before any callback,
+     * conflation or analytics sees them. Set while not streaming; the
+     * filter's state lives until it is replaced or disabled.
+     * @return BUSY while streaming
+     */
+    PCIeError set_dedup(const DedupConfig& config);
+    PCIeError disable_dedup();
+    DedupStats get_dedup_stats() const;
+
+    /**
+     * Latest BBO per Symbol
+     * Kept up to date from every record read. Lock-free and safe to call
+     * from any thread while streaming, and across close() and a reopen:
+     * open() clears the cache in place, or with a different max_symbols
+     * installs a new one, and neither is freed before the wrapper.
+     * get_cache() therefore stays valid for the wrapper's lifetime, but
+     * may not be the current cache after a reopen with a new max_symbols.
+     * @return false if the symbol has not been seen since open()
+     */
+    bool get_latest(SymbolKey symbol, BBOQuote& quote) const;
+    const BBOCache* get_cache() const;
+
+    /**
+     * Book Snapshot
+     * With config.snapshot_path set, open() warm-starts the cache from the
+     * last checkpoint (entries read as stale until a live record replaces
+     * them), a background thread checkpoints every snapshot_interval_ms,
+     * and close() writes a final one.
+     * @return INVALID_PARAMETER if no snapshot file is open
+     */
+    PCIeError checkpoint();
+    uint64_t get_snapshot_generation() const;
+
+    /**
+     * NUMA Placement
+     * Decided in open() from the card's numa_node / local_cpulist and the
+     * config: per-symbol tables, read buffers and rings are allocated on
+     * the chosen node and streaming threads are pinned to its CPUs. A
+     * config that points away from the card is honoured, flagged remote
+     * and warned about.
+     */
+    NumaPlacement get_numa_placement() const;
+
     /**
      * Statistics
+     * fifo_overflows counts STATUS_FIFO_FULL going up, sampled every
+     * config.status_poll_ms by read_bbo()/read_records(), every stream
+     * mode built on them (start_streaming(), conflated, analytics,
+     * sharded, parallel) and the dispatch thread of
+     * start_multichannel_streaming().
      */
     TransferStats get_stats() const;
+
+    /**
+     * Faults injected by config.faults and how long reads took to recover
+     * from each class, summed over the C2H source and every channel
+     * (all zero when fault injection is off)
+     */
+    FaultStats get_fault_stats() const;
     void reset_stats();
 
     /**
@@ -146,17 +343,53 @@ private:
 /**
  * XDMA Device Discovery
  * Find available XDMA devices in the system
+ *
+ * Reads /sys/bus/pci/devices: every function bound to the xdma driver or
+ * with xdma nodes under it is reported with its negotiated and advertised
+ * link, NUMA placement, BAR sizes and the /dev/xdmaN_* nodes the driver
+ * made for it. A Xilinx vendor ID alone does not qualify. Nodes found in /dev with no sysfs entry (containers without
+ * /sys) are still listed, with the PCI fields left empty.
  */
 class XDMADeviceDiscovery {
 public:
+    static constexpr uint16_t XILINX_VENDOR_ID = 0x10EE;
+    static constexpr size_t NUM_BARS = 6;
+
     struct DeviceInfo {
         std::string device_path;    // e.g., "/dev/xdma0"
-        uint16_t vendor_id;
-        uint16_t device_id;
+        uint16_t vendor_id = 0;
+        uint16_t device_id = 0;
+        uint16_t subsystem_vendor_id = 0;
+        uint16_t subsystem_device_id = 0;
         std::string pci_slot;       // e.g., "0000:01:00.0"
-        bool link_up;
-        uint8_t link_width;         // x1, x4, x8, x16
-        uint8_t link_speed;         // 1=Gen1, 2=Gen2, 3=Gen3
+        std::string driver;         // Bound kernel driver, empty if none
+        bool link_up = false;
+        uint8_t link_width = 0;     // Negotiated: x1, x4, x8, x16
+        uint8_t link_speed = 0;     // Negotiated: 1=Gen1, 2=Gen2, 3=Gen3 ...
+        uint8_t max_link_width = 0; // Advertised by the device
+        uint8_t max_link_speed = 0;
+        int numa_node = -1;         // -1 = platform reports no affinity
+        std::string local_cpus;     // CPU list local to the slot, e.g. "0-7,16-23"
+        uint64_t bar_size[NUM_BARS] = {};  // Bytes, 0 = BAR unused
+
+        // Character devices created by the driver, channels in index order
+        std::string user_path;
+        std::string control_path;
+        std::vector<std::string> c2h_paths;
+        std::vector<std::string> h2c_paths;
+        std::vector<std::string> events_paths;
+
+        // Trained below what the device advertises (slot, riser, signal integrity)
+        bool link_degraded() const {
+            return link_up && (link_width < max_link_width || link_speed < max_link_speed);
+        }
+
+        /**
+         * Open configuration for one DMA channel of this device
+         * Paths of absent nodes are left empty, so open() fails with
+         * OPEN_FAILED rather than opening another card's /dev/xdma0_*.
+         */
+        XDMADeviceConfig config(size_t channel = 0) const;
     };
 
     /**
@@ -165,6 +398,20 @@ public:
      */
     static std::vector<DeviceInfo> enumerate_devices();
 
+    /**
+     * Enumerate against another tree (a fake sysfs in tests)
+     * @param pci_root Directory laid out like /sys/bus/pci/devices
+     * @param dev_root Directory holding the xdma character devices
+     */
+    static std::vector<DeviceInfo> enumerate_devices(const std::string& pci_root,
+                                                     const std::string& dev_root);
+
+    /**
+     * PCIe generation from a sysfs link speed ("8.0 GT/s PCIe")
+     * @return 0 if unknown
+     */
+    static uint8_t link_speed_gen(const std::string& speed);
+
     /**
      * Check if XDMA driver is loaded
      */
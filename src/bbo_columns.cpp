@@ -0,0 +1,216 @@
+#include "bbo_columns.h"
+
+#include <algorithm>
+
+namespace pcie {
+
+namespace {
+
+// Column kernels are cloned for AVX2 and baseline x86-64; the loader picks
+// one per process, so the same binary runs on any host. The dynamic cost
+// model lets -O2 vectorise these loops (its default model skips them).
+
+__attribute__((target_clones("avx2", "default"), optimize("vect-cost-model=dynamic")))
+void reduce_u32(const uint32_t* __restrict v, size_t n,
+                uint32_t* min_out, uint32_t* max_out, uint64_t* sum_out) {
+    uint32_t lo = UINT32_MAX;
+    uint32_t hi = 0;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        lo = std::min(lo, v[i]);
+        hi = std::max(hi, v[i]);
+        sum += v[i];
+    }
+    *min_out = lo;
+    *max_out = hi;
+    *sum_out = sum;
+}
+
+__attribute__((target_clones("avx2", "default"), optimize("vect-cost-model=dynamic")))
+void diff_u32(const uint32_t* __restrict a, const uint32_t* __restrict b,
+              uint32_t* __restrict out, size_t n) {
+    // Unsigned subtraction handles counter wraparound
+    for (size_t i = 0; i < n; i++) {
+        out[i] = b[i] - a[i];
+    }
+}
+
+}  // namespace
+
+void BBOColumns::clear() {
+    symbol.clear();
+    bid_price.clear();
+    bid_size.clear();
+    ask_price.clear();
+    ask_size.clear();
+    spread.clear();
+    ts_t1.clear();
+    ts_t2.clear();
+    ts_t3.clear();
+    ts_t4.clear();
+    flags.clear();
+}
+
+void BBOColumns::reserve(size_t count) {
+    symbol.reserve(count);
+    bid_price.reserve(count);
+    bid_size.reserve(count);
+    ask_price.reserve(count);
+    ask_size.reserve(count);
+    spread.reserve(count);
+    ts_t1.reserve(count);
+    ts_t2.reserve(count);
+    ts_t3.reserve(count);
+    ts_t4.reserve(count);
+    flags.reserve(count);
+}
+
+void BBOColumns::append(const BBORecord* records, size_t count) {
+    size_t base = size();
+    size_t total = base + count;
+
+    // resize() once per column, then plain indexed stores
+    symbol.resize(total);
+    bid_price.resize(total);
+    bid_size.resize(total);
+    ask_price.resize(total);
+    ask_size.resize(total);
+    spread.resize(total);
+    ts_t1.resize(total);
+    ts_t2.resize(total);
+    ts_t3.resize(total);
+    ts_t4.resize(total);
+    flags.resize(total);
+
+    for (size_t i = 0; i < count; i++) {
+        const BBORecord& r = records[i];
+        size_t j = base + i;
+        symbol[j] = r.symbol.raw();
+        bid_price[j] = r.bid_price;
+        bid_size[j] = r.bid_size;
+        ask_price[j] = r.ask_price;
+        ask_size[j] = r.ask_size;
+        spread[j] = r.spread;
+        ts_t1[j] = r.ts_t1;
+        ts_t2[j] = r.ts_t2;
+        ts_t3[j] = r.ts_t3;
+        ts_t4[j] = r.ts_t4;
+        flags[j] = r.flags;
+    }
+}
+
+BBORecord BBOColumns::record(size_t i) const {
+    BBORecord r;
+    r.symbol = SymbolKey::from_raw(symbol[i]);
+    r.bid_price = bid_price[i];
+    r.bid_size = bid_size[i];
+    r.ask_price = ask_price[i];
+    r.ask_size = ask_size[i];
+    r.spread = spread[i];
+    r.ts_t1 = ts_t1[i];
+    r.ts_t2 = ts_t2[i];
+    r.ts_t3 = ts_t3[i];
+    r.ts_t4 = ts_t4[i];
+    r.flags = flags[i];
+    return r;
+}
+
+SpreadSummary summarize_spreads(const BBOColumns& cols) {
+    SpreadSummary s;
+    s.count = cols.size();
+    if (s.count == 0) return s;
+
+    uint32_t lo, hi;
+    uint64_t sum;
+    reduce_u32(cols.spread.data(), s.count, &lo, &hi, &sum);
+
+    s.min = Price4::from_raw(lo);
+    s.max = Price4::from_raw(hi);
+    s.mean = static_cast<double>(sum) / static_cast<double>(s.count) / Price4::SCALE;
+    return s;
+}
+
+void latency_cycles(const BBOColumns& cols, uint32_t* out) {
+    diff_u32(cols.ts_t1.data(), cols.ts_t4.data(), out, cols.size());
+}
+
+LatencySummary summarize_latency(const BBOColumns& cols) {
+    std::vector<uint32_t> cycles;
+    return summarize_latency(cols, cycles);
+}
+
+LatencySummary summarize_latency(const BBOColumns& cols, std::vector<uint32_t>& cycles) {
+    LatencySummary s;
+    s.count = cols.size();
+    if (s.count == 0) return s;
+
+    cycles.resize(s.count);
+    latency_cycles(cols, cycles.data());
+
+    uint32_t lo, hi;
+    uint64_t sum;
+    reduce_u32(cycles.data(), s.count, &lo, &hi, &sum);
+    s.min = lo;
+    s.max = hi;
+    s.mean = static_cast<double>(sum) / static_cast<double>(s.count);
+
+    // Ascending ranks, so each selection only partitions what is left
+    auto select = [&](double p, size_t from) {
+        size_t rank = std::min(static_cast<size_t>(p / 100.0 * static_cast<double>(s.count)),
+                               s.count - 1);
+        rank = std::max(rank, from);
+        std::nth_element(cycles.begin() + from, cycles.begin() + rank, cycles.end());
+        return rank;
+    };
+    size_t r = select(50.0, 0);
+    s.p50 = cycles[r];
+    r = select(90.0, r);
+    s.p90 = cycles[r];
+    r = select(99.0, r);
+    s.p99 = cycles[r];
+    r = select(99.9, r);
+    s.p999 = cycles[r];
+    return s;
+}
+
+size_t group_by_symbol(const BBOColumns& cols, std::vector<SymbolGroup>& groups,
+                       std::vector<uint32_t>* group_of_row, size_t max_symbols) {
+    SymbolIndex index(max_symbols);
+    return group_by_symbol(cols, groups, group_of_row, index);
+}
+
+size_t group_by_symbol(const BBOColumns& cols, std::vector<SymbolGroup>& groups,
+                       std::vector<uint32_t>* group_of_row, SymbolIndex& index) {
+    groups.clear();
+    index.clear();
+    if (group_of_row) group_of_row->assign(cols.size(), UINT32_MAX);
+
+    uint32_t g = SymbolIndex::NOT_FOUND;
+    for (size_t i = 0; i < cols.size(); i++) {
+        // Feeds arrive in bursts per symbol: skip the probe within a run
+        if (i == 0 || cols.symbol[i] != cols.symbol[i - 1]) {
+            SymbolKey key = cols.symbol_at(i);
+            g = index.find_or_insert(key);
+            if (g != SymbolIndex::NOT_FOUND && g == groups.size()) {
+                groups.emplace_back();
+                groups.back().symbol = key;
+            }
+        }
+        if (g == SymbolIndex::NOT_FOUND) continue;
+
+        SymbolGroup& grp = groups[g];
+        uint32_t sp = cols.spread[i];
+        grp.count++;
+        grp.last = static_cast<uint32_t>(i);
+        grp.min_spread = std::min(grp.min_spread, sp);
+        grp.max_spread = std::max(grp.max_spread, sp);
+        grp.spread_sum += sp;
+        grp.bid_volume += cols.bid_size[i];
+        grp.ask_volume += cols.ask_size[i];
+
+        if (group_of_row) (*group_of_row)[i] = g;
+    }
+    return groups.size();
+}
+
+}  // namespace pcie
@@ -0,0 +1,257 @@
+#include "bbo_decode.h"
+
+#include <immintrin.h>
+#include <cstdint>
+#include <cstring>
+
+namespace pcie {
+
+namespace {
+
+using DecodeFn = size_t (*)(const uint8_t*, size_t, BBORecord*);
+
+inline uint32_t load_u32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t packet_flags(uint32_t padding) {
+    return BBORecord::FLAG_WIRE48 |
+           (padding != BBOPacket::PADDING ? BBORecord::FLAG_BAD_PADDING : 0);
+}
+
+// Scalar reference kernels
+
+size_t decode36_scalar(const uint8_t* in, size_t count, BBORecord* out) {
+    for (size_t i = 0; i < count; i++, in += sizeof(BBOData)) {
+        BBORecord& r = out[i];
+        r.symbol = SymbolKey::from_bytes(in);
+        r.bid_price = __builtin_bswap32(load_u32(in + 8));
+        r.bid_size = __builtin_bswap32(load_u32(in + 12));
+        r.ask_price = __builtin_bswap32(load_u32(in + 16));
+        r.ask_size = __builtin_bswap32(load_u32(in + 20));
+        r.spread = __builtin_bswap32(load_u32(in + 24));
+        r.ts_t1 = __builtin_bswap32(load_u32(in + 28));
+        r.ts_t2 = 0;
+        r.ts_t3 = 0;
+        r.ts_t4 = __builtin_bswap32(load_u32(in + 32));
+        r.flags = 0;
+    }
+    return 0;
+}
+
+size_t decode48_scalar(const uint8_t* in, size_t count, BBORecord* out) {
+    size_t bad = 0;
+    for (size_t i = 0; i < count; i++, in += sizeof(BBOPacket)) {
+        BBORecord& r = out[i];
+        r.symbol = SymbolKey::from_bytes(in);
+        r.bid_price = load_u32(in + 8);
+        r.bid_size = load_u32(in + 12);
+        r.ask_price = load_u32(in + 16);
+        r.ask_size = load_u32(in + 20);
+        r.spread = load_u32(in + 24);
+        r.ts_t1 = load_u32(in + 28);
+        r.ts_t2 = load_u32(in + 32);
+        r.ts_t3 = load_u32(in + 36);
+        r.ts_t4 = load_u32(in + 40);
+        r.flags = packet_flags(load_u32(in + 44));
+        bad += (r.flags & BBORecord::FLAG_BAD_PADDING) != 0;
+    }
+    return bad;
+}
+
+// SSSE3 kernels: three 16-byte chunks per record, pshufb for the swaps
+
+__attribute__((target("ssse3")))
+inline __m128i normalize_symbol_128(__m128i v) {
+    // Exactly-zero bytes in the symbol half become spaces (SymbolKey rules)
+    const __m128i sym_pad = _mm_set_epi64x(0, 0x2020202020202020LL);
+    __m128i zero = _mm_cmpeq_epi8(v, _mm_setzero_si128());
+    return _mm_or_si128(v, _mm_and_si128(zero, sym_pad));
+}
+
+__attribute__((target("ssse3")))
+size_t decode36_ssse3(const uint8_t* in, size_t count, BBORecord* out) {
+    // Bytes 0-15: symbol kept, bid_price/bid_size swapped
+    const __m128i swap_a = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+                                         11, 10, 9, 8, 15, 14, 13, 12);
+    // Bytes 16-31: ask_price, ask_size, spread, rx_timestamp all swapped
+    const __m128i swap_b = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+                                         11, 10, 9, 8, 15, 14, 13, 12);
+
+    for (size_t i = 0; i < count; i++, in += sizeof(BBOData)) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16));
+        uint32_t tx = __builtin_bswap32(load_u32(in + 32));
+
+        a = normalize_symbol_128(_mm_shuffle_epi8(a, swap_a));
+        b = _mm_shuffle_epi8(b, swap_b);
+        __m128i c = _mm_setr_epi32(0, 0, static_cast<int>(tx), 0);
+
+        __m128i* dst = reinterpret_cast<__m128i*>(&out[i]);
+        _mm_store_si128(dst, a);
+        _mm_store_si128(dst + 1, b);
+        _mm_store_si128(dst + 2, c);
+    }
+    return 0;
+}
+
+__attribute__((target("ssse3")))
+size_t decode48_ssse3(const uint8_t* in, size_t count, BBORecord* out) {
+    const __m128i keep_ts = _mm_setr_epi32(-1, -1, -1, 0);
+    size_t bad = 0;
+
+    for (size_t i = 0; i < count; i++, in += sizeof(BBOPacket)) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 32));
+
+        uint32_t flags = packet_flags(static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(c, 12))));
+        bad += (flags & BBORecord::FLAG_BAD_PADDING) != 0;
+
+        // Padding word is replaced by the flags
+        c = _mm_or_si128(_mm_and_si128(c, keep_ts),
+                         _mm_setr_epi32(0, 0, 0, static_cast<int>(flags)));
+
+        __m128i* dst = reinterpret_cast<__m128i*>(&out[i]);
+        _mm_store_si128(dst, normalize_symbol_128(a));
+        _mm_store_si128(dst + 1, b);
+        _mm_store_si128(dst + 2, c);
+    }
+    return bad;
+}
+
+// AVX2 kernels: first 32 bytes of a record in one in-lane vpshufb
+
+__attribute__((target("avx2")))
+inline __m256i normalize_symbol_256(__m256i v) {
+    const __m256i sym_pad = _mm256_setr_epi64x(0x2020202020202020LL, 0, 0, 0);
+    __m256i zero = _mm256_cmpeq_epi8(v, _mm256_setzero_si256());
+    return _mm256_or_si256(v, _mm256_and_si256(zero, sym_pad));
+}
+
+__attribute__((target("avx2")))
+size_t decode36_avx2(const uint8_t* in, size_t count, BBORecord* out) {
+    // Low lane: symbol kept, bid fields swapped; high lane: all four swapped
+    const __m256i swap = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+                                          11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4,
+                                          11, 10, 9, 8, 15, 14, 13, 12);
+
+    for (size_t i = 0; i < count; i++, in += sizeof(BBOData)) {
+        __m256i ab = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+        uint32_t tx = __builtin_bswap32(load_u32(in + 32));
+
+        ab = normalize_symbol_256(_mm256_shuffle_epi8(ab, swap));
+        __m128i c = _mm_setr_epi32(0, 0, static_cast<int>(tx), 0);
+
+        uint8_t* dst = reinterpret_cast<uint8_t*>(&out[i]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), ab);
+        _mm_store_si128(reinterpret_cast<__m128i*>(dst + 32), c);
+    }
+    return 0;
+}
+
+__attribute__((target("avx2")))
+size_t decode48_avx2(const uint8_t* in, size_t count, BBORecord* out) {
+    const __m128i keep_ts = _mm_setr_epi32(-1, -1, -1, 0);
+    size_t bad = 0;
+
+    for (size_t i = 0; i < count; i++, in += sizeof(BBOPacket)) {
+        __m256i ab = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 32));
+
+        uint32_t flags = packet_flags(static_cast<uint32_t>(_mm_extract_epi32(c, 3)));
+        bad += (flags & BBORecord::FLAG_BAD_PADDING) != 0;
+        c = _mm_or_si128(_mm_and_si128(c, keep_ts),
+                         _mm_setr_epi32(0, 0, 0, static_cast<int>(flags)));
+
+        uint8_t* dst = reinterpret_cast<uint8_t*>(&out[i]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), normalize_symbol_256(ab));
+        _mm_store_si128(reinterpret_cast<__m128i*>(dst + 32), c);
+    }
+    return bad;
+}
+
+DecodeKernel detect_kernel() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return DecodeKernel::AVX2;
+    if (__builtin_cpu_supports("ssse3")) return DecodeKernel::SSSE3;
+    return DecodeKernel::SCALAR;
+}
+
+DecodeFn select(DecodeKernel kernel, WireFormat format) {
+    bool wide = (format == WireFormat::BBO48);
+    switch (kernel) {
+        case DecodeKernel::AVX2: return wide ? decode48_avx2 : decode36_avx2;
+        case DecodeKernel::SSSE3: return wide ? decode48_ssse3 : decode36_ssse3;
+        default: return wide ? decode48_scalar : decode36_scalar;
+    }
+}
+
+// Resolved once at load time so the per-batch cost is one indirect call
+const DecodeKernel g_best = detect_kernel();
+const DecodeFn g_decode36 = select(g_best, WireFormat::BBO36);
+const DecodeFn g_decode48 = select(g_best, WireFormat::BBO48);
+
+}  // namespace
+
+const char* decode_kernel_name(DecodeKernel kernel) {
+    switch (kernel) {
+        case DecodeKernel::SCALAR: return "scalar";
+        case DecodeKernel::SSSE3: return "ssse3";
+        case DecodeKernel::AVX2: return "avx2";
+        default: return "unknown";
+    }
+}
+
+DecodeKernel best_decode_kernel() {
+    return g_best;
+}
+
+bool decode_kernel_supported(DecodeKernel kernel) {
+    return static_cast<int>(kernel) <= static_cast<int>(g_best);
+}
+
+size_t decode_bbo_batch(const void* wire, size_t count, BBORecord* out, WireFormat format) {
+    DecodeFn fn = (format == WireFormat::BBO48) ? g_decode48 : g_decode36;
+    return fn(static_cast<const uint8_t*>(wire), count, out);
+}
+
+size_t decode_bbo_batch(const void* wire, size_t count, BBORecord* out, WireFormat format,
+                        DecodeKernel kernel) {
+    if (!decode_kernel_supported(kernel)) {
+        kernel = DecodeKernel::SCALAR;
+    }
+    return select(kernel, format)(static_cast<const uint8_t*>(wire), count, out);
+}
+
+void encode_bbo_batch(const BBORecord* in, size_t count, void* wire, WireFormat format) {
+    uint8_t* out = static_cast<uint8_t*>(wire);
+    if (format == WireFormat::BBO48) {
+        for (size_t i = 0; i < count; i++, out += sizeof(BBOPacket)) {
+            const BBORecord& r = in[i];
+            BBOPacket p;
+            r.symbol.to_bytes(p.symbol);
+            p.bid_price = r.bid_price;
+            p.bid_size = r.bid_size;
+            p.ask_price = r.ask_price;
+            p.ask_size = r.ask_size;
+            p.spread = r.spread;
+            p.ts_t1 = r.ts_t1;
+            p.ts_t2 = r.ts_t2;
+            p.ts_t3 = r.ts_t3;
+            p.ts_t4 = r.ts_t4;
+            p.padding = BBOPacket::PADDING;
+            std::memcpy(out, &p, sizeof(p));
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; i++, out += sizeof(BBOData)) {
+        BBOData b = in[i].to_bbo_data();
+        std::memcpy(out, &b, sizeof(b));
+    }
+}
+
+}  // namespace pcie
@@ -0,0 +1,182 @@
+#include "bbo_generator.h"
+#include "bbo_decode.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace pcie {
+
+namespace {
+
+// Uniform in [0, n) from the low 16 bits of r (no division)
+inline uint32_t pick(uint64_t r, uint32_t n) {
+    return static_cast<uint32_t>(((r & 0xFFFF) * n) >> 16);
+}
+
+// a if it is after b on the wrapping 32-bit cycle counter, else b
+inline uint32_t later(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b) > 0 ? a : b;
+}
+
+std::vector<double> zipf_weights(size_t n, double s) {
+    std::vector<double> w(n);
+    double total = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        w[i] = s > 0.0 ? 1.0 / std::pow(static_cast<double>(i + 1), s) : 1.0;
+        total += w[i];
+    }
+    for (double& x : w) x /= total;
+    return w;
+}
+
+}  // namespace
+
+BBOGenerator::BBOGenerator(const GeneratorConfig& config)
+    : config_(config),
+      // SplitMix64 of the seed: xorshift needs a non-zero, well-mixed state
+      rng_([&] {
+          uint64_t z = config.seed + 0x9E3779B97F4A7C15ULL;
+          z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+          z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+          z ^= z >> 31;
+          return z ? z : 1;
+      }()) {
+    config_.tick = std::max<uint32_t>(config_.tick, 1);
+    uint32_t n = std::clamp<uint32_t>(config_.symbols, 1, MAX_SYMBOLS);
+    config_.symbols = n;
+
+    if (config_.pattern == GeneratorPattern::TEST_PATTERN) {
+        symbols_.push_back(SymbolKey("TESTAAPL"));
+        gap_span_ = 1;
+        return;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "GEN%05u", i);
+        symbols_.push_back(SymbolKey(name));
+        bids_.push_back(std::max(config_.start_price, config_.tick) + (i % 1000) * 10000);
+    }
+
+    // Vose alias table over the Zipf weights
+    if (config_.zipf_s > 0.0) {
+        std::vector<double> scaled = zipf_weights(n, config_.zipf_s);
+        std::vector<uint32_t> small, large;
+        for (uint32_t i = 0; i < n; i++) {
+            scaled[i] *= n;
+            (scaled[i] < 1.0 ? small : large).push_back(i);
+        }
+        accept_.assign(n, UINT32_MAX);
+        alias_.resize(n);
+        for (uint32_t i = 0; i < n; i++) alias_[i] = i;
+        while (!small.empty() && !large.empty()) {
+            uint32_t s = small.back();
+            uint32_t l = large.back();
+            small.pop_back();
+            accept_[s] = static_cast<uint32_t>(scaled[s] * 4294967296.0);
+            alias_[s] = l;
+            scaled[l] -= 1.0 - scaled[s];
+            if (scaled[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // Leftovers are 1.0 up to rounding: always keep
+    }
+
+    uint64_t mean_gap = config_.rate ? FPGA_HZ / config_.rate : DEFAULT_GAP_CYCLES;
+    gap_span_ = static_cast<uint32_t>(std::clamp<uint64_t>(2 * mean_gap - 1, 1, UINT32_MAX));
+}
+
+std::vector<double> BBOGenerator::popularity() const {
+    if (config_.pattern == GeneratorPattern::TEST_PATTERN) return {1.0};
+    return zipf_weights(symbols_.size(), config_.zipf_s);
+}
+
+uint32_t BBOGenerator::pick_symbol() {
+    uint32_t n = static_cast<uint32_t>(symbols_.size());
+    if (accept_.empty()) {
+        uint32_t i = next_rr_;
+        next_rr_ = i + 1 == n ? 0 : i + 1;
+        return i;
+    }
+
+    uint64_t r = random();
+    uint32_t i = static_cast<uint32_t>(((r >> 32) * n) >> 32);
+    return static_cast<uint32_t>(r) < accept_[i] ? i : alias_[i];
+}
+
+void BBOGenerator::next_market(BBORecord& r) {
+    uint32_t sym = pick_symbol();
+    uint64_t a = random();
+    uint64_t b = random();
+
+    // Walk: one tick down, stay or up; never below one tick
+    uint32_t tick = config_.tick;
+    uint32_t& bid = bids_[sym];
+    uint32_t moved = bid + (pick(a, 3) - 1) * tick;   // Branch-free: the move is random by design
+    bid = moved >= tick ? moved : bid;
+    uint32_t spread = tick * (1 + pick(a >> 16, 3));
+
+    r.symbol = symbols_[sym];
+    r.bid_price = bid;
+    r.ask_price = bid + spread;
+    r.spread = spread;
+    r.bid_size = 100 * (1 + pick(a >> 32, 50));
+    r.ask_size = 100 * (1 + pick(a >> 48, 50));
+
+    // T1 arrives after a random gap; the FIFO read and the TX framer each
+    // handle one record at a time, so they queue behind the previous one
+    t1_ += 1 + static_cast<uint32_t>(((b >> 32) * gap_span_) >> 32);
+    uint32_t t2 = t1_ + PARSE_CYCLES + static_cast<uint32_t>(b % JITTER_CYCLES);
+    t3_ = later(t2 + CDC_CYCLES + static_cast<uint32_t>((b >> 8) % JITTER_CYCLES), t3_ + 1);
+    t4_ = later(t3_ + TX_CYCLES, t4_ + PACKET_BEATS);
+    r.ts_t1 = t1_;
+    r.ts_t2 = t2;
+    r.ts_t3 = t3_;
+    r.ts_t4 = t4_;
+    r.flags = 0;
+}
+
+void BBOGenerator::next_test(BBORecord& r) {
+    uint32_t count = static_cast<uint32_t>(produced_);
+    r.symbol = symbols_[0];
+    r.bid_price = TEST_BID;
+    r.bid_size = TEST_BID_SIZE;
+    r.ask_price = TEST_ASK;
+    r.ask_size = TEST_ASK_SIZE;
+    r.spread = TEST_ASK - TEST_BID;
+    r.ts_t1 = count;
+    r.ts_t2 = count;
+    r.ts_t3 = count;
+    r.ts_t4 = count;
+    r.flags = 0;
+}
+
+void BBOGenerator::next(BBORecord* out, size_t count) {
+    bool test = config_.pattern == GeneratorPattern::TEST_PATTERN;
+    for (size_t i = 0; i < count; i++) {
+        if (test) {
+            next_test(out[i]);
+        } else {
+            next_market(out[i]);
+        }
+        produced_++;
+    }
+}
+
+void BBOGenerator::next_wire(void* wire, size_t count, WireFormat format) {
+    uint8_t* out = static_cast<uint8_t*>(wire);
+    size_t record_size = wire_record_size(format);
+    BBORecord batch[64];
+    while (count > 0) {
+        size_t n = std::min<size_t>(count, 64);
+        next(batch, n);
+        encode_bbo_batch(batch, n, out, format);
+        out += n * record_size;
+        count -= n;
+    }
+}
+
+}  // namespace pcie
@@ -0,0 +1,298 @@
+#include "book_snapshot.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace pcie {
+
+struct BookSnapshot::FileHeader {
+    uint64_t magic;
+    uint32_t format_version;
+    uint32_t capacity;
+    uint64_t generation;      // Published generation; accessed through atomic_ref
+    uint8_t reserved[40];
+};
+
+struct BookSnapshot::HalfHeader {
+    uint64_t generation;      // Generation held here, 0 while being rewritten
+    uint64_t count;
+    int64_t wall_time_ns;     // CLOCK_REALTIME of the checkpoint
+    uint8_t reserved[40];
+};
+
+struct BookSnapshot::Entry {
+    uint64_t symbol;          // SymbolKey::raw()
+    uint32_t bid_price;
+    uint32_t bid_size;
+    uint32_t ask_price;
+    uint32_t ask_size;
+    uint32_t rx_timestamp;
+    uint32_t tx_timestamp;
+    int64_t wall_time_ns;     // When the record was read, CLOCK_REALTIME
+    uint64_t updates;
+};
+
+namespace {
+
+int64_t wall_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t steady_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::atomic_ref<uint64_t> atomic_word(uint64_t& word) {
+    return std::atomic_ref<uint64_t>(word);
+}
+
+}  // namespace
+
+BookSnapshot::~BookSnapshot() {
+    close();
+}
+
+size_t BookSnapshot::file_size(size_t capacity) {
+    static_assert(sizeof(FileHeader) == 64, "snapshot header must be 64 bytes");
+    static_assert(sizeof(HalfHeader) == 64, "snapshot half header must be 64 bytes");
+    static_assert(sizeof(Entry) == 48, "snapshot entry must be 48 bytes");
+    return sizeof(FileHeader) + 2 * (sizeof(HalfHeader) + capacity * sizeof(Entry));
+}
+
+BookSnapshot::FileHeader* BookSnapshot::header() const {
+    return static_cast<FileHeader*>(map_);
+}
+
+BookSnapshot::HalfHeader* BookSnapshot::half(uint64_t generation) const {
+    uint8_t* base = static_cast<uint8_t*>(map_) + sizeof(FileHeader);
+    size_t half_size = sizeof(HalfHeader) + capacity_ * sizeof(Entry);
+    return reinterpret_cast<HalfHeader*>(base + (generation & 1) * half_size);
+}
+
+BookSnapshot::Entry* BookSnapshot::entries(uint64_t generation) const {
+    return reinterpret_cast<Entry*>(half(generation) + 1);
+}
+
+PCIeError BookSnapshot::map_file(const std::string& path, size_t capacity) {
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+        fprintf(stderr, "Failed to open snapshot %s: %s\n", path.c_str(), strerror(errno));
+        return PCIeError::OPEN_FAILED;
+    }
+
+    // Keep a valid existing file as-is, whatever capacity it was made with
+    FileHeader existing{};
+    struct stat st;
+    bool valid = fstat(fd_, &st) == 0 &&
+                 pread(fd_, &existing, sizeof(existing), 0) == static_cast<ssize_t>(sizeof(existing)) &&
+                 existing.magic == MAGIC && existing.format_version == FORMAT_VERSION &&
+                 existing.capacity > 0 &&
+                 static_cast<size_t>(st.st_size) >= file_size(existing.capacity);
+
+    capacity_ = valid ? existing.capacity : capacity;
+    map_size_ = file_size(capacity_);
+
+    if (!valid && ftruncate(fd_, 0) < 0) {
+        fprintf(stderr, "Failed to reset snapshot %s: %s\n", path.c_str(), strerror(errno));
+        close();
+        return PCIeError::OPEN_FAILED;
+    }
+    if (!valid && ftruncate(fd_, static_cast<off_t>(map_size_)) < 0) {
+        fprintf(stderr, "Failed to size snapshot %s: %s\n", path.c_str(), strerror(errno));
+        close();
+        return PCIeError::OPEN_FAILED;
+    }
+
+    map_ = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map_ == MAP_FAILED) {
+        fprintf(stderr, "Failed to mmap snapshot %s: %s\n", path.c_str(), strerror(errno));
+        map_ = nullptr;
+        close();
+        return PCIeError::MMAP_FAILED;
+    }
+
+    if (!valid) {
+        // Fresh (zeroed) file: generation 0, both halves empty
+        FileHeader* h = header();
+        h->format_version = FORMAT_VERSION;
+        h->capacity = static_cast<uint32_t>(capacity_);
+        atomic_word(h->magic).store(MAGIC, std::memory_order_release);
+    }
+    return PCIeError::SUCCESS;
+}
+
+PCIeError BookSnapshot::open(const std::string& path, size_t capacity) {
+    close();
+    if (capacity == 0) capacity = 1;
+    skipped_.store(0, std::memory_order_relaxed);
+
+    PCIeError err = map_file(path, capacity);
+    if (err != PCIeError::SUCCESS || capacity_ >= capacity) return err;
+
+    // Too small for this cache: rebuild at the requested capacity beside
+    // the old file and rename it over, so a process still mapping the old
+    // one keeps a consistent book. The latest generation carries over.
+    std::vector<Entry> book;
+    int64_t wall = 0;
+    uint64_t gen = read_published(book, &wall);
+    size_t old_capacity = capacity_;
+    close();
+
+    std::string grown = path + ".grow";
+    unlink(grown.c_str());
+    err = map_file(grown, capacity);
+    if (err != PCIeError::SUCCESS) return err;
+
+    if (gen > 0) {
+        HalfHeader* h = half(gen);
+        std::copy(book.begin(), book.end(), entries(gen));
+        h->count = book.size();
+        h->wall_time_ns = wall;
+        atomic_word(h->generation).store(gen, std::memory_order_release);
+        atomic_word(header()->generation).store(gen, std::memory_order_release);
+    }
+
+    if (rename(grown.c_str(), path.c_str()) < 0) {
+        fprintf(stderr, "Failed to replace snapshot %s: %s\n", path.c_str(), strerror(errno));
+        close();
+        unlink(grown.c_str());
+        return PCIeError::OPEN_FAILED;
+    }
+    printf("Snapshot %s grown from %zu to %zu symbols\n", path.c_str(), old_capacity, capacity_);
+    return PCIeError::SUCCESS;
+}
+
+void BookSnapshot::close() {
+    if (map_ != nullptr) {
+        msync(map_, map_size_, MS_ASYNC);
+        munmap(map_, map_size_);
+        map_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+uint64_t BookSnapshot::generation() const {
+    if (!map_) return 0;
+    return atomic_word(header()->generation).load(std::memory_order_acquire);
+}
+
+uint64_t BookSnapshot::checkpoint(const BBOCache& cache) {
+    if (!map_) return 0;
+    std::lock_guard<std::mutex> lock(write_mutex_);
+
+    uint64_t next = generation() + 1;
+    HalfHeader* h = half(next);
+    Entry* out = entries(next);
+
+    // Take the half out of circulation before touching its entries
+    atomic_word(h->generation).store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // steady_clock -> wall clock, one offset for the whole checkpoint
+    int64_t wall = wall_now_ns();
+    int64_t offset = wall - steady_now_ns();
+
+    // A cache larger than the file loses its newest symbols; say so once
+    size_t n = std::min(cache.size(), capacity_);
+    size_t left_out = cache.size() - n;
+    if (left_out > 0 && skipped_.load(std::memory_order_relaxed) == 0) {
+        fprintf(stderr, "Warning: snapshot holds %zu symbols, %zu left out\n", capacity_, left_out);
+    }
+    bump(skipped_, left_out);
+
+    size_t count = 0;
+    BBOQuote q;
+    for (uint32_t slot = 0; slot < n; slot++) {
+        cache.read_slot(slot, q);
+        if (q.updates == 0) continue;  // Slot claimed, first write not finished
+
+        Entry& e = out[count++];
+        e.symbol = q.symbol.raw();
+        e.bid_price = q.bid_price;
+        e.bid_size = q.bid_size;
+        e.ask_price = q.ask_price;
+        e.ask_size = q.ask_size;
+        e.rx_timestamp = q.rx_timestamp;
+        e.tx_timestamp = q.tx_timestamp;
+        e.wall_time_ns = static_cast<int64_t>(q.host_time_ns) + offset;
+        e.updates = q.updates;
+    }
+    h->count = count;
+    h->wall_time_ns = wall;
+
+    atomic_word(h->generation).store(next, std::memory_order_release);
+    atomic_word(header()->generation).store(next, std::memory_order_release);
+    return next;
+}
+
+uint64_t BookSnapshot::read_published(std::vector<Entry>& copy, int64_t* wall_time_ns) const {
+    copy.clear();
+    if (!map_) return 0;
+
+    // Another process may be checkpointing into the file; retry if the
+    // half we copied was recycled underneath us
+    for (int attempt = 0; attempt < 100; attempt++) {
+        uint64_t gen = generation();
+        if (gen == 0) return 0;
+
+        HalfHeader* h = half(gen);
+        if (atomic_word(h->generation).load(std::memory_order_acquire) != gen) continue;
+
+        size_t count = std::min<uint64_t>(h->count, capacity_);
+        copy.assign(entries(gen), entries(gen) + count);
+        int64_t wall = h->wall_time_ns;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (atomic_word(h->generation).load(std::memory_order_relaxed) == gen) {
+            if (wall_time_ns) *wall_time_ns = wall;
+            return gen;
+        }
+        copy.clear();
+    }
+    return 0;
+}
+
+size_t BookSnapshot::load(BBOCache& cache, uint64_t* generation_out) const {
+    if (generation_out) *generation_out = 0;
+
+    std::vector<Entry> copy;
+    uint64_t gen = read_published(copy);
+    if (copy.empty()) return 0;
+
+    // Wall clock -> this process's steady_clock
+    int64_t offset = steady_now_ns() - wall_now_ns();
+
+    size_t restored = 0;
+    BBOQuote q{};
+    for (const Entry& e : copy) {
+        int64_t host = e.wall_time_ns + offset;
+        q.symbol = SymbolKey::from_raw(e.symbol);
+        q.bid_price = e.bid_price;
+        q.bid_size = e.bid_size;
+        q.ask_price = e.ask_price;
+        q.ask_size = e.ask_size;
+        q.rx_timestamp = e.rx_timestamp;
+        q.tx_timestamp = e.tx_timestamp;
+        q.host_time_ns = host > 0 ? static_cast<uint64_t>(host) : 0;
+        restored += cache.warm(q);
+    }
+
+    if (generation_out) *generation_out = gen;
+    return restored;
+}
+
+}  // namespace pcie
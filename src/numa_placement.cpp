@@ -0,0 +1,171 @@
+#include "numa_placement.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace pcie {
+
+namespace {
+
+// <numaif.h> values; called through syscall() to avoid a libnuma dependency
+constexpr int MPOL_DEFAULT = 0;
+constexpr int MPOL_PREFERRED = 1;
+constexpr unsigned long MPOL_F_NODE = 1UL << 0;
+constexpr unsigned long MPOL_F_ADDR = 1UL << 1;
+
+std::string read_line(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+}  // namespace
+
+NumaTopology::NumaTopology(const std::string& node_root) {
+    // Node ids can have holes; stop after a run of missing ones
+    for (int node = 0, missing = 0; missing < 8; node++) {
+        std::string list = read_line(node_root + "/node" + std::to_string(node) + "/cpulist");
+        if (list.empty()) {
+            missing++;
+            continue;
+        }
+        missing = 0;
+        node_cpus_.resize(static_cast<size_t>(node) + 1);
+        node_cpus_[node] = parse_cpulist(list);
+    }
+}
+
+const std::vector<int>& NumaTopology::cpus(int node) const {
+    static const std::vector<int> none;
+    if (node < 0 || static_cast<size_t>(node) >= node_cpus_.size()) return none;
+    return node_cpus_[node];
+}
+
+int NumaTopology::node_of_cpu(int cpu) const {
+    for (size_t node = 0; node < node_cpus_.size(); node++) {
+        const auto& set = node_cpus_[node];
+        if (std::find(set.begin(), set.end(), cpu) != set.end()) return static_cast<int>(node);
+    }
+    return -1;
+}
+
+NumaPlacement NumaTopology::place(int device_node, const std::vector<int>& device_cpus,
+                                  int requested_node, const std::vector<int>& requested_cpus) const {
+    NumaPlacement p;
+    p.device_node = device_node;
+    char msg[160];
+
+    if (requested_node == NUMA_AUTO) {
+        p.node = device_node;
+        p.source = device_node >= 0 ? "device" : "none";
+    } else if (requested_node >= 0) {
+        p.node = requested_node;
+        p.source = "config";
+        if (device_node >= 0 && requested_node != device_node) {
+            p.remote = true;
+            snprintf(msg, sizeof(msg), "buffers on node %d, card is on node %d (remote)",
+                     requested_node, device_node);
+            p.warnings.emplace_back(msg);
+        }
+    }
+
+    if (!requested_cpus.empty()) {
+        p.cpus = requested_cpus;
+        p.source = "config";
+        for (int cpu : requested_cpus) {
+            int node = node_of_cpu(cpu);
+            if (device_node >= 0 && node >= 0 && node != device_node) {
+                p.remote = true;
+                snprintf(msg, sizeof(msg), "CPU %d is on node %d, card is on node %d (remote)",
+                         cpu, node, device_node);
+                p.warnings.emplace_back(msg);
+            }
+        }
+    } else if (p.node >= 0) {
+        p.cpus = cpus(p.node);
+        if (p.cpus.empty() && p.node == device_node) p.cpus = device_cpus;
+    }
+    return p;
+}
+
+std::vector<int> NumaTopology::parse_cpulist(const std::string& list) {
+    std::vector<int> cpus;
+    const char* s = list.c_str();
+    while (*s) {
+        char* end;
+        long first = strtol(s, &end, 10);
+        if (end == s) break;
+        long last = first;
+        s = end;
+        if (*s == '-') {
+            last = strtol(s + 1, &end, 10);
+            s = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++) cpus.push_back(static_cast<int>(cpu));
+        if (*s != ',') break;
+        s++;
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::string NumaTopology::format_cpulist(const std::vector<int>& cpus) {
+    std::string out;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) j++;
+        if (!out.empty()) out += ',';
+        out += std::to_string(cpus[i]);
+        if (j > i) out += '-' + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return out;
+}
+
+bool pin_current_thread(const std::vector<int>& cpus) {
+    if (cpus.empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+int memory_node(const void* addr) {
+    int node = -1;
+    long ret = syscall(SYS_get_mempolicy, &node, nullptr, 0UL,
+                       const_cast<void*>(addr), MPOL_F_NODE | MPOL_F_ADDR);
+    return ret == 0 ? node : -1;
+}
+
+ScopedMemoryNode::ScopedMemoryNode(int node) {
+    if (node < 0 || static_cast<unsigned long>(node) >= MAX_NODES) return;
+
+    if (syscall(SYS_get_mempolicy, &saved_mode_, saved_mask_, MAX_NODES, nullptr, 0UL) != 0) {
+        return;  // No NUMA support in this kernel
+    }
+
+    unsigned long mask[sizeof(saved_mask_) / sizeof(saved_mask_[0])] = {};
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+    active_ = syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, MAX_NODES) == 0;
+}
+
+ScopedMemoryNode::~ScopedMemoryNode() {
+    if (!active_) return;
+    if (saved_mode_ == MPOL_DEFAULT) {
+        syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0UL);
+    } else {
+        syscall(SYS_set_mempolicy, saved_mode_, saved_mask_, MAX_NODES);
+    }
+}
+
+}  // namespace pcie
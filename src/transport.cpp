@@ -0,0 +1,671 @@
+#include "transport.h"
+#include "bbo_decode.h"
+#include "thread_util.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstddef>
+#include <cstdio>
+#include <new>
+#include <utility>
+
+namespace pcie {
+
+namespace {
+
+int open_node(const std::string& path, int flags, mode_t mode = 0) {
+    int fd = ::open(path.c_str(), flags, mode);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open %s: %s\n", path.c_str(), strerror(errno));
+    }
+    return fd;
+}
+
+// Add offset to the timestamps of packed wire records in place
+void advance_timestamps(uint8_t* wire, size_t count, WireFormat format, uint32_t offset) {
+    auto add = [offset](uint8_t* p, bool big_endian) {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        v = big_endian ? __builtin_bswap32(__builtin_bswap32(v) + offset) : v + offset;
+        std::memcpy(p, &v, 4);
+    };
+    if (format == WireFormat::BBO48) {
+        for (size_t i = 0; i < count; i++, wire += sizeof(BBOPacket)) {
+            for (size_t at = offsetof(BBOPacket, ts_t1); at <= offsetof(BBOPacket, ts_t4); at += 4) {
+                add(wire + at, false);
+            }
+        }
+    } else {
+        for (size_t i = 0; i < count; i++, wire += sizeof(BBOData)) {
+            add(wire + offsetof(BBOData, rx_timestamp), true);
+            add(wire + offsetof(BBOData, tx_timestamp), true);
+        }
+    }
+}
+
+// Symbol names are GEN%05u: a larger universe would repeat them
+PCIeError check_generator(const GeneratorConfig& config) {
+    if (config.symbols > BBOGenerator::MAX_SYMBOLS) {
+        fprintf(stderr, "Generator universe of %u symbols exceeds %u\n",
+                config.symbols, BBOGenerator::MAX_SYMBOLS);
+        return PCIeError::INVALID_PARAMETER;
+    }
+    return PCIeError::SUCCESS;
+}
+
+// Map an existing feed segment and check it is one
+PCIeError open_segment(const std::string& name, std::shared_ptr<ShmSegment>& out) {
+    if (name.empty()) {
+        fprintf(stderr, "Shared-memory transport needs shm_name\n");
+        return PCIeError::INVALID_PARAMETER;
+    }
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open shared memory %s: %s\n", name.c_str(), strerror(errno));
+        return PCIeError::OPEN_FAILED;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < ShmFeedHeader::SIZE) {
+        fprintf(stderr, "Shared memory %s is not a feed segment\n", name.c_str());
+        ::close(fd);
+        return PCIeError::OPEN_FAILED;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Failed to mmap shared memory %s: %s\n", name.c_str(), strerror(errno));
+        return PCIeError::MMAP_FAILED;
+    }
+
+    auto segment = std::make_shared<ShmSegment>();
+    segment->base = static_cast<uint8_t*>(base);
+    segment->size = size;
+    const ShmFeedHeader* h = segment->header();
+    bool valid = h->magic == ShmFeedHeader::MAGIC && h->version == ShmFeedHeader::VERSION &&
+                 h->ring_bytes != 0 && (h->ring_bytes & (h->ring_bytes - 1)) == 0 &&
+                 ShmSegment::total_size(h->bar_bytes, h->h2c_bytes, h->ring_bytes) <= size;
+    if (!valid) {
+        fprintf(stderr, "Shared memory %s is not a feed segment\n", name.c_str());
+        return PCIeError::OPEN_FAILED;
+    }
+    out = std::move(segment);
+    return PCIeError::SUCCESS;
+}
+
+}  // namespace
+
+ShmSegment::~ShmSegment() {
+    if (base) munmap(base, size);
+}
+
+// Generator
+
+GeneratorSource::GeneratorSource(const GeneratorConfig& config, WireFormat format)
+    : config_(config), format_(format), record_size_(wire_record_size(format)),
+      generator_(std::make_unique<BBOGenerator>(config)) {
+    if (config.pool_records == 0) return;
+
+    std::vector<BBORecord> pool(config.pool_records);
+    generator_->next(pool.data(), pool.size());
+    pool_.resize(pool.size() * record_size_);
+    encode_bbo_batch(pool.data(), pool.size(), pool_.data(), format_);
+
+    // Next lap starts where the stream would have: straight after the last
+    // record for the packet counter, a packet after the last T4 otherwise
+    if (config.pattern == GeneratorPattern::TEST_PATTERN) {
+        pool_span_ = config.pool_records;
+    } else {
+        pool_span_ = pool.back().ts_t4 - pool.front().ts_t1 + BBOGenerator::PACKET_BEATS;
+    }
+}
+
+uint64_t GeneratorSource::due(uint32_t timeout_ms) {
+    if (config_.rate == 0) return UINT64_MAX;
+
+    using Clock = std::chrono::steady_clock;
+    auto now = Clock::now();
+    if (!started_) {
+        start_ = now;
+        started_ = true;
+    }
+    auto deadline = now + std::chrono::milliseconds(timeout_ms);
+    double rate = static_cast<double>(config_.rate);
+    for (;;) {
+        // Record k is due at start + k / rate
+        double elapsed = std::chrono::duration<double>(now - start_).count();
+        uint64_t released = static_cast<uint64_t>(elapsed * rate) + 1;
+        if (released > produced_) return released - produced_;
+        if (now >= deadline) return 0;
+
+        auto next = start_ + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(produced_) / rate));
+        auto wait = std::min(next, deadline) - now;
+        if (wait > std::chrono::microseconds(100)) {
+            std::this_thread::sleep_for(wait);
+        } else {
+            std::this_thread::yield();
+        }
+        now = Clock::now();
+    }
+}
+
+void GeneratorSource::fill(uint8_t* out, size_t count) {
+    produced_ += count;
+    if (pool_.empty()) {
+        generator_->next_wire(out, count, format_);
+        return;
+    }
+
+    size_t pool_records = pool_.size() / record_size_;
+    while (count > 0) {
+        size_t n = std::min(count, pool_records - pool_next_);
+        std::memcpy(out, pool_.data() + pool_next_ * record_size_, n * record_size_);
+        if (pool_offset_ != 0) advance_timestamps(out, n, format_, pool_offset_);
+        out += n * record_size_;
+        count -= n;
+        pool_next_ += n;
+        if (pool_next_ == pool_records) {
+            pool_next_ = 0;
+            pool_offset_ += pool_span_;
+        }
+    }
+}
+
+ssize_t GeneratorSource::read(void* buf, size_t len, uint32_t timeout_ms) {
+    uint8_t* out = static_cast<uint8_t*>(buf);
+    size_t done = 0;
+
+    // Rest of a record the previous read split
+    if (stage_off_ < stage_len_) {
+        done = std::min(len, stage_len_ - stage_off_);
+        std::memcpy(out, stage_ + stage_off_, done);
+        stage_off_ += done;
+    }
+
+    while (done < len) {
+        uint64_t left = config_.records ? config_.records - produced_ : UINT64_MAX;
+        if (left == 0) break;
+        // Only wait while there is nothing to hand back yet
+        uint64_t released = due(done == 0 ? timeout_ms : 0);
+        if (released == 0) break;
+
+        size_t room = len - done;
+        if (room < record_size_) {
+            fill(stage_, 1);
+            stage_len_ = record_size_;
+            stage_off_ = room;
+            std::memcpy(out + done, stage_, room);
+            done = len;
+            break;
+        }
+        size_t count = std::min<uint64_t>({room / record_size_, released, left});
+        fill(out + done, count);
+        done += count * record_size_;
+    }
+    if (done > 0) return static_cast<ssize_t>(done);
+    return config_.records && produced_ >= config_.records ? -1 : 0;  // -1: end of stream
+}
+
+// Fault injection
+
+struct FaultInner {
+    C2HSource source;
+};
+
+struct FaultSource::Counters {
+    struct Class {
+        std::atomic<uint64_t> injected{0};
+        std::atomic<uint64_t> recovered{0};
+        std::atomic<uint64_t> total_recovery_ns{0};
+        std::atomic<uint64_t> max_recovery_ns{0};
+    };
+    std::atomic<uint64_t> reads{0};
+    Class kinds[static_cast<size_t>(FaultKind::COUNT)];
+};
+
+FaultSource::FaultSource() = default;
+FaultSource::~FaultSource() = default;
+FaultSource::FaultSource(FaultSource&&) noexcept = default;
+FaultSource& FaultSource::operator=(FaultSource&&) noexcept = default;
+
+FaultSource::FaultSource(std::unique_ptr<FaultInner> inner, const FaultConfig& config)
+    : inner_(std::move(inner)), config_(config),
+      rng_((static_cast<uint64_t>(config.seed) + 1) * 0x9E3779B97F4A7C15ULL),
+      counters_(std::make_unique<Counters>()) {
+    std::stable_sort(config_.schedule.begin(), config_.schedule.end(),
+                     [](const FaultEvent& a, const FaultEvent& b) { return a.at_read < b.at_read; });
+}
+
+bool FaultSource::is_open() const {
+    return inner_ && c2h_is_open(inner_->source);
+}
+
+FaultStats FaultSource::stats() const {
+    FaultStats s;
+    if (!counters_) return s;
+    s.reads = counters_->reads.load(std::memory_order_relaxed);
+    for (size_t k = 0; k < static_cast<size_t>(FaultKind::COUNT); k++) {
+        const Counters::Class& c = counters_->kinds[k];
+        s.kinds[k].injected = c.injected.load(std::memory_order_relaxed);
+        s.kinds[k].recovered = c.recovered.load(std::memory_order_relaxed);
+        s.kinds[k].total_recovery_ns = c.total_recovery_ns.load(std::memory_order_relaxed);
+        s.kinds[k].max_recovery_ns = c.max_recovery_ns.load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+// Fault for this read, if any: the schedule first, then one draw against
+// the per-class probabilities
+FaultEvent FaultSource::draw() {
+    uint64_t read = reads_++;
+    bump(counters_->reads);
+
+    const std::vector<FaultEvent>& schedule = config_.schedule;
+    while (next_event_ < schedule.size() && schedule[next_event_].at_read < read) next_event_++;
+    if (next_event_ < schedule.size() && schedule[next_event_].at_read == read) {
+        return schedule[next_event_++];
+    }
+
+    FaultEvent none;
+    none.kind = FaultKind::COUNT;
+    double u = static_cast<double>(random() >> 11) * 0x1.0p-53;
+    const double p[] = {config_.short_read, config_.interrupted, config_.would_block,
+                        config_.stall, config_.link_down};
+    for (size_t k = 0; k < static_cast<size_t>(FaultKind::COUNT); k++) {
+        if (u < p[k]) {
+            none.kind = static_cast<FaultKind>(k);
+            return none;
+        }
+        u -= p[k];
+    }
+    return none;
+}
+
+void FaultSource::begin(FaultKind kind, uint64_t clear_ns) {
+    size_t k = static_cast<size_t>(kind);
+    bump(counters_->kinds[k].injected);
+    if (open_[k]++ == 0) first_clear_ns_[k] = clear_ns;
+    sum_clear_ns_[k] += clear_ns;
+    last_clear_ns_ = std::max(last_clear_ns_, clear_ns);
+}
+
+// Data came back: every fault still open has recovered
+void FaultSource::recovered(uint64_t now_ns) {
+    if (now_ns < last_clear_ns_) return;
+    for (size_t k = 0; k < static_cast<size_t>(FaultKind::COUNT); k++) {
+        if (open_[k] == 0) continue;
+        Counters::Class& c = counters_->kinds[k];
+        uint64_t longest = now_ns - first_clear_ns_[k];
+        bump(c.recovered, open_[k]);
+        bump(c.total_recovery_ns, open_[k] * now_ns - sum_clear_ns_[k]);
+        if (longest > c.max_recovery_ns.load(std::memory_order_relaxed)) {
+            c.max_recovery_ns.store(longest, std::memory_order_relaxed);
+        }
+        open_[k] = 0;
+        sum_clear_ns_[k] = 0;
+    }
+}
+
+ssize_t FaultSource::read(void* buf, size_t len, uint32_t timeout_ms) {
+    uint64_t now = steady_ns();
+    if (outage_ != FaultKind::COUNT && now >= outage_end_ns_) {
+        outage_ = FaultKind::COUNT;
+    }
+
+    bool short_read = false;
+    if (outage_ == FaultKind::COUNT) {
+        FaultEvent fault = draw();
+        switch (fault.kind) {
+            case FaultKind::INTERRUPTED:
+                begin(fault.kind, now);
+                errno = EINTR;
+                return 0;
+            case FaultKind::WOULD_BLOCK:
+                begin(fault.kind, now);
+                errno = EAGAIN;
+                return 0;
+            case FaultKind::STALL:
+            case FaultKind::LINK_DOWN: {
+                uint32_t ms = fault.duration_ms;
+                if (ms == 0) ms = fault.kind == FaultKind::STALL ? config_.stall_ms : config_.link_down_ms;
+                outage_ = fault.kind;
+                outage_end_ns_ = now + static_cast<uint64_t>(ms) * 1000000;
+                begin(fault.kind, outage_end_ns_);
+                break;
+            }
+            case FaultKind::SHORT_READ:
+                short_read = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Outage: the link fails reads, a stall waits out the timeout quietly
+    if (outage_ == FaultKind::LINK_DOWN) {
+        errno = EIO;
+        return -1;
+    }
+    if (outage_ == FaultKind::STALL) {
+        uint64_t wait = std::min<uint64_t>(static_cast<uint64_t>(timeout_ms) * 1000000, outage_end_ns_ - now);
+        if (wait > 0) std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+        return 0;
+    }
+
+    // Bytes a short read held back go first
+    uint8_t* out = static_cast<uint8_t*>(buf);
+    bool from_held = held_off_ < held_.size();
+    size_t n;
+    if (from_held) {
+        n = std::min(len, held_.size() - held_off_);
+        std::memcpy(out, held_.data() + held_off_, n);
+    } else {
+        ssize_t got = read_c2h(inner_->source, buf, len, timeout_ms);
+        if (got <= 0) return got;
+        n = static_cast<size_t>(got);
+    }
+
+    recovered(steady_ns());
+
+    size_t keep = n;
+    if (short_read && n > 1) {
+        keep = 1 + static_cast<size_t>(random() % (n - 1));
+        begin(FaultKind::SHORT_READ, steady_ns());
+    }
+    if (from_held) {
+        held_off_ += keep;
+        if (held_off_ == held_.size()) {
+            held_.clear();
+            held_off_ = 0;
+        }
+    } else if (keep < n) {
+        held_.assign(out + keep, out + n);
+        held_off_ = 0;
+    }
+    return static_cast<ssize_t>(keep);
+}
+
+void wrap_faults(const XDMADeviceConfig& config, size_t index, C2HSource& source) {
+    if (!config.faults.enabled() || std::holds_alternative<FaultSource>(source)) return;
+    FaultConfig faults = config.faults;
+    faults.seed += static_cast<uint32_t>(index);
+    auto inner = std::make_unique<FaultInner>();
+    inner->source = std::move(source);
+    source = FaultSource(std::move(inner), faults);
+}
+
+// Register BAR
+
+PCIeError RegisterBar::map(int fd, size_t size) {
+    release();
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        fprintf(stderr, "Failed to mmap control registers: %s\n", strerror(errno));
+        return PCIeError::MMAP_FAILED;
+    }
+    regs_ = static_cast<volatile uint32_t*>(p);
+    size_ = size;
+    mapped_ = true;
+    return PCIeError::SUCCESS;
+}
+
+void RegisterBar::emulate(size_t size) {
+    release();
+    size_t words = std::max<size_t>(size / 4, ControlRegisters::LATENCY_US_OFFSET / 4 + 1);
+    emulated_ = std::make_unique<uint32_t[]>(words);
+    regs_ = emulated_.get();
+    size_ = words * 4;
+    regs_[ControlRegisters::STATUS_OFFSET / 4] =
+        ControlRegisters::STATUS_RUNNING | ControlRegisters::STATUS_LINK_UP;
+}
+
+void RegisterBar::borrow(volatile uint32_t* regs, size_t size) {
+    release();
+    regs_ = regs;
+    size_ = size;
+}
+
+void RegisterBar::release() {
+    if (mapped_ && regs_) {
+        munmap(const_cast<uint32_t*>(regs_), size_);
+    }
+    mapped_ = false;
+    emulated_.reset();
+    regs_ = nullptr;
+    size_ = 0;
+}
+
+// Transport
+
+PCIeError Transport::open(const XDMADeviceConfig& config) {
+    close();
+    kind = config.transport;
+    PCIeError err = PCIeError::SUCCESS;
+
+    switch (kind) {
+        case TransportKind::XDMA: {
+            int fd = open_node(config.c2h_path, O_RDONLY);
+            if (fd < 0) { err = PCIeError::OPEN_FAILED; break; }
+            c2h = FdSource(fd);
+
+            fd = open_node(config.h2c_path, O_WRONLY);
+            if (fd < 0) { err = PCIeError::OPEN_FAILED; break; }
+            h2c = FdSink(fd);
+
+            fd = open_node(config.user_path, O_RDWR | O_SYNC);
+            if (fd < 0) { err = PCIeError::OPEN_FAILED; break; }
+            err = bar.map(fd, config.user_map_size);
+            ::close(fd);   // The mapping holds the BAR
+
+            // Events node is optional (interrupt-driven mode)
+            if (err == PCIeError::SUCCESS && !config.events_path.empty()) {
+                events_fd = ::open(config.events_path.c_str(), O_RDONLY);
+            }
+            break;
+        }
+
+        case TransportKind::FILE: {
+            int fd = open_node(config.c2h_path, O_RDONLY);
+            if (fd < 0) { err = PCIeError::OPEN_FAILED; break; }
+            c2h = FdSource(fd);
+
+            if (!config.h2c_path.empty()) {
+                fd = open_node(config.h2c_path, O_WRONLY | O_CREAT, 0644);
+                if (fd < 0) { err = PCIeError::OPEN_FAILED; break; }
+                h2c = FdSink(fd);
+            }
+
+            if (config.user_path.empty()) {
+                bar.emulate(config.user_map_size);
+                break;
+            }
+            fd = open_node(config.user_path, O_RDWR);
+            if (fd < 0) { err = PCIeError::OPEN_FAILED; break; }
+            err = bar.map(fd, config.user_map_size);
+            ::close(fd);
+            break;
+        }
+
+        case TransportKind::SHM:
+            err = open_segment(config.shm_name, shm);
+            if (err != PCIeError::SUCCESS) break;
+            c2h = ShmSource(shm);
+            h2c = MemorySink(shm->h2c(), shm->header()->h2c_bytes);
+            bar.borrow(reinterpret_cast<volatile uint32_t*>(shm->bar()), shm->header()->bar_bytes);
+            break;
+
+        case TransportKind::GENERATOR:
+            err = check_generator(config.generator);
+            if (err != PCIeError::SUCCESS) break;
+            c2h = GeneratorSource(config.generator, config.wire_format);
+            bar.emulate(config.user_map_size);
+            break;
+
+        default:
+            err = PCIeError::INVALID_PARAMETER;
+            break;
+    }
+
+    if (err != PCIeError::SUCCESS) {
+        close();
+    } else {
+        wrap_faults(config, 0, c2h);
+    }
+    return err;
+}
+
+void Transport::close() {
+    c2h = C2HSource();
+    h2c = H2CSink();
+    bar.release();
+    if (events_fd >= 0) ::close(events_fd);
+    events_fd = -1;
+    shm.reset();
+}
+
+PCIeError Transport::open_channel(const XDMADeviceConfig& config, const std::string& path,
+                                  size_t index, C2HSource& out) {
+    PCIeError err = PCIeError::SUCCESS;
+    switch (config.transport) {
+        case TransportKind::XDMA:
+        case TransportKind::FILE: {
+            int fd = open_node(path, O_RDONLY);
+            if (fd < 0) return PCIeError::OPEN_FAILED;
+            out = FdSource(fd);
+            break;
+        }
+
+        case TransportKind::SHM: {
+            std::shared_ptr<ShmSegment> segment;
+            err = open_segment(path, segment);
+            if (err == PCIeError::SUCCESS) out = ShmSource(std::move(segment));
+            break;
+        }
+
+        case TransportKind::GENERATOR: {
+            err = check_generator(config.generator);
+            if (err != PCIeError::SUCCESS) break;
+            GeneratorConfig generator = config.generator;
+            generator.seed += static_cast<uint32_t>(index);
+            out = GeneratorSource(generator, config.wire_format);
+            break;
+        }
+
+        default:
+            return PCIeError::INVALID_PARAMETER;
+    }
+
+    if (err == PCIeError::SUCCESS) {
+        wrap_faults(config, index, out);
+    }
+    return err;
+}
+
+// Shared-memory feed
+
+PCIeError ShmFeed::create(const std::string& name, size_t ring_bytes, size_t bar_bytes,
+                          size_t h2c_bytes) {
+    destroy();
+
+    // Power-of-two ring; regions kept cache-line aligned
+    size_t ring = 4096;
+    while (ring < ring_bytes) ring <<= 1;
+    bar_bytes = (std::max<size_t>(bar_bytes, 4096) + 63) & ~size_t(63);
+    h2c_bytes = (h2c_bytes + 63) & ~size_t(63);
+    size_t size = ShmSegment::total_size(bar_bytes, h2c_bytes, ring);
+
+    shm_unlink(name.c_str());   // Replace a segment a crashed producer left
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to create shared memory %s: %s\n", name.c_str(), strerror(errno));
+        return PCIeError::OPEN_FAILED;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) < 0) {
+        fprintf(stderr, "Failed to size shared memory %s: %s\n", name.c_str(), strerror(errno));
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return PCIeError::OPEN_FAILED;
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Failed to mmap shared memory %s: %s\n", name.c_str(), strerror(errno));
+        shm_unlink(name.c_str());
+        return PCIeError::MMAP_FAILED;
+    }
+
+    segment_ = std::make_unique<ShmSegment>();
+    segment_->base = static_cast<uint8_t*>(base);
+    segment_->size = size;
+    name_ = name;
+
+    ShmFeedHeader* h = new (base) ShmFeedHeader();
+    h->bar_bytes = bar_bytes;
+    h->h2c_bytes = h2c_bytes;
+    h->ring_bytes = ring;
+    h->head.store(0, std::memory_order_relaxed);
+    h->tail.store(0, std::memory_order_relaxed);
+    h->closed.store(0, std::memory_order_relaxed);
+    registers()[ControlRegisters::STATUS_OFFSET / 4] =
+        ControlRegisters::STATUS_RUNNING | ControlRegisters::STATUS_LINK_UP;
+
+    // Magic last: a reader that sees it sees a complete header
+    h->version = ShmFeedHeader::VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    h->magic = ShmFeedHeader::MAGIC;
+    return PCIeError::SUCCESS;
+}
+
+void ShmFeed::destroy() {
+    segment_.reset();
+    if (!name_.empty()) {
+        shm_unlink(name_.c_str());
+        name_.clear();
+    }
+}
+
+bool ShmFeed::write(const void* data, size_t size, uint32_t timeout_ms) {
+    if (!segment_) return false;
+    ShmFeedHeader* h = segment_->header();
+    if (size > h->ring_bytes) return false;
+
+    uint64_t head = h->head.load(std::memory_order_relaxed);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    IdleBackoff idle;
+    for (;;) {
+        uint64_t tail = h->tail.load(std::memory_order_acquire);
+        if (h->ring_bytes - (head - tail) >= size) break;
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        idle.wait();
+    }
+
+    uint8_t* ring = segment_->ring();
+    size_t offset = head & (h->ring_bytes - 1);
+    size_t first = std::min<size_t>(size, h->ring_bytes - offset);
+    std::memcpy(ring + offset, data, first);
+    std::memcpy(ring, static_cast<const uint8_t*>(data) + first, size - first);
+    h->head.store(head + size, std::memory_order_release);
+    return true;
+}
+
+void ShmFeed::close_stream() {
+    if (segment_) segment_->header()->closed.store(1, std::memory_order_release);
+}
+
+size_t ShmFeed::pending() const {
+    if (!segment_) return 0;
+    const ShmFeedHeader* h = segment_->header();
+    return h->head.load(std::memory_order_acquire) - h->tail.load(std::memory_order_acquire);
+}
+
+volatile uint32_t* ShmFeed::registers() const {
+    return segment_ ? reinterpret_cast<volatile uint32_t*>(segment_->bar()) : nullptr;
+}
+
+const uint8_t* ShmFeed::h2c() const {
+    return segment_ ? segment_->h2c() : nullptr;
+}
+
+}  // namespace pcie
@@ -0,0 +1,345 @@
+#include "xdma_device_pool.h"
+#include "spsc_ring.h"
+#include "thread_util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <shared_mutex>
+#include <thread>
+
+namespace pcie {
+
+/**
+ * Implementation details (PIMPL pattern)
+ */
+struct XDMADevicePool::Impl {
+    struct Device {
+        uint32_t index = 0;
+        std::string name;
+        XDMADeviceConfig config;
+        XDMAWrapper xdma;
+
+        // Held exclusively by the reader while it reopens the device, so
+        // get_latest() never sees the cache being replaced
+        mutable std::shared_mutex reopen_mutex;
+
+        std::unique_ptr<SpscRing<BBORecord>> ring;
+        std::thread reader;
+
+        // Written by the reader (or open/close), read from any thread
+        std::atomic<PoolDeviceState> state{PoolDeviceState::CLOSED};
+        std::atomic<PCIeError> last_error{PCIeError::SUCCESS};
+        std::atomic<uint64_t> records{0};
+        std::atomic<uint64_t> reads{0};
+        std::atomic<uint64_t> ring_full{0};
+        std::atomic<uint64_t> failures{0};
+        std::atomic<uint64_t> reopens{0};
+        std::atomic<uint64_t> last_record_ns{0};
+    };
+
+    std::vector<std::unique_ptr<Device>> devices;
+
+    // Streaming state
+    DevicePoolConfig config;
+    RecordCallback callback;
+    std::atomic<bool> streaming{false};
+    std::thread dispatcher;
+    std::atomic<uint64_t> delivered{0};
+
+    bool open_device(Device& dev);
+    void fail(Device& dev, PoolDeviceState state, PCIeError error);
+    void read_device(Device& dev);
+    void dispatch();
+    void stop();
+
+    ~Impl() { stop(); }
+};
+
+// Open (or reopen) one card; on failure it is left closed and FAILED
+bool XDMADevicePool::Impl::open_device(Device& dev) {
+    std::unique_lock<std::shared_mutex> lock(dev.reopen_mutex);
+    dev.xdma.close();
+    PCIeError err = dev.xdma.open(dev.config);
+    if (err != PCIeError::SUCCESS) {
+        dev.xdma.close();   // open() can fail with some nodes already open
+        dev.last_error = err;
+        dev.state = PoolDeviceState::FAILED;
+        return false;
+    }
+    dev.state = dev.xdma.is_link_up() ? PoolDeviceState::UP : PoolDeviceState::LINK_DOWN;
+    return true;
+}
+
+void XDMADevicePool::Impl::fail(Device& dev, PoolDeviceState state, PCIeError error) {
+    if (dev.state == PoolDeviceState::UP) {
+        bump(dev.failures);
+        fprintf(stderr, "Device %u (%s): %s, %s\n", dev.index, dev.name.c_str(),
+                pool_device_state_string(state), pcie_error_string(error));
+    }
+    dev.last_error = error;
+    dev.state = state;
+}
+
+void XDMADevicePool::Impl::read_device(Device& dev) {
+    using clock = std::chrono::steady_clock;
+
+    // Buffers below are allocated and first touched on the card's node
+    NumaPlacement placement = dev.xdma.get_numa_placement();
+    pin_current_thread(placement.cpus);
+    ScopedMemoryNode local(placement.node);
+
+    size_t batch = std::max<size_t>(config.batch_records, 1);
+    std::vector<BBORecord> records(batch);
+    auto link_period = std::chrono::milliseconds(std::max<uint32_t>(config.link_check_ms, 1));
+    auto next_link_check = clock::now();
+    auto next_reopen = clock::now() + std::chrono::milliseconds(config.reopen_ms);
+
+    while (streaming) {
+        auto now = clock::now();
+
+        if (dev.state == PoolDeviceState::FAILED) {
+            if (config.reopen_ms == 0 || now < next_reopen) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            next_reopen = now + std::chrono::milliseconds(config.reopen_ms);
+            if (open_device(dev)) {
+                bump(dev.reopens);
+                printf("Device %u (%s): reopened\n", dev.index, dev.name.c_str());
+            }
+            continue;
+        }
+
+        // One BAR read per period; a downed card stops being read
+        if (now >= next_link_check) {
+            next_link_check = now + link_period;
+            bool link_up = (dev.xdma.get_status() & ControlRegisters::STATUS_LINK_UP) != 0;
+            if (!link_up) {
+                fail(dev, PoolDeviceState::LINK_DOWN, PCIeError::LINK_DOWN);
+            } else if (dev.state == PoolDeviceState::LINK_DOWN) {
+                dev.state = PoolDeviceState::UP;
+                printf("Device %u (%s): link up\n", dev.index, dev.name.c_str());
+            }
+        }
+        if (dev.state == PoolDeviceState::LINK_DOWN) {
+            std::this_thread::sleep_for(std::min<clock::duration>(link_period,
+                                                                  std::chrono::milliseconds(10)));
+            continue;
+        }
+
+        int n = dev.xdma.read_records(records.data(), batch, 100);  // 100ms timeout
+        if (n < 0) {
+            fail(dev, PoolDeviceState::FAILED, PCIeError::READ_FAILED);
+            next_reopen = clock::now() + std::chrono::milliseconds(config.reopen_ms);
+            continue;
+        }
+        if (n == 0) continue;
+
+        // Ring full: hold this card's reads back until the dispatcher catches up
+        for (int i = 0; i < n && streaming; i++) {
+            if (dev.ring->try_push(records[i])) continue;
+            bump(dev.ring_full);
+            while (streaming && !dev.ring->try_push(records[i])) {
+                std::this_thread::yield();
+            }
+        }
+        bump(dev.records, static_cast<uint64_t>(n));
+        bump(dev.reads);
+        dev.last_record_ns.store(steady_ns(), std::memory_order_relaxed);
+    }
+}
+
+void XDMADevicePool::Impl::dispatch() {
+    size_t batch = std::max<size_t>(config.batch_records, 1);
+    BBORecord rec;
+    IdleBackoff idle;
+
+    while (streaming) {
+        // Round-robin, at most one batch per device per pass
+        uint64_t n = 0;
+        for (auto& dev : devices) {
+            for (size_t k = 0; k < batch && dev->ring->try_pop(rec); k++) {
+                if (callback) callback(dev->index, rec);
+                n++;
+            }
+        }
+
+        if (n > 0) {
+            bump(delivered, n);
+            idle.reset();
+            continue;
+        }
+
+        // Nothing ready: spin briefly, then back off
+        idle.wait();
+    }
+}
+
+void XDMADevicePool::Impl::stop() {
+    streaming = false;
+    for (auto& dev : devices) {
+        if (dev->reader.joinable()) dev->reader.join();
+    }
+    if (dispatcher.joinable()) dispatcher.join();
+}
+
+XDMADevicePool::XDMADevicePool() : pImpl(std::make_unique<Impl>()) {}
+
+XDMADevicePool::~XDMADevicePool() {
+    close();
+}
+
+PCIeError XDMADevicePool::open() {
+    return open_enumerated(XDMADeviceConfig());
+}
+
+PCIeError XDMADevicePool::open_enumerated(const XDMADeviceConfig& base) {
+    std::vector<XDMADeviceConfig> configs;
+    std::vector<std::string> names;
+
+    for (const auto& info : XDMADeviceDiscovery::enumerate_devices()) {
+        // A function with no driver nodes cannot be read
+        if (info.c2h_paths.empty() || info.user_path.empty()) continue;
+
+        XDMADeviceConfig paths = info.config();
+        XDMADeviceConfig config = base;
+        config.c2h_path = paths.c2h_path;
+        config.h2c_path = paths.h2c_path;
+        config.user_path = paths.user_path;
+        config.events_path = paths.events_path;
+        config.c2h_channels.clear();
+        if (!config.snapshot_path.empty()) {
+            config.snapshot_path += "." + std::to_string(configs.size());
+        }
+        configs.push_back(config);
+        names.push_back(info.pci_slot.empty() ? info.device_path : info.pci_slot);
+    }
+    if (configs.empty()) {
+        return PCIeError::DEVICE_NOT_FOUND;
+    }
+
+    PCIeError err = open(configs);
+    for (size_t i = 0; i < names.size(); i++) {
+        pImpl->devices[i]->name = names[i];
+    }
+    return err;
+}
+
+PCIeError XDMADevicePool::open(const std::vector<XDMADeviceConfig>& configs) {
+    close();
+    if (configs.empty()) {
+        return PCIeError::INVALID_PARAMETER;
+    }
+
+    size_t opened = 0;
+    for (size_t i = 0; i < configs.size(); i++) {
+        auto dev = std::make_unique<Impl::Device>();
+        dev->index = static_cast<uint32_t>(i);
+        dev->name = configs[i].c2h_path;
+        dev->config = configs[i];
+        if (pImpl->open_device(*dev)) {
+            opened++;
+        } else {
+            fprintf(stderr, "Device %zu (%s): open failed, %s\n", i, dev->name.c_str(),
+                    pcie_error_string(dev->last_error));
+        }
+        pImpl->devices.push_back(std::move(dev));
+    }
+    return opened > 0 ? PCIeError::SUCCESS : PCIeError::OPEN_FAILED;
+}
+
+void XDMADevicePool::close() {
+    if (!pImpl) return;
+    pImpl->stop();
+    for (auto& dev : pImpl->devices) {
+        dev->xdma.close();
+        dev->state = PoolDeviceState::CLOSED;
+    }
+    pImpl->devices.clear();
+}
+
+size_t XDMADevicePool::size() const {
+    return pImpl->devices.size();
+}
+
+XDMAWrapper& XDMADevicePool::device(uint32_t index) {
+    return pImpl->devices.at(index)->xdma;
+}
+
+PCIeError XDMADevicePool::start_streaming(RecordCallback callback, const DevicePoolConfig& config) {
+    if (pImpl->devices.empty()) {
+        return PCIeError::DEVICE_NOT_FOUND;
+    }
+    if (pImpl->streaming) {
+        return PCIeError::BUSY;
+    }
+    pImpl->stop();
+
+    pImpl->config = config;
+    pImpl->callback = std::move(callback);
+    pImpl->delivered = 0;
+    for (auto& dev : pImpl->devices) {
+        // Ring on the card's node, next to the reader that fills it
+        ScopedMemoryNode local(dev->xdma.get_numa_placement().node);
+        dev->ring = std::make_unique<SpscRing<BBORecord>>(config.ring_capacity);
+    }
+    pImpl->streaming = true;
+
+    for (auto& dev : pImpl->devices) {
+        Impl::Device* d = dev.get();
+        d->reader = std::thread([this, d]() { pImpl->read_device(*d); });
+    }
+    pImpl->dispatcher = std::thread([this]() { pImpl->dispatch(); });
+    return PCIeError::SUCCESS;
+}
+
+void XDMADevicePool::stop_streaming() {
+    pImpl->stop();
+}
+
+bool XDMADevicePool::is_streaming() const {
+    return pImpl->streaming;
+}
+
+bool XDMADevicePool::get_latest(uint32_t device, SymbolKey symbol, BBOQuote& quote) const {
+    if (device >= pImpl->devices.size()) return false;
+    const Impl::Device& dev = *pImpl->devices[device];
+    std::shared_lock<std::shared_mutex> lock(dev.reopen_mutex);
+    return dev.xdma.get_latest(symbol, quote);
+}
+
+PoolDeviceHealth XDMADevicePool::get_health(uint32_t device) const {
+    PoolDeviceHealth health;
+    if (device >= pImpl->devices.size()) return health;
+    const Impl::Device& dev = *pImpl->devices[device];
+
+    health.device = dev.index;
+    health.name = dev.name;
+    health.state = dev.state;
+    health.last_error = dev.last_error;
+    health.records = dev.records.load(std::memory_order_relaxed);
+    health.reads = dev.reads.load(std::memory_order_relaxed);
+    health.ring_full = dev.ring_full.load(std::memory_order_relaxed);
+    health.failures = dev.failures.load(std::memory_order_relaxed);
+    health.reopens = dev.reopens.load(std::memory_order_relaxed);
+    uint64_t last = dev.last_record_ns.load(std::memory_order_relaxed);
+    if (last != 0) {
+        uint64_t now = steady_ns();
+        health.idle_ms = now > last ? (now - last) / 1'000'000 : 0;
+    }
+    return health;
+}
+
+DevicePoolStats XDMADevicePool::get_stats() const {
+    DevicePoolStats stats;
+    for (uint32_t i = 0; i < pImpl->devices.size(); i++) {
+        stats.devices.push_back(get_health(i));
+        if (stats.devices.back().state == PoolDeviceState::UP) stats.up++;
+    }
+    stats.delivered = pImpl->delivered.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}  // namespace pcie
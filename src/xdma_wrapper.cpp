@@ -1,16 +1,23 @@
 #include "xdma_wrapper.h"
+#include "bbo_decode.h"
+#include "book_snapshot.h"
+#include "spsc_ring.h"
+#include "thread_util.h"
+#include "transport.h"
 
 #include <fcntl.h>
 #include <unistd.h>
-#include <sys/mman.h>
 #include <sys/stat.h>
-#include <sys/ioctl.h>
-#include <poll.h>
 #include <dirent.h>
+#include <cerrno>
+#include <algorithm>
+#include <climits>
 #include <cstring>
 #include <cstdio>
 #include <chrono>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
 #include <sstream>
 
 namespace pcie {
@@ -19,21 +26,103 @@ namespace pcie {
  * Implementation details (PIMPL pattern)
  */
 struct XDMAWrapper::Impl {
-    // File descriptors
-    int fd_c2h = -1;         // Card-to-Host DMA channel
-    int fd_h2c = -1;         // Host-to-Card DMA channel
-    int fd_user = -1;        // User/control registers
-    int fd_events = -1;      // Event/interrupt file
-
-    // Memory-mapped control registers
-    volatile uint32_t* ctrl_regs = nullptr;
-    size_t ctrl_regs_size = 4096;  // 4KB page
+    // C2H source, H2C sink and register BAR (backend chosen in open)
+    Transport transport;
 
     // Streaming state
     std::atomic<bool> streaming{false};
     std::thread stream_thread;
     BBOCallback stream_callback;
 
+    // Reset coordination: the streaming thread parks itself when
+    // pause_pending is raised and stays parked until pause_requested clears
+    std::mutex pause_mutex;
+    std::condition_variable pause_cv;
+    bool pause_requested = false;    // guarded by pause_mutex
+    uint32_t stream_threads = 0;     // guarded by pause_mutex; threads that must park
+    uint32_t parked_threads = 0;     // guarded by pause_mutex
+    std::atomic<bool> pause_pending{false};
+    std::atomic<bool> reset_in_progress{false};
+    ResetReport last_reset;          // guarded by pause_mutex
+
+    // Configuration passed to open()
+    XDMADeviceConfig config;
+
+    // Memory node and CPUs for the streaming path (decided in open)
+    NumaPlacement placement;
+
+    // Latest BBO per symbol (created on open, sized from the config).
+    // get_latest() and get_cache() load `cache` from any thread without a
+    // lock, so no cache is freed while the wrapper lives: a reopen clears
+    // the current one in place, and only a new max_symbols publishes a
+    // fresh cache, the old one staying in `caches` until destruction.
+    std::vector<std::unique_ptr<BBOCache>> caches;
+    std::atomic<BBOCache*> cache{nullptr};
+
+    BBOCache& book() const { return *cache.load(std::memory_order_acquire); }
+
+    // Book snapshot (config.snapshot_path) and its checkpoint thread
+    std::unique_ptr<BookSnapshot> snapshot;
+    std::thread snapshot_thread;
+    std::mutex snapshot_mutex;
+    std::condition_variable snapshot_cv;
+    bool snapshot_stop = false;      // guarded by snapshot_mutex
+
+    // Conflated delivery (created by start_conflated_streaming). Shared so
+    // a drain_conflated() still waiting on the old buffer outlives a restart.
+    std::shared_ptr<ConflationBuffer> conflation;
+    mutable std::mutex conflation_mutex;   // Guards the pointer, not the buffer
+
+    // Derived quotes (created by start_analytics_streaming)
+    std::unique_ptr<QuoteAnalytics> analytics;
+
+    // No-change suppression ahead of dispatch (set_dedup)
+    std::unique_ptr<DedupFilter> dedup;
+
+    // Multi-channel C2H (start_multichannel_streaming): one reader thread
+    // per channel feeding its ring, the stream thread dispatches
+    struct C2HChannel {
+        C2HSource* source = nullptr; // &own, or the transport's own C2H for channel 0
+        C2HSource own;
+        size_t carry = 0;            // Partial record bytes held by the reader
+        SpscRing<ChannelRecord> ring;
+        std::thread reader;
+        std::atomic<bool> finished{false};
+        std::atomic<uint64_t> records{0};
+        std::atomic<uint64_t> reads{0};
+        std::atomic<uint64_t> ring_full{0};
+        std::atomic<uint64_t> read_failures{0};   // Kept out of stats: written by the reader
+
+        explicit C2HChannel(size_t capacity) : ring(capacity) {}
+    };
+    std::vector<std::unique_ptr<C2HChannel>> channels;
+    std::unique_ptr<ChannelMerge> merge;
+    MultiChannelConfig multichannel;
+    ChannelCallback channel_callback;
+    std::atomic<uint64_t> channel_delivered{0};
+
+    // Symbol-sharded workers (created by start_sharded_streaming)
+    std::unique_ptr<ShardedDispatcher> sharded;
+    bool bulk_stream = false;        // Stream thread reads with read_records()
+
+    // Work-stealing workers (created by start_parallel_streaming)
+    std::unique_ptr<WorkStealingExecutor> executor;
+
+    // Bulk read buffer; the first rx_carry bytes are a partial record
+    std::vector<uint8_t> rx_buf;
+    size_t rx_carry = 0;
+    std::vector<BBORecord> rx_records;   // Decode target for read_columns
+
+    // read_bbo(): a record a short read left incomplete
+    uint8_t bbo_stage[sizeof(BBOData)];
+    size_t bbo_staged = 0;
+
+    // errno of the last failed C2H read, 0 when the stream simply ended
+    int read_errno = 0;
+
+    // Fault injection stats of channel sources already closed
+    FaultStats closed_faults;
+
     // Statistics
     TransferStats stats;
     std::atomic<uint64_t> bbo_read_count{0};
@@ -41,23 +130,33 @@ struct XDMAWrapper::Impl {
     // Device info
     bool link_up = false;
 
+    // STATUS_FIFO_FULL watch (config.status_poll_ms)
+    uint64_t next_status_poll_ns = 0;
+    bool overflow_latched = false;
+
+    void poll_status(XDMAWrapper& self, uint64_t now_ns);
+    bool retry_read(int err, const char* what, uint64_t& failing_since_ns, uint32_t& backoff_ms,
+                    std::atomic<uint64_t>* failures = nullptr);
+    void park_stream_thread();
+    bool pause_stream(std::chrono::steady_clock::time_point deadline);
+    void resume_stream();
+    void start_snapshots();
+    void stop_snapshots();
+    void drain_c2h(C2HSource& source, size_t record_size, size_t partial, ResetReport& report,
+                   std::chrono::steady_clock::time_point deadline);
+    void join_stream();
+    void place(const XDMADeviceConfig& config);
+    void pin_stream_thread() const;
+    template <typename Source>
+    void read_channel(C2HChannel& ch, Source& source, size_t index);
+    void dispatch_record(uint32_t channel, const ChannelRecord& item, size_t record_size);
+    ResetReport run_reset(XDMAWrapper& self, uint32_t timeout_ms);
+
     ~Impl() {
         // Ensure streaming is stopped
         streaming = false;
-        if (stream_thread.joinable()) {
-            stream_thread.join();
-        }
-
-        // Unmap control registers
-        if (ctrl_regs != nullptr && ctrl_regs != MAP_FAILED) {
-            munmap(const_cast<uint32_t*>(ctrl_regs), ctrl_regs_size);
-        }
-
-        // Close file descriptors
-        if (fd_c2h >= 0) close(fd_c2h);
-        if (fd_h2c >= 0) close(fd_h2c);
-        if (fd_user >= 0) close(fd_user);
-        if (fd_events >= 0) close(fd_events);
+        join_stream();
+        stop_snapshots();
     }
 };
 
@@ -71,52 +170,53 @@ XDMAWrapper::XDMAWrapper(XDMAWrapper&&) noexcept = default;
 XDMAWrapper& XDMAWrapper::operator=(XDMAWrapper&&) noexcept = default;
 
 PCIeError XDMAWrapper::open() {
+    return open(XDMADeviceConfig());
+}
+
+PCIeError XDMAWrapper::open(const XDMADeviceConfig& config) {
     // Check if driver is loaded
-    if (!XDMADeviceDiscovery::is_driver_loaded()) {
+    if (config.transport == TransportKind::XDMA && config.require_driver &&
+        !XDMADeviceDiscovery::is_driver_loaded()) {
         fprintf(stderr, "XDMA driver not loaded. Run: sudo modprobe xdma\n");
         return PCIeError::DEVICE_NOT_FOUND;
     }
 
-    // Open C2H channel (for reading BBO data)
-    pImpl->fd_c2h = ::open(XDMADevicePaths::C2H_0, O_RDONLY);
-    if (pImpl->fd_c2h < 0) {
-        fprintf(stderr, "Failed to open %s: %s\n",
-                XDMADevicePaths::C2H_0, strerror(errno));
-        return PCIeError::OPEN_FAILED;
+    // C2H, H2C and the mapped register BAR
+    PCIeError err = pImpl->transport.open(config);
+    if (err != PCIeError::SUCCESS) {
+        return err;
     }
 
-    // Open H2C channel (for writing commands)
-    pImpl->fd_h2c = ::open(XDMADevicePaths::H2C_0, O_WRONLY);
-    if (pImpl->fd_h2c < 0) {
-        fprintf(stderr, "Failed to open %s: %s\n",
-                XDMADevicePaths::H2C_0, strerror(errno));
-        return PCIeError::OPEN_FAILED;
-    }
+    pImpl->config = config;
+    pImpl->place(config);
 
-    // Open user/control interface for mmap
-    pImpl->fd_user = ::open(XDMADevicePaths::USER, O_RDWR | O_SYNC);
-    if (pImpl->fd_user < 0) {
-        fprintf(stderr, "Failed to open %s: %s\n",
-                XDMADevicePaths::USER, strerror(errno));
-        return PCIeError::OPEN_FAILED;
+    // Per-symbol cache; outlives close() so late readers stay valid
+    BBOCache* current = pImpl->cache.load(std::memory_order_relaxed);
+    if (current && current->capacity() == config.max_symbols) {
+        current->clear();  // Keeps the node it was first placed on
+    } else {
+        ScopedMemoryNode local(pImpl->placement.node);
+        pImpl->caches.push_back(std::make_unique<BBOCache>(config.max_symbols));
+        pImpl->cache.store(pImpl->caches.back().get(), std::memory_order_release);
     }
 
-    // Memory-map control registers
-    pImpl->ctrl_regs = static_cast<volatile uint32_t*>(
-        mmap(nullptr, pImpl->ctrl_regs_size,
-             PROT_READ | PROT_WRITE, MAP_SHARED,
-             pImpl->fd_user, 0));
-
-    if (pImpl->ctrl_regs == MAP_FAILED) {
-        fprintf(stderr, "Failed to mmap control registers: %s\n", strerror(errno));
-        pImpl->ctrl_regs = nullptr;
-        return PCIeError::MMAP_FAILED;
+    // Warm start: a missing or unusable snapshot is not fatal
+    if (!config.snapshot_path.empty()) {
+        auto snapshot = std::make_unique<BookSnapshot>();
+        if (snapshot->open(config.snapshot_path, config.max_symbols) == PCIeError::SUCCESS) {
+            uint64_t generation = 0;
+            size_t restored = snapshot->load(pImpl->book(), &generation);
+            if (generation > 0) {
+                printf("Warm start: %zu symbols from snapshot generation %lu (stale until refreshed)\n",
+                       restored, generation);
+            }
+            pImpl->snapshot = std::move(snapshot);
+            pImpl->start_snapshots();
+        } else {
+            fprintf(stderr, "Warning: book snapshot disabled\n");
+        }
     }
 
-    // Open events file (optional - for interrupt-driven mode)
-    pImpl->fd_events = ::open(XDMADevicePaths::EVENTS_0, O_RDONLY);
-    // Events file is optional, don't fail if not present
-
     // Check link status
     uint32_t status = get_status();
     pImpl->link_up = (status & ControlRegisters::STATUS_LINK_UP) != 0;
@@ -127,30 +227,44 @@ PCIeError XDMAWrapper::open() {
 
     // Read and display version
     uint32_t version = get_version();
-    printf("XDMA device opened. Version: 0x%08X, Link: %s\n",
-           version, pImpl->link_up ? "UP" : "DOWN");
+    if (config.transport == TransportKind::XDMA) {
+        printf("XDMA device opened. Version: 0x%08X, Link: %s\n",
+               version, pImpl->link_up ? "UP" : "DOWN");
+    } else {
+        printf("Transport %s opened. Version: 0x%08X, Link: %s\n",
+               transport_kind_string(config.transport), version, pImpl->link_up ? "UP" : "DOWN");
+    }
 
     return PCIeError::SUCCESS;
 }
 
 void XDMAWrapper::close() {
-    stop_streaming();
+    if (!pImpl) return;
 
-    if (pImpl) {
-        if (pImpl->ctrl_regs != nullptr && pImpl->ctrl_regs != MAP_FAILED) {
-            munmap(const_cast<uint32_t*>(pImpl->ctrl_regs), pImpl->ctrl_regs_size);
-            pImpl->ctrl_regs = nullptr;
-        }
+    // An in-flight reset sequence still owns the descriptors
+    while (pImpl->reset_in_progress) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    stop_streaming();
 
-        if (pImpl->fd_c2h >= 0) { ::close(pImpl->fd_c2h); pImpl->fd_c2h = -1; }
-        if (pImpl->fd_h2c >= 0) { ::close(pImpl->fd_h2c); pImpl->fd_h2c = -1; }
-        if (pImpl->fd_user >= 0) { ::close(pImpl->fd_user); pImpl->fd_user = -1; }
-        if (pImpl->fd_events >= 0) { ::close(pImpl->fd_events); pImpl->fd_events = -1; }
+    // Final checkpoint holds everything up to the last record read
+    pImpl->stop_snapshots();
+    if (pImpl->snapshot) {
+        pImpl->snapshot->checkpoint(pImpl->book());
+        pImpl->snapshot.reset();
     }
+
+    pImpl->transport.close();
+    pImpl->rx_carry = 0;
+    pImpl->bbo_staged = 0;
+    pImpl->closed_faults = FaultStats();
+    pImpl->next_status_poll_ns = 0;
+    pImpl->overflow_latched = false;
 }
 
 bool XDMAWrapper::is_open() const {
-    return pImpl && pImpl->fd_c2h >= 0 && pImpl->ctrl_regs != nullptr;
+    return pImpl && pImpl->transport.is_open();
 }
 
 bool XDMAWrapper::is_link_up() const {
@@ -162,29 +276,35 @@ PCIeError XDMAWrapper::read_bbo(BBOData& bbo, uint32_t timeout_ms) {
         return PCIeError::DEVICE_NOT_FOUND;
     }
 
-    // Use poll() for timeout handling
-    if (timeout_ms > 0) {
-        struct pollfd pfd;
-        pfd.fd = pImpl->fd_c2h;
-        pfd.events = POLLIN;
-
-        int ret = poll(&pfd, 1, static_cast<int>(timeout_ms));
-        if (ret < 0) {
-            return PCIeError::READ_FAILED;
-        }
-        if (ret == 0) {
-            return PCIeError::TIMEOUT;
-        }
+    // Read BBO data. A short read is staged and completed by further reads
+    // within the timeout, or by the next call, so the stream stays aligned.
+    Impl& im = *pImpl;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    uint32_t wait_ms = timeout_ms;
+    ssize_t n;
+    for (;;) {
+        errno = 0;
+        n = read_c2h(im.transport.c2h, im.bbo_stage + im.bbo_staged,
+                     sizeof(BBOData) - im.bbo_staged, wait_ms);
+        im.read_errno = n < 0 ? errno : 0;
+        if (n <= 0) break;
+        im.bbo_staged += static_cast<size_t>(n);
+        if (im.bbo_staged == sizeof(BBOData)) break;
+
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        wait_ms = static_cast<uint32_t>(std::max<int64_t>(left, 0));
     }
-
-    // Read BBO data
-    ssize_t n = read(pImpl->fd_c2h, &bbo, sizeof(BBOData));
+    uint64_t now_ns = steady_ns();
+    im.poll_status(*this, now_ns);
     if (n < 0) {
-        return PCIeError::READ_FAILED;
+        return PCIeError::READ_FAILED;  // read_errno 0: end of stream
     }
-    if (n < static_cast<ssize_t>(sizeof(BBOData))) {
-        return PCIeError::READ_FAILED;
+    if (im.bbo_staged < sizeof(BBOData)) {
+        return PCIeError::TIMEOUT;
     }
+    std::memcpy(&bbo, im.bbo_stage, sizeof(BBOData));
+    im.bbo_staged = 0;
 
     // Update statistics
     pImpl->stats.bytes_transferred += sizeof(BBOData);
@@ -195,6 +315,8 @@ PCIeError XDMAWrapper::read_bbo(BBOData& bbo, uint32_t timeout_ms) {
     double latency = bbo.get_fpga_latency_us();
     pImpl->stats.update_latency(latency);
 
+    pImpl->book().update(bbo, now_ns);
+
     return PCIeError::SUCCESS;
 }
 
@@ -213,12 +335,11 @@ int XDMAWrapper::read_bbos(std::vector<BBOData>& bbos, size_t max_count, uint32_
         BBOData bbo;
         PCIeError err = read_bbo(bbo, remaining_ms);
 
+        // An early empty read (EINTR, EAGAIN) is not the end of the wait
         if (err == PCIeError::SUCCESS) {
             bbos.push_back(bbo);
-        } else if (err == PCIeError::TIMEOUT) {
-            break;
-        } else {
-            return -1;
+        } else if (err != PCIeError::TIMEOUT) {
+            return bbos.empty() ? -1 : static_cast<int>(bbos.size());
         }
 
         // Update remaining timeout
@@ -230,23 +351,78 @@ int XDMAWrapper::read_bbos(std::vector<BBOData>& bbos, size_t max_count, uint32_
     return static_cast<int>(bbos.size());
 }
 
-PCIeError XDMAWrapper::write_data(const void* data, size_t size, uint64_t offset) {
-    if (!is_open() || pImpl->fd_h2c < 0) {
-        return PCIeError::DEVICE_NOT_FOUND;
+int XDMAWrapper::read_records(BBORecord* out, size_t max_count, uint32_t timeout_ms) {
+    if (!is_open()) {
+        return -1;
+    }
+    if (max_count == 0) {
+        return 0;
     }
 
-    // Seek to offset
-    if (lseek(pImpl->fd_h2c, static_cast<off_t>(offset), SEEK_SET) < 0) {
-        return PCIeError::WRITE_FAILED;
+    WireFormat format = pImpl->config.wire_format;
+    size_t record_size = wire_record_size(format);
+    size_t want = max_count * record_size;
+    if (pImpl->rx_buf.size() < want) {
+        ScopedMemoryNode local(pImpl->placement.node);
+        pImpl->rx_buf.resize(want);
     }
 
-    // Write data
-    ssize_t n = write(pImpl->fd_h2c, data, size);
-    if (n < 0 || static_cast<size_t>(n) != size) {
-        return PCIeError::WRITE_FAILED;
+    uint8_t* buf = pImpl->rx_buf.data();
+    errno = 0;
+    ssize_t n = read_c2h(pImpl->transport.c2h, buf + pImpl->rx_carry, want - pImpl->rx_carry,
+                         timeout_ms);
+    pImpl->read_errno = n < 0 ? errno : 0;
+    uint64_t now_ns = steady_ns();
+    pImpl->poll_status(*this, now_ns);
+    if (n <= 0) {
+        return static_cast<int>(n);  // 0: timeout, -1: error or end of stream
     }
 
-    return PCIeError::SUCCESS;
+    size_t avail = pImpl->rx_carry + static_cast<size_t>(n);
+    size_t count = avail / record_size;
+    size_t used = count * record_size;
+
+    size_t bad = decode_bbo_batch(buf, count, out, format);
+
+    // Keep the partial tail for the next call
+    pImpl->rx_carry = avail - used;
+    if (pImpl->rx_carry > 0) {
+        std::memmove(buf, buf + used, pImpl->rx_carry);
+    }
+
+    // Records with bad padding are still returned, flagged, for the caller to judge
+    pImpl->stats.bytes_transferred += used;
+    pImpl->stats.transfers_failed += bad;
+    pImpl->bbo_read_count += count;
+
+    // Counted per record, as read_bbo() does
+    for (size_t i = 0; i < count; i++) {
+        pImpl->stats.transfers_completed++;
+        pImpl->stats.update_latency(out[i].get_fpga_latency_us());
+        pImpl->book().update(out[i], now_ns);
+    }
+
+    return static_cast<int>(count);
+}
+
+int XDMAWrapper::read_columns(BBOColumns& cols, size_t max_count, uint32_t timeout_ms) {
+    if (pImpl->rx_records.size() < max_count) {
+        ScopedMemoryNode local(pImpl->placement.node);
+        pImpl->rx_records.resize(max_count);
+    }
+
+    int n = read_records(pImpl->rx_records.data(), max_count, timeout_ms);
+    if (n > 0) {
+        cols.append(pImpl->rx_records.data(), static_cast<size_t>(n));
+    }
+    return n;
+}
+
+PCIeError XDMAWrapper::write_data(const void* data, size_t size, uint64_t offset) {
+    if (!is_open()) {
+        return PCIeError::DEVICE_NOT_FOUND;
+    }
+    return pImpl->transport.write_h2c(data, size, offset);
 }
 
 // Control Register Access
@@ -266,24 +442,6 @@ PCIeError XDMAWrapper::set_enabled(bool enable) {
     return PCIeError::SUCCESS;
 }
 
-PCIeError XDMAWrapper::reset() {
-    if (!is_open()) {
-        return PCIeError::DEVICE_NOT_FOUND;
-    }
-
-    // Assert reset
-    uint32_t ctrl = read_register(ControlRegisters::CONTROL_OFFSET);
-    write_register(ControlRegisters::CONTROL_OFFSET, ctrl | ControlRegisters::CTRL_RESET);
-
-    // Wait briefly
-    usleep(1000);  // 1ms
-
-    // Deassert reset
-    write_register(ControlRegisters::CONTROL_OFFSET, ctrl & ~ControlRegisters::CTRL_RESET);
-
-    return PCIeError::SUCCESS;
-}
-
 bool XDMAWrapper::get_enabled() const {
     if (!is_open()) return false;
     return (read_register(ControlRegisters::CONTROL_OFFSET) & ControlRegisters::CTRL_ENABLE) != 0;
@@ -304,54 +462,298 @@ uint32_t XDMAWrapper::get_version() const {
     return read_register(ControlRegisters::VERSION_OFFSET);
 }
 
-PCIeError XDMAWrapper::set_symbol_filter(uint32_t index, const std::string& symbol) {
+// Reset Sequence
+// The FIFO overflow bit is sticky, so a poll every status_poll_ms sees
+// every event; one register read per period keeps MMIO off the hot path
+void XDMAWrapper::Impl::poll_status(XDMAWrapper& self, uint64_t now_ns) {
+    if (config.status_poll_ms == 0 || now_ns < next_status_poll_ns) return;
+    next_status_poll_ns = now_ns + static_cast<uint64_t>(config.status_poll_ms) * 1000000;
+
+    bool overflow = (self.read_register(ControlRegisters::STATUS_OFFSET) &
+                     ControlRegisters::STATUS_FIFO_FULL) != 0;
+    if (overflow && !overflow_latched) {
+        stats.fifo_overflows++;
+        fprintf(stderr, "FPGA FIFO overflow: updates dropped before C2H (BBO count %u)\n",
+                self.read_register(ControlRegisters::BBO_COUNT_OFFSET));
+    }
+    overflow_latched = overflow;
+}
+
+// Streaming read failures
+// An error from the driver (EIO while the link retrains, say) is retried
+// with doubling back-off up to config.read_retry_max_ms, and streaming
+// only stops once reads have failed for read_error_limit_ms. End of
+// stream (no errno) stops at once. The first failure of a run and the
+// recovery are logged, not every retry. Failures count in stats, owned by
+// the stream thread, or in the channel reader's own failures counter.
+bool XDMAWrapper::Impl::retry_read(int err, const char* what, uint64_t& failing_since_ns,
+                                   uint32_t& backoff_ms, std::atomic<uint64_t>* failures) {
+    if (err == 0) return false;  // End of stream
+
+    uint64_t now_ns = steady_ns();
+    if (failures) {
+        bump(*failures);
+    } else {
+        stats.transfers_failed++;
+    }
+    if (failing_since_ns == 0) {
+        failing_since_ns = now_ns;
+        backoff_ms = 1;
+        fprintf(stderr, "%s: read failed: %s, retrying\n", what, strerror(err));
+    } else if (config.read_error_limit_ms != 0 &&
+               now_ns - failing_since_ns >= static_cast<uint64_t>(config.read_error_limit_ms) * 1000000) {
+        fprintf(stderr, "%s: reads failing for %u ms, giving up: %s\n",
+                what, config.read_error_limit_ms, strerror(err));
+        return false;
+    }
+
+    // Sleep in short steps so stop and reset requests are not held up
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(backoff_ms);
+    while (streaming && !pause_pending.load(std::memory_order_acquire) &&
+           std::chrono::steady_clock::now() < until) {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    backoff_ms = std::min(backoff_ms * 2, std::max<uint32_t>(config.read_retry_max_ms, 1));
+    return true;
+}
+
+void XDMAWrapper::Impl::park_stream_thread() {
+    std::unique_lock<std::mutex> lock(pause_mutex);
+    parked_threads++;
+    pause_cv.notify_all();
+    pause_cv.wait(lock, [this] { return !pause_requested || !streaming; });
+    parked_threads--;
+}
+
+bool XDMAWrapper::Impl::pause_stream(std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(pause_mutex);
+    pause_requested = true;
+    pause_pending.store(true, std::memory_order_release);
+
+    // Streaming threads notice the flag between reads (at most one read
+    // timeout away) and acknowledge by parking
+    return pause_cv.wait_until(lock, deadline, [this] {
+        return parked_threads >= stream_threads || !streaming;
+    });
+}
+
+void XDMAWrapper::Impl::resume_stream() {
+    {
+        std::lock_guard<std::mutex> lock(pause_mutex);
+        pause_requested = false;
+        pause_pending.store(false, std::memory_order_release);
+    }
+    pause_cv.notify_all();
+}
+
+void XDMAWrapper::Impl::drain_c2h(C2HSource& source, size_t record_size, size_t partial,
+                                  ResetReport& report,
+                                  std::chrono::steady_clock::time_point deadline) {
+    // A feed that never runs dry would otherwise hold the blackout open
+    // until the deadline; past this much the stale data is gone anyway
+    constexpr uint64_t DRAIN_LIMIT = 256 * 1024;
+
+    // Whole number of records per read so a drain that ends on an empty
+    // read also ends on a record boundary
+    uint8_t scratch[4096];
+    size_t chunk = sizeof(scratch) / record_size * record_size;
+    size_t start = partial;  // Bytes of the current record a reader already took
+    uint64_t drained = 0;
+
+    for (;;) {
+        auto now = std::chrono::steady_clock::now();
+        int wait_ms = 0;
+        if (partial != 0) {
+            // Mid-record: wait (bounded) for the rest of it
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+            wait_ms = static_cast<int>(std::max<int64_t>(left, 1));
+        } else if (now >= deadline || drained >= DRAIN_LIMIT) {
+            break;  // On a boundary and out of budget
+        }
+
+        size_t want = (partial == 0) ? chunk : record_size - partial;
+        ssize_t n = read_c2h(source, scratch, want, static_cast<uint32_t>(wait_ms));
+        if (n <= 0) break;  // Empty, or the stream ended
+
+        drained += static_cast<uint64_t>(n);
+        partial = (partial + static_cast<size_t>(n)) % record_size;
+    }
+
+    report.drained_bytes += drained;
+    report.drained_records += (start + drained) / record_size;
+}
+
+static bool wait_register(const XDMAWrapper& xdma, uint32_t offset, uint32_t mask,
+                          uint32_t expected, std::chrono::steady_clock::time_point deadline,
+                          uint32_t& polls) {
+    for (uint32_t spin = 0;; spin++) {
+        polls++;
+        if ((xdma.read_register(offset) & mask) == expected) {
+            return true;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        // Tight polling first (AXI-Lite round trip is ~1 us), then back off
+        if (spin < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+    }
+}
+
+ResetReport XDMAWrapper::Impl::run_reset(XDMAWrapper& self, uint32_t timeout_ms) {
+    using clock = std::chrono::steady_clock;
+    const auto budget = std::chrono::milliseconds(timeout_ms);
+    ResetReport report;
+
+    // 1. Pause dispatch. Allow one streaming read timeout on top of the budget.
+    auto t_pause = clock::now();
+    bool was_streaming = streaming.load();
+    if (was_streaming && !pause_stream(t_pause + budget + std::chrono::milliseconds(100))) {
+        resume_stream();
+        report.error = PCIeError::TIMEOUT;
+        return report;
+    }
+    report.was_streaming = was_streaming && streaming.load();
+
+    // 2. Drain C2H so nothing half-read survives into the post-reset stream
+    auto t_drain = clock::now() + budget;
+    bool multichannel = false;
+    for (const auto& ch : channels) {
+        if (!ch->source) continue;
+        drain_c2h(*ch->source, wire_record_size(config.wire_format), ch->carry, report, t_drain);
+        multichannel = true;
+    }
+    if (!multichannel && bulk_stream) {
+        drain_c2h(transport.c2h, wire_record_size(config.wire_format), rx_carry, report, t_drain);
+        rx_carry = 0;
+    } else if (!multichannel) {
+        drain_c2h(transport.c2h, sizeof(BBOData), bbo_staged, report, t_drain);
+        bbo_staged = 0;
+    }
+
+    // 3. Snapshot configuration the reset would otherwise leave behind
+    uint32_t ctrl = self.read_register(ControlRegisters::CONTROL_OFFSET) &
+                    ~ControlRegisters::CTRL_RESET;
+    constexpr uint32_t filter_words = ControlRegisters::SYMBOL_FILTER_SLOTS * 2;
+    uint32_t filters[filter_words];
+    for (uint32_t i = 0; i < filter_words; i++) {
+        filters[i] = self.read_register(ControlRegisters::SYMBOL_FILTER_0_OFFSET + i * 4);
+    }
+
+    // 4. Pulse reset. MMIO writes are posted, so read CONTROL back to know
+    //    each edge has landed instead of sleeping a fixed interval.
+    auto t_reset = clock::now();
+    self.write_register(ControlRegisters::CONTROL_OFFSET, ctrl | ControlRegisters::CTRL_RESET);
+    bool asserted = wait_register(self, ControlRegisters::CONTROL_OFFSET,
+                                  ControlRegisters::CTRL_RESET, ControlRegisters::CTRL_RESET,
+                                  t_reset + budget, report.status_polls);
+    self.write_register(ControlRegisters::CONTROL_OFFSET, ctrl);
+    bool released = wait_register(self, ControlRegisters::CONTROL_OFFSET,
+                                  ControlRegisters::CTRL_RESET, 0,
+                                  clock::now() + budget, report.status_polls);
+
+    // 5. Restore filters and enable state. Words under the timestamp and
+    //    latency registers would write stale values over the fresh ones.
+    for (uint32_t i = 0; i < filter_words; i++) {
+        uint32_t offset = ControlRegisters::SYMBOL_FILTER_0_OFFSET + i * 4;
+        if (ControlRegisters::is_status_word(offset)) continue;
+        self.write_register(offset, filters[i]);
+    }
+    self.write_register(ControlRegisters::CONTROL_OFFSET, ctrl);
+
+    // 6. STATUS_RUNNING needs enable and data in the CDC FIFO, so an idle
+    //    feed legitimately never shows it; report rather than fail.
+    if (ctrl & ControlRegisters::CTRL_ENABLE) {
+        report.running_confirmed = wait_register(self, ControlRegisters::STATUS_OFFSET,
+                                                 ControlRegisters::STATUS_RUNNING,
+                                                 ControlRegisters::STATUS_RUNNING,
+                                                 clock::now() + budget, report.status_polls);
+    }
+    report.reset_us = std::chrono::duration<double, std::micro>(clock::now() - t_reset).count();
+
+    // 7. Resume dispatch
+    if (was_streaming) {
+        resume_stream();
+    }
+    report.blackout_us = std::chrono::duration<double, std::micro>(clock::now() - t_pause).count();
+
+    if (!asserted || !released) {
+        report.error = PCIeError::TIMEOUT;
+    }
+    return report;
+}
+
+PCIeError XDMAWrapper::reset() {
+    // Called from the streaming callback the pause could never be acknowledged
+    if (pImpl->stream_thread.get_id() == std::this_thread::get_id()) {
+        return PCIeError::BUSY;
+    }
+    return reset_async().get().error;
+}
+
+std::future<ResetReport> XDMAWrapper::reset_async(uint32_t timeout_ms) {
+    if (!is_open() || pImpl->reset_in_progress.exchange(true)) {
+        std::promise<ResetReport> rejected;
+        ResetReport report;
+        report.error = is_open() ? PCIeError::BUSY : PCIeError::DEVICE_NOT_FOUND;
+        rejected.set_value(report);
+        return rejected.get_future();
+    }
+
+    return std::async(std::launch::async, [this, timeout_ms]() {
+        ResetReport report = pImpl->run_reset(*this, timeout_ms);
+        {
+            std::lock_guard<std::mutex> lock(pImpl->pause_mutex);
+            pImpl->last_reset = report;
+        }
+        pImpl->reset_in_progress = false;
+        return report;
+    });
+}
+
+ResetReport XDMAWrapper::get_last_reset_report() const {
+    std::lock_guard<std::mutex> lock(pImpl->pause_mutex);
+    return pImpl->last_reset;
+}
+
+PCIeError XDMAWrapper::set_symbol_filter(uint32_t index, SymbolKey symbol) {
     if (!is_open()) {
         return PCIeError::DEVICE_NOT_FOUND;
     }
-    if (index > 7) {
+    if (index >= ControlRegisters::SYMBOL_FILTER_SLOTS) {
         return PCIeError::INVALID_PARAMETER;
     }
 
-    // Prepare 8-byte symbol (space-padded)
-    char sym_buf[8];
-    memset(sym_buf, ' ', 8);
-    size_t copy_len = std::min(symbol.length(), size_t(8));
-    memcpy(sym_buf, symbol.c_str(), copy_len);
-
-    // Write as two 32-bit words
+    // Key bytes are already the space-padded register image;
+    // write as two 32-bit words
     uint32_t offset = ControlRegisters::SYMBOL_FILTER_0_OFFSET + (index * 8);
-    uint32_t word0, word1;
-    memcpy(&word0, sym_buf, 4);
-    memcpy(&word1, sym_buf + 4, 4);
-
-    write_register(offset, word0);
-    write_register(offset + 4, word1);
+    write_register(offset, static_cast<uint32_t>(symbol.raw()));
+    write_register(offset + 4, static_cast<uint32_t>(symbol.raw() >> 32));
 
     return PCIeError::SUCCESS;
 }
 
-std::string XDMAWrapper::get_symbol_filter(uint32_t index) const {
-    if (!is_open() || index > 7) {
-        return "";
+PCIeError XDMAWrapper::set_symbol_filter(uint32_t index, const std::string& symbol) {
+    return set_symbol_filter(index, SymbolKey(symbol));
+}
+
+SymbolKey XDMAWrapper::get_symbol_filter_key(uint32_t index) const {
+    if (!is_open() || index >= ControlRegisters::SYMBOL_FILTER_SLOTS) {
+        return SymbolKey();
     }
 
     uint32_t offset = ControlRegisters::SYMBOL_FILTER_0_OFFSET + (index * 8);
-    uint32_t word0 = read_register(offset);
-    uint32_t word1 = read_register(offset + 4);
-
-    char sym_buf[9];
-    memcpy(sym_buf, &word0, 4);
-    memcpy(sym_buf + 4, &word1, 4);
-    sym_buf[8] = '\0';
+    uint64_t word0 = read_register(offset);
+    uint64_t word1 = read_register(offset + 4);
 
-    // Trim trailing spaces
-    int len = 7;
-    while (len >= 0 && sym_buf[len] == ' ') {
-        sym_buf[len] = '\0';
-        len--;
-    }
+    return SymbolKey::from_raw(word0 | (word1 << 32));
+}
 
-    return std::string(sym_buf);
+std::string XDMAWrapper::get_symbol_filter(uint32_t index) const {
+    return std::string(get_symbol_filter_key(index).view());
 }
 
 uint32_t XDMAWrapper::get_last_rx_timestamp() const {
@@ -380,14 +782,40 @@ PCIeError XDMAWrapper::start_streaming(BBOCallback callback) {
         return PCIeError::SUCCESS;  // Already streaming
     }
 
+    // A previous stream may have ended on its own after an error
+    pImpl->join_stream();
+
     pImpl->stream_callback = std::move(callback);
+    pImpl->bulk_stream = false;
+    pImpl->stream_threads = 1;
     pImpl->streaming = true;
 
     pImpl->stream_thread = std::thread([this]() {
+        pImpl->pin_stream_thread();
         BBOData bbo;
+        uint64_t failing_since_ns = 0;   // First failed read of the current run, 0 = reading fine
+        uint32_t backoff_ms = 0;
 
         while (pImpl->streaming) {
+            // Reset sequence in progress: park between records
+            if (pImpl->pause_pending.load(std::memory_order_acquire)) {
+                pImpl->park_stream_thread();
+                continue;
+            }
+
             PCIeError err = read_bbo(bbo, 100);  // 100ms timeout
+            if (err == PCIeError::READ_FAILED) {
+                if (pImpl->retry_read(pImpl->read_errno, "Streaming", failing_since_ns, backoff_ms)) continue;
+                break;
+            }
+            if (failing_since_ns != 0 && err == PCIeError::SUCCESS) {
+                fprintf(stderr, "Streaming: reads recovered\n");
+                failing_since_ns = 0;
+            }
+
+            if (err == PCIeError::SUCCESS && pImpl->dedup && !pImpl->dedup->accept(bbo)) {
+                continue;  // Top of book unchanged
+            }
 
             if (err == PCIeError::SUCCESS && pImpl->stream_callback) {
                 pImpl->stream_callback(bbo);
@@ -396,88 +824,838 @@ PCIeError XDMAWrapper::start_streaming(BBOCallback callback) {
                 break;
             }
         }
+
+        // Let a pending reset know there is nothing left to pause
+        {
+            std::lock_guard<std::mutex> lock(pImpl->pause_mutex);
+            pImpl->streaming = false;
+        }
+        pImpl->pause_cv.notify_all();
     });
 
     return PCIeError::SUCCESS;
 }
 
 void XDMAWrapper::stop_streaming() {
-    pImpl->streaming = false;
-    if (pImpl->stream_thread.joinable()) {
-        pImpl->stream_thread.join();
+    {
+        std::lock_guard<std::mutex> lock(pImpl->pause_mutex);
+        pImpl->streaming = false;
     }
+    pImpl->pause_cv.notify_all();
+    pImpl->join_stream();
 }
 
 bool XDMAWrapper::is_streaming() const {
     return pImpl->streaming;
 }
 
+PCIeError XDMAWrapper::start_conflated_streaming() {
+    if (!is_open()) {
+        return PCIeError::DEVICE_NOT_FOUND;
+    }
+    if (pImpl->streaming) {
+        return PCIeError::BUSY;
+    }
+
+    // Fresh buffer per session so stale symbols are not re-delivered
+    std::shared_ptr<ConflationBuffer> buffer;
+    {
+        ScopedMemoryNode local(pImpl->placement.node);
+        buffer = std::make_shared<ConflationBuffer>(pImpl->config.max_symbols);
+    }
+    {
+        std::lock_guard<std::mutex> lock(pImpl->conflation_mutex);
+        pImpl->conflation = buffer;
+    }
+
+    return start_streaming([buffer](const BBOData& bbo) {
+        buffer->publish(bbo);
+    });
+}
+
+size_t XDMAWrapper::drain_conflated(std::vector<BBOData>& bbos, size_t max_count,
+                                    uint32_t timeout_ms) {
+    std::shared_ptr<ConflationBuffer> buffer;
+    {
+        std::lock_guard<std::mutex> lock(pImpl->conflation_mutex);
+        buffer = pImpl->conflation;
+    }
+    if (!buffer) {
+        bbos.clear();
+        return 0;
+    }
+    return buffer->drain(bbos, max_count, timeout_ms);
+}
+
+ConflationStats XDMAWrapper::get_conflation_stats() const {
+    std::lock_guard<std::mutex> lock(pImpl->conflation_mutex);
+    return pImpl->conflation ? pImpl->conflation->get_stats() : ConflationStats();
+}
+
+PCIeError XDMAWrapper::start_analytics_streaming(AnalyticsCallback callback,
+                                                 const QuoteAnalyticsConfig& config) {
+    if (!is_open()) {
+        return PCIeError::DEVICE_NOT_FOUND;
+    }
+    if (pImpl->streaming) {
+        return PCIeError::BUSY;
+    }
+
+    {
+        ScopedMemoryNode local(pImpl->placement.node);
+        pImpl->analytics = std::make_unique<QuoteAnalytics>(config);
+    }
+    QuoteAnalytics* analytics = pImpl->analytics.get();
+
+    return start_streaming([analytics, cb = std::move(callback)](const BBOData& bbo) {
+        uint64_t now_ns = steady_ns();
+        DerivedQuote quote;
+        analytics->update(bbo, now_ns, quote);
+        if (cb) cb(bbo, quote);
+    });
+}
+
+PCIeError XDMAWrapper::start_sharded_streaming(ShardCallback callback,
+                                               const ShardedDispatchConfig& config) {
+    if (!is_open()) {
+        return PCIeError::DEVICE_NOT_FOUND;
+    }
+    if (pImpl->streaming) {
+        return PCIeError::BUSY;
+    }
+    pImpl->join_stream();
+
+    ShardedDispatchConfig cfg = config;
+    if (cfg.cpus.empty()) {
+        cfg.cpus = pImpl->placement.cpus;
+    }
+    {
+        ScopedMemoryNode local(pImpl->placement.node);
+        pImpl->sharded = std::make_unique<ShardedDispatcher>(cfg, std::move(callback));
+    }
+    pImpl->bulk_stream = true;
+    pImpl->stream_threads = 1;
+    pImpl->streaming = true;
+
+    pImpl->stream_thread = std::thread([this]() {
+        Impl& im = *pImpl;
+        im.pin_stream_thread();
+        ScopedMemoryNode local(im.placement.node);
+        std::vector<BBORecord> records(64);
+        uint64_t failing_since_ns = 0;
+        uint32_t backoff_ms = 0;
+
+        while (im.streaming) {
+            // Reset sequence in progress: finish what the workers hold, then park
+            if (im.pause_pending.load(std::memory_order_acquire)) {
+                im.sharded->flush();
+                im.park_stream_thread();
+                continue;
+            }
+
+            int n = read_records(records.data(), records.size(), 100);  // 100ms timeout
+            if (n < 0) {
+                if (im.retry_read(im.read_errno, "Streaming", failing_since_ns, backoff_ms)) continue;
+                break;
+            }
+            if (failing_since_ns != 0 && n > 0) {
+                fprintf(stderr, "Streaming: reads recovered\n");
+                failing_since_ns = 0;
+            }
+            for (int i = 0; i < n; i++) {
+                if (im.dedup && !im.dedup->accept(records[i])) {
+                    continue;  // Top of book unchanged
+                }
+                im.sharded->submit(records[i]);
+            }
+        }
+
+        // Queued records are still handled
+        im.sharded->stop();
+
+        // Let a pending reset know there is nothing left to pause
+        {
+            std::lock_guard<std::mutex> lock(im.pause_mutex);
+            im.streaming = false;
+        }
+        im.pause_cv.notify_all();
+    });
+
+    return PCIeError::SUCCESS;
+}
+
+ShardedDispatchStats XDMAWrapper::get_sharded_stats() const {
+    return pImpl->sharded ? pImpl->sharded->stats() : ShardedDispatchStats();
+}
+
+PCIeError XDMAWrapper::start_parallel_streaming(BatchCallback callback,
+                                                const WorkStealingConfig& config) {
+    if (!is_open()) {
+        return PCIeError::DEVICE_NOT_FOUND;
+    }
+    if (pImpl->streaming) {
+        return PCIeError::BUSY;
+    }
+    pImpl->join_stream();
+
+    WorkStealingConfig cfg = config;
+    if (cfg.cpus.empty()) {
+        cfg.cpus = pImpl->placement.cpus;
+    }
+    {
+        ScopedMemoryNode local(pImpl->placement.node);
+        pImpl->executor = std::make_unique<WorkStealingExecutor>(cfg, std::move(callback));
+    }
+    pImpl->bulk_stream = true;
+    pImpl->stream_threads = 1;
+    pImpl->streaming = true;
+
+    pImpl->stream_thread = std::thread([this]() {
+        Impl& im = *pImpl;
+        im.pin_stream_thread();
+        ScopedMemoryNode local(im.placement.node);
+        WorkStealingExecutor& executor = *im.executor;
+        uint64_t failing_since_ns = 0;
+        uint32_t backoff_ms = 0;
+
+        while (im.streaming) {
+            // Reset sequence in progress: finish what the workers hold, then park
+            if (im.pause_pending.load(std::memory_order_acquire)) {
+                executor.flush();
+                im.park_stream_thread();
+                continue;
+            }
+
+            std::vector<BBORecord> batch = executor.acquire();
+            batch.resize(executor.batch_records());
+            int n = read_records(batch.data(), batch.size(), 100);  // 100ms timeout
+            if (n < 0) {
+                if (im.retry_read(im.read_errno, "Streaming", failing_since_ns, backoff_ms)) continue;
+                break;
+            }
+            if (failing_since_ns != 0 && n > 0) {
+                fprintf(stderr, "Streaming: reads recovered\n");
+                failing_since_ns = 0;
+            }
+
+            // Compact out unchanged tops of book
+            size_t kept = 0;
+            for (int i = 0; i < n; i++) {
+                if (im.dedup && !im.dedup->accept(batch[i])) continue;
+                batch[kept++] = batch[i];
+            }
+            batch.resize(kept);
+            executor.submit(std::move(batch));
+        }
+
+        // Queued tasks still run
+        executor.stop();
+
+        // Let a pending reset know there is nothing left to pause
+        {
+            std::lock_guard<std::mutex> lock(im.pause_mutex);
+            im.streaming = false;
+        }
+        im.pause_cv.notify_all();
+    });
+
+    return PCIeError::SUCCESS;
+}
+
+WorkStealingStats XDMAWrapper::get_parallel_stats() const {
+    return pImpl->executor ? pImpl->executor->stats() : WorkStealingStats();
+}
+
+void XDMAWrapper::Impl::join_stream() {
+    if (stream_thread.joinable()) {
+        stream_thread.join();
+    }
+    for (auto& ch : channels) {
+        if (ch->reader.joinable()) ch->reader.join();
+        if (const FaultSource* faults = std::get_if<FaultSource>(&ch->own)) closed_faults += faults->stats();
+        ch->own = C2HSource();
+        ch->source = nullptr;
+    }
+}
+
+template <typename Source>
+void XDMAWrapper::Impl::read_channel(C2HChannel& ch, Source& source, size_t index) {
+    // Buffers below are allocated and first touched on this thread
+    pin_stream_thread();
+    ScopedMemoryNode local(placement.node);
+
+    WireFormat format = config.wire_format;
+    size_t record_size = wire_record_size(format);
+    size_t batch = std::max<size_t>(multichannel.batch_records, 1);
+    std::vector<uint8_t> buf(batch * record_size);
+    std::vector<BBORecord> decoded(batch);
+
+    // A reset drains the channel to a record boundary while we are parked
+    auto park = [&]() {
+        park_stream_thread();
+        ch.carry = 0;
+    };
+
+    std::string name = "C2H channel " + std::to_string(index);
+    uint64_t failing_since_ns = 0;
+    uint32_t backoff_ms = 0;
+
+    while (streaming) {
+        if (pause_pending.load(std::memory_order_acquire)) {
+            park();
+            continue;
+        }
+
+        errno = 0;   // Left at 0 when the stream simply ended
+        ssize_t n = source.read(buf.data() + ch.carry, buf.size() - ch.carry, 100);  // 100ms timeout
+        if (n == 0) continue;
+        if (n < 0) {
+            if (retry_read(errno, name.c_str(), failing_since_ns, backoff_ms, &ch.read_failures)) continue;
+            break;  // End of stream, or failing past the limit
+        }
+        if (failing_since_ns != 0) {
+            fprintf(stderr, "%s: reads recovered\n", name.c_str());
+            failing_since_ns = 0;
+        }
+
+        size_t avail = ch.carry + static_cast<size_t>(n);
+        size_t count = avail / record_size;
+        size_t used = count * record_size;
+        decode_bbo_batch(buf.data(), count, decoded.data(), format);
+        ch.carry = avail - used;
+        if (ch.carry > 0) {
+            std::memmove(buf.data(), buf.data() + used, ch.carry);
+        }
+
+        ChannelRecord item;
+        item.host_time_ns = steady_ns();
+
+        // Ring full: hold the C2H read back until the dispatcher catches up
+        for (size_t i = 0; i < count && streaming; i++) {
+            item.record = decoded[i];
+            if (ch.ring.try_push(item)) continue;
+            bump(ch.ring_full);
+            while (streaming && !ch.ring.try_push(item)) {
+                if (pause_pending.load(std::memory_order_acquire)) park();
+                std::this_thread::yield();
+            }
+        }
+        bump(ch.records, count);
+        bump(ch.reads);
+    }
+
+    ch.finished.store(true, std::memory_order_release);
+
+    // One fewer thread for a reset to wait on
+    {
+        std::lock_guard<std::mutex> lock(pause_mutex);
+        stream_threads--;
+    }
+    pause_cv.notify_all();
+}
+
+void XDMAWrapper::Impl::dispatch_record(uint32_t channel, const ChannelRecord& item,
+                                        size_t record_size) {
+    const BBORecord& rec = item.record;
+
+    // Counted per record, as read_records() does
+    stats.bytes_transferred += record_size;
+    stats.transfers_completed++;
+    if (rec.flags & BBORecord::FLAG_BAD_PADDING) stats.transfers_failed++;
+    stats.update_latency(rec.get_fpga_latency_us());
+    bbo_read_count++;
+    book().update(rec, item.host_time_ns);
+    bump(channel_delivered);
+
+    if (dedup && !dedup->accept(rec)) {
+        return;  // Top of book unchanged
+    }
+    if (channel_callback) {
+        channel_callback(channel, rec);
+    }
+}
+
+PCIeError XDMAWrapper::start_multichannel_streaming(ChannelCallback callback,
+                                                    const MultiChannelConfig& config) {
+    if (!is_open()) {
+        return PCIeError::DEVICE_NOT_FOUND;
+    }
+    if (pImpl->streaming) {
+        return PCIeError::BUSY;
+    }
+    pImpl->join_stream();
+
+    std::vector<std::string> paths = pImpl->config.c2h_channels;
+    if (paths.empty()) {
+        paths.push_back(Transport::primary_channel(pImpl->config));
+    }
+    if (paths.size() > XDMADevicePaths::MAX_C2H_CHANNELS) {
+        return PCIeError::INVALID_PARAMETER;
+    }
+
+    // Channel 0 of the device is already open as the transport's C2H
+    ScopedMemoryNode local(pImpl->placement.node);
+    for (const auto& ch : pImpl->channels) {
+        pImpl->stats.transfers_failed += ch->read_failures.load(std::memory_order_relaxed);
+    }
+    pImpl->channels.clear();
+    const std::string& primary = Transport::primary_channel(pImpl->config);
+    for (const std::string& path : paths) {
+        auto ch = std::make_unique<Impl::C2HChannel>(config.ring_capacity);
+        if (path == primary) {
+            ch->source = &pImpl->transport.c2h;
+        } else {
+            PCIeError err = Transport::open_channel(pImpl->config, path, pImpl->channels.size(),
+                                                    ch->own);
+            if (err != PCIeError::SUCCESS) {
+                pImpl->join_stream();
+                return err;
+            }
+            ch->source = &ch->own;
+        }
+        pImpl->channels.push_back(std::move(ch));
+    }
+
+    size_t n = pImpl->channels.size();
+    pImpl->multichannel = config;
+    pImpl->channel_callback = std::move(callback);
+    pImpl->merge = std::make_unique<ChannelMerge>(n, uint64_t(config.merge_window_us) * 1000);
+    pImpl->channel_delivered = 0;
+    pImpl->stream_threads = static_cast<uint32_t>(n + 1);
+    pImpl->streaming = true;
+
+    for (size_t i = 0; i < n; i++) {
+        Impl::C2HChannel* ch = pImpl->channels[i].get();
+        // Backend resolved once per reader thread, not per read
+        ch->reader = std::thread([this, ch, i]() {
+            std::visit([&](auto& source) { pImpl->read_channel(*ch, source, i); }, *ch->source);
+        });
+    }
+
+    pImpl->stream_thread = std::thread([this, n]() {
+        Impl& im = *pImpl;
+        im.pin_stream_thread();
+        size_t record_size = wire_record_size(im.config.wire_format);
+        size_t batch = std::max<size_t>(im.multichannel.batch_records, 1);
+        bool ordered = im.multichannel.order == MergeOrder::TIMESTAMP;
+
+        auto pop = [&im](size_t ch, ChannelRecord& item) {
+            return im.channels[ch]->ring.try_pop(item);
+        };
+        auto deliver = [&im, record_size](size_t ch, const ChannelRecord& item) {
+            im.dispatch_record(static_cast<uint32_t>(ch), item, record_size);
+        };
+
+        IdleBackoff idle;
+        while (im.streaming) {
+            // Reset sequence in progress: park between records
+            if (im.pause_pending.load(std::memory_order_acquire)) {
+                im.park_stream_thread();
+                continue;
+            }
+
+            // Reader threads only read C2H; the FIFO watch runs here
+            uint64_t now_ns = steady_ns();
+            im.poll_status(*this, now_ns);
+
+            // A finished reader has pushed its last record already
+            bool all_finished = true;
+            for (size_t ch = 0; ch < n; ch++) {
+                if (im.channels[ch]->finished.load(std::memory_order_acquire)) {
+                    im.merge->close(ch);
+                } else {
+                    all_finished = false;
+                }
+            }
+
+            size_t delivered = 0;
+            if (ordered) {
+                delivered = im.merge->poll(now_ns, pop, deliver);
+            } else {
+                ChannelRecord item;
+                for (size_t ch = 0; ch < n; ch++) {
+                    for (size_t k = 0; k < batch && pop(ch, item); k++) {
+                        deliver(ch, item);
+                        delivered++;
+                    }
+                }
+            }
+
+            if (delivered > 0) {
+                idle.reset();
+                continue;
+            }
+            if (all_finished && im.merge->empty()) {
+                bool drained = true;
+                for (size_t ch = 0; ch < n; ch++) drained &= im.channels[ch]->ring.empty();
+                if (drained) break;  // Every channel has ended
+            }
+
+            // Nothing ready: spin briefly, then back off well inside the merge window
+            idle.wait();
+        }
+
+        // Let a pending reset know there is nothing left to pause
+        {
+            std::lock_guard<std::mutex> lock(im.pause_mutex);
+            im.streaming = false;
+            im.stream_threads--;
+        }
+        im.pause_cv.notify_all();
+    });
+
+    return PCIeError::SUCCESS;
+}
+
+MultiChannelStats XDMAWrapper::get_multichannel_stats() const {
+    MultiChannelStats stats;
+    for (const auto& ch : pImpl->channels) {
+        ChannelStats cs;
+        cs.records = ch->records.load(std::memory_order_relaxed);
+        cs.reads = ch->reads.load(std::memory_order_relaxed);
+        cs.ring_full = ch->ring_full.load(std::memory_order_relaxed);
+        cs.read_failures = ch->read_failures.load(std::memory_order_relaxed);
+        cs.finished = ch->finished.load(std::memory_order_relaxed);
+        stats.channels.push_back(cs);
+    }
+    stats.delivered = pImpl->channel_delivered.load(std::memory_order_relaxed);
+    if (pImpl->merge) {
+        stats.window_flushes = pImpl->merge->window_flushes();
+        stats.late = pImpl->merge->late();
+    }
+    return stats;
+}
+
+PCIeError XDMAWrapper::set_dedup(const DedupConfig& config) {
+    if (pImpl->streaming) {
+        return PCIeError::BUSY;
+    }
+    ScopedMemoryNode local(pImpl->placement.node);
+    pImpl->dedup = std::make_unique<DedupFilter>(config);
+    return PCIeError::SUCCESS;
+}
+
+PCIeError XDMAWrapper::disable_dedup() {
+    if (pImpl->streaming) {
+        return PCIeError::BUSY;
+    }
+    pImpl->dedup.reset();
+    return PCIeError::SUCCESS;
+}
+
+DedupStats XDMAWrapper::get_dedup_stats() const {
+    return pImpl->dedup ? pImpl->dedup->get_stats() : DedupStats();
+}
+
+void XDMAWrapper::Impl::start_snapshots() {
+    if (config.snapshot_interval_ms == 0) return;
+
+    snapshot_stop = false;
+    snapshot_thread = std::thread([this]() {
+        auto interval = std::chrono::milliseconds(config.snapshot_interval_ms);
+        std::unique_lock<std::mutex> lock(snapshot_mutex);
+        while (!snapshot_cv.wait_for(lock, interval, [this] { return snapshot_stop; })) {
+            lock.unlock();
+            snapshot->checkpoint(book());
+            lock.lock();
+        }
+    });
+}
+
+void XDMAWrapper::Impl::stop_snapshots() {
+    {
+        std::lock_guard<std::mutex> lock(snapshot_mutex);
+        snapshot_stop = true;
+    }
+    snapshot_cv.notify_all();
+    if (snapshot_thread.joinable()) {
+        snapshot_thread.join();
+    }
+}
+
+PCIeError XDMAWrapper::checkpoint() {
+    if (!pImpl->snapshot) {
+        return PCIeError::INVALID_PARAMETER;
+    }
+    pImpl->snapshot->checkpoint(pImpl->book());
+    return PCIeError::SUCCESS;
+}
+
+uint64_t XDMAWrapper::get_snapshot_generation() const {
+    return pImpl->snapshot ? pImpl->snapshot->generation() : 0;
+}
+
+void XDMAWrapper::Impl::place(const XDMADeviceConfig& cfg) {
+    // Find the card behind the configured nodes (none for a mock device
+    // or a transport other than the driver)
+    int device_node = -1;
+    std::vector<int> device_cpus;
+    std::vector<XDMADeviceDiscovery::DeviceInfo> devices;
+    if (cfg.transport == TransportKind::XDMA) {
+        devices = XDMADeviceDiscovery::enumerate_devices();
+    }
+    for (const auto& dev : devices) {
+        bool match = dev.user_path == cfg.user_path ||
+                     std::find(dev.c2h_paths.begin(), dev.c2h_paths.end(), cfg.c2h_path) !=
+                         dev.c2h_paths.end();
+        if (match) {
+            device_node = dev.numa_node;
+            device_cpus = NumaTopology::parse_cpulist(dev.local_cpus);
+            break;
+        }
+    }
+
+    NumaTopology topology;
+    placement = topology.place(device_node, device_cpus, cfg.numa_node, cfg.stream_cpus);
+
+    if (placement.node >= 0 || !placement.cpus.empty()) {
+        printf("NUMA placement: node %d, CPUs %s (%s; card on node %d)\n",
+               placement.node, NumaTopology::format_cpulist(placement.cpus).c_str(),
+               placement.source, device_node);
+    }
+    for (const std::string& warning : placement.warnings) {
+        fprintf(stderr, "Warning: NUMA placement: %s\n", warning.c_str());
+    }
+}
+
+void XDMAWrapper::Impl::pin_stream_thread() const {
+    if (!placement.cpus.empty() && !pin_current_thread(placement.cpus)) {
+        fprintf(stderr, "Warning: could not pin streaming thread to CPUs %s\n",
+                NumaTopology::format_cpulist(placement.cpus).c_str());
+    }
+}
+
+NumaPlacement XDMAWrapper::get_numa_placement() const {
+    return pImpl->placement;
+}
+
+bool XDMAWrapper::get_latest(SymbolKey symbol, BBOQuote& quote) const {
+    const BBOCache* cache = pImpl->cache.load(std::memory_order_acquire);
+    return cache && cache->get(symbol, quote);
+}
+
+const BBOCache* XDMAWrapper::get_cache() const {
+    return pImpl->cache.load(std::memory_order_acquire);
+}
+
+FaultStats XDMAWrapper::get_fault_stats() const {
+    FaultStats total = pImpl->closed_faults;
+    auto add = [&total](const C2HSource& source) {
+        if (const FaultSource* faults = std::get_if<FaultSource>(&source)) total += faults->stats();
+    };
+    add(pImpl->transport.c2h);
+    for (const auto& ch : pImpl->channels) {
+        if (ch->source && ch->source != &pImpl->transport.c2h) add(*ch->source);
+    }
+    return total;
+}
+
 TransferStats XDMAWrapper::get_stats() const {
-    return pImpl->stats;
+    TransferStats stats = pImpl->stats;
+    for (const auto& ch : pImpl->channels) {
+        stats.transfers_failed += ch->read_failures.load(std::memory_order_relaxed);
+    }
+    return stats;
 }
 
 void XDMAWrapper::reset_stats() {
     pImpl->stats = TransferStats();
+    for (auto& ch : pImpl->channels) ch->read_failures.store(0, std::memory_order_relaxed);
     pImpl->bbo_read_count = 0;
 }
 
 uint32_t XDMAWrapper::read_register(uint32_t offset) const {
-    if (!pImpl || !pImpl->ctrl_regs) return 0;
-    return pImpl->ctrl_regs[offset / 4];
+    if (!pImpl || !pImpl->transport.bar.regs()) return 0;
+    return pImpl->transport.bar.regs()[offset / 4];
 }
 
 void XDMAWrapper::write_register(uint32_t offset, uint32_t value) {
-    if (!pImpl || !pImpl->ctrl_regs) return;
-    pImpl->ctrl_regs[offset / 4] = value;
+    if (!pImpl || !pImpl->transport.bar.regs()) return;
+    pImpl->transport.bar.regs()[offset / 4] = value;
     __sync_synchronize();  // Memory barrier
 }
 
 // Device Discovery Implementation
+namespace {
+
+// First line of a sysfs attribute, "" if absent
+std::string read_sysfs(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+unsigned long read_sysfs_number(const std::string& path, int base) {
+    std::string value = read_sysfs(path);
+    return value.empty() ? 0 : strtoul(value.c_str(), nullptr, base);
+}
+
+std::vector<std::string> list_dir(const std::string& path) {
+    std::vector<std::string> names;
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return names;
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') names.emplace_back(entry->d_name);
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+// "xdma0_c2h_3" -> device "xdma0"; false for anything else
+bool split_xdma_node(const std::string& name, std::string& device) {
+    size_t underscore = name.find('_');
+    if (name.compare(0, 4, "xdma") != 0 || underscore == std::string::npos || underscore == 4) {
+        return false;
+    }
+    for (size_t i = 4; i < underscore; i++) {
+        if (name[i] < '0' || name[i] > '9') return false;
+    }
+    device = name.substr(0, underscore);
+    return true;
+}
+
+// Slot a node into the device's path fields (channel lists sorted later)
+void add_xdma_node(XDMADeviceDiscovery::DeviceInfo& info, const std::string& dev_root,
+                   const std::string& device, const std::string& name) {
+    std::string kind = name.substr(device.size() + 1);
+    std::string path = dev_root + "/" + name;
+
+    if (info.device_path.empty()) info.device_path = dev_root + "/" + device;
+    if (kind == "user") info.user_path = path;
+    else if (kind == "control") info.control_path = path;
+    else if (kind.compare(0, 4, "c2h_") == 0) info.c2h_paths.push_back(path);
+    else if (kind.compare(0, 4, "h2c_") == 0) info.h2c_paths.push_back(path);
+    else if (kind.compare(0, 7, "events_") == 0) info.events_paths.push_back(path);
+}
+
+// Order "..._c2h_2" before "..._c2h_10"
+void sort_channels(std::vector<std::string>& paths) {
+    auto index = [](const std::string& path) {
+        return strtoul(path.c_str() + path.rfind('_') + 1, nullptr, 10);
+    };
+    std::sort(paths.begin(), paths.end(), [&](const std::string& a, const std::string& b) {
+        return index(a) < index(b);
+    });
+}
+
+void read_pci_function(const std::string& dir, XDMADeviceDiscovery::DeviceInfo& info) {
+    info.vendor_id = static_cast<uint16_t>(read_sysfs_number(dir + "/vendor", 16));
+    info.device_id = static_cast<uint16_t>(read_sysfs_number(dir + "/device", 16));
+    info.subsystem_vendor_id = static_cast<uint16_t>(read_sysfs_number(dir + "/subsystem_vendor", 16));
+    info.subsystem_device_id = static_cast<uint16_t>(read_sysfs_number(dir + "/subsystem_device", 16));
+
+    // Link attributes read "Unknown" / 0 when the link is down
+    info.link_speed = XDMADeviceDiscovery::link_speed_gen(read_sysfs(dir + "/current_link_speed"));
+    info.link_width = static_cast<uint8_t>(read_sysfs_number(dir + "/current_link_width", 10));
+    info.max_link_speed = XDMADeviceDiscovery::link_speed_gen(read_sysfs(dir + "/max_link_speed"));
+    info.max_link_width = static_cast<uint8_t>(read_sysfs_number(dir + "/max_link_width", 10));
+    info.link_up = info.link_width > 0 && info.link_speed > 0;
+
+    std::string numa = read_sysfs(dir + "/numa_node");
+    info.numa_node = numa.empty() ? -1 : atoi(numa.c_str());
+    info.local_cpus = read_sysfs(dir + "/local_cpulist");
+
+    // resource: one "start end flags" line per region, BARs first
+    std::ifstream resource(dir + "/resource");
+    std::string line;
+    for (size_t bar = 0; bar < XDMADeviceDiscovery::NUM_BARS && std::getline(resource, line); bar++) {
+        unsigned long long start = 0, end = 0;
+        if (sscanf(line.c_str(), "%llx %llx", &start, &end) == 2 && end > start) {
+            info.bar_size[bar] = end - start + 1;
+        }
+    }
+
+    char target[PATH_MAX];
+    ssize_t len = readlink((dir + "/driver").c_str(), target, sizeof(target) - 1);
+    if (len > 0) {
+        target[len] = '\0';
+        const char* slash = strrchr(target, '/');
+        info.driver = slash ? slash + 1 : target;
+    }
+}
+
+}  // namespace
+
+uint8_t XDMADeviceDiscovery::link_speed_gen(const std::string& speed) {
+    double gts = strtod(speed.c_str(), nullptr);
+    if (gts >= 64.0) return 6;
+    if (gts >= 32.0) return 5;
+    if (gts >= 16.0) return 4;
+    if (gts >= 8.0) return 3;
+    if (gts >= 5.0) return 2;
+    if (gts >= 2.5) return 1;
+    return 0;
+}
+
+XDMADeviceConfig XDMADeviceDiscovery::DeviceInfo::config(size_t channel) const {
+    // No /dev/xdma0_* defaults: those belong to whichever card is xdma0
+    XDMADeviceConfig config;
+    config.c2h_path = channel < c2h_paths.size() ? c2h_paths[channel] : "";
+    config.h2c_path = channel < h2c_paths.size() ? h2c_paths[channel] : "";
+    config.user_path = user_path;
+    config.events_path = events_paths.empty() ? "" : events_paths[0];
+    return config;
+}
+
 std::vector<XDMADeviceDiscovery::DeviceInfo> XDMADeviceDiscovery::enumerate_devices() {
-    std::vector<DeviceInfo> devices;
+    return enumerate_devices("/sys/bus/pci/devices", "/dev");
+}
 
-    // Check /dev for xdma devices
-    DIR* dev = opendir("/dev");
-    if (!dev) {
-        return devices;
-    }
-
-    struct dirent* entry;
-    while ((entry = readdir(dev)) != nullptr) {
-        std::string name(entry->d_name);
-        if (name.find("xdma") == 0 && name.find("_") != std::string::npos) {
-            // Extract device number (e.g., "xdma0" from "xdma0_c2h_0")
-            size_t underscore = name.find('_');
-            std::string dev_name = name.substr(0, underscore);
-
-            // Check if we already have this device
-            bool found = false;
-            for (const auto& d : devices) {
-                if (d.device_path.find(dev_name) != std::string::npos) {
-                    found = true;
-                    break;
-                }
+std::vector<XDMADeviceDiscovery::DeviceInfo> XDMADeviceDiscovery::enumerate_devices(
+        const std::string& pci_root, const std::string& dev_root) {
+    std::vector<DeviceInfo> devices;
+    std::vector<std::string> claimed;   // xdmaN names tied to a PCI function
+
+    for (const std::string& slot : list_dir(pci_root)) {
+        std::string dir = pci_root + "/" + slot;
+        DeviceInfo info;
+        read_pci_function(dir, info);
+
+        // The driver parents its class devices on the PCI function
+        std::string device;
+        for (const std::string& node : list_dir(dir + "/xdma")) {
+            if (!split_xdma_node(node, device)) continue;
+            add_xdma_node(info, dev_root, device, node);
+            if (std::find(claimed.begin(), claimed.end(), device) == claimed.end()) {
+                claimed.push_back(device);
             }
+        }
 
-            if (!found) {
-                DeviceInfo info;
-                info.device_path = "/dev/" + dev_name;
+        // A Xilinx ID alone may be any FPGA design, not an XDMA endpoint
+        if (info.driver != "xdma" && info.device_path.empty()) {
+            continue;
+        }
 
-                // Try to read PCI info from sysfs
-                // This is a simplified approach - real implementation would
-                // search /sys/bus/pci/devices/ for matching devices
-                info.vendor_id = 0x10EE;  // Xilinx
-                info.device_id = 0x7024;  // Default XDMA
-                info.link_up = true;  // Assume up if device exists
-                info.link_width = 4;
-                info.link_speed = 2;  // Gen2
+        info.pci_slot = slot;
+        devices.push_back(std::move(info));
+    }
 
-                devices.push_back(info);
-            }
+    // Nodes with no sysfs parent
+    std::vector<DeviceInfo> orphans;
+    std::vector<std::string> orphan_names;
+    for (const std::string& node : list_dir(dev_root)) {
+        std::string device;
+        if (!split_xdma_node(node, device) ||
+            std::find(claimed.begin(), claimed.end(), device) != claimed.end()) {
+            continue;
+        }
+        auto it = std::find(orphan_names.begin(), orphan_names.end(), device);
+        if (it == orphan_names.end()) {
+            orphan_names.push_back(device);
+            orphans.emplace_back();
+            it = orphan_names.end() - 1;
         }
+        add_xdma_node(orphans[it - orphan_names.begin()], dev_root, device, node);
     }
+    devices.insert(devices.end(), orphans.begin(), orphans.end());
 
-    closedir(dev);
+    for (DeviceInfo& info : devices) {
+        sort_channels(info.c2h_paths);
+        sort_channels(info.h2c_paths);
+        sort_channels(info.events_paths);
+    }
     return devices;
 }
 
@@ -0,0 +1,299 @@
+/**
+ * Columnar Batch Test and Benchmark
+ * Checks BBOColumns and its reductions against straightforward loops over
+ * the array-of-structs records, that a reused index and latency buffer
+ * give the same results batch after batch, then times a spread scan both
+ * ways and grouping with a new vs a reused index.
+ * Needs no hardware.
+ *
+ * Usage: ./bbo_columns_test [options]
+ *   -n <count>  Records in the batch (default: 1000000)
+ *   -h          Show this help
+ */
+
+#include "bbo_columns.h"
+#include "bench_util.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+#include <getopt.h>
+
+using namespace pcie;
+using bench::check;
+
+static const char* TICKERS[] = {"AAPL", "MSFT", "GOOGL", "AMZN", "NVDA", "META", "TSLA", "SPY"};
+
+static std::vector<BBORecord> make_records(size_t count, uint32_t seed) {
+    std::vector<BBORecord> recs(count);
+    std::mt19937 rng(seed);
+
+    for (size_t i = 0; i < count; i++) {
+        BBORecord& r = recs[i];
+        r.symbol = SymbolKey(TICKERS[rng() % 8]);
+        r.bid_price = 1000000 + rng() % 100000;
+        r.spread = 1 + rng() % 500;
+        r.ask_price = r.bid_price + r.spread;
+        r.bid_size = rng() % 10000;
+        r.ask_size = rng() % 10000;
+        r.ts_t1 = static_cast<uint32_t>(rng());
+        r.ts_t2 = r.ts_t1 + 5;
+        r.ts_t3 = r.ts_t1 + 20;
+        r.ts_t4 = r.ts_t1 + 30 + rng() % 200;   // Wraps for some rows
+        r.flags = BBORecord::FLAG_WIRE48;
+    }
+    return recs;
+}
+
+static bool test_columns(size_t count) {
+    std::vector<BBORecord> recs = make_records(count, 42);
+
+    // Two appends to exercise growing a batch
+    BBOColumns cols;
+    cols.append(recs.data(), count / 3);
+    cols.append(recs.data() + count / 3, count - count / 3);
+
+    bool ok = check(cols.size() == count, "size after append");
+
+    bool rows_ok = true;
+    for (size_t i = 0; i < count; i++) {
+        BBORecord r = cols.record(i);
+        rows_ok &= std::memcmp(&r, &recs[i], sizeof(BBORecord)) == 0;
+    }
+    ok &= check(rows_ok, "record() round trip");
+
+    // Spreads
+    uint32_t lo = UINT32_MAX, hi = 0;
+    uint64_t sum = 0;
+    for (const BBORecord& r : recs) {
+        lo = std::min(lo, r.spread);
+        hi = std::max(hi, r.spread);
+        sum += r.spread;
+    }
+    SpreadSummary sp = summarize_spreads(cols);
+    ok &= check(sp.count == count && sp.min.raw() == lo && sp.max.raw() == hi &&
+                sp.mean == static_cast<double>(sum) / count / Price4::SCALE,
+                "summarize_spreads");
+
+    // Latency percentiles against a full sort
+    std::vector<uint64_t> lat;
+    for (const BBORecord& r : recs) lat.push_back(r.get_fpga_latency_cycles());
+    bench::Summary ref = bench::summarize(lat);
+    LatencySummary ls = summarize_latency(cols);
+    ok &= check(ls.min == ref.min && ls.p50 == ref.p50 && ls.p90 == ref.p90 &&
+                ls.p99 == ref.p99 && ls.p999 == ref.p999 && ls.max == ref.max,
+                "summarize_latency percentiles");
+
+    // Grouping against std::map
+    std::map<SymbolKey, SymbolGroup> expect;
+    for (size_t i = 0; i < count; i++) {
+        SymbolGroup& g = expect[recs[i].symbol];
+        g.symbol = recs[i].symbol;
+        g.count++;
+        g.last = static_cast<uint32_t>(i);
+        g.min_spread = std::min(g.min_spread, recs[i].spread);
+        g.max_spread = std::max(g.max_spread, recs[i].spread);
+        g.spread_sum += recs[i].spread;
+        g.bid_volume += recs[i].bid_size;
+        g.ask_volume += recs[i].ask_size;
+    }
+
+    std::vector<SymbolGroup> groups;
+    std::vector<uint32_t> group_of_row;
+    size_t n = group_by_symbol(cols, groups, &group_of_row);
+    bool groups_ok = n == expect.size();
+    for (const SymbolGroup& g : groups) {
+        const SymbolGroup& e = expect[g.symbol];
+        groups_ok &= g.count == e.count && g.last == e.last &&
+                     g.min_spread == e.min_spread && g.max_spread == e.max_spread &&
+                     g.spread_sum == e.spread_sum && g.bid_volume == e.bid_volume &&
+                     g.ask_volume == e.ask_volume;
+    }
+    for (size_t i = 0; i < count; i++) {
+        groups_ok &= groups[group_of_row[i]].symbol == recs[i].symbol;
+    }
+    ok &= check(groups_ok, "group_by_symbol");
+
+    // Table full: rows of later symbols are left ungrouped
+    n = group_by_symbol(cols, groups, &group_of_row, 2);
+    size_t ungrouped = std::count(group_of_row.begin(), group_of_row.end(), UINT32_MAX);
+    size_t grouped = 0;
+    for (const SymbolGroup& g : groups) grouped += g.count;
+    ok &= check(n == 2 && grouped + ungrouped == count, "group_by_symbol capacity");
+
+    cols.clear();
+    ok &= check(cols.empty() && summarize_spreads(cols).count == 0, "clear");
+    return ok;
+}
+
+static bool same_groups(const std::vector<SymbolGroup>& a, const std::vector<uint32_t>& rows_a,
+                        const std::vector<SymbolGroup>& b, const std::vector<uint32_t>& rows_b) {
+    if (a.size() != b.size() || rows_a != rows_b) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!(a[i].symbol == b[i].symbol) || a[i].count != b[i].count || a[i].last != b[i].last ||
+            a[i].min_spread != b[i].min_spread || a[i].max_spread != b[i].max_spread ||
+            a[i].spread_sum != b[i].spread_sum || a[i].bid_volume != b[i].bid_volume ||
+            a[i].ask_volume != b[i].ask_volume) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// One index and one latency buffer across batches of different shapes
+static bool test_reuse() {
+    std::vector<std::vector<BBORecord>> batches;
+    for (uint32_t seed = 1; seed <= 3; seed++) batches.push_back(make_records(5000, seed));
+
+    // Runs of one symbol, as a bursty feed delivers them
+    std::vector<BBORecord> runs = make_records(4096, 9);
+    for (size_t i = 0; i < runs.size(); i++) runs[i].symbol = SymbolKey(TICKERS[(i / 16) % 8]);
+    batches.push_back(runs);
+
+    // More distinct names than the small index holds, then few again
+    std::vector<BBORecord> wide = make_records(3000, 11);
+    for (size_t i = 0; i < wide.size(); i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "W%zu", i % 100);
+        wide[i].symbol = SymbolKey(name);
+    }
+    batches.push_back(wide);
+    batches.push_back(make_records(500, 12));
+
+    SymbolIndex index(4096);
+    SymbolIndex small(64);
+    std::vector<uint32_t> scratch;
+    bool grouped = true, capped = true, latency = true;
+    for (const std::vector<BBORecord>& recs : batches) {
+        BBOColumns cols;
+        cols.append(recs.data(), recs.size());
+
+        std::vector<SymbolGroup> fresh, reused;
+        std::vector<uint32_t> fresh_rows, reused_rows;
+        group_by_symbol(cols, fresh, &fresh_rows);
+        group_by_symbol(cols, reused, &reused_rows, index);
+        grouped &= same_groups(fresh, fresh_rows, reused, reused_rows);
+
+        group_by_symbol(cols, fresh, &fresh_rows, 64);
+        group_by_symbol(cols, reused, &reused_rows, small);
+        capped &= same_groups(fresh, fresh_rows, reused, reused_rows);
+
+        LatencySummary a = summarize_latency(cols);
+        LatencySummary b = summarize_latency(cols, scratch);
+        latency &= a.count == b.count && a.min == b.min && a.p50 == b.p50 && a.p90 == b.p90 &&
+                   a.p99 == b.p99 && a.p999 == b.p999 && a.max == b.max && a.mean == b.mean;
+    }
+
+    bool ok = check(grouped, "reused index matches a new one");
+    ok &= check(capped, "reused full index matches max_symbols");
+    ok &= check(latency, "summarize_latency with a reused buffer");
+    return ok;
+}
+
+/**
+ * Mean spread over the batch: AoS walk vs the columnar kernel
+ */
+static void bench_scan(size_t count) {
+    std::vector<BBORecord> recs = make_records(count, 7);
+    BBOColumns cols;
+    cols.append(recs.data(), count);
+
+    const int iterations = 20;
+    uint64_t best_aos = UINT64_MAX, best_soa = UINT64_MAX;
+
+    for (int it = 0; it < iterations; it++) {
+        uint64_t t0 = bench::now_ns();
+        uint32_t lo = UINT32_MAX, hi = 0;
+        uint64_t sum = 0;
+        for (const BBORecord& r : recs) {
+            lo = std::min(lo, r.spread);
+            hi = std::max(hi, r.spread);
+            sum += r.spread;
+        }
+        uint64_t t1 = bench::now_ns();
+        bench::do_not_optimize(lo);
+        bench::do_not_optimize(hi);
+        bench::do_not_optimize(sum);
+        best_aos = std::min(best_aos, t1 - t0);
+
+        t0 = bench::now_ns();
+        SpreadSummary s = summarize_spreads(cols);
+        t1 = bench::now_ns();
+        bench::do_not_optimize(s);
+        best_soa = std::min(best_soa, t1 - t0);
+    }
+
+    printf("  spread min/max/mean, array of structs: %8.3f ns/record\n",
+           static_cast<double>(best_aos) / count);
+    printf("  spread min/max/mean, columnar:         %8.3f ns/record\n",
+           static_cast<double>(best_soa) / count);
+
+    // Grouping in small batches, where setting up the index dominates
+    const size_t batch = 256;
+    std::vector<SymbolGroup> groups;
+    SymbolIndex index(4096);
+    uint64_t best_new = UINT64_MAX, best_reused = UINT64_MAX;
+    BBOColumns part;
+    part.append(recs.data(), std::min(batch, count));
+    for (int it = 0; it < iterations; it++) {
+        uint64_t t0 = bench::now_ns();
+        for (int rep = 0; rep < 100; rep++) group_by_symbol(part, groups);
+        uint64_t t1 = bench::now_ns();
+        best_new = std::min(best_new, t1 - t0);
+
+        t0 = bench::now_ns();
+        for (int rep = 0; rep < 100; rep++) group_by_symbol(part, groups, nullptr, index);
+        t1 = bench::now_ns();
+        best_reused = std::min(best_reused, t1 - t0);
+    }
+    bench::do_not_optimize(groups.size());
+    printf("  group_by_symbol, %zu rows, new index:    %8.3f ns/record\n", part.size(),
+           static_cast<double>(best_new) / (100.0 * part.size()));
+    printf("  group_by_symbol, %zu rows, reused index: %8.3f ns/record\n", part.size(),
+           static_cast<double>(best_reused) / (100.0 * part.size()));
+}
+
+static void print_usage(const char* prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  -n <count>  Records in the batch (default: 1000000)\n");
+    printf("  -h          Show this help\n");
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = 1000000;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+            case 'n': count = std::strtoul(optarg, nullptr, 10); break;
+            case 'h':
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (count < 16) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    printf("========================================\n");
+    printf("BBO Columnar Batch Test\n");
+    printf("========================================\n");
+
+    printf("Correctness:\n");
+    bool ok = test_columns(100000);
+
+    printf("\nReuse across batches:\n");
+    ok &= test_reuse();
+
+    printf("\nScan (%zu records, best of 20):\n", count);
+    bench_scan(count);
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+/**
+ * Synthetic C2H Feed
+ * Drives the host pipeline without a card: generates wire records
+ * (BBOGenerator) and writes them wherever a transport reads from - a
+ * regular file or FIFO for TransportKind::FILE, a shared-memory segment
+ * for TransportKind::SHM. The in-process GENERATOR transport takes the
+ * same GeneratorConfig directly. Reports the rate it sustained.
+ *
+ * Usage: ./bbo_feed [options] <path | shm:/name>
+ *   -f <36|48>  Wire format (default: 36)
+ *   -n <count>  Records to write, 0 = until interrupted (default: 10000000)
+ *   -s <count>  Symbol universe (default: 8, at most 100000)
+ *   -z <s>      Zipf popularity exponent, 0 = round-robin (default: 0)
+ *   -r <rate>   Target records/s, 0 = as fast as the sink takes them (default: 0)
+ *   -p <count>  Replay a pre-encoded pool of this many records (default: off)
+ *   -S <seed>   Generator seed (default: 1)
+ *   -t          FPGA test pattern (TESTAAPL, order_book_pcie_top TEST_MODE 2)
+ *   -h          Show this help
+ *
+ * Examples:
+ *   mkfifo /tmp/c2h && ./bbo_feed -r 1000000 -s 500 -z 1.1 /tmp/c2h
+ *   ./bbo_feed -f 48 -n 0 shm:/bbo_feed
+ */
+
+#include "transport.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+
+using namespace pcie;
+
+static std::atomic<bool> g_stop{false};
+
+static void on_signal(int) {
+    g_stop = true;
+}
+
+// Whole buffer to a descriptor; false once the reader has gone
+static bool write_fd(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR && !g_stop) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static void usage(const char* prog) {
+    printf("Usage: %s [options] <path | shm:/name>\n", prog);
+    printf("  -f <36|48>  Wire format (default: 36)\n");
+    printf("  -n <count>  Records to write, 0 = until interrupted (default: 10000000)\n");
+    printf("  -s <count>  Symbol universe (default: 8, at most 100000)\n");
+    printf("  -z <s>      Zipf popularity exponent, 0 = round-robin (default: 0)\n");
+    printf("  -r <rate>   Target records/s, 0 = as fast as the sink takes them (default: 0)\n");
+    printf("  -p <count>  Replay a pre-encoded pool of this many records (default: off)\n");
+    printf("  -S <seed>   Generator seed (default: 1)\n");
+    printf("  -t          FPGA test pattern (TESTAAPL, order_book_pcie_top TEST_MODE 2)\n");
+}
+
+int main(int argc, char* argv[]) {
+    GeneratorConfig config;
+    config.records = 10000000;
+    WireFormat format = WireFormat::BBO36;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:n:s:z:r:p:S:th")) != -1) {
+        switch (opt) {
+            case 'f': format = atoi(optarg) == 48 ? WireFormat::BBO48 : WireFormat::BBO36; break;
+            case 'n': config.records = strtoull(optarg, nullptr, 10); break;
+            case 's': config.symbols = static_cast<uint32_t>(atoi(optarg)); break;
+            case 'z': config.zipf_s = atof(optarg); break;
+            case 'r': config.rate = strtoull(optarg, nullptr, 10); break;
+            case 'p': config.pool_records = static_cast<uint32_t>(atoi(optarg)); break;
+            case 'S': config.seed = static_cast<uint32_t>(atoi(optarg)); break;
+            case 't': config.pattern = GeneratorPattern::TEST_PATTERN; break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::string target = argv[optind];
+    if (config.symbols > BBOGenerator::MAX_SYMBOLS) {
+        fprintf(stderr, "At most %u symbols (GEN00000..GEN99999)\n", BBOGenerator::MAX_SYMBOLS);
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    ShmFeed feed;
+    int fd = -1;
+    bool shm = target.rfind("shm:", 0) == 0;
+    if (shm) {
+        if (feed.create(target.substr(4), 8 << 20) != PCIeError::SUCCESS) return 1;
+    } else {
+        // Blocks on a FIFO until the reader opens it
+        fd = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            fprintf(stderr, "Failed to open %s: %s\n", target.c_str(), strerror(errno));
+            return 1;
+        }
+    }
+
+    size_t record_size = wire_record_size(format);
+    std::vector<uint8_t> buf((256 << 10) / record_size * record_size);   // Whole records only
+    GeneratorSource source(config, format);
+
+    printf("Feeding %s: %s, %s, %u symbols, zipf %.2f, rate %s\n", target.c_str(),
+           format == WireFormat::BBO48 ? "BBO48" : "BBO36",
+           config.pattern == GeneratorPattern::TEST_PATTERN ? "test pattern" : "market",
+           config.symbols, config.zipf_s,
+           config.rate ? std::to_string(config.rate).c_str() : "unbounded");
+
+    uint64_t start = bench::now_ns();
+    uint64_t bytes = 0;
+    while (!g_stop) {
+        ssize_t n = source.read(buf.data(), buf.size(), 100);
+        if (n < 0) break;   // config.records written
+        if (n == 0) continue;
+
+        bool written;
+        if (shm) {
+            // All or nothing; retry while the reader catches up
+            while (!(written = feed.write(buf.data(), static_cast<size_t>(n), 100)) && !g_stop) {}
+        } else {
+            written = write_fd(fd, buf.data(), static_cast<size_t>(n));
+        }
+        if (!written) break;
+        bytes += static_cast<uint64_t>(n);
+    }
+    double seconds = static_cast<double>(bench::now_ns() - start) / 1e9;
+
+    if (shm) {
+        // The reader ends at close once drained; keep the name until then
+        feed.close_stream();
+        while (feed.pending() > 0 && !g_stop) usleep(1000);
+    } else {
+        close(fd);
+    }
+
+    uint64_t records = bytes / record_size;
+    printf("Wrote %lu records (%.1f MB) in %.3f s: %.0f records/s, %.1f MB/s\n",
+           records, static_cast<double>(bytes) / 1e6, seconds,
+           seconds > 0 ? static_cast<double>(records) / seconds : 0.0,
+           seconds > 0 ? static_cast<double>(bytes) / 1e6 / seconds : 0.0);
+    return 0;
+}
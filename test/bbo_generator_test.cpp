@@ -0,0 +1,307 @@
+/**
+ * Synthetic Generator Test and Benchmark
+ * Checks the test pattern byte for byte against order_book_pcie_top
+ * TEST_MODE 2, the market model (determinism, Zipf popularity, the price
+ * walk, T1-T4 ordering), pool replay across laps and rate pacing, then
+ * measures how fast each mode fills a C2H buffer.
+ * Needs no hardware.
+ */
+
+#include "bbo_generator.h"
+#include "bbo_decode.h"
+#include "transport.h"
+#include "bench_util.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <unordered_set>
+#include <vector>
+#include <signal.h>
+
+using namespace pcie;
+using bench::check;
+
+// Packet n exactly as the RTL puts it on the 64-bit stream (beat 1 first,
+// tdata[7:0] at the lowest address)
+static void rtl_test_packet(uint32_t n, uint8_t out[48]) {
+    const uint64_t beats[6] = {
+        0x4C50414154534554ULL,                              // "TESTAAPL"
+        (0x00000064ULL << 32) | 0x00003A98,                 // Bid size | bid price
+        (0x000000C8ULL << 32) | 0x00003AFC,                 // Ask size | ask price
+        (static_cast<uint64_t>(n) << 32) | 0x00000064,      // T1 | spread
+        (static_cast<uint64_t>(n) << 32) | n,               // T3 | T2
+        (0xDEADBEEFULL << 32) | n,                          // Padding | T4
+    };
+    std::memcpy(out, beats, sizeof(beats));
+}
+
+static std::vector<uint8_t> read_all(GeneratorSource& source, size_t bytes, size_t chunk) {
+    std::vector<uint8_t> out(bytes);
+    size_t done = 0;
+    while (done < bytes) {
+        ssize_t n = source.read(out.data() + done, std::min(chunk, bytes - done), 100);
+        if (n <= 0) break;
+        done += static_cast<size_t>(n);
+    }
+    out.resize(done);
+    return out;
+}
+
+static bool test_pattern() {
+    bool ok = true;
+    constexpr size_t N = 1000;
+    GeneratorConfig config;
+    config.pattern = GeneratorPattern::TEST_PATTERN;
+    config.records = N;
+
+    GeneratorSource direct(config, WireFormat::BBO48);
+    config.pool_records = 64;   // Not a divisor of N: laps end mid-read
+    GeneratorSource pooled(config, WireFormat::BBO48);
+    std::vector<uint8_t> a = read_all(direct, N * 48 + 48, 4096);
+    std::vector<uint8_t> b = read_all(pooled, N * 48 + 48, 1000);
+
+    bool exact = a.size() == N * 48 && b.size() == N * 48;
+    for (size_t i = 0; exact && i < N; i++) {
+        uint8_t expect[48];
+        rtl_test_packet(static_cast<uint32_t>(i), expect);
+        exact = std::memcmp(a.data() + i * 48, expect, 48) == 0 &&
+                std::memcmp(b.data() + i * 48, expect, 48) == 0;
+    }
+    ok &= check(exact, "BBO48 byte-exact with TEST_MODE 2");
+    ok &= check(direct.read(a.data(), 48, 0) == -1, "stream ends after config.records");
+
+    config.records = 3;
+    config.pool_records = 0;
+    GeneratorSource narrow(config, WireFormat::BBO36);
+    std::vector<uint8_t> c = read_all(narrow, 3 * 36, 36);
+    BBORecord recs[3];
+    decode_bbo_batch(c.data(), 3, recs, WireFormat::BBO36);
+    ok &= check(c.size() == 3 * 36 && recs[2].symbol == SymbolKey("TESTAAPL") &&
+                recs[2].bid_price == 15000 && recs[2].ask_price == 15100 &&
+                recs[2].bid_size == 100 && recs[2].ask_size == 200 && recs[2].spread == 100 &&
+                recs[2].ts_t1 == 2 && recs[2].ts_t4 == 2,
+                "BBO36 carries the same fields");
+    return ok;
+}
+
+static bool test_market() {
+    bool ok = true;
+    constexpr size_t N = 1000000;
+    GeneratorConfig config;
+    config.symbols = 100;
+    config.zipf_s = 1.0;
+    config.seed = 7;
+
+    BBOGenerator gen(config);
+    std::vector<BBORecord> recs(N);
+    gen.next(recs.data(), N);
+
+    BBOGenerator again(config);
+    std::vector<BBORecord> same(1000);
+    again.next(same.data(), same.size());
+    config.seed = 8;
+    BBOGenerator other(config);
+    std::vector<BBORecord> diff(1000);
+    other.next(diff.data(), diff.size());
+    ok &= check(std::memcmp(same.data(), recs.data(), 1000 * sizeof(BBORecord)) == 0 &&
+                std::memcmp(diff.data(), recs.data(), 1000 * sizeof(BBORecord)) != 0,
+                "deterministic per seed");
+
+    // Popularity
+    std::map<SymbolKey, size_t> index;
+    for (size_t i = 0; i < gen.symbols().size(); i++) index[gen.symbols()[i]] = i;
+    std::vector<size_t> counts(gen.symbols().size());
+    for (const auto& r : recs) counts[index[r.symbol]]++;
+    std::vector<double> share = gen.popularity();
+    double worst = 0.0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        worst = std::max(worst, std::fabs(static_cast<double>(counts[i]) / N - share[i]));
+    }
+    printf("  top symbol %.1f%% (expect %.1f%%), 100th %.2f%%, worst error %.4f\n",
+           100.0 * counts[0] / N, 100.0 * share[0], 100.0 * counts[99] / N, worst);
+    ok &= check(worst < 0.003, "Zipf shares within 0.3%");
+    ok &= check(counts[0] > 1.8 * counts[1] && counts[1] > counts[99] * 20, "rank 1 ~2x rank 2, ~100x rank 100");
+
+    // Walk and spread
+    std::vector<uint32_t> last(counts.size(), 0);
+    bool walk = true;
+    for (const auto& r : recs) {
+        uint32_t& prev = last[index[r.symbol]];
+        uint32_t tick = config.tick;
+        walk &= prev == 0 || (r.bid_price + tick >= prev && r.bid_price <= prev + tick);
+        walk &= r.bid_price >= tick && r.ask_price == r.bid_price + r.spread &&
+                r.spread >= tick && r.spread <= 3 * tick && r.spread % tick == 0;
+        walk &= r.bid_size >= 100 && r.bid_size <= 5000 && r.ask_size >= 100 && r.ask_size <= 5000;
+        prev = r.bid_price;
+    }
+    ok &= check(walk, "bids move one tick at most, spread 1-3 ticks");
+
+    // Timestamps
+    bool order = true;
+    for (size_t i = 0; i < N; i++) {
+        const BBORecord& r = recs[i];
+        order &= static_cast<int32_t>(r.ts_t2 - r.ts_t1) >= static_cast<int32_t>(BBOGenerator::PARSE_CYCLES) &&
+                 static_cast<int32_t>(r.ts_t3 - r.ts_t2) >= static_cast<int32_t>(BBOGenerator::CDC_CYCLES) &&
+                 static_cast<int32_t>(r.ts_t4 - r.ts_t3) >= static_cast<int32_t>(BBOGenerator::TX_CYCLES);
+        if (i > 0) {
+            order &= static_cast<int32_t>(r.ts_t4 - recs[i - 1].ts_t4) >=
+                     static_cast<int32_t>(BBOGenerator::PACKET_BEATS);
+        }
+    }
+    ok &= check(order, "T1 < T2 < T3 < T4, T4 a packet apart");
+
+    config.rate = 1000000;   // 250 cycles apart on average
+    config.zipf_s = 0.0;
+    BBOGenerator paced(config);
+    paced.next(recs.data(), 100000);
+    double gap = static_cast<double>(recs[99999].ts_t1 - recs[0].ts_t1) / 99999.0;
+    uint32_t latency = recs[99999].get_fpga_latency_cycles();
+    printf("  rate 1M/s: mean T1 gap %.1f cycles, latency %u cycles\n", gap, latency);
+    ok &= check(std::fabs(gap - 250.0) < 5.0, "T1 gap follows the configured rate");
+    ok &= check(latency < 40, "no queueing below line rate");
+    ok &= check(recs[1].symbol == SymbolKey("GEN00001"), "s = 0: round-robin");
+
+    // The largest universe has a distinct name per symbol; a larger one is clamped
+    GeneratorConfig wide;
+    wide.symbols = BBOGenerator::MAX_SYMBOLS;
+    BBOGenerator full(wide);
+    std::unordered_set<SymbolKey, SymbolKeyHash> names(full.symbols().begin(), full.symbols().end());
+    ok &= check(names.size() == BBOGenerator::MAX_SYMBOLS && full.symbols().back() == SymbolKey("GEN99999"),
+                "100000 distinct names");
+    wide.symbols = BBOGenerator::MAX_SYMBOLS + 1;
+    ok &= check(BBOGenerator(wide).symbols().size() == BBOGenerator::MAX_SYMBOLS, "larger universe clamped");
+    return ok;
+}
+
+static bool test_pool() {
+    bool ok = true;
+    for (WireFormat format : {WireFormat::BBO36, WireFormat::BBO48}) {
+        size_t size = wire_record_size(format);
+        GeneratorConfig config;
+        config.symbols = 16;
+        config.zipf_s = 1.2;
+        config.records = 5000;
+        GeneratorSource direct(config, format);
+        config.pool_records = 1000;
+        GeneratorSource pooled(config, format);
+
+        std::vector<uint8_t> a = read_all(direct, 5000 * size, 65536);
+        std::vector<uint8_t> b = read_all(pooled, 5000 * size, 65536);
+        std::vector<BBORecord> recs(5000);
+        decode_bbo_batch(b.data(), 5000, recs.data(), format);
+
+        bool increasing = true;
+        for (size_t i = 1; i < recs.size(); i++) {
+            increasing &= static_cast<int32_t>(recs[i].ts_t4 - recs[i - 1].ts_t4) > 0 &&
+                          static_cast<int32_t>(recs[i].ts_t1 - recs[i - 1].ts_t1) > 0;
+        }
+        bool same_lap = b.size() == 5000 * size && std::memcmp(a.data(), b.data(), 1000 * size) == 0;
+        bool laps_match = recs[1000].symbol == recs[0].symbol &&
+                          recs[1000].bid_price == recs[0].bid_price &&
+                          recs[4999].get_fpga_latency_cycles() == recs[999].get_fpga_latency_cycles();
+        const char* name = format == WireFormat::BBO48 ? "BBO48" : "BBO36";
+        char what[64];
+        snprintf(what, sizeof(what), "%s pool: first lap as generated", name);
+        ok &= check(same_lap, what);
+        snprintf(what, sizeof(what), "%s pool: laps repeat, time moves on", name);
+        ok &= check(laps_match && increasing, what);
+    }
+    return ok;
+}
+
+static bool test_rate() {
+    bool ok = true;
+    GeneratorConfig config;
+    config.rate = 200000;
+    GeneratorSource source(config, WireFormat::BBO36);
+
+    std::vector<uint8_t> buf(1 << 16);
+    uint64_t start = bench::now_ns();
+    size_t bytes = 0;
+    int empty = 0;
+    while (bench::now_ns() - start < 250000000ULL) {
+        ssize_t n = source.read(buf.data(), buf.size(), 10);
+        if (n > 0) {
+            bytes += static_cast<size_t>(n);
+        } else {
+            empty += n == 0;
+        }
+    }
+    double seconds = static_cast<double>(bench::now_ns() - start) / 1e9;
+    double rate = static_cast<double>(bytes / 36) / seconds;
+    printf("  target 200000/s: %.0f records/s\n", rate);
+    ok &= check(std::fabs(rate - 200000.0) < 20000.0, "paced within 10% of target");
+    ok &= check(bytes % 36 == 0, "paced reads end on a record");
+
+    config.rate = 10;
+    GeneratorSource slow(config, WireFormat::BBO36);
+    ok &= check(slow.read(buf.data(), buf.size(), 0) == 36 && slow.read(buf.data(), buf.size(), 0) == 0,
+                "slow rate: one due, then timeout");
+    return ok;
+}
+
+static void bench_fill() {
+    constexpr size_t RECORDS = 4000000;
+    struct Mode {
+        const char* name;
+        GeneratorPattern pattern;
+        double zipf_s;
+        uint32_t pool;
+    };
+    const Mode modes[] = {
+        {"test", GeneratorPattern::TEST_PATTERN, 0.0, 0},
+        {"market", GeneratorPattern::MARKET, 0.0, 0},
+        {"zipf", GeneratorPattern::MARKET, 1.0, 0},
+        {"pool", GeneratorPattern::MARKET, 1.0, 65536},
+    };
+    std::vector<uint8_t> buf(1 << 20);
+    for (WireFormat format : {WireFormat::BBO36, WireFormat::BBO48}) {
+        for (const Mode& m : modes) {
+            GeneratorConfig config;
+            config.pattern = m.pattern;
+            config.symbols = 1000;
+            config.zipf_s = m.zipf_s;
+            config.pool_records = m.pool;
+            config.records = RECORDS;
+            GeneratorSource source(config, format);
+
+            uint64_t start = bench::now_ns();
+            size_t bytes = 0;
+            ssize_t n;
+            while ((n = source.read(buf.data(), buf.size(), 0)) > 0) bytes += static_cast<size_t>(n);
+            bench::do_not_optimize(buf[0]);
+            double ns = static_cast<double>(bench::now_ns() - start);
+            printf("  %-6s %-6s %6.2f ns/record %9.1f MB/s\n",
+                   format == WireFormat::BBO48 ? "BBO48" : "BBO36", m.name,
+                   ns / RECORDS, static_cast<double>(bytes) * 1e3 / ns);
+        }
+    }
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("========================================\n");
+    printf("Synthetic Generator Test\n");
+    printf("========================================\n");
+
+    printf("Test pattern:\n");
+    bool ok = test_pattern();
+
+    printf("\nMarket model:\n");
+    ok &= test_market();
+
+    printf("\nPool replay:\n");
+    ok &= test_pool();
+
+    printf("\nRate pacing:\n");
+    ok &= test_rate();
+
+    printf("\nFill throughput:\n");
+    bench_fill();
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
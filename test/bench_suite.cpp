@@ -0,0 +1,422 @@
+/**
+ * Host-Path Benchmark Suite
+ * Repeatable per-record costs of each stage the host runs on C2H data,
+ * for regression tracking:
+ *
+ *   decode    decode_bbo_batch, both wire formats
+ *   symbol    SymbolKey packing, SymbolIndex lookup, BBOCache update
+ *   stats     TransferStats bookkeeping as read_bbo() does it
+ *   dispatch  BBOCallback / ChannelCallback invocation
+ *   stream    End to end: start_streaming() on the mock device, and
+ *             read_records() on the generator transport
+ *
+ * Each case runs in batches on a pinned CPU: warm-up repetitions first
+ * (discarded), then measured repetitions of -n records each. Reported per
+ * case: records/s over all measured time, ns/record percentiles across
+ * batches, and the spread of records/s between repetitions (a case whose
+ * spread is large is not yet a stable baseline). -j writes the same as
+ * JSON. Needs no hardware.
+ *
+ * Usage: ./bench_suite [options]
+ *   -n <count>  Records per repetition (default: 1000000)
+ *   -r <count>  Measured repetitions (default: 5)
+ *   -w <count>  Warm-up repetitions (default: 1)
+ *   -c <cpu>    CPU for the measuring and streaming threads, -1 = don't
+ *               pin (default: first CPU allowed)
+ *   -f <text>   Only cases whose name contains text
+ *   -j <path>   Write results as JSON
+ *   -h          Show this help
+ */
+
+#include "xdma_wrapper.h"
+#include "bbo_cache.h"
+#include "bbo_decode.h"
+#include "bbo_generator.h"
+#include "numa_placement.h"
+#include "symbol_index.h"
+#include "bench_util.h"
+#include "mock_device.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <getopt.h>
+#include <sched.h>
+#include <signal.h>
+
+using namespace pcie;
+
+static constexpr size_t BATCH = 256;           // Records per timed sample
+static constexpr size_t STREAM_BATCH = 1024;   // Stream cases: records per sample
+static constexpr size_t WORKING_SET = 65536;   // Records cycled through by the in-memory cases
+
+struct Options {
+    size_t records = 1000000;
+    int repetitions = 5;
+    int warmup = 1;
+    int cpu = -2;   // -2 = first allowed
+    std::string filter;
+    std::string json;
+};
+
+/**
+ * One benchmark: run() processes about one batch and returns how many
+ * records it handled (0 = failed, the case is abandoned)
+ */
+struct Case {
+    const char* name;
+    const char* group;
+    std::function<size_t()> run;
+};
+
+struct Result {
+    const char* name;
+    const char* group;
+    uint64_t records = 0;
+    double records_per_s = 0.0;
+    double mean = 0.0;   // ns/record
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double p999 = 0.0;
+    double max = 0.0;
+    double spread = 0.0;   // (max - min) / median of per-repetition records/s
+    std::vector<double> rep_rates;
+};
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size()));
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+static bool measure(const Case& c, const Options& opt, uint64_t overhead, Result& out) {
+    out.name = c.name;
+    out.group = c.group;
+    std::vector<double> per_record;
+    per_record.reserve(opt.records / BATCH * opt.repetitions + 64);
+    uint64_t total_ns = 0;
+
+    for (int rep = 0; rep < opt.warmup + opt.repetitions; rep++) {
+        bool measured = rep >= opt.warmup;
+        uint64_t done = 0;
+        uint64_t rep_ns = 0;
+        while (done < opt.records) {
+            uint64_t t0 = bench::now_ns();
+            size_t n = c.run();
+            uint64_t t1 = bench::now_ns();
+            if (n == 0) return false;
+            uint64_t ns = t1 - t0 > overhead ? t1 - t0 - overhead : 0;
+            done += n;
+            rep_ns += ns;
+            if (measured) per_record.push_back(static_cast<double>(ns) / static_cast<double>(n));
+        }
+        if (measured) {
+            out.records += done;
+            total_ns += rep_ns;
+            out.rep_rates.push_back(rep_ns ? static_cast<double>(done) * 1e9 / static_cast<double>(rep_ns) : 0.0);
+        }
+    }
+
+    std::sort(per_record.begin(), per_record.end());
+    out.records_per_s = total_ns ? static_cast<double>(out.records) * 1e9 / static_cast<double>(total_ns) : 0.0;
+    out.mean = out.records ? static_cast<double>(total_ns) / static_cast<double>(out.records) : 0.0;
+    out.p50 = percentile(per_record, 50.0);
+    out.p90 = percentile(per_record, 90.0);
+    out.p99 = percentile(per_record, 99.0);
+    out.p999 = percentile(per_record, 99.9);
+    out.max = per_record.empty() ? 0.0 : per_record.back();
+
+    std::vector<double> rates = out.rep_rates;
+    std::sort(rates.begin(), rates.end());
+    double median = percentile(rates, 50.0);
+    out.spread = median > 0.0 ? (rates.back() - rates.front()) / median : 0.0;
+    return true;
+}
+
+static void print_header() {
+    printf("%-30s %12s %8s %8s %8s %8s %9s %8s %7s\n",
+           "Case", "records/s", "mean", "p50", "p90", "p99", "p99.9", "max", "spread");
+    printf("%-30s %12s %8s %8s %8s %8s %9s %8s %7s\n",
+           "", "", "(ns/rec)", "", "", "", "", "", "");
+}
+
+static void print_row(const Result& r) {
+    printf("%-30s %12.0f %8.2f %8.2f %8.2f %8.2f %9.2f %8.1f %6.1f%%\n",
+           r.name, r.records_per_s, r.mean, r.p50, r.p90, r.p99, r.p999, r.max, 100.0 * r.spread);
+}
+
+static bool write_json(const std::string& path, const Options& opt, int cpu, uint64_t overhead,
+                const std::vector<Result>& results) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        perror(path.c_str());
+        return false;
+    }
+    fprintf(f, "{\n");
+    fprintf(f, "  \"suite\": \"host_path\",\n");
+    fprintf(f, "  \"unix_time\": %ld,\n", static_cast<long>(time(nullptr)));
+    fprintf(f, "  \"compiler\": \"%s\",\n", __VERSION__);
+    fprintf(f, "  \"cpu\": %d,\n", cpu);
+    fprintf(f, "  \"records_per_repetition\": %zu,\n", opt.records);
+    fprintf(f, "  \"repetitions\": %d,\n", opt.repetitions);
+    fprintf(f, "  \"warmup\": %d,\n", opt.warmup);
+    fprintf(f, "  \"timer_overhead_ns\": %lu,\n", overhead);
+    fprintf(f, "  \"cases\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"group\": \"%s\", \"records\": %lu, \"records_per_s\": %.1f,\n",
+                r.name, r.group, r.records, r.records_per_s);
+        fprintf(f, "     \"ns_per_record\": {\"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+                   "\"p99\": %.3f, \"p999\": %.3f, \"max\": %.3f},\n",
+                r.mean, r.p50, r.p90, r.p99, r.p999, r.max);
+        fprintf(f, "     \"spread\": %.4f, \"repetition_records_per_s\": [", r.spread);
+        for (size_t k = 0; k < r.rep_rates.size(); k++) {
+            fprintf(f, "%s%.1f", k ? ", " : "", r.rep_rates[k]);
+        }
+        fprintf(f, "]}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+static int first_allowed_cpu() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return -1;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set)) return cpu;
+    }
+    return -1;
+}
+
+static void usage(const char* prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  -n <count>  Records per repetition (default: 1000000)\n");
+    printf("  -r <count>  Measured repetitions (default: 5)\n");
+    printf("  -w <count>  Warm-up repetitions (default: 1)\n");
+    printf("  -c <cpu>    CPU for the measuring and streaming threads, -1 = don't pin\n");
+    printf("              (default: first CPU allowed)\n");
+    printf("  -f <text>   Only cases whose name contains text\n");
+    printf("  -j <path>   Write results as JSON\n");
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    int o;
+    while ((o = getopt(argc, argv, "n:r:w:c:f:j:h")) != -1) {
+        switch (o) {
+            case 'n': opt.records = strtoull(optarg, nullptr, 10); break;
+            case 'r': opt.repetitions = atoi(optarg); break;
+            case 'w': opt.warmup = atoi(optarg); break;
+            case 'c': opt.cpu = atoi(optarg); break;
+            case 'f': opt.filter = optarg; break;
+            case 'j': opt.json = optarg; break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return (o == 'h') ? 0 : 1;
+        }
+    }
+    opt.records = std::max<size_t>(opt.records, STREAM_BATCH);
+    opt.repetitions = std::max(opt.repetitions, 1);
+    opt.warmup = std::max(opt.warmup, 0);
+
+    // The mock writer sees EPIPE when the wrapper closes the FIFO
+    signal(SIGPIPE, SIG_IGN);
+
+    int cpu = opt.cpu == -2 ? first_allowed_cpu() : opt.cpu;
+    if (cpu >= 0 && !pin_current_thread({cpu})) {
+        fprintf(stderr, "Warning: could not pin to CPU %d, running unpinned\n", cpu);
+        cpu = -1;
+    }
+
+    // Shared input: a market stream over 1000 symbols, in every form the cases need
+    GeneratorConfig gen;
+    gen.symbols = 1000;
+    gen.zipf_s = 1.0;
+    BBOGenerator generator(gen);
+    std::vector<BBORecord> records(WORKING_SET);
+    generator.next(records.data(), records.size());
+    std::vector<uint8_t> wire36(WORKING_SET * wire_record_size(WireFormat::BBO36));
+    std::vector<uint8_t> wire48(WORKING_SET * wire_record_size(WireFormat::BBO48));
+    encode_bbo_batch(records.data(), records.size(), wire36.data(), WireFormat::BBO36);
+    encode_bbo_batch(records.data(), records.size(), wire48.data(), WireFormat::BBO48);
+    const BBOData* bbos = reinterpret_cast<const BBOData*>(wire36.data());
+    std::vector<std::string> names;
+    for (const SymbolKey& key : generator.symbols()) names.emplace_back(key.view());
+
+    size_t pos = 0;   // Position in the working set, shared by the in-memory cases
+    auto next_span = [&pos]() {
+        if (pos + BATCH > WORKING_SET) pos = 0;
+        size_t at = pos;
+        pos += BATCH;
+        return at;
+    };
+
+    std::vector<BBORecord> out(STREAM_BATCH);
+    uint64_t sink = 0;
+
+    SymbolIndex index(gen.symbols);
+    for (const SymbolKey& key : generator.symbols()) index.find_or_insert(key);
+    BBOCache cache(gen.symbols);
+    TransferStats stats;
+
+    std::function<void(const BBOData&)> bbo_callback = [&sink](const BBOData& b) { sink += b.bid_price; };
+    XDMAWrapper::ChannelCallback channel_callback = [&sink](uint32_t ch, const BBORecord& r) {
+        sink += r.bid_price + ch;
+    };
+
+    // End-to-end: mock device behind start_streaming()
+    MockDevice mock;
+    XDMAWrapper mock_xdma;
+    std::atomic<uint64_t> streamed{0};
+    uint64_t stream_seen = 0;
+
+    // End-to-end: generator transport behind read_records()
+    XDMAWrapper gen_xdma;
+
+    std::vector<Case> cases = {
+        {"decode BBO36", "decode", [&]() {
+            size_t at = next_span();
+            decode_bbo_batch(wire36.data() + at * wire_record_size(WireFormat::BBO36), BATCH,
+                             out.data(), WireFormat::BBO36);
+            bench::do_not_optimize(out[0].bid_price);
+            return BATCH;
+        }},
+        {"decode BBO48", "decode", [&]() {
+            size_t at = next_span();
+            decode_bbo_batch(wire48.data() + at * wire_record_size(WireFormat::BBO48), BATCH,
+                             out.data(), WireFormat::BBO48);
+            bench::do_not_optimize(out[0].bid_price);
+            return BATCH;
+        }},
+        {"symbol pack (text)", "symbol", [&]() {
+            size_t at = next_span();
+            uint64_t acc = 0;
+            for (size_t i = 0; i < BATCH; i++) acc += SymbolKey(names[(at + i) % names.size()]).raw();
+            bench::do_not_optimize(acc);
+            return BATCH;
+        }},
+        {"symbol index find", "symbol", [&]() {
+            size_t at = next_span();
+            uint32_t acc = 0;
+            for (size_t i = 0; i < BATCH; i++) acc += index.find(records[at + i].symbol);
+            bench::do_not_optimize(acc);
+            return BATCH;
+        }},
+        {"bbo cache update", "symbol", [&]() {
+            size_t at = next_span();
+            uint64_t now = bench::now_ns();
+            for (size_t i = 0; i < BATCH; i++) cache.update(bbos[at + i], now);
+            return BATCH;
+        }},
+        {"stats update (read_bbo)", "stats", [&]() {
+            size_t at = next_span();
+            for (size_t i = 0; i < BATCH; i++) {
+                stats.bytes_transferred += sizeof(BBOData);
+                stats.update_latency(bbos[at + i].get_fpga_latency_us());
+                stats.transfers_completed++;
+            }
+            bench::do_not_optimize(stats.avg_latency_us);
+            return BATCH;
+        }},
+        {"dispatch BBOCallback", "dispatch", [&]() {
+            size_t at = next_span();
+            for (size_t i = 0; i < BATCH; i++) bbo_callback(bbos[at + i]);
+            bench::do_not_optimize(sink);
+            return BATCH;
+        }},
+        {"dispatch ChannelCallback", "dispatch", [&]() {
+            size_t at = next_span();
+            for (size_t i = 0; i < BATCH; i++) channel_callback(0, records[at + i]);
+            bench::do_not_optimize(sink);
+            return BATCH;
+        }},
+        {"stream mock FIFO (read_bbo)", "stream", [&]() -> size_t {
+            // Samples are the time for the streaming thread to deliver the next batch
+            uint64_t target = stream_seen + STREAM_BATCH;
+            uint64_t deadline = bench::now_ns() + 1000000000ULL;
+            uint64_t now;
+            while ((now = streamed.load(std::memory_order_acquire)) < target) {
+                if (!mock_xdma.is_streaming() || bench::now_ns() > deadline) return 0;
+                std::this_thread::yield();
+            }
+            size_t n = static_cast<size_t>(now - stream_seen);
+            stream_seen = now;
+            return n;
+        }},
+        {"stream generator (read_records)", "stream", [&]() -> size_t {
+            int n = gen_xdma.read_records(out.data(), STREAM_BATCH, 100);
+            return n > 0 ? static_cast<size_t>(n) : 0;
+        }},
+    };
+
+    printf("=== Host-Path Benchmark Suite ===\n");
+    uint64_t overhead = bench::timer_overhead_ns();
+    printf("Records/repetition: %zu | Repetitions: %d (+%d warm-up) | CPU: %s | Timer overhead: %lu ns\n\n",
+           opt.records, opt.repetitions, opt.warmup,
+           cpu >= 0 ? std::to_string(cpu).c_str() : "unpinned", overhead);
+    print_header();
+
+    std::vector<Result> results;
+    bool ok = true;
+    for (const Case& c : cases) {
+        if (!opt.filter.empty() && std::string(c.name).find(opt.filter) == std::string::npos) continue;
+
+        if (std::string(c.name).find("mock") != std::string::npos) {
+            if (!mock.create()) return 1;
+            XDMADeviceConfig config = mock.config();
+            config.numa_node = -1;
+            if (cpu >= 0) config.stream_cpus = {cpu};
+            if (mock_xdma.open(config) != PCIeError::SUCCESS) {
+                printf("%-30s open failed\n", c.name);
+                ok = false;
+                continue;
+            }
+            mock_xdma.start_streaming([&streamed](const BBOData&) {
+                streamed.fetch_add(1, std::memory_order_release);
+            });
+        } else if (std::string(c.name).find("generator") != std::string::npos) {
+            XDMADeviceConfig config;
+            config.transport = TransportKind::GENERATOR;
+            config.generator = gen;
+            config.numa_node = -1;
+            if (gen_xdma.open(config) != PCIeError::SUCCESS) {
+                printf("%-30s open failed\n", c.name);
+                ok = false;
+                continue;
+            }
+        }
+
+        Result r;
+        if (measure(c, opt, overhead, r)) {
+            print_row(r);
+            results.push_back(r);
+        } else {
+            printf("%-30s failed\n", c.name);
+            ok = false;
+        }
+
+        if (mock_xdma.is_open()) {
+            mock_xdma.stop_streaming();
+            mock_xdma.close();
+            mock.destroy();
+        }
+        if (gen_xdma.is_open()) gen_xdma.close();
+    }
+    bench::do_not_optimize(sink);
+
+    if (!opt.json.empty()) {
+        if (!write_json(opt.json, opt, cpu, overhead, results)) return 1;
+        printf("\nResults written to %s\n", opt.json.c_str());
+    }
+    return ok ? 0 : 1;
+}
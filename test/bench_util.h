@@ -0,0 +1,142 @@
+/**
+ * Benchmark Utilities
+ * Shared timing and percentile reporting for the host-path benchmarks,
+ * and the check printer and record factory the offline tests share
+ */
+
+#pragma once
+
+#include "pcie_types.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace bench {
+
+inline uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Keep the optimiser from discarding a measured result
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Percentile summary of a sample set (nanoseconds)
+ */
+struct Summary {
+    size_t count = 0;
+    double mean = 0.0;
+    uint64_t min = 0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+};
+
+// Nearest-rank percentile of an already sorted sample set
+inline uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size()));
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+inline Summary summarize(std::vector<uint64_t>& samples) {
+    Summary s;
+    if (samples.empty()) return s;
+
+    std::sort(samples.begin(), samples.end());
+
+    double total = 0.0;
+    for (uint64_t v : samples) total += static_cast<double>(v);
+
+    s.count = samples.size();
+    s.mean = total / static_cast<double>(samples.size());
+    s.min = samples.front();
+    s.p50 = percentile(samples, 50.0);
+    s.p90 = percentile(samples, 90.0);
+    s.p99 = percentile(samples, 99.0);
+    s.p999 = percentile(samples, 99.9);
+    s.max = samples.back();
+    return s;
+}
+
+/**
+ * Smallest observable interval between two clock reads; subtracted from
+ * per-operation samples so sub-100 ns operations are not all timer cost
+ */
+inline uint64_t timer_overhead_ns(int iterations = 10000) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < iterations; i++) {
+        uint64_t t0 = now_ns();
+        uint64_t t1 = now_ns();
+        best = std::min(best, t1 - t0);
+    }
+    return best;
+}
+
+inline void print_header() {
+    printf("%-28s %8s %8s %8s %8s %8s %9s %10s\n",
+           "Operation", "p50", "p90", "p99", "p99.9", "max", "mean", "MB/s");
+    printf("%-28s %8s %8s %8s %8s %8s %9s %10s\n",
+           "", "(ns)", "(ns)", "(ns)", "(ns)", "(ns)", "(ns)", "");
+}
+
+/**
+ * Print one result row
+ * @param bytes_per_op Payload moved per sample, 0 to omit the MB/s column
+ */
+inline void print_row(const char* name, const Summary& s, size_t bytes_per_op = 0) {
+    printf("%-28s %8lu %8lu %8lu %8lu %8lu %9.1f",
+           name, s.p50, s.p90, s.p99, s.p999, s.max, s.mean);
+    if (bytes_per_op > 0 && s.mean > 0.0) {
+        // bytes per ns == GB/s, so scale by 1000 for MB/s
+        printf(" %10.1f", static_cast<double>(bytes_per_op) / s.mean * 1000.0);
+    }
+    printf("\n");
+}
+
+/**
+ * Print one test check as an aligned OK/FAIL line
+ * @return cond, for ok &= check(...)
+ */
+inline bool check(bool cond, const char* what) {
+    printf("  %-44s %s\n", what, cond ? "OK" : "FAIL");
+    return cond;
+}
+
+/**
+ * Native record for a hand-built quote (prices fixed-point, 4 decimals)
+ * @param t1 ts_t1 / rx_timestamp
+ * @param t4 ts_t4 / tx_timestamp
+ */
+inline pcie::BBORecord make_record(const char* symbol, uint32_t bid, uint32_t bid_size,
+                                   uint32_t ask, uint32_t ask_size,
+                                   uint32_t t1 = 0, uint32_t t4 = 0) {
+    pcie::BBORecord r{};
+    r.symbol = pcie::SymbolKey(symbol);
+    r.bid_price = bid;
+    r.bid_size = bid_size;
+    r.ask_price = ask;
+    r.ask_size = ask_size;
+    r.spread = ask > bid ? ask - bid : 0;
+    r.ts_t1 = t1;
+    r.ts_t4 = t4;
+    return r;
+}
+
+// The same quote as the 36-byte big-endian wire record
+inline pcie::BBOData make_bbo(const char* symbol, uint32_t bid, uint32_t bid_size,
+                              uint32_t ask, uint32_t ask_size,
+                              uint32_t t1 = 0, uint32_t t4 = 0) {
+    return make_record(symbol, bid, bid_size, ask, ask_size, t1, t4).to_bbo_data();
+}
+
+}  // namespace bench
@@ -0,0 +1,297 @@
+/**
+ * Book Snapshot Test
+ * Checkpoints a BBO cache to an mmapped file and warm-starts a fresh
+ * cache from it: round trip, stale marking, generation publication,
+ * growing a file too small for the cache, recovery from a bad file,
+ * the XDMAWrapper open/close path on a mock device, and lock-free
+ * readers of the cache while the wrapper reopens. Needs no hardware.
+ */
+
+#include "book_snapshot.h"
+#include "xdma_wrapper.h"
+#include "mock_device.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <signal.h>
+#include <unistd.h>
+
+using namespace pcie;
+using bench::check;
+using bench::make_record;
+using bench::now_ns;
+
+static std::string temp_path(const char* name) {
+    return "/tmp/book_snapshot_test_" + std::to_string(getpid()) + "_" + name;
+}
+
+static bool test_round_trip() {
+    bool ok = true;
+    std::string path = temp_path("round_trip");
+
+    BBOCache live(64);
+    uint64_t t = now_ns();
+    live.update(make_record("AAPL", 1500000, 100, 1500100, 200, 1000, 1025), t);
+    live.update(make_record("MSFT", 4000000, 100, 4001000, 200, 1000, 1025), t);
+    live.update(make_record("AAPL", 1500200, 100, 1500300, 200, 1000, 1025), t);
+
+    {
+        BookSnapshot snap;
+        ok &= check(snap.open(path, 64) == PCIeError::SUCCESS, "create snapshot file");
+        ok &= check(snap.generation() == 0, "new file has generation 0");
+        ok &= check(snap.checkpoint(live) == 1, "first checkpoint is generation 1");
+    }
+
+    // A new process: fresh cache, existing file
+    BookSnapshot snap;
+    ok &= check(snap.open(path, 8) == PCIeError::SUCCESS && snap.capacity() == 64,
+                "reopen keeps the file's capacity");
+
+    BBOCache warm(64);
+    uint64_t gen = 0;
+    ok &= check(snap.load(warm, &gen) == 2 && gen == 1, "load restores 2 symbols");
+
+    BBOQuote q;
+    ok &= check(warm.get(SymbolKey("AAPL"), q) && q.bid_price == 1500200 &&
+                q.ask_price == 1500300 && q.rx_timestamp == 1000 && q.tx_timestamp == 1025,
+                "restored quote matches latest");
+    ok &= check(q.stale, "restored quote is stale");
+
+    // Wall-clock round trip keeps the age within the test's runtime
+    uint64_t age = now_ns() - q.host_time_ns;
+    ok &= check(q.host_time_ns <= now_ns() && age < 5'000'000'000ULL, "restored timestamp preserved");
+
+    warm.update(make_record("AAPL", 1500400, 100, 1500500, 200, 1000, 1025), now_ns());
+    ok &= check(warm.get(SymbolKey("AAPL"), q) && !q.stale && q.bid_price == 1500400,
+                "live update clears stale");
+    ok &= check(warm.get(SymbolKey("MSFT"), q) && q.stale, "untouched symbol stays stale");
+
+    unlink(path.c_str());
+    return ok;
+}
+
+static bool test_generations() {
+    bool ok = true;
+    std::string path = temp_path("generations");
+
+    BookSnapshot snap;
+    snap.open(path, 16);
+
+    BBOCache cache(16);
+    cache.update(make_record("AAPL", 1500000, 100, 1500100, 200, 1000, 1025), now_ns());
+    snap.checkpoint(cache);
+    cache.update(make_record("AAPL", 1600000, 100, 1600100, 200, 1000, 1025), now_ns());
+    cache.update(make_record("IBM", 1200000, 100, 1200100, 200, 1000, 1025), now_ns());
+    ok &= check(snap.checkpoint(cache) == 2, "second checkpoint is generation 2");
+
+    // The newest generation wins; the previous half is left intact
+    BBOCache warm(16);
+    BBOQuote q;
+    ok &= check(snap.load(warm) == 2 && warm.get(SymbolKey("AAPL"), q) && q.bid_price == 1600000,
+                "load picks the latest generation");
+
+    for (int i = 0; i < 10; i++) snap.checkpoint(cache);
+    ok &= check(snap.generation() == 12, "generation counts every checkpoint");
+
+    // A second mapping of the same file sees the published generation
+    BookSnapshot reader;
+    reader.open(path, 16);
+    BBOCache other(16);
+    uint64_t gen = 0;
+    ok &= check(reader.load(other, &gen) == 2 && gen == 12, "second mapping loads generation 12");
+
+    // Capacity bounds what a checkpoint can hold
+    BBOCache big(32);
+    char name[8];
+    for (int i = 0; i < 20; i++) {
+        snprintf(name, sizeof(name), "S%02d", i);
+        big.update(make_record(name, 100, 100, 200, 200, 1000, 1025), now_ns());
+    }
+    snap.checkpoint(big);
+    BBOCache small(32);
+    ok &= check(snap.load(small) == 16, "checkpoint truncated at capacity");
+    ok &= check(snap.skipped() == 4, "left-out symbols counted");
+
+    // Reopening for a larger cache grows the file and keeps the book
+    ok &= check(snap.open(path, 32) == PCIeError::SUCCESS && snap.capacity() == 32 &&
+                snap.generation() == 13 && snap.skipped() == 0,
+                "smaller file grown, generation kept");
+    BBOCache grown(32);
+    ok &= check(snap.load(grown) == 16, "grown file loads the old book");
+    ok &= check(snap.checkpoint(big) == 14 && snap.skipped() == 0, "grown file takes every symbol");
+    BBOCache all(32);
+    ok &= check(snap.load(all) == 20, "all 20 symbols restored");
+
+    // The old mapping still holds its own consistent book
+    BBOCache old_view(32);
+    ok &= check(reader.load(old_view) == 16 && reader.generation() == 13, "old mapping unaffected");
+
+    unlink(path.c_str());
+    return ok;
+}
+
+static bool test_bad_file() {
+    bool ok = true;
+    std::string path = temp_path("bad_file");
+
+    FILE* f = fopen(path.c_str(), "w");
+    fputs("not a snapshot", f);
+    fclose(f);
+
+    BookSnapshot snap;
+    ok &= check(snap.open(path, 32) == PCIeError::SUCCESS && snap.capacity() == 32 &&
+                snap.generation() == 0,
+                "garbage file is reinitialised");
+    BBOCache cache(32);
+    ok &= check(snap.load(cache) == 0 && cache.size() == 0, "nothing loaded from it");
+
+    ok &= check(snap.open("/nonexistent/dir/snap", 32) == PCIeError::OPEN_FAILED && !snap.is_open(),
+                "unwritable path fails to open");
+
+    BookSnapshot closed;
+    ok &= check(closed.checkpoint(cache) == 0 && closed.load(cache) == 0, "closed snapshot is inert");
+
+    unlink(path.c_str());
+    return ok;
+}
+
+static bool test_wrapper() {
+    bool ok = true;
+    std::string path = temp_path("wrapper");
+    SymbolKey sym("MOCKAAPL");
+    BBOQuote q;
+
+    // First session: stream, checkpoint in the background, final one on close
+    {
+        MockDevice mock;
+        if (!mock.create()) return check(false, "mock device created");
+        XDMADeviceConfig config = mock.config();
+        config.snapshot_path = path;
+        config.snapshot_interval_ms = 20;
+
+        XDMAWrapper xdma;
+        if (xdma.open(config) != PCIeError::SUCCESS) return check(false, "mock device opened");
+        ok &= check(!xdma.get_latest(sym, q), "no snapshot on first open");
+
+        xdma.start_streaming([](const BBOData&) {});
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        ok &= check(xdma.get_snapshot_generation() >= 2, "periodic checkpoints");
+        xdma.stop_streaming();
+        ok &= check(xdma.checkpoint() == PCIeError::SUCCESS, "checkpoint() on demand");
+        xdma.close();
+    }
+
+    // Restart: the book is there before any record is read
+    MockDevice mock;
+    if (!mock.create()) return check(false, "mock device created");
+    XDMADeviceConfig config = mock.config();
+    config.snapshot_path = path;
+    config.snapshot_interval_ms = 0;
+
+    XDMAWrapper xdma;
+    if (xdma.open(config) != PCIeError::SUCCESS) return check(false, "mock device reopened");
+    ok &= check(xdma.get_latest(sym, q) && q.stale && q.bid_price >= 1500000,
+                "warm start: quote present and stale");
+
+    xdma.start_streaming([](const BBOData&) {});
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    xdma.stop_streaming();
+    ok &= check(xdma.get_latest(sym, q) && !q.stale, "live data refreshes the quote");
+    xdma.close();
+
+    XDMAWrapper plain;
+    ok &= check(plain.checkpoint() == PCIeError::INVALID_PARAMETER,
+                "checkpoint() without a snapshot file");
+
+    unlink(path.c_str());
+    return ok;
+}
+
+// get_latest() readers keep running while the wrapper closes and reopens
+static bool test_reopen() {
+    // The mock's writer ends with its reader, so each open gets a new one
+    auto mock = std::make_unique<MockDevice>();
+    XDMAWrapper xdma;
+    if (!mock->create() || xdma.open(mock->config()) != PCIeError::SUCCESS) {
+        return check(false, "mock device opened");
+    }
+
+    SymbolKey sym("MOCKAAPL");
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> reads{0};
+    std::thread reader([&]() {
+        BBOQuote q;
+        while (running) {
+            xdma.get_latest(sym, q);
+            if (const BBOCache* cache = xdma.get_cache()) cache->get(sym, q);
+            reads++;
+        }
+    });
+
+    bool opened = true;
+    bool cleared = true;
+    bool kept = true;
+    bool replaced = true;
+    const BBOCache* first = xdma.get_cache();
+    for (int i = 0; i < 20; i++) {
+        BBOQuote q;
+        xdma.start_streaming([](const BBOData&) {});
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        xdma.stop_streaming();
+        xdma.close();
+
+        const BBOCache* before = xdma.get_cache();
+        mock = std::make_unique<MockDevice>();
+        opened &= mock->create();
+        XDMADeviceConfig config = mock->config();
+        config.max_symbols = i % 5 == 4 ? 1024 + i : before->capacity();
+        opened &= xdma.open(config) == PCIeError::SUCCESS;
+        cleared &= !xdma.get_latest(sym, q);
+        if (i % 5 == 4) {
+            replaced &= xdma.get_cache() != before && before->get(sym, q);  // Last session's book
+        } else {
+            kept &= xdma.get_cache() == before;
+        }
+    }
+    running = false;
+    reader.join();
+    xdma.close();
+
+    printf("  %lu lock-free reads across 20 reopens\n", static_cast<unsigned long>(reads.load()));
+    bool ok = check(opened && reads > 0, "readers run through reopen");
+    ok &= check(cleared, "reopen forgets the last session's quotes");
+    ok &= check(kept && first != nullptr, "same max_symbols: cache cleared in place");
+    ok &= check(replaced, "new max_symbols: old cache left readable");
+    return ok;
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("========================================\n");
+    printf("Book Snapshot Test\n");
+    printf("========================================\n");
+
+    printf("Round trip:\n");
+    bool ok = test_round_trip();
+
+    printf("\nGenerations:\n");
+    ok &= test_generations();
+
+    printf("\nBad files:\n");
+    ok &= test_bad_file();
+
+    printf("\nWrapper warm start:\n");
+    ok &= test_wrapper();
+
+    printf("\nReopen under readers:\n");
+    ok &= test_reopen();
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/**
+ * Conflation Buffer Test
+ * Newer updates overwrite a pending symbol without a second dirty entry,
+ * drain() delivers first-dirtied order and honours max_count, a full
+ * table counts rejections, a waiting drain() wakes on publish(), and
+ * drain_conflated() keeps running while start_conflated_streaming()
+ * replaces the buffer. Needs no hardware.
+ */
+
+#include "conflation_buffer.h"
+#include "xdma_wrapper.h"
+#include "mock_device.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <signal.h>
+
+using namespace pcie;
+using bench::check;
+using bench::make_bbo;
+
+static uint32_t bid_of(const BBOData& bbo) {
+    return __builtin_bswap32(bbo.bid_price);
+}
+
+static bool test_overwrite() {
+    bool ok = true;
+    ConflationBuffer buf(16);
+    buf.publish(make_bbo("AAPL", 1500000, 100, 1500100, 200));
+    buf.publish(make_bbo("AAPL", 1500200, 100, 1500300, 200));
+    buf.publish(make_bbo("AAPL", 1500400, 100, 1500500, 200));
+    ok &= check(buf.get_stats().pending == 1, "one dirty entry for three updates");
+
+    std::vector<BBOData> out;
+    size_t n = buf.drain(out, 10);
+    ok &= check(n == 1 && out.size() == 1 && bid_of(out[0]) == 1500400, "newest update delivered");
+
+    ConflationStats s = buf.get_stats();
+    ok &= check(s.published == 3 && s.delivered == 1 && s.conflated == 2 && s.pending == 0,
+                "published 3, delivered 1, conflated 2");
+    ok &= check(buf.drain(out, 10) == 0 && out.empty(), "nothing left after drain");
+    return ok;
+}
+
+static bool test_order() {
+    bool ok = true;
+    ConflationBuffer buf(16);
+    buf.publish(make_bbo("MSFT", 4000000, 100, 4001000, 200));
+    buf.publish(make_bbo("AAPL", 1500000, 100, 1500100, 200));
+    buf.publish(make_bbo("IBM", 1200000, 100, 1200100, 200));
+    buf.publish(make_bbo("AAPL", 1500900, 100, 1501000, 200));   // Keeps its place
+
+    std::vector<BBOData> out;
+    ok &= check(buf.drain(out, 2) == 2 && out[0].get_symbol_key() == SymbolKey("MSFT") &&
+                    out[1].get_symbol_key() == SymbolKey("AAPL") && bid_of(out[1]) == 1500900,
+                "first-dirtied order, max_count 2");
+    ok &= check(buf.drain(out, 2) == 1 && out[0].get_symbol_key() == SymbolKey("IBM"), "remainder on next drain");
+
+    // Symbol drained, then dirtied again: goes to the back
+    buf.publish(make_bbo("IBM", 1200200, 100, 1200300, 200));
+    buf.publish(make_bbo("MSFT", 4000100, 100, 4001100, 200));
+    ok &= check(buf.drain(out, 10) == 2 && out[0].get_symbol_key() == SymbolKey("IBM") &&
+                    out[1].get_symbol_key() == SymbolKey("MSFT"),
+                "re-dirtied symbols in new order");
+
+    // Many rounds wrap the dirty ring
+    bool wrapped = true;
+    for (int round = 0; round < 50; round++) {
+        for (int i = 0; i < 5; i++) {
+            char name[16];
+            snprintf(name, sizeof(name), "W%d", (round + i) % 7);
+            buf.publish(make_bbo(name, 1000000 + round, 100, 1000100 + round, 200));
+        }
+        wrapped &= buf.drain(out, 16) == 5;
+        for (int i = 0; i < 5 && i < static_cast<int>(out.size()); i++) {
+            char name[16];
+            snprintf(name, sizeof(name), "W%d", (round + i) % 7);
+            wrapped &= out[i].get_symbol_key() == SymbolKey(name);
+        }
+    }
+    ok &= check(wrapped, "order kept across dirty-ring wraps");
+    return ok;
+}
+
+static bool test_full() {
+    bool ok = true;
+    ConflationBuffer buf(4);
+    bool accepted = true;
+    const char* names[] = {"A", "B", "C", "D"};
+    for (const char* name : names) accepted &= buf.publish(make_bbo(name, 100, 1, 200, 1));
+    ok &= check(accepted, "capacity symbols accepted");
+    ok &= check(!buf.publish(make_bbo("E", 100, 1, 200, 1)), "new symbol rejected when full");
+    ok &= check(buf.publish(make_bbo("B", 300, 1, 400, 1)), "known symbol still accepted");
+
+    ConflationStats s = buf.get_stats();
+    ok &= check(s.rejected == 1 && s.published == 6 && s.pending == 4, "rejected counted");
+
+    std::vector<BBOData> out;
+    ok &= check(buf.drain(out, 10) == 4, "rejected update not delivered");
+    return ok;
+}
+
+static bool test_wake() {
+    bool ok = true;
+    ConflationBuffer buf(16);
+
+    std::vector<BBOData> out;
+    auto t0 = std::chrono::steady_clock::now();
+    ok &= check(buf.drain(out, 10, 20) == 0, "empty drain times out");
+    auto waited = std::chrono::steady_clock::now() - t0;
+    ok &= check(waited >= std::chrono::milliseconds(15), "timeout honoured");
+
+    std::atomic<size_t> got{0};
+    std::atomic<int64_t> took_ms{0};
+    std::thread consumer([&]() {
+        std::vector<BBOData> mine;
+        auto start = std::chrono::steady_clock::now();
+        got = buf.drain(mine, 10, 5000);
+        took_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    buf.publish(make_bbo("AAPL", 1500000, 100, 1500100, 200));
+    consumer.join();
+    printf("  drain woke after %ld ms\n", static_cast<long>(took_ms.load()));
+    ok &= check(got == 1 && took_ms < 2000, "waiting drain wakes on publish");
+    return ok;
+}
+
+// A consumer keeps draining while the session restarts under it
+static bool test_restart() {
+    MockDevice mock;
+    XDMAWrapper xdma;
+    bool ok = check(mock.create() && xdma.open(mock.config()) == PCIeError::SUCCESS,
+                    "mock device opened");
+    if (!ok) {
+        mock.destroy();
+        return false;
+    }
+
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> drained{0};
+    std::thread consumer([&]() {
+        std::vector<BBOData> out;
+        while (running) drained += xdma.drain_conflated(out, 64, 5);
+    });
+
+    bool started = true;
+    for (int i = 0; i < 30; i++) {
+        started &= xdma.start_conflated_streaming() == PCIeError::SUCCESS;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        xdma.stop_streaming();
+    }
+    started &= xdma.start_conflated_streaming() == PCIeError::SUCCESS;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    running = false;
+    consumer.join();
+    xdma.stop_streaming();
+
+    ok &= check(started, "30 restarts while draining");
+    ok &= check(drained > 0, "consumer drained across restarts");
+    ConflationStats s = xdma.get_conflation_stats();
+    ok &= check(s.published > 0 && s.delivered + s.conflated + s.pending <= s.published,
+                "last session's stats consistent");
+    xdma.close();
+    mock.destroy();
+    return ok;
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);  // Mock writer outlives the wrapper's reader
+
+    printf("========================================\n");
+    printf("Conflation Buffer Test\n");
+    printf("========================================\n");
+
+    printf("Overwrite:\n");
+    bool ok = test_overwrite();
+
+    printf("\nDrain order:\n");
+    ok &= test_order();
+
+    printf("\nFull table:\n");
+    ok &= test_full();
+
+    printf("\nWake on publish:\n");
+    ok &= test_wake();
+
+    printf("\nRestart while draining:\n");
+    ok &= test_restart();
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
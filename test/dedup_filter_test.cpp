@@ -0,0 +1,203 @@
+/**
+ * Dedup Filter Test
+ * Checks payload and field-mask suppression, per-symbol counts, that
+ * BBOData and BBORecord input share one state, and filtering ahead of
+ * dispatch on a mock device stream, across a switch of streaming mode.
+ * Needs no hardware.
+ */
+
+#include "dedup_filter.h"
+#include "xdma_wrapper.h"
+#include "mock_device.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <signal.h>
+
+using namespace pcie;
+using bench::check;
+using bench::make_bbo;
+using bench::make_record;
+
+static bool test_modes() {
+    bool ok = true;
+
+    // Default: any top-of-book field, timestamps ignored
+    DedupFilter top;
+    bool first = top.accept(make_bbo("AAPL", 1500000, 100, 1500100, 200, 1, 2));
+    bool repeat = top.accept(make_bbo("AAPL", 1500000, 100, 1500100, 200, 50, 60));
+    bool size = top.accept(make_bbo("AAPL", 1500000, 101, 1500100, 200, 70, 80));
+    bool other = top.accept(make_bbo("MSFT", 1500000, 101, 1500100, 200, 70, 80));
+    ok &= check(first && !repeat && size && other, "FIELDS/TOP: timestamps ignored, sizes count");
+
+    // Prices only: size changes are suppressed too
+    DedupConfig prices;
+    prices.fields = DEDUP_PRICES;
+    DedupFilter px(prices);
+    px.accept(make_bbo("AAPL", 1500000, 100, 1500100, 200));
+    bool size_only = px.accept(make_bbo("AAPL", 1500000, 999, 1500100, 1));
+    bool bid_move = px.accept(make_bbo("AAPL", 1500100, 999, 1500200, 1));
+    ok &= check(!size_only && bid_move, "FIELDS/PRICES: size-only change suppressed");
+
+    // Payload: exact repeats only (rx timestamp is inside the 32 bytes)
+    DedupConfig payload;
+    payload.mode = DedupMode::PAYLOAD;
+    DedupFilter pl(payload);
+    pl.accept(make_bbo("AAPL", 1500000, 100, 1500100, 200, 5, 6));
+    bool exact = pl.accept(make_bbo("AAPL", 1500000, 100, 1500100, 200, 5, 99));
+    bool new_rx = pl.accept(make_bbo("AAPL", 1500000, 100, 1500100, 200, 7, 99));
+    ok &= check(!exact && new_rx, "PAYLOAD: exact repeat dropped, new T1 passes");
+
+    // BBORecord input, same rules
+    DedupFilter rec;
+    BBORecord r{};
+    r.symbol = SymbolKey("AAPL");
+    r.bid_price = 1500000;
+    r.ask_price = 1500100;
+    rec.accept(r);
+    r.ts_t1 = 1234;
+    r.ts_t4 = 5678;
+    bool rec_repeat = rec.accept(r);
+    r.ask_size = 1;
+    bool rec_change = rec.accept(r);
+    ok &= check(!rec_repeat && rec_change, "BBORecord input");
+
+    // Either input type follows the same quote
+    DedupFilter mixed;
+    mixed.accept(make_bbo("AAPL", 1500000, 100, 1500100, 200, 1, 2));
+    bool as_record = mixed.accept(make_record("AAPL", 1500000, 100, 1500100, 200, 3, 4));
+    bool moved = mixed.accept(make_record("AAPL", 1500100, 100, 1500200, 200, 3, 4));
+    bool back = mixed.accept(make_bbo("AAPL", 1500100, 100, 1500200, 200, 5, 6));
+    ok &= check(!as_record && moved && !back, "BBOData then BBORecord: one state");
+
+    DedupStats s = top.get_stats();
+    ok &= check(s.seen == 4 && s.suppressed == 1 && s.passed == 3 &&
+                top.suppressed(SymbolKey("AAPL")) == 1 && top.suppressed(SymbolKey("MSFT")) == 0,
+                "stats and per-symbol counts");
+
+    // Table full: new symbols pass untracked
+    DedupConfig tiny;
+    tiny.max_symbols = 1;
+    DedupFilter small(tiny);
+    small.accept(make_bbo("AAPL", 1, 1, 2, 1));
+    bool a = small.accept(make_bbo("MSFT", 1, 1, 2, 1));
+    bool b = small.accept(make_bbo("MSFT", 1, 1, 2, 1));
+    ok &= check(a && b && small.get_stats().untracked == 2, "full table passes untracked");
+    return ok;
+}
+
+static void bench_accept() {
+    // Half the records repeat the previous quote of their symbol
+    std::vector<BBOData> recs;
+    const char* tickers[] = {"AAPL", "MSFT", "GOOGL", "AMZN"};
+    for (uint32_t i = 0; i < 4096; i++) {
+        recs.push_back(make_bbo(tickers[i % 4], 1500000 + (i / 8) * 100, 100, 1500100 + (i / 8) * 100,
+                                200, i, i + 1));
+    }
+
+    DedupFilter filter;
+    const int passes = 200;
+    uint64_t t0 = bench::now_ns();
+    size_t passed = 0;
+    for (int p = 0; p < passes; p++) {
+        for (const BBOData& b : recs) passed += filter.accept(b);
+    }
+    uint64_t t1 = bench::now_ns();
+    bench::do_not_optimize(passed);
+    printf("  accept(): %.2f ns/record\n",
+           static_cast<double>(t1 - t0) / (static_cast<double>(passes) * recs.size()));
+}
+
+static bool test_streaming() {
+    // Each quote sent three times with fresh timestamps
+    std::vector<BBOData> recs;
+    for (uint32_t i = 0; i < 30; i++) {
+        uint32_t q = i / 3;
+        recs.push_back(make_bbo(i % 2 ? "AAPL" : "MSFT", 1500000 + q * 100, 100,
+                                1500100 + q * 100, 200, i * 10, i * 10 + 5));
+    }
+
+    MockDevice mock;
+    mock.set_records(recs);
+    XDMAWrapper xdma;
+    if (!mock.create() || xdma.open(mock.config()) != PCIeError::SUCCESS) {
+        return check(false, "mock device opened");
+    }
+
+    bool ok = check(xdma.set_dedup(DedupConfig()) == PCIeError::SUCCESS, "set_dedup()");
+
+    std::atomic<uint64_t> delivered{0};
+    xdma.start_streaming([&](const BBOData&) { delivered++; });
+    ok &= check(xdma.set_dedup(DedupConfig()) == PCIeError::BUSY, "set_dedup() while streaming is BUSY");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    xdma.stop_streaming();
+
+    DedupStats s = xdma.get_dedup_stats();
+    xdma.close();
+    mock.destroy();
+
+    printf("  %lu seen, %lu passed, %lu suppressed\n", s.seen, s.passed, s.suppressed);
+    ok &= check(s.seen > 0 && s.suppressed > 0 && delivered == s.passed,
+                "only changed records dispatched");
+    return ok;
+}
+
+// One filter across a BBOData session and a BBORecord (sharded) session
+static bool test_mode_switch() {
+    std::vector<BBOData> recs = {make_bbo("AAPL", 1500000, 100, 1500100, 200),
+                                 make_bbo("MSFT", 4000000, 100, 4001000, 200)};
+    MockDevice mock;
+    mock.set_records(recs);
+    XDMAWrapper xdma;
+    if (!mock.create() || xdma.open(mock.config()) != PCIeError::SUCCESS) {
+        return check(false, "mock device opened");
+    }
+
+    bool ok = check(xdma.set_dedup(DedupConfig()) == PCIeError::SUCCESS, "set_dedup()");
+    std::atomic<uint64_t> delivered{0};
+    xdma.start_streaming([&](const BBOData&) { delivered++; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    xdma.stop_streaming();
+    DedupStats first = xdma.get_dedup_stats();
+
+    ok &= check(xdma.start_sharded_streaming([&](uint32_t, const BBORecord&) { delivered++; }) ==
+                    PCIeError::SUCCESS,
+                "sharded session started");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    xdma.stop_streaming();
+    DedupStats s = xdma.get_dedup_stats();
+    xdma.close();
+    mock.destroy();
+
+    printf("  %lu seen, %lu passed\n", s.seen, s.passed);
+    ok &= check(first.passed == 2 && s.seen > first.seen, "first session passes each quote once");
+    ok &= check(s.passed == 2 && delivered == 2, "quotes stay suppressed after the switch");
+    return ok;
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("========================================\n");
+    printf("Dedup Filter Test\n");
+    printf("========================================\n");
+
+    printf("Modes:\n");
+    bool ok = test_modes();
+
+    printf("\nThroughput:\n");
+    bench_accept();
+
+    printf("\nStreaming:\n");
+    ok &= test_streaming();
+
+    printf("\nMode switch:\n");
+    ok &= test_mode_switch();
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
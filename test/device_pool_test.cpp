@@ -0,0 +1,223 @@
+/**
+ * Device Pool Test
+ * Runs XDMADevicePool over several mock cards: the unified stream tags
+ * records with the right device, a card whose link drops or whose C2H
+ * ends does not stall the others, a failed card is reopened, and open()
+ * copes with cards that are missing.
+ * Needs no hardware.
+ */
+
+#include "xdma_device_pool.h"
+#include "mock_device.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+using namespace pcie;
+using bench::check;
+
+static void sleep_ms(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// Record set naming its card ("MOCKDEV0", "MOCKDEV1", ...)
+static std::vector<BBOData> device_records(uint32_t device, size_t n) {
+    std::vector<BBOData> records(n);
+    for (size_t i = 0; i < n; i++) {
+        BBOData& b = records[i];
+        char symbol[9];
+        snprintf(symbol, sizeof(symbol), "MOCKDEV%u", device);
+        std::memcpy(b.symbol, symbol, 8);
+        b.bid_price = __builtin_bswap32(1000000 + device * 10000 + static_cast<uint32_t>(i));
+        b.bid_size = __builtin_bswap32(100);
+        b.ask_price = __builtin_bswap32(1000100 + device * 10000 + static_cast<uint32_t>(i));
+        b.ask_size = __builtin_bswap32(100);
+        b.spread = __builtin_bswap32(100);
+        b.rx_timestamp = 0;
+        b.tx_timestamp = __builtin_bswap32(25);
+    }
+    return records;
+}
+
+static void set_link(const XDMADeviceConfig& config, bool up) {
+    int fd = ::open(config.user_path.c_str(), O_RDWR);
+    if (fd < 0) return;
+    uint32_t status = ControlRegisters::STATUS_RUNNING | (up ? ControlRegisters::STATUS_LINK_UP : 0);
+    if (pwrite(fd, &status, 4, ControlRegisters::STATUS_OFFSET) != 4) perror("pwrite");
+    ::close(fd);
+}
+
+static bool test_unified_stream() {
+    bool ok = true;
+    std::vector<std::unique_ptr<MockDevice>> mocks;
+    std::vector<XDMADeviceConfig> configs;
+    for (uint32_t i = 0; i < 3; i++) {
+        auto mock = std::make_unique<MockDevice>();
+        mock->set_records(device_records(i, 100));
+        if (!mock->create()) return check(false, "mock device created");
+        configs.push_back(mock->config());
+        mocks.push_back(std::move(mock));
+    }
+
+    XDMADevicePool pool;
+    ok &= check(pool.open(configs) == PCIeError::SUCCESS && pool.size() == 3, "three cards opened");
+
+    std::atomic<uint64_t> count[3] = {};
+    std::atomic<uint64_t> mislabelled{0};
+    DevicePoolConfig pc;
+    pc.link_check_ms = 10;
+    pc.reopen_ms = 0;
+    ok &= check(pool.start_streaming([&](uint32_t device, const BBORecord& rec) {
+        char expect[9];
+        snprintf(expect, sizeof(expect), "MOCKDEV%u", device);
+        if (device >= 3 || rec.symbol != SymbolKey(expect)) {
+            mislabelled++;
+            return;
+        }
+        count[device]++;
+    }, pc) == PCIeError::SUCCESS, "unified stream started");
+    ok &= check(pool.start_streaming(nullptr, pc) == PCIeError::BUSY, "second start: BUSY");
+
+    sleep_ms(150);
+    ok &= check(count[0] > 0 && count[1] > 0 && count[2] > 0 && mislabelled == 0,
+                "every record tagged with its card");
+    DevicePoolStats stats = pool.get_stats();
+    ok &= check(stats.up == 3 && stats.devices[1].records > 0 && stats.devices[1].idle_ms < 100,
+                "all cards healthy");
+
+    // Link drop on card 1: it stops, the others do not
+    set_link(configs[1], false);
+    sleep_ms(50);
+    uint64_t c0 = count[0], c1 = count[1], c2 = count[2];
+    sleep_ms(100);
+    PoolDeviceHealth h1 = pool.get_health(1);
+    ok &= check(h1.state == PoolDeviceState::LINK_DOWN && h1.last_error == PCIeError::LINK_DOWN &&
+                h1.failures == 1, "link drop reported");
+    ok &= check(count[1] - c1 <= 2 * pc.ring_capacity, "downed card no longer read");
+    ok &= check(count[0] > c0 && count[2] > c2, "other cards keep flowing");
+
+    set_link(configs[1], true);
+    sleep_ms(100);
+    c1 = count[1];
+    sleep_ms(50);
+    ok &= check(pool.get_health(1).state == PoolDeviceState::UP && count[1] > c1, "card resumes on link up");
+
+    // Card 2 goes away entirely
+    mocks[2]->destroy();
+    sleep_ms(100);
+    c0 = count[0];
+    c1 = count[1];
+    sleep_ms(100);
+    PoolDeviceHealth h2 = pool.get_health(2);
+    ok &= check(h2.state == PoolDeviceState::FAILED && h2.last_error == PCIeError::READ_FAILED,
+                "ended card reported failed");
+    ok &= check(count[0] > c0 && count[1] > c1, "others unaffected");
+
+    BBOQuote q;
+    ok &= check(pool.get_latest(0, SymbolKey("MOCKDEV0"), q) &&
+                !pool.get_latest(0, SymbolKey("MOCKDEV1"), q) &&
+                pool.get_latest(2, SymbolKey("MOCKDEV2"), q),
+                "per-card latest BBO");
+
+    pool.stop_streaming();
+    stats = pool.get_stats();
+    ok &= check(stats.delivered == count[0] + count[1] + count[2], "stats count every delivery");
+    printf("  %lu / %lu / %lu records, %zu up\n",
+           count[0].load(), count[1].load(), count[2].load(), stats.up);
+    pool.close();
+    return ok;
+}
+
+// A card whose C2H is a regular file: every pass ends, and is reopened
+static bool test_reopen() {
+    bool ok = true;
+    MockDevice bar;   // For its BAR and H2C files only
+    if (!bar.create()) return check(false, "mock device created");
+
+    char dir[] = "/tmp/pool_test_XXXXXX";
+    if (!mkdtemp(dir)) return check(false, "temp dir");
+    XDMADeviceConfig config = bar.config();
+    config.c2h_path = std::string(dir) + "/c2h_0";
+    FILE* f = fopen(config.c2h_path.c_str(), "wb");
+    std::vector<BBOData> records = device_records(0, 10);
+    fwrite(records.data(), sizeof(BBOData), records.size(), f);
+    fclose(f);
+
+    XDMADevicePool pool;
+    ok &= check(pool.open({config}) == PCIeError::SUCCESS, "file-backed card opened");
+
+    std::atomic<uint64_t> count{0};
+    DevicePoolConfig pc;
+    pc.reopen_ms = 20;
+    pool.start_streaming([&](uint32_t, const BBORecord&) { count++; }, pc);
+    sleep_ms(200);
+    pool.stop_streaming();
+
+    PoolDeviceHealth h = pool.get_health(0);
+    printf("  %lu records, %lu failures, %lu reopens\n", count.load(), h.failures, h.reopens);
+    ok &= check(h.reopens >= 2 && h.failures >= h.reopens, "failed card reopened");
+    ok &= check(count == h.records && count % 10 == 0 && count >= 10 * (h.reopens + 1) - 10,
+                "full pass after each reopen");
+    pool.close();
+
+    unlink(config.c2h_path.c_str());
+    rmdir(dir);
+    return ok;
+}
+
+static bool test_open() {
+    bool ok = true;
+
+    MockDevice mock;
+    if (!mock.create()) return check(false, "mock device created");
+    XDMADeviceConfig missing = mock.config();
+    missing.c2h_path = "/nonexistent/c2h_0";
+
+    XDMADevicePool pool;
+    ok &= check(pool.open({mock.config(), missing}) == PCIeError::SUCCESS &&
+                pool.get_health(0).state == PoolDeviceState::UP &&
+                pool.get_health(1).state == PoolDeviceState::FAILED &&
+                pool.get_health(1).last_error == PCIeError::OPEN_FAILED,
+                "missing card kept as failed");
+    pool.close();
+    ok &= check(pool.size() == 0 && pool.start_streaming(nullptr) == PCIeError::DEVICE_NOT_FOUND,
+                "closed pool");
+
+    ok &= check(pool.open({missing}) == PCIeError::OPEN_FAILED, "no card opened: OPEN_FAILED");
+    pool.close();
+
+    // Discovery on this host: usually no cards at all
+    if (XDMADeviceDiscovery::enumerate_devices().empty()) {
+        ok &= check(pool.open() == PCIeError::DEVICE_NOT_FOUND, "no cards enumerated: DEVICE_NOT_FOUND");
+    }
+    return ok;
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("========================================\n");
+    printf("Device Pool Test\n");
+    printf("========================================\n");
+
+    printf("Unified stream over three cards:\n");
+    bool ok = test_unified_stream();
+
+    printf("\nReopen:\n");
+    ok &= test_reopen();
+
+    printf("\nOpen:\n");
+    ok &= test_open();
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,279 @@
+/**
+ * Fault Injection Soak Test
+ * Streams the generator's test pattern (T1-T4 = packet count, so every
+ * record carries its sequence number) through a FaultSource playing
+ * short reads, EINTR, EAGAIN, stalls and link-down outages, on each read
+ * path: read_bbo() streaming, read_records() streaming, multi-channel
+ * readers and read_bbos(). Checks that every record arrives exactly once
+ * and in order after recovery, that a link down for longer than
+ * read_error_limit_ms stops streaming, and reports the recovery time of
+ * each fault class. Needs no hardware.
+ *
+ * Usage: fault_injection_test [records]
+ */
+
+#include "xdma_wrapper.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace pcie;
+using bench::check;
+
+// Sequence numbers seen, in arrival order
+struct Sequence {
+    std::mutex mutex;
+    std::vector<uint32_t> seen;
+
+    void add(uint32_t seq) {
+        std::lock_guard<std::mutex> lock(mutex);
+        seen.push_back(seq);
+    }
+
+    // Exactly count records, each once and in order
+    bool complete(size_t count) const {
+        if (seen.size() != count) return false;
+        for (size_t i = 1; i < seen.size(); i++) {
+            if (seen[i] != seen[0] + i) return false;
+        }
+        return true;
+    }
+};
+
+static XDMADeviceConfig soak_config(uint64_t records, uint32_t seed) {
+    XDMADeviceConfig config;
+    config.transport = TransportKind::GENERATOR;
+    config.wire_format = WireFormat::BBO36;
+    config.generator.pattern = GeneratorPattern::TEST_PATTERN;
+    config.generator.records = records;
+    config.read_retry_max_ms = 10;
+
+    FaultConfig& f = config.faults;
+    f.short_read = 0.05;
+    f.interrupted = 0.02;
+    f.would_block = 0.02;
+    f.stall = 0.002;
+    f.link_down = 0.002;
+    f.stall_ms = 10;
+    f.link_down_ms = 20;
+    f.seed = seed;
+    // Every class at least once, early, whatever the draws
+    f.schedule = {{3, FaultKind::SHORT_READ, 0}, {5, FaultKind::INTERRUPTED, 0},
+                  {7, FaultKind::WOULD_BLOCK, 0}, {9, FaultKind::STALL, 0},
+                  {11, FaultKind::LINK_DOWN, 0}};
+    return config;
+}
+
+static void wait_for_end(XDMAWrapper& xdma, int max_ms) {
+    for (int i = 0; i < max_ms / 10 && xdma.is_streaming(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+static bool every_class_injected(const FaultStats& s) {
+    for (size_t k = 0; k < static_cast<size_t>(FaultKind::COUNT); k++) {
+        if (s.kinds[k].injected == 0) return false;
+    }
+    return true;
+}
+
+// read_bbo() stream thread: one record per read, short reads staged
+static bool test_record_stream(uint64_t records, FaultStats& total) {
+    bool ok = true;
+    XDMAWrapper xdma;
+    ok &= check(xdma.open(soak_config(records, 1)) == PCIeError::SUCCESS, "generator opened with faults");
+
+    Sequence seq;
+    ok &= check(xdma.start_streaming([&](const BBOData& bbo) {
+        seq.add(__builtin_bswap32(bbo.tx_timestamp));
+    }) == PCIeError::SUCCESS, "streaming started");
+    wait_for_end(xdma, 30000);
+    ok &= check(!xdma.is_streaming(), "streaming ends with the stream");
+    xdma.stop_streaming();
+
+    FaultStats s = xdma.get_fault_stats();
+    ok &= check(every_class_injected(s), "every fault class injected");
+    ok &= check(seq.complete(records), "no record lost or repeated");
+    ok &= check(xdma.get_stats().transfers_failed > 0, "link-down reads counted as failed");
+    total += s;
+    xdma.close();
+    return ok;
+}
+
+// read_records() stream thread: carried partial records across faults
+static bool test_bulk_stream(uint64_t records, FaultStats& total) {
+    bool ok = true;
+    XDMAWrapper xdma;
+    ok &= check(xdma.open(soak_config(records, 2)) == PCIeError::SUCCESS, "generator opened with faults");
+
+    Sequence seq;
+    ShardedDispatchConfig shards;
+    shards.workers = 2;
+    ok &= check(xdma.start_sharded_streaming([&](uint32_t, const BBORecord& r) {
+        seq.add(r.ts_t4);
+    }, shards) == PCIeError::SUCCESS, "sharded streaming started");
+    wait_for_end(xdma, 30000);
+    ok &= check(!xdma.is_streaming(), "streaming ends with the stream");
+    xdma.stop_streaming();
+
+    FaultStats s = xdma.get_fault_stats();
+    ok &= check(every_class_injected(s), "every fault class injected");
+    ok &= check(seq.complete(records), "no record lost or repeated");
+    total += s;
+    xdma.close();
+    return ok;
+}
+
+// Per-channel readers, each with its own FaultSource
+static bool test_multichannel(uint64_t records, FaultStats& total) {
+    bool ok = true;
+    XDMADeviceConfig config = soak_config(records, 3);
+    config.c2h_channels = {"gen-a", "gen-b"};
+    XDMAWrapper xdma;
+    ok &= check(xdma.open(config) == PCIeError::SUCCESS, "two faulty channels opened");
+
+    Sequence seq[2];
+    MultiChannelConfig mc;
+    mc.order = MergeOrder::PER_CHANNEL;
+    ok &= check(xdma.start_multichannel_streaming([&](uint32_t channel, const BBORecord& r) {
+        if (channel < 2) seq[channel].add(r.ts_t4);
+    }, mc) == PCIeError::SUCCESS, "multi-channel streaming started");
+    wait_for_end(xdma, 30000);
+    ok &= check(!xdma.is_streaming(), "streaming ends with the channels");
+    xdma.stop_streaming();
+
+    FaultStats s = xdma.get_fault_stats();
+    ok &= check(every_class_injected(s) && s.kinds[static_cast<size_t>(FaultKind::LINK_DOWN)].injected >= 2,
+                "faults injected on both channels");
+    ok &= check(seq[0].complete(records) && seq[1].complete(records), "no record lost or repeated per channel");
+
+    // Readers count their own failures; get_stats() sums them
+    MultiChannelStats mcs = xdma.get_multichannel_stats();
+    uint64_t failed = xdma.get_stats().transfers_failed;
+    ok &= check(mcs.channels.size() == 2 && mcs.channels[0].read_failures > 0 &&
+                    mcs.channels[1].read_failures > 0 &&
+                    failed == mcs.channels[0].read_failures + mcs.channels[1].read_failures,
+                "read failures per channel sum to the total");
+
+    // A new session replaces the channels but keeps their count
+    ok &= check(xdma.start_multichannel_streaming([](uint32_t, const BBORecord&) {}, mc) == PCIeError::SUCCESS,
+                "multi-channel streaming restarted");
+    wait_for_end(xdma, 30000);
+    xdma.stop_streaming();
+    mcs = xdma.get_multichannel_stats();
+    ok &= check(xdma.get_stats().transfers_failed ==
+                    failed + mcs.channels[0].read_failures + mcs.channels[1].read_failures,
+                "failures of replaced channels kept");
+    total += xdma.get_fault_stats();
+    xdma.close();
+    return ok;
+}
+
+// read_bbos() keeps waiting through early empty reads
+static bool test_read_bbos() {
+    bool ok = true;
+    XDMADeviceConfig config;
+    config.transport = TransportKind::GENERATOR;
+    config.generator.pattern = GeneratorPattern::TEST_PATTERN;
+    config.generator.records = 100;
+    config.faults.interrupted = 0.3;
+    config.faults.would_block = 0.2;
+    config.faults.short_read = 0.2;
+    XDMAWrapper xdma;
+    ok &= check(xdma.open(config) == PCIeError::SUCCESS, "generator opened with faults");
+
+    std::vector<BBOData> bbos;
+    Sequence seq;
+    bool full = true;
+    for (int i = 0; i < 2; i++) {
+        full &= xdma.read_bbos(bbos, 50, 1000) == 50;
+        for (const BBOData& bbo : bbos) seq.add(__builtin_bswap32(bbo.tx_timestamp));
+    }
+    ok &= check(full, "EINTR / EAGAIN do not end the wait");
+    ok &= check(seq.complete(100), "no record lost or repeated");
+    ok &= check(xdma.read_bbos(bbos, 50, 100) == -1, "end of stream still reported");
+    xdma.close();
+    return ok;
+}
+
+// A link that stays down past read_error_limit_ms stops streaming
+static bool test_give_up() {
+    bool ok = true;
+    XDMADeviceConfig config;
+    config.transport = TransportKind::GENERATOR;
+    config.generator.pattern = GeneratorPattern::TEST_PATTERN;
+    config.read_retry_max_ms = 10;
+    config.read_error_limit_ms = 100;
+    config.faults.schedule = {{20, FaultKind::LINK_DOWN, 5000}};
+    XDMAWrapper xdma;
+    ok &= check(xdma.open(config) == PCIeError::SUCCESS, "generator opened with a long outage");
+
+    std::atomic<uint64_t> delivered{0};
+    auto start = std::chrono::steady_clock::now();
+    ok &= check(xdma.start_streaming([&](const BBOData&) {
+        delivered.fetch_add(1, std::memory_order_relaxed);
+    }) == PCIeError::SUCCESS, "streaming started");
+    wait_for_end(xdma, 3000);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    ok &= check(!xdma.is_streaming() && ms < 3000, "streaming stops after the error limit");
+    xdma.stop_streaming();
+    ok &= check(delivered == 20, "records before the outage delivered");
+    xdma.close();
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t records = argc > 1 ? strtoull(argv[1], nullptr, 0) : 20000;
+    if (records < 1000) records = 1000;
+
+    printf("========================================\n");
+    printf("Fault Injection Soak Test\n");
+    printf("========================================\n");
+    printf("%lu records per stream\n", static_cast<unsigned long>(records));
+
+    FaultStats total;
+    printf("\nread_bbo() streaming:\n");
+    bool ok = test_record_stream(records, total);
+
+    printf("\nread_records() streaming (sharded):\n");
+    ok &= test_bulk_stream(records, total);
+
+    printf("\nMulti-channel:\n");
+    ok &= test_multichannel(records, total);
+
+    printf("\nread_bbos():\n");
+    ok &= test_read_bbos();
+
+    printf("\nError limit:\n");
+    ok &= test_give_up();
+
+    // Recovery: from the fault (or the end of an outage) to the next data
+    printf("\nRecovery time (%lu faulty reads):\n", static_cast<unsigned long>(total.reads));
+    printf("  %-12s %10s %10s %12s %12s\n", "fault", "injected", "recovered", "avg (us)", "max (us)");
+    for (size_t k = 0; k < static_cast<size_t>(FaultKind::COUNT); k++) {
+        const FaultClassStats& c = total.kinds[k];
+        printf("  %-12s %10lu %10lu %12.1f %12.1f\n", fault_kind_string(static_cast<FaultKind>(k)),
+               static_cast<unsigned long>(c.injected), static_cast<unsigned long>(c.recovered),
+               c.avg_recovery_us(), static_cast<double>(c.max_recovery_ns) / 1000.0);
+    }
+    bool recovered = true;
+    bool bounded = true;
+    for (const FaultClassStats& c : total.kinds) {
+        // Faults after a stream's last record never see data again (4 streams)
+        recovered &= c.injected > 0 && c.recovered + 4 >= c.injected;
+        // Back-off caps at read_retry_max_ms; leave room for a loaded machine
+        bounded &= c.max_recovery_ns < 250000000ULL;
+    }
+    ok &= check(recovered, "every fault class recovered");
+    ok &= check(bounded, "recovery within 250 ms");
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
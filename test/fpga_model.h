@@ -0,0 +1,408 @@
+/**
+ * Behavioural Model of the C2H Datapath
+ * Cycle-approximate C++ stand-in for bbo_cdc_fifo.vhd feeding
+ * bbo_axi_stream.vhd as pcie_bbo_top wires them, so host behaviour under
+ * FPGA backpressure can be exercised without a card. Shared by the tests
+ * that need it, like mock_device.h.
+ *
+ * What is modelled, in picoseconds on both clocks:
+ *   - Poisson bbo_update pulses on clk_trading (one per cycle at most)
+ *   - The CDC FIFO: 2^FIFO_DEPTH_LOG2 slots, pointers crossing through
+ *     2-FF synchronisers and registered wr_full/rd_empty, so the write side
+ *     sees reads three write cycles late and the read side sees writes
+ *     three read cycles late. Full and empty are the RTL's gray compares
+ *     (pointer difference == depth, == 0, modulo twice the depth): wr_full
+ *     misses a write on the previous cycle, so back-to-back updates overwrite
+ *     a full FIFO, after which the difference passes the depth, full never
+ *     matches again and the FIFO runs as an unprotected ring until reads
+ *     catch up.
+ *   - wr_en gated by wr_full as in pcie_bbo_top (refused updates are lost
+ *     silently, the overflow flag never rises), or ungated to exercise the
+ *     sticky overflow and STATUS_FIFO_FULL.
+ *   - The framer: FIFO read, latch, one cycle to raise TVALID, six beats,
+ *     back to IDLE and ready again - ten axi_aclk cycles per packet when
+ *     the host keeps up. TREADY is per packet: the whole 48 bytes go when
+ *     the host has room, else the framer holds in BEAT1.
+ *   - T1 update, T2 FIFO write, T3 FIFO read, T4 first beat, in axi_aclk
+ *     cycles.
+ *
+ * Packets carry the intended layout (BBOPacket, TLAST on beat six). The
+ * RTL differs in two places the model does not reproduce:
+ *   - bbo_axi_stream registers tdata in the state it belongs to, so the
+ *     beat accepted in each state is the previous one.
+ *   - The ready it drives to the FIFO drops a cycle after the latch, so the
+ *     FIFO sees a second read per packet.
+ *
+ * BBOPipelineModel is the simulation alone, advanced by the caller against
+ * any sink. FpgaModelDevice runs it in real time behind a ShmFeed: the C2H
+ * ring is the host's DMA buffer (its room is TREADY) and the register page
+ * is the BAR (CONTROL in; STATUS, BBO_COUNT and the timestamps out), so an
+ * XDMAWrapper opened with config() is the host under test.
+ */
+
+#pragma once
+
+#include "bbo_decode.h"
+#include "bbo_generator.h"
+#include "transport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace pcie {
+
+struct FpgaModelConfig {
+    uint32_t fifo_depth_log2 = 4;        // bbo_cdc_fifo FIFO_DEPTH_LOG2 (pcie_bbo_top: 4)
+    uint64_t trading_hz = 200000000;     // Write clock (clk_trading)
+    uint64_t axi_hz = 250000000;         // Read clock, AXI-Stream and T1-T4 (axi_aclk)
+    bool gate_write_on_full = true;      // pcie_bbo_top: wr_en includes not wr_full
+    uint64_t update_rate = 1000000;      // bbo_update pulses per second (Poisson), 0 = none
+    GeneratorConfig source;              // Symbols and prices of the updates
+    uint32_t seed = 1;                   // Arrival times
+};
+
+struct FpgaModelStats {
+    uint64_t offered = 0;        // bbo_update pulses
+    uint64_t written = 0;        // Accepted into the CDC FIFO
+    uint64_t dropped = 0;        // Refused on wr_full (lost silently when gated)
+    uint64_t overwrites = 0;     // Accepted into a full FIFO on a stale wr_full
+    uint64_t disabled = 0;       // Arrived with CTRL_ENABLE clear or CTRL_RESET set
+    uint64_t sent = 0;           // Packets completed on the stream
+    uint64_t stall_cycles = 0;   // axi_aclk cycles the framer waited for TREADY
+    uint32_t max_fill = 0;       // Deepest FIFO occupancy
+    bool overflow = false;       // Sticky overflow as the read domain sees it
+};
+
+class BBOPipelineModel {
+public:
+    static constexpr uint64_t NEVER = UINT64_MAX;
+    static constexpr uint64_t PACKET_CYCLES = 10;   // Read to next read with TREADY high
+
+    explicit BBOPipelineModel(const FpgaModelConfig& config)
+        : config_(config),
+          source_(config.source),
+          depth_(1u << config.fifo_depth_log2),
+          wr_ps_(1000000000000ULL / config.trading_hz),
+          rd_ps_(1000000000000ULL / config.axi_hz),
+          rng_((config.seed + 1) * 0x9E3779B97F4A7C15ULL),
+          mem_(depth_) {
+        mean_gap_ps_ = config.update_rate ? 1e12 / static_cast<double>(config.update_rate) : 0.0;
+        schedule_arrival();
+    }
+
+    /**
+     * Run both clock domains up to until_ps
+     * @param sink bool(const BBOPacket&, uint64_t t_ps): false holds TREADY
+     *             low; the framer retries on the next advance()
+     */
+    template <typename Sink>
+    void advance(uint64_t until_ps, Sink&& sink) {
+        if (blocked_) {
+            blocked_ = false;
+            send_edge_ = std::max(send_edge_, edge_after(now_ps_, rd_ps_));
+        }
+        for (;;) {
+            uint64_t rd = next_framer_edge();
+            uint64_t wr = next_arrival_;
+            if (std::min(rd, wr) > until_ps) break;
+            if (rd <= wr) {
+                framer(rd, sink);
+            } else {
+                arrival(wr);
+            }
+        }
+        now_ps_ = std::max(now_ps_, until_ps);
+    }
+
+    void set_enabled(bool enabled) { enabled_ = enabled; }
+
+    // CTRL_RESET is a level: held, the FIFO, framer, overflow and BBO count stay clear
+    void set_reset(bool reset) {
+        in_reset_ = reset;
+        if (!reset) return;
+        writes_ = reads_ = reads_seen_ = writes_visible_ = 0;
+        last_write_ = NEVER;
+        unseen_writes_.clear();
+        recent_reads_.clear();
+        sending_ = false;
+        blocked_ = false;
+        ready_edge_ = 0;
+        overflow_at_ = NEVER;
+        bbo_count_ = 0;
+    }
+
+    FpgaModelStats stats() const {
+        FpgaModelStats s = stats_;
+        s.overflow = overflow();
+        return s;
+    }
+
+    uint64_t now_ps() const { return now_ps_; }
+    // Pointer difference, as the RTL counts it (past depth once overwritten)
+    uint32_t fill() const { return static_cast<uint32_t>((writes_ - reads_) & (2 * depth_ - 1)); }
+    bool running() const { return enabled_ && fill() != 0; }
+    bool overflow() const { return now_ps_ >= overflow_at_; }
+    uint32_t bbo_count() const { return static_cast<uint32_t>(bbo_count_); }
+    uint32_t last_t1() const { return last_t1_; }
+    uint32_t last_t4() const { return last_t4_; }
+    uint32_t depth() const { return depth_; }
+    uint64_t cycles(uint64_t ps) const { return ps / rd_ps_; }
+
+private:
+    // First edge of a clock with period p strictly after t
+    static uint64_t edge_after(uint64_t t, uint64_t p) { return (t / p + 1) * p; }
+
+    double uniform() {
+        rng_ ^= rng_ >> 12;
+        rng_ ^= rng_ << 25;
+        rng_ ^= rng_ >> 27;
+        return static_cast<double>((rng_ * 0x2545F4914F6CDD1DULL) >> 11) * 0x1.0p-53;
+    }
+
+    void schedule_arrival() {
+        if (mean_gap_ps_ == 0.0) {
+            next_arrival_ = NEVER;
+            return;
+        }
+        arrival_ps_ += -std::log(1.0 - uniform()) * mean_gap_ps_;
+        uint64_t raw = static_cast<uint64_t>(arrival_ps_);
+        uint64_t edge = (raw + wr_ps_ - 1) / wr_ps_ * wr_ps_;
+        // bbo_update is a one-cycle pulse: a second update waits a cycle
+        if (next_arrival_ != NEVER && edge <= next_arrival_) edge = next_arrival_ + wr_ps_;
+        next_arrival_ = edge;
+        next_t1_ = static_cast<uint32_t>(raw / rd_ps_);
+    }
+
+    uint64_t next_framer_edge() const {
+        if (sending_) return blocked_ ? NEVER : send_edge_;
+        if (!read_empty()) return ready_edge_;
+        if (unseen_writes_.empty()) return NEVER;
+        // rd_empty clears three read edges after the write lands
+        return std::max(ready_edge_, edge_after(unseen_writes_.front() + 3 * rd_ps_, rd_ps_));
+    }
+
+    bool read_empty() const { return ((writes_visible_ - reads_) & (2 * depth_ - 1)) == 0; }
+
+    void arrival(uint64_t e) {
+        uint32_t t1 = next_t1_;
+        stats_.offered++;
+        schedule_arrival();
+        if (!enabled_ || in_reset_) {
+            stats_.disabled++;
+            return;
+        }
+
+        // wr_full used at this edge was registered last edge from the
+        // pointers then: writes before it, reads three write edges back
+        while (!recent_reads_.empty() && recent_reads_.front() + 3 * wr_ps_ < e) {
+            recent_reads_.pop_front();
+            reads_seen_++;
+        }
+        uint64_t writes_seen = writes_ - (last_write_ != NEVER && last_write_ + wr_ps_ == e ? 1 : 0);
+        bool full = ((writes_seen - reads_seen_) & (2 * depth_ - 1)) == depth_;
+        if (full) {
+            stats_.dropped++;
+            if (!config_.gate_write_on_full && overflow_at_ == NEVER) {
+                overflow_at_ = edge_after(e + rd_ps_, rd_ps_);   // overflow_sync2
+            }
+            return;
+        }
+
+        if (writes_ - reads_ >= depth_) stats_.overwrites++;   // Oldest unread slot
+        BBORecord& rec = mem_[writes_ % depth_];
+        source_.next(&rec, 1);
+        rec.ts_t1 = t1;
+        rec.ts_t2 = static_cast<uint32_t>(e / rd_ps_);
+        writes_++;
+        last_write_ = e;
+        unseen_writes_.push_back(e);
+        stats_.written++;
+        stats_.max_fill = std::max(stats_.max_fill, fill());
+    }
+
+    template <typename Sink>
+    void framer(uint64_t t, Sink& sink) {
+        if (!sending_) {
+            // rd_empty used at this edge: writes three read edges back
+            while (!unseen_writes_.empty() && unseen_writes_.front() + 3 * rd_ps_ < t) {
+                unseen_writes_.pop_front();
+                writes_visible_++;
+            }
+            if (read_empty()) return;
+
+            // FIFO read; latch next edge, TVALID the one after, first beat then
+            packet_ = mem_[reads_ % depth_];
+            packet_.ts_t3 = static_cast<uint32_t>(t / rd_ps_);
+            reads_++;
+            recent_reads_.push_back(t);
+            sending_ = true;
+            send_edge_ = first_try_ = t + 3 * rd_ps_;
+            return;
+        }
+
+        packet_.ts_t4 = static_cast<uint32_t>(t / rd_ps_);
+        BBOPacket wire;
+        encode_bbo_batch(&packet_, 1, &wire, WireFormat::BBO48);
+        if (!sink(static_cast<const BBOPacket&>(wire), t)) {
+            blocked_ = true;
+            return;
+        }
+        stats_.sent++;
+        stats_.stall_cycles += (t - first_try_) / rd_ps_;
+        bbo_count_++;
+        last_t1_ = packet_.ts_t1;
+        last_t4_ = packet_.ts_t4;
+        sending_ = false;
+        ready_edge_ = t + 7 * rd_ps_;   // Last beat at t + 5, IDLE raises ready, read
+    }
+
+    FpgaModelConfig config_;
+    BBOGenerator source_;
+    uint32_t depth_;
+    uint64_t wr_ps_;
+    uint64_t rd_ps_;
+    uint64_t rng_;
+    double mean_gap_ps_ = 0.0;
+    double arrival_ps_ = 0.0;
+    uint64_t next_arrival_ = NEVER;
+    uint32_t next_t1_ = 0;
+    uint64_t now_ps_ = 0;
+    bool enabled_ = true;            // control_registers resets with enable set
+    bool in_reset_ = false;
+
+    // CDC FIFO: pointers count every write and read since reset
+    std::vector<BBORecord> mem_;
+    uint64_t writes_ = 0;
+    uint64_t reads_ = 0;
+    uint64_t reads_seen_ = 0;              // Reads the write side has synchronised
+    uint64_t writes_visible_ = 0;          // Writes the read side has synchronised
+    uint64_t last_write_ = NEVER;
+    std::deque<uint64_t> unseen_writes_;   // Writes not yet seen by the read side
+    std::deque<uint64_t> recent_reads_;    // Reads not yet seen by the write side
+    uint64_t overflow_at_ = NEVER;
+
+    // Framer
+    bool sending_ = false;
+    bool blocked_ = false;
+    BBORecord packet_{};
+    uint64_t send_edge_ = 0;
+    uint64_t first_try_ = 0;
+    uint64_t ready_edge_ = 0;
+    uint64_t bbo_count_ = 0;
+    uint32_t last_t1_ = 0;
+    uint32_t last_t4_ = 0;
+
+    FpgaModelStats stats_;
+};
+
+/**
+ * The model as a device: real time, ShmFeed C2H ring and register page
+ */
+class FpgaModelDevice {
+public:
+    static constexpr uint32_t VERSION = 0x21000001;
+    static constexpr auto POLL = std::chrono::microseconds(50);
+
+    explicit FpgaModelDevice(const FpgaModelConfig& config) : model_(config) {}
+    ~FpgaModelDevice() { destroy(); }
+
+    FpgaModelDevice(const FpgaModelDevice&) = delete;
+    FpgaModelDevice& operator=(const FpgaModelDevice&) = delete;
+
+    /**
+     * Create the segment and start the clock
+     * @param ring_bytes Host DMA buffer: its room is TREADY
+     */
+    bool create(size_t ring_bytes = 64 << 10) {
+        static std::atomic<uint32_t> instance{0};
+        name_ = "/fpga_model_" + std::to_string(getpid()) + "_" + std::to_string(instance++);
+        if (feed_.create(name_, ring_bytes) != PCIeError::SUCCESS) return false;
+
+        volatile uint32_t* regs = feed_.registers();
+        regs[ControlRegisters::VERSION_OFFSET / 4] = VERSION;
+        regs[ControlRegisters::CONTROL_OFFSET / 4] = ControlRegisters::CTRL_ENABLE;
+        publish();
+        stop_ = false;
+        thread_ = std::thread([this]() { run(); });
+        return true;
+    }
+
+    void destroy() {
+        stop_ = true;
+        if (thread_.joinable()) thread_.join();
+        feed_.destroy();
+    }
+
+    // Host configuration for this device (SHM transport, BBO48)
+    XDMADeviceConfig config() const {
+        XDMADeviceConfig config;
+        config.transport = TransportKind::SHM;
+        config.shm_name = name_;
+        config.wire_format = WireFormat::BBO48;
+        config.require_driver = false;
+        return config;
+    }
+
+    FpgaModelStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return model_.stats();
+    }
+
+    uint32_t fill() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return model_.fill();
+    }
+
+private:
+    // CONTROL is sampled each poll, so a CTRL_RESET pulse shorter than
+    // POLL can go unseen
+    void run() {
+        auto start = std::chrono::steady_clock::now();
+        volatile uint32_t* regs = feed_.registers();
+        while (!stop_) {
+            uint32_t ctrl = regs[ControlRegisters::CONTROL_OFFSET / 4];
+            uint64_t now_ps = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count()) * 1000;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                model_.set_reset((ctrl & ControlRegisters::CTRL_RESET) != 0);
+                model_.set_enabled((ctrl & ControlRegisters::CTRL_ENABLE) != 0);
+                model_.advance(now_ps, [this](const BBOPacket& p, uint64_t) {
+                    return feed_.write(&p, sizeof(p), 0);
+                });
+                publish();
+            }
+            std::this_thread::sleep_for(POLL);
+        }
+    }
+
+    void publish() {
+        volatile uint32_t* regs = feed_.registers();
+        uint32_t status = ControlRegisters::STATUS_LINK_UP;
+        if (model_.running()) status |= ControlRegisters::STATUS_RUNNING;
+        if (model_.overflow()) status |= ControlRegisters::STATUS_FIFO_FULL;
+        regs[ControlRegisters::STATUS_OFFSET / 4] = status;
+        regs[ControlRegisters::BBO_COUNT_OFFSET / 4] = model_.bbo_count();
+        regs[ControlRegisters::RX_TIMESTAMP_OFFSET / 4] = model_.last_t1();
+        regs[ControlRegisters::TX_TIMESTAMP_OFFSET / 4] = model_.last_t4();
+        // 4 ns cycles in hundredths of a microsecond
+        regs[ControlRegisters::LATENCY_US_OFFSET / 4] = (model_.last_t4() - model_.last_t1()) * 4 / 10;
+    }
+
+    BBOPipelineModel model_;
+    ShmFeed feed_;
+    std::string name_;
+    mutable std::mutex mutex_;
+    std::thread thread_;
+    std::atomic<bool> stop_{true};
+};
+
+}  // namespace pcie
@@ -0,0 +1,371 @@
+/**
+ * FPGA Datapath Model Test
+ * Exercises the behavioural model of bbo_cdc_fifo and bbo_axi_stream
+ * (fpga_model.h) in simulated time - pipeline latency, framer throughput,
+ * where drops start against host consumption and offered rate, overflow
+ * with and without the pcie_bbo_top gating - then runs it in real time
+ * behind the shared-memory transport and checks what XDMAWrapper sees:
+ * every packet when it keeps up, one fifo_overflows when the host stalls
+ * an ungated FIFO, whether it reads directly or through the
+ * multi-channel dispatch thread, and none for the gated FIFO, which
+ * drops silently.
+ * Needs no hardware.
+ */
+
+#include "fpga_model.h"
+#include "xdma_wrapper.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <signal.h>
+
+using namespace pcie;
+using bench::check;
+
+static constexpr uint64_t PS_PER_US = 1000000;
+
+/**
+ * Host at a fixed drain rate behind a buffer of `capacity` packets; TREADY
+ * is low while the buffer is full
+ */
+struct HostModel {
+    double rate;          // Packets per second, 0 = unbounded
+    double capacity;
+    double level = 0.0;
+    uint64_t last_ps = 0;
+    uint64_t received = 0;
+
+    bool operator()(const BBOPacket&, uint64_t t_ps) {
+        if (rate > 0.0) {
+            level = std::max(0.0, level - static_cast<double>(t_ps - last_ps) * 1e-12 * rate);
+            last_ps = t_ps;
+            if (level + 1.0 > capacity) return false;
+            level += 1.0;
+        }
+        received++;
+        return true;
+    }
+};
+
+// Advance in host-poll-sized steps so a blocked framer retries as it would
+static FpgaModelStats run(BBOPipelineModel& model, HostModel& host, uint64_t duration_ps,
+                          uint64_t step_ps = 10 * PS_PER_US) {
+    for (uint64_t t = step_ps; t <= duration_ps; t += step_ps) model.advance(t, host);
+    return model.stats();
+}
+
+static double drop_share(const FpgaModelStats& s) {
+    return s.offered ? static_cast<double>(s.dropped) / static_cast<double>(s.offered) : 0.0;
+}
+
+// Refused or overwritten before the framer read them
+static double loss_share(const FpgaModelStats& s) {
+    return s.offered ? static_cast<double>(s.dropped + s.overwrites) / static_cast<double>(s.offered) : 0.0;
+}
+
+static bool test_latency() {
+    bool ok = true;
+    FpgaModelConfig config;
+    config.update_rate = 100000;   // Far apart: every packet sees an empty pipeline
+    BBOPipelineModel model(config);
+
+    std::vector<BBORecord> seen;
+    model.advance(10000 * PS_PER_US, [&](const BBOPacket& p, uint64_t) {
+        BBORecord r;
+        decode_bbo_batch(&p, 1, &r, WireFormat::BBO48);
+        seen.push_back(r);
+        return true;
+    });
+
+    bool ordered = !seen.empty();
+    uint32_t min_t2_t4 = UINT32_MAX, max_t2_t4 = 0;
+    for (const BBORecord& r : seen) {
+        ordered &= r.ts_t1 <= r.ts_t2 && r.ts_t2 < r.ts_t3 && r.ts_t3 < r.ts_t4;
+        min_t2_t4 = std::min(min_t2_t4, r.ts_t4 - r.ts_t2);
+        max_t2_t4 = std::max(max_t2_t4, r.ts_t4 - r.ts_t2);
+    }
+    printf("    %zu packets, FIFO write to first beat %u-%u cycles\n", seen.size(), min_t2_t4, max_t2_t4);
+    ok &= check(seen.size() == model.stats().sent && seen.size() > 900, "every update reached the stream");
+    ok &= check(ordered, "T1 <= T2 < T3 < T4 on every packet");
+    // 2-FF sync and registered empty, read, latch, TVALID
+    ok &= check(min_t2_t4 == 7, "idle pipeline: T2 -> T4 in 7 cycles");
+    ok &= check(model.stats().dropped == 0 && model.stats().overwrites == 0, "nothing lost");
+    return ok;
+}
+
+static bool test_throughput() {
+    bool ok = true;
+    FpgaModelConfig config;
+    config.update_rate = 100000000;   // Four times what the framer can take
+    BBOPipelineModel model(config);
+    HostModel host{0.0, 0.0};
+    FpgaModelStats s = run(model, host, 1000 * PS_PER_US);
+
+    double rate = static_cast<double>(s.sent) / 1e-3;
+    double limit = static_cast<double>(config.axi_hz) / BBOPipelineModel::PACKET_CYCLES;
+    printf("    %.2fM packets/s sent, limit %.2fM, %.0f%% refused, %.0f%% overwritten\n",
+           rate / 1e6, limit / 1e6, 100.0 * drop_share(s),
+           100.0 * static_cast<double>(s.overwrites) / static_cast<double>(s.offered));
+    ok &= check(rate > 0.95 * limit && rate <= limit, "saturated framer: one packet per 10 cycles");
+    ok &= check(s.stall_cycles == 0, "fast host never stalls the framer");
+    ok &= check(loss_share(s) > 0.6, "excess updates lost at the FIFO");
+    ok &= check(s.max_fill >= model.depth(), "FIFO ran full");
+    ok &= check(!s.overflow, "gated: overflow flag never raised");
+    return ok;
+}
+
+static bool test_host_rate() {
+    bool ok = true;
+    FpgaModelConfig config;
+    config.update_rate = 1000000;
+
+    {
+        BBOPipelineModel model(config);
+        HostModel host{2000000.0, 1024.0};
+        FpgaModelStats s = run(model, host, 100000 * PS_PER_US);
+        ok &= check(s.dropped == 0 && host.received == s.sent && s.sent + model.fill() == s.written,
+                    "host at 2x the update rate: nothing lost");
+    }
+
+    {
+        BBOPipelineModel model(config);
+        HostModel host{500000.0, 1024.0};
+        FpgaModelStats s = run(model, host, 100000 * PS_PER_US);
+        printf("    host at half the update rate: %.1f%% dropped, %lu stall cycles\n",
+               100.0 * drop_share(s), s.stall_cycles);
+        ok &= check(drop_share(s) > 0.4 && drop_share(s) < 0.55, "host at half the rate: about half dropped");
+        ok &= check(s.stall_cycles > 0 && !s.overflow, "framer stalled, gated FIFO silent");
+    }
+
+    // Where drops start: host consumption as a share of the update rate
+    printf("    host / update rate   dropped\n");
+    bool monotonic = true;
+    double last = 1.0;
+    for (double share : {0.5, 0.8, 0.9, 0.95, 1.0, 1.05, 1.2}) {
+        BBOPipelineModel model(config);
+        HostModel host{share * static_cast<double>(config.update_rate), 256.0};
+        FpgaModelStats s = run(model, host, 50000 * PS_PER_US);
+        printf("    %17.2f   %6.2f%%\n", share, 100.0 * drop_share(s));
+        monotonic &= drop_share(s) <= last;
+        last = drop_share(s);
+    }
+    ok &= check(monotonic, "drops fall as the host speeds up");
+    return ok;
+}
+
+static bool test_offered_rate() {
+    bool ok = true;
+    printf("    offered    refused   overwritten\n");
+    double at_5m = 1.0, at_40m = 0.0;
+    uint64_t overwrites_5m = 1;
+    for (uint64_t rate : {5000000ULL, 10000000ULL, 20000000ULL, 25000000ULL, 40000000ULL, 200000000ULL}) {
+        FpgaModelConfig config;
+        config.update_rate = rate;
+        BBOPipelineModel model(config);
+        HostModel host{0.0, 0.0};
+        FpgaModelStats s = run(model, host, 2000 * PS_PER_US);
+        printf("    %5luM/s   %6.2f%%   %6.2f%%\n", rate / 1000000, 100.0 * drop_share(s),
+               100.0 * static_cast<double>(s.overwrites) / static_cast<double>(s.offered));
+        if (rate == 5000000) {
+            at_5m = drop_share(s);
+            overwrites_5m = s.overwrites;
+        }
+        if (rate == 40000000) at_40m = loss_share(s);
+        if (rate == 200000000) {
+            // A write on the cycle after the one that filled it sees the old wr_full
+            ok &= check(s.overwrites > 0, "back-to-back updates overwrite a full FIFO");
+        }
+    }
+    ok &= check(at_5m == 0.0 && overwrites_5m == 0, "5M/s: fast host, no drops");
+    ok &= check(at_40m > 0.3, "40M/s: beyond the framer, updates lost");
+    return ok;
+}
+
+static bool test_overflow_flag() {
+    bool ok = true;
+    FpgaModelConfig config;
+    config.update_rate = 1000000;
+    HostModel stalled{1.0, 0.0};   // Never room
+
+    BBOPipelineModel gated(config);
+    FpgaModelStats g = run(gated, stalled, 1000 * PS_PER_US);
+    ok &= check(g.dropped > 0 && !g.overflow, "gated, host stalled: drops, no overflow");
+
+    config.gate_write_on_full = false;
+    BBOPipelineModel ungated(config);
+    FpgaModelStats u = run(ungated, stalled, 1000 * PS_PER_US);
+    ok &= check(u.dropped > 0 && u.overflow, "ungated, host stalled: overflow raised");
+    ok &= check(u.sent == 0 && u.max_fill >= ungated.depth(), "FIFO held until full, nothing sent");
+
+    ungated.set_reset(true);
+    ok &= check(!ungated.overflow() && ungated.fill() == 0 && ungated.bbo_count() == 0,
+                "CTRL_RESET clears FIFO, overflow and count");
+    ungated.set_reset(false);
+    return ok;
+}
+
+// Read until the stream has been quiet for quiet_ms
+static size_t drain(XDMAWrapper& xdma, std::vector<BBORecord>& out, uint32_t quiet_ms) {
+    BBORecord buf[256];
+    size_t total = 0;
+    for (;;) {
+        int n = xdma.read_records(buf, 256, quiet_ms);
+        if (n <= 0) return total;
+        out.insert(out.end(), buf, buf + n);
+        total += static_cast<size_t>(n);
+    }
+}
+
+static bool test_device_keeps_up() {
+    bool ok = true;
+    FpgaModelConfig config;
+    config.update_rate = 200000;
+    config.source.symbols = 64;
+    FpgaModelDevice device(config);
+    if (!device.create()) return check(false, "model device created");
+
+    XDMAWrapper xdma;
+    ok &= check(xdma.open(device.config()) == PCIeError::SUCCESS, "host opened the model device");
+    ok &= check(xdma.get_version() == FpgaModelDevice::VERSION, "VERSION from the model");
+
+    std::vector<BBORecord> records;
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    BBORecord buf[256];
+    while (std::chrono::steady_clock::now() < until) {
+        int n = xdma.read_records(buf, 256, 10);
+        if (n > 0) records.insert(records.end(), buf, buf + n);
+    }
+    xdma.write_register(ControlRegisters::CONTROL_OFFSET, 0);   // Stop updates, let it drain
+    drain(xdma, records, 50);
+
+    FpgaModelStats s = device.stats();
+    bool ordered = true;
+    for (size_t i = 0; i < records.size(); i++) {
+        const BBORecord& r = records[i];
+        ordered &= r.ts_t1 <= r.ts_t2 && r.ts_t2 < r.ts_t3 && r.ts_t3 < r.ts_t4;
+        if (i > 0) ordered &= r.ts_t4 > records[i - 1].ts_t4;
+    }
+    printf("    %zu records in 200 ms, %lu updates offered\n", records.size(), s.offered);
+    ok &= check(records.size() > 10000 && s.dropped == 0, "fast host: no drops");
+    ok &= check(records.size() == s.sent && xdma.get_bbo_count() == s.sent,
+                "records == packets sent == BBO_COUNT");
+    ok &= check(ordered, "timestamps ordered within and across packets");
+    ok &= check(xdma.get_stats().fifo_overflows == 0, "no overflow reported");
+    xdma.close();
+    return ok;
+}
+
+static bool test_device_stalled(bool gated) {
+    bool ok = true;
+    FpgaModelConfig config;
+    config.update_rate = 1000000;
+    config.gate_write_on_full = gated;
+    FpgaModelDevice device(config);
+    if (!device.create(4096)) return check(false, "model device created");
+
+    XDMADeviceConfig host = device.config();
+    host.status_poll_ms = 10;
+    XDMAWrapper xdma;
+    ok &= check(xdma.open(host) == PCIeError::SUCCESS, "host opened the model device");
+
+    // Host away: the ring fills, then the framer stalls, then the FIFO
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    std::vector<BBORecord> records;
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+    BBORecord buf[256];
+    while (std::chrono::steady_clock::now() < until) {
+        int n = xdma.read_records(buf, 256, 5);
+        if (n > 0) records.insert(records.end(), buf, buf + n);
+    }
+    FpgaModelStats s = device.stats();
+    uint64_t overflows = xdma.get_stats().fifo_overflows;
+
+    if (gated) {
+        ok &= check(s.dropped > 0 && !s.overflow, "gated: updates dropped, flag never set");
+        // pcie_bbo_top gates wr_en on wr_full, so this loss is invisible to the host
+        ok &= check(overflows == 0, "gated: host cannot see the loss");
+    } else {
+        ok &= check(s.dropped > 0 && s.overflow, "ungated: updates dropped, flag set");
+        ok &= check(overflows == 1, "ungated: host counted one overflow");
+
+        // Held well past the model's poll period; a pulse shorter than it can be missed
+        xdma.write_register(ControlRegisters::CONTROL_OFFSET,
+                            ControlRegisters::CTRL_ENABLE | ControlRegisters::CTRL_RESET);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        ok &= check(!(xdma.get_status() & ControlRegisters::STATUS_FIFO_FULL) && xdma.get_bbo_count() == 0,
+                    "CTRL_RESET clears STATUS_FIFO_FULL, BBO_COUNT");
+        xdma.write_register(ControlRegisters::CONTROL_OFFSET, ControlRegisters::CTRL_ENABLE);
+    }
+    xdma.close();
+    return ok;
+}
+
+// Reader threads never touch the BAR; the dispatch thread samples the flag
+static bool test_device_stalled_multichannel() {
+    bool ok = true;
+    FpgaModelConfig config;
+    config.update_rate = 1000000;
+    config.gate_write_on_full = false;
+    FpgaModelDevice device(config);
+    if (!device.create(4096)) return check(false, "model device created");
+
+    XDMADeviceConfig host = device.config();
+    host.status_poll_ms = 10;
+    XDMAWrapper xdma;
+    ok &= check(xdma.open(host) == PCIeError::SUCCESS, "host opened the model device");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    std::atomic<uint64_t> delivered{0};
+    ok &= check(xdma.start_multichannel_streaming([&](uint32_t, const BBORecord&) {
+        delivered.fetch_add(1, std::memory_order_relaxed);
+    }) == PCIeError::SUCCESS, "multi-channel streaming started");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    xdma.stop_streaming();
+
+    ok &= check(device.stats().overflow && delivered > 0, "updates dropped, records delivered");
+    ok &= check(xdma.get_stats().fifo_overflows == 1, "multi-channel: host counted one overflow");
+    xdma.close();
+    return ok;
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("========================================\n");
+    printf("FPGA Datapath Model Test\n");
+    printf("========================================\n");
+
+    printf("Pipeline latency:\n");
+    bool ok = test_latency();
+
+    printf("\nFramer throughput:\n");
+    ok &= test_throughput();
+
+    printf("\nHost consumption:\n");
+    ok &= test_host_rate();
+
+    printf("\nOffered rate (fast host):\n");
+    ok &= test_offered_rate();
+
+    printf("\nOverflow flag:\n");
+    ok &= test_overflow_flag();
+
+    printf("\nModel device, host keeping up:\n");
+    ok &= test_device_keeps_up();
+
+    printf("\nModel device, host stalled (gated FIFO):\n");
+    ok &= test_device_stalled(true);
+
+    printf("\nModel device, host stalled (ungated FIFO):\n");
+    ok &= test_device_stalled(false);
+
+    printf("\nModel device, host stalled (multi-channel):\n");
+    ok &= test_device_stalled_multichannel();
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,583 @@
+/**
+ * Host-Path Latency Regression Check
+ * Replays one fixed C2H stream through the FILE transport and times each
+ * host stage per batch of records:
+ *
+ *   read        Transport read of the batch's wire bytes
+ *   decode      decode_bbo_batch
+ *   cache       BBOCache update
+ *   dedup       DedupFilter (FIELDS, top of book)
+ *   analytics   QuoteAnalytics
+ *   dispatch    ChannelCallback invocation
+ *   end_to_end  All of the above
+ *
+ * Each stage reports ns/record at p50, p99, p99.9 and max over every
+ * measured batch, with a 95% confidence interval per percentile from a
+ * hierarchical bootstrap: repetitions are resampled, then blocks of
+ * consecutive batches within each, so both run-to-run variation and
+ * bursts of host noise widen the interval instead of averaging away.
+ *
+ * Against a baseline (-b) a percentile regresses when the lower end of
+ * its interval now is above the upper end of the baseline's interval by
+ * more than the threshold: the slowdown holds under the most charitable
+ * reading of both runs. A percentile that regresses is measured again
+ * (-R runs of the whole stream) and only one that regresses in every
+ * re-run fails the check, so a burst of host noise during one run is not
+ * a regression. Gated are p50/p99/p99.9; max is a single batch and is
+ * only reported. -u writes the baseline instead.
+ *
+ * The stream is generated from a fixed seed, or replayed from a capture
+ * (-i), so a baseline only compares with runs of the same stream, batch
+ * and format. Needs no hardware.
+ *
+ * Usage: ./latency_regress [options]
+ *   -b <path>   Baseline to compare against
+ *   -u          Write the results to the baseline path instead
+ *   -t <frac>   Regression threshold (default: 0.25 = 25% slower)
+ *   -i <path>   Replay a recorded C2H capture (default: generated stream)
+ *   -f <36|48>  Wire format of the stream (default: 36)
+ *   -n <count>  Records per repetition (default: 200000)
+ *   -r <count>  Measured repetitions (default: 10)
+ *   -R <count>  Re-runs confirming a regression (default: 2)
+ *   -c <cpu>    CPU to run on, -1 = don't pin (default: first CPU allowed)
+ *   -h          Show this help
+ */
+
+#include "transport.h"
+#include "bbo_cache.h"
+#include "bbo_decode.h"
+#include "bbo_generator.h"
+#include "dedup_filter.h"
+#include "numa_placement.h"
+#include "quote_analytics.h"
+#include "xdma_wrapper.h"
+#include "bench_util.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include <sched.h>
+#include <unistd.h>
+
+using namespace pcie;
+
+static constexpr size_t BATCH = 64;              // Records per timed sample
+static constexpr size_t BOOTSTRAP_ROUNDS = 400;
+static constexpr size_t BOOTSTRAP_BLOCK = 256;   // Consecutive batches per resampled block
+static constexpr uint32_t SYMBOLS = 1000;
+
+enum Stage { READ, DECODE, CACHE, DEDUP, ANALYTICS, DISPATCH, END_TO_END, NUM_STAGES };
+
+static const char* const STAGE_NAMES[NUM_STAGES] = {
+    "read", "decode", "cache", "dedup", "analytics", "dispatch", "end_to_end"
+};
+
+// Percentiles reported per stage; the last (max) never gates
+static constexpr int NUM_PCTS = 4;
+static const char* const PCT_NAMES[NUM_PCTS] = {"p50", "p99", "p99.9", "max"};
+static const double PCT_VALUES[NUM_PCTS] = {50.0, 99.0, 99.9, 100.0};
+
+struct Options {
+    std::string baseline;
+    bool update = false;
+    double threshold = 0.25;
+    std::string input;
+    WireFormat format = WireFormat::BBO36;
+    size_t records = 200000;
+    int repetitions = 10;
+    int confirm_runs = 2;
+    int cpu = -2;   // -2 = first allowed
+};
+
+/**
+ * One percentile with its bootstrap interval (ns/record)
+ */
+struct Estimate {
+    double value = 0.0;
+    double lo = 0.0;
+    double hi = 0.0;
+};
+
+using StageEstimates = std::vector<Estimate>;   // NUM_PCTS entries
+
+struct Baseline {
+    size_t batch = 0;
+    int format = 0;
+    std::string cpu;
+    std::map<std::string, StageEstimates> stages;
+};
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    if (p >= 100.0) return sorted.back();
+    size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size()));
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+/**
+ * Percentiles of a stage with hierarchical bootstrap intervals
+ * Each round resamples the repetitions, then blocks of consecutive batches
+ * within each, so the interval carries both run-to-run variation and
+ * bursts of host noise inside a run. Seeded, so the same samples always
+ * give the same intervals.
+ * @param reps Per repetition, ns/record of each batch in batch order
+ */
+static StageEstimates estimate(const std::vector<std::vector<double>>& reps) {
+    StageEstimates out(NUM_PCTS);
+    std::vector<double> sorted;
+    for (const auto& rep : reps) sorted.insert(sorted.end(), rep.begin(), rep.end());
+    if (sorted.empty()) return out;
+
+    std::sort(sorted.begin(), sorted.end());
+    for (int p = 0; p < NUM_PCTS; p++) {
+        out[p].value = out[p].lo = out[p].hi = percentile(sorted, PCT_VALUES[p]);
+    }
+
+    uint64_t rng = 0x9E3779B97F4A7C15ULL;
+    auto random = [&rng]() {
+        rng ^= rng >> 12;
+        rng ^= rng << 25;
+        rng ^= rng >> 27;
+        return rng * 0x2545F4914F6CDD1DULL;
+    };
+
+    std::vector<std::vector<double>> rounds(NUM_PCTS, std::vector<double>(BOOTSTRAP_ROUNDS));
+    std::vector<double> resample;
+    resample.reserve(sorted.size());
+    for (size_t round = 0; round < BOOTSTRAP_ROUNDS; round++) {
+        resample.clear();
+        for (size_t r = 0; r < reps.size(); r++) {
+            const std::vector<double>& rep = reps[random() % reps.size()];
+            if (rep.empty()) continue;
+            size_t block = std::min(BOOTSTRAP_BLOCK, rep.size());
+            size_t starts = rep.size() - block + 1;
+            for (size_t filled = 0; filled < rep.size();) {
+                size_t start = static_cast<size_t>(random() % starts);
+                size_t take = std::min(block, rep.size() - filled);
+                resample.insert(resample.end(), rep.begin() + start, rep.begin() + start + take);
+                filled += take;
+            }
+        }
+        std::sort(resample.begin(), resample.end());
+        for (int p = 0; p < NUM_PCTS; p++) rounds[p][round] = percentile(resample, PCT_VALUES[p]);
+    }
+
+    // Max has no useful interval: a resample can only lose the largest batch
+    for (int p = 0; p + 1 < NUM_PCTS; p++) {
+        std::sort(rounds[p].begin(), rounds[p].end());
+        out[p].lo = percentile(rounds[p], 2.5);
+        out[p].hi = percentile(rounds[p], 97.5);
+    }
+    return out;
+}
+
+static std::string cpu_model() {
+    std::ifstream in("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) return line.substr(line.find_first_not_of(' ', colon + 1));
+        }
+    }
+    return "unknown";
+}
+
+static int first_allowed_cpu() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return -1;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set)) return cpu;
+    }
+    return -1;
+}
+
+/**
+ * Baseline file: '#' comments, then "batch <n>", "format <36|48>",
+ * "cpu <model>" and one "<stage> <pct> <value> <lo> <hi>" line per
+ * percentile
+ */
+static bool load_baseline(const std::string& path, Baseline& out) {
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "Cannot read baseline %s\n", path.c_str());
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        char stage[32];
+        char pct[16];
+        double value, lo, hi;
+        if (line.compare(0, 4, "cpu ") == 0) {
+            out.cpu = line.substr(4);
+        } else if (sscanf(line.c_str(), "batch %zu", &out.batch) == 1 ||
+                   sscanf(line.c_str(), "format %d", &out.format) == 1) {
+            continue;
+        } else if (sscanf(line.c_str(), "%31s %15s %lf %lf %lf", stage, pct, &value, &lo, &hi) == 5) {
+            StageEstimates& e = out.stages[stage];
+            e.resize(NUM_PCTS);
+            for (int p = 0; p < NUM_PCTS; p++) {
+                if (strcmp(pct, PCT_NAMES[p]) == 0) e[p] = {value, lo, hi};
+            }
+        } else {
+            fprintf(stderr, "Baseline %s: cannot parse \"%s\"\n", path.c_str(), line.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool write_baseline(const std::string& path, const Options& opt,
+                           const std::vector<StageEstimates>& results) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        perror(path.c_str());
+        return false;
+    }
+    time_t now = time(nullptr);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%d", gmtime(&now));
+    fprintf(f, "# Host-path latency baseline, written by latency_regress -u on %s\n", date);
+    fprintf(f, "# %zu records x %d repetitions of the %s stream, ns/record per batch\n",
+            opt.records, opt.repetitions, opt.input.empty() ? "generated" : opt.input.c_str());
+    fprintf(f, "# <stage> <percentile> <value> <ci_lo> <ci_hi>\n");
+    fprintf(f, "batch %zu\n", BATCH);
+    fprintf(f, "format %zu\n", wire_record_size(opt.format));
+    fprintf(f, "cpu %s\n", cpu_model().c_str());
+    for (int s = 0; s < NUM_STAGES; s++) {
+        for (int p = 0; p < NUM_PCTS; p++) {
+            const Estimate& e = results[s][p];
+            fprintf(f, "%-12s %-6s %10.3f %10.3f %10.3f\n",
+                    STAGE_NAMES[s], PCT_NAMES[p], e.value, e.lo, e.hi);
+        }
+    }
+    return fclose(f) == 0;
+}
+
+// Fixed stream for a run: the same seed and universe every time
+static bool write_generated_stream(const std::string& path, const Options& opt) {
+    GeneratorConfig gen;
+    gen.symbols = SYMBOLS;
+    gen.zipf_s = 1.0;
+    gen.seed = 1;
+    BBOGenerator generator(gen);
+
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        perror(path.c_str());
+        return false;
+    }
+    size_t record_size = wire_record_size(opt.format);
+    std::vector<uint8_t> wire(4096 * record_size);
+    for (size_t done = 0; done < opt.records;) {
+        size_t n = std::min<size_t>(4096, opt.records - done);
+        generator.next_wire(wire.data(), n, opt.format);
+        if (fwrite(wire.data(), record_size, n, f) != n) {
+            perror(path.c_str());
+            fclose(f);
+            return false;
+        }
+        done += n;
+    }
+    return fclose(f) == 0;
+}
+
+/**
+ * One pass over the stream through every stage, appending ns/record per
+ * batch to samples[stage]
+ * @return false if the stream could not be opened or read
+ */
+static bool replay(const std::string& path, const Options& opt, uint64_t overhead, bool measured,
+                   std::vector<double>* samples) {
+    XDMADeviceConfig config;
+    config.transport = TransportKind::FILE;
+    config.c2h_path = path;
+    config.h2c_path = "";
+    config.user_path = "";
+    config.wire_format = opt.format;
+    Transport transport;
+    if (transport.open(config) != PCIeError::SUCCESS) return false;
+
+    size_t record_size = wire_record_size(opt.format);
+    std::vector<uint8_t> wire(BATCH * record_size);
+    std::vector<BBORecord> records(BATCH);
+    std::vector<DerivedQuote> quotes(BATCH);
+    BBOCache cache(SYMBOLS * 2);
+    DedupFilter dedup(DedupConfig{DedupMode::FIELDS, DEDUP_TOP, SYMBOLS * 2});
+    QuoteAnalytics analytics;
+    uint64_t sink = 0;
+    XDMAWrapper::ChannelCallback callback = [&sink](uint32_t ch, const BBORecord& r) {
+        sink += r.bid_price + ch;
+    };
+    bool passed[BATCH];
+
+    auto sample = [&](Stage stage, uint64_t t0, uint64_t t1) {
+        if (!measured) return;
+        uint64_t ns = t1 - t0 > overhead ? t1 - t0 - overhead : 0;
+        samples[stage].push_back(static_cast<double>(ns) / static_cast<double>(BATCH));
+    };
+
+    for (size_t done = 0; done + BATCH <= opt.records; done += BATCH) {
+        uint64_t t0 = bench::now_ns();
+        size_t got = 0;
+        while (got < wire.size()) {
+            ssize_t n = read_c2h(transport.c2h, wire.data() + got, wire.size() - got, 0);
+            if (n < 0) {
+                fprintf(stderr, "Stream %s ended after %zu records\n", path.c_str(), done);
+                return false;
+            }
+            got += static_cast<size_t>(n);
+        }
+        uint64_t t1 = bench::now_ns();
+        decode_bbo_batch(wire.data(), BATCH, records.data(), opt.format);
+        uint64_t t2 = bench::now_ns();
+        for (size_t i = 0; i < BATCH; i++) cache.update(records[i], t2);
+        uint64_t t3 = bench::now_ns();
+        for (size_t i = 0; i < BATCH; i++) passed[i] = dedup.accept(records[i]);
+        uint64_t t4 = bench::now_ns();
+        for (size_t i = 0; i < BATCH; i++) {
+            if (passed[i]) analytics.update(records[i], t4, quotes[i]);
+        }
+        uint64_t t5 = bench::now_ns();
+        for (size_t i = 0; i < BATCH; i++) {
+            if (passed[i]) callback(0, records[i]);
+        }
+        uint64_t t6 = bench::now_ns();
+
+        sample(READ, t0, t1);
+        sample(DECODE, t1, t2);
+        sample(CACHE, t2, t3);
+        sample(DEDUP, t3, t4);
+        sample(ANALYTICS, t4, t5);
+        sample(DISPATCH, t5, t6);
+        sample(END_TO_END, t0, t6);
+    }
+    bench::do_not_optimize(sink);
+    return true;
+}
+
+/**
+ * Warm-up pass, then opt.repetitions measured passes
+ * @param results Per stage, the percentiles of every measured batch
+ */
+static bool measure(const std::string& path, const Options& opt, uint64_t overhead,
+                    std::vector<StageEstimates>& results) {
+    // samples[stage][repetition], the warm-up pass first and dropped
+    std::vector<std::vector<std::vector<double>>> samples(
+        NUM_STAGES, std::vector<std::vector<double>>(opt.repetitions));
+    for (int rep = 0; rep <= opt.repetitions; rep++) {
+        std::vector<double> pass[NUM_STAGES];
+        if (!replay(path, opt, overhead, rep > 0, pass)) return false;
+        for (int s = 0; s < NUM_STAGES && rep > 0; s++) samples[s][rep - 1] = std::move(pass[s]);
+    }
+    results.clear();
+    for (int s = 0; s < NUM_STAGES; s++) results.push_back(estimate(samples[s]));
+    return true;
+}
+
+// Slower than the baseline even at the fast end of this run's interval
+static bool regressed(const Estimate& now, const Estimate& base, double threshold) {
+    return now.lo > base.hi * (1.0 + threshold);
+}
+
+static void usage(const char* prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  -b <path>   Baseline to compare against\n");
+    printf("  -u          Write the results to the baseline path instead\n");
+    printf("  -t <frac>   Regression threshold (default: 0.25 = 25%% slower)\n");
+    printf("  -i <path>   Replay a recorded C2H capture (default: generated stream)\n");
+    printf("  -f <36|48>  Wire format of the stream (default: 36)\n");
+    printf("  -n <count>  Records per repetition (default: 200000)\n");
+    printf("  -r <count>  Measured repetitions (default: 10)\n");
+    printf("  -R <count>  Re-runs confirming a regression (default: 2)\n");
+    printf("  -c <cpu>    CPU to run on, -1 = don't pin (default: first CPU allowed)\n");
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    int o;
+    while ((o = getopt(argc, argv, "b:ut:i:f:n:r:R:c:h")) != -1) {
+        switch (o) {
+            case 'b': opt.baseline = optarg; break;
+            case 'u': opt.update = true; break;
+            case 't': opt.threshold = atof(optarg); break;
+            case 'i': opt.input = optarg; break;
+            case 'f': opt.format = atoi(optarg) == 48 ? WireFormat::BBO48 : WireFormat::BBO36; break;
+            case 'n': opt.records = strtoull(optarg, nullptr, 10); break;
+            case 'r': opt.repetitions = atoi(optarg); break;
+            case 'R': opt.confirm_runs = atoi(optarg); break;
+            case 'c': opt.cpu = atoi(optarg); break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return (o == 'h') ? 0 : 1;
+        }
+    }
+    if (opt.update && opt.baseline.empty()) {
+        fprintf(stderr, "-u needs a baseline path (-b)\n");
+        return 1;
+    }
+    opt.repetitions = std::max(opt.repetitions, 1);
+    opt.confirm_runs = std::max(opt.confirm_runs, 0);
+
+    int cpu = opt.cpu == -2 ? first_allowed_cpu() : opt.cpu;
+    if (cpu >= 0 && !pin_current_thread({cpu})) {
+        fprintf(stderr, "Warning: could not pin to CPU %d, running unpinned\n", cpu);
+        cpu = -1;
+    }
+
+    // A baseline for another batch or format cannot be compared with
+    Baseline base;
+    bool compare = !opt.baseline.empty() && !opt.update;
+    if (compare) {
+        if (!load_baseline(opt.baseline, base)) return 1;
+        if (base.batch != BATCH || base.format != static_cast<int>(wire_record_size(opt.format))) {
+            fprintf(stderr, "Baseline %s is for batch %zu, BBO%d; this run is batch %zu, BBO%zu\n",
+                    opt.baseline.c_str(), base.batch, base.format, BATCH, wire_record_size(opt.format));
+            return 1;
+        }
+    }
+
+    // A capture is replayed as far as it goes, in whole batches
+    std::string path = opt.input;
+    if (path.empty()) {
+        char tmpl[] = "/tmp/latency_regress_XXXXXX";
+        int fd = mkstemp(tmpl);
+        if (fd < 0) {
+            perror("mkstemp");
+            return 1;
+        }
+        ::close(fd);
+        path = tmpl;
+        if (!write_generated_stream(path, opt)) {
+            unlink(path.c_str());
+            return 1;
+        }
+    } else {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) {
+            fprintf(stderr, "Cannot read capture %s\n", path.c_str());
+            return 1;
+        }
+        size_t available = static_cast<size_t>(in.tellg()) / wire_record_size(opt.format);
+        opt.records = std::min(opt.records, available);
+    }
+    opt.records -= opt.records % BATCH;
+    if (opt.records == 0) {
+        fprintf(stderr, "Stream holds less than one batch (%zu records)\n", BATCH);
+        return 1;
+    }
+
+    printf("=== Host-Path Latency Regression Check ===\n");
+    uint64_t overhead = bench::timer_overhead_ns();
+    printf("Stream: %s | Records: %zu x %d (+1 warm-up) | Batch: %zu | CPU: %s\n\n",
+           opt.input.empty() ? "generated" : opt.input.c_str(), opt.records, opt.repetitions, BATCH,
+           cpu >= 0 ? std::to_string(cpu).c_str() : "unpinned");
+
+    std::vector<StageEstimates> results;
+    bool ok = measure(path, opt, overhead, results);
+
+    if (compare) {
+        std::string model = cpu_model();
+        if (base.cpu != model) {
+            printf("Warning: baseline was taken on \"%s\", this is \"%s\"\n\n",
+                   base.cpu.c_str(), model.c_str());
+        }
+    }
+
+    // confirmed[stage][pct]: regressed in the first run and every re-run
+    std::vector<std::vector<bool>> confirmed(NUM_STAGES, std::vector<bool>(NUM_PCTS, false));
+    int suspects = 0;
+    int reruns = 0;
+    for (int s = 0; s < NUM_STAGES && compare && ok; s++) {
+        auto found = base.stages.find(STAGE_NAMES[s]);
+        if (found == base.stages.end()) continue;
+        for (int p = 0; p + 1 < NUM_PCTS; p++) {
+            confirmed[s][p] = regressed(results[s][p], found->second[p], opt.threshold);
+            suspects += confirmed[s][p];
+        }
+    }
+    for (int run = 1; run <= opt.confirm_runs && suspects > 0; run++) {
+        std::vector<StageEstimates> again;
+        if (!measure(path, opt, overhead, again)) {
+            ok = false;
+            break;
+        }
+        reruns++;
+        int still = 0;
+        for (int s = 0; s < NUM_STAGES; s++) {
+            for (int p = 0; p + 1 < NUM_PCTS; p++) {
+                if (!confirmed[s][p]) continue;
+                confirmed[s][p] = regressed(again[s][p], base.stages[STAGE_NAMES[s]][p], opt.threshold);
+                still += confirmed[s][p];
+            }
+        }
+        printf("Re-run %d/%d: %d of %d regressed percentile(s) regressed again\n",
+               run, opt.confirm_runs, still, suspects);
+        suspects = still;
+    }
+    if (opt.input.empty()) unlink(path.c_str());
+    if (!ok) return 1;
+    if (reruns > 0) printf("\n");
+
+    if (opt.update) {
+        if (!write_baseline(opt.baseline, opt, results)) return 1;
+        printf("Baseline written to %s\n", opt.baseline.c_str());
+    }
+
+    printf("%-12s %-6s %10s %21s", "Stage", "pct", "ns/rec", "95% CI");
+    if (compare) printf(" %10s %8s  %s", "baseline", "change", "verdict");
+    printf("\n");
+
+    int regressions = 0;
+    for (int s = 0; s < NUM_STAGES; s++) {
+        auto found = base.stages.find(STAGE_NAMES[s]);
+        for (int p = 0; p < NUM_PCTS; p++) {
+            const Estimate& e = results[s][p];
+            printf("%-12s %-6s %10.2f  [%8.2f, %8.2f]", p == 0 ? STAGE_NAMES[s] : "", PCT_NAMES[p],
+                   e.value, e.lo, e.hi);
+            if (compare) {
+                if (found == base.stages.end()) {
+                    printf(" %10s %8s  new", "-", "-");
+                } else {
+                    const Estimate& b = found->second[p];
+                    double change = b.value > 0.0 ? e.value / b.value - 1.0 : 0.0;
+                    const char* verdict = "ok";
+                    if (p == NUM_PCTS - 1) {
+                        verdict = "(not gated)";
+                    } else if (confirmed[s][p]) {
+                        verdict = "REGRESSED";
+                        regressions++;
+                    } else if (regressed(e, b, opt.threshold)) {
+                        verdict = "not repeated";
+                    } else if (e.hi * (1.0 + opt.threshold) < b.lo) {
+                        verdict = "faster";
+                    }
+                    printf(" %10.2f %+7.1f%%  %s", b.value, 100.0 * change, verdict);
+                }
+            }
+            printf("\n");
+        }
+    }
+
+    if (compare) {
+        printf("\n");
+        if (regressions > 0) {
+            printf("FAIL: %d percentile(s) regressed more than %.0f%% against %s\n",
+                   regressions, 100.0 * opt.threshold, opt.baseline.c_str());
+            return 1;
+        }
+        printf("PASS: no percentile regressed more than %.0f%% against %s\n",
+               100.0 * opt.threshold, opt.baseline.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,219 @@
+/**
+ * MMIO and DMA Microbenchmark
+ * Measures the host-side cost of XDMAWrapper register and DMA paths
+ *
+ * Without a card (or with -m) the wrapper is opened against a mock device:
+ * a file-backed mmap "BAR" and a FIFO fed by a writer thread as C2H, so
+ * the numbers track the host path alone and regressions show up without
+ * hardware. With -g the generator transport replaces the FIFO, leaving
+ * decode and bookkeeping without any syscall cost.
+ *
+ * Usage: ./mmio_dma_bench [options]
+ *   -m          Force mock device (file-backed BAR, pipe-backed C2H)
+ *   -g          In-process generator transport (emulated BAR, no C2H syscalls)
+ *   -n <count>  Samples per measurement (default: 10000)
+ *   -h          Show this help
+ */
+
+#include "xdma_wrapper.h"
+#include "bench_util.h"
+#include "mock_device.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include <signal.h>
+
+using namespace pcie;
+
+static void bench_registers(XDMAWrapper& xdma, int samples, uint64_t overhead) {
+    std::vector<uint64_t> ns(samples);
+
+    // Register read: STATUS is volatile on hardware
+    for (int i = 0; i < samples; i++) {
+        uint64_t t0 = bench::now_ns();
+        uint32_t v = xdma.read_register(ControlRegisters::STATUS_OFFSET);
+        uint64_t t1 = bench::now_ns();
+        bench::do_not_optimize(v);
+        ns[i] = (t1 - t0 > overhead) ? t1 - t0 - overhead : 0;
+    }
+    bench::print_row("read_register(STATUS)", bench::summarize(ns));
+
+    // Register write: scratch symbol filter slot, restored afterwards
+    const uint32_t offset = ControlRegisters::SYMBOL_FILTER_0_OFFSET + 7 * 8;
+    uint32_t saved = xdma.read_register(offset);
+    for (int i = 0; i < samples; i++) {
+        uint64_t t0 = bench::now_ns();
+        xdma.write_register(offset, static_cast<uint32_t>(i));
+        uint64_t t1 = bench::now_ns();
+        ns[i] = (t1 - t0 > overhead) ? t1 - t0 - overhead : 0;
+    }
+    xdma.write_register(offset, saved);
+    bench::print_row("write_register(FILTER7)", bench::summarize(ns));
+
+    // Write followed by read-back: the posted write has actually landed
+    for (int i = 0; i < samples; i++) {
+        uint64_t t0 = bench::now_ns();
+        xdma.write_register(offset, static_cast<uint32_t>(i));
+        uint32_t v = xdma.read_register(offset);
+        uint64_t t1 = bench::now_ns();
+        bench::do_not_optimize(v);
+        ns[i] = (t1 - t0 > overhead) ? t1 - t0 - overhead : 0;
+    }
+    xdma.write_register(offset, saved);
+    bench::print_row("write+readback", bench::summarize(ns));
+}
+
+static void bench_c2h(XDMAWrapper& xdma, int samples, uint64_t overhead) {
+    std::vector<uint64_t> ns;
+    ns.reserve(samples);
+
+    // Single record
+    for (int i = 0; i < samples; i++) {
+        BBOData bbo;
+        uint64_t t0 = bench::now_ns();
+        PCIeError err = xdma.read_bbo(bbo, 1000);
+        uint64_t t1 = bench::now_ns();
+        if (err != PCIeError::SUCCESS) {
+            printf("%-28s %s\n", "read_bbo", pcie_error_string(err));
+            return;
+        }
+        ns.push_back((t1 - t0 > overhead) ? t1 - t0 - overhead : 0);
+    }
+    bench::print_row("read_bbo (36 B)", bench::summarize(ns), sizeof(BBOData));
+
+    // Batched reads: one sample per call
+    static const size_t batch_sizes[] = {8, 64, 512};
+    std::vector<BBOData> bbos;
+    for (size_t batch : batch_sizes) {
+        ns.clear();
+        int calls = std::max(samples / static_cast<int>(batch), 100);
+        for (int i = 0; i < calls; i++) {
+            uint64_t t0 = bench::now_ns();
+            int n = xdma.read_bbos(bbos, batch, 1000);
+            uint64_t t1 = bench::now_ns();
+            if (n < 0) {
+                printf("read_bbos(%zu) failed\n", batch);
+                return;
+            }
+            ns.push_back((t1 - t0 > overhead) ? t1 - t0 - overhead : 0);
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "read_bbos (%zu x 36 B)", batch);
+        bench::print_row(name, bench::summarize(ns), batch * sizeof(BBOData));
+    }
+
+    // Bulk read + batch decode: one read() per call, so a call may return
+    // fewer records than asked for; MB/s uses the average actually read
+    std::vector<BBORecord> records(512);
+    for (size_t batch : batch_sizes) {
+        ns.clear();
+        uint64_t total = 0;
+        int calls = std::max(samples / static_cast<int>(batch), 100);
+        for (int i = 0; i < calls; i++) {
+            uint64_t t0 = bench::now_ns();
+            int n = xdma.read_records(records.data(), batch, 1000);
+            uint64_t t1 = bench::now_ns();
+            if (n < 0) {
+                printf("read_records(%zu) failed\n", batch);
+                return;
+            }
+            total += static_cast<uint64_t>(n);
+            ns.push_back((t1 - t0 > overhead) ? t1 - t0 - overhead : 0);
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "read_records (<=%zu x 36 B)", batch);
+        bench::print_row(name, bench::summarize(ns), total * sizeof(BBOData) / calls);
+    }
+}
+
+static void bench_h2c(XDMAWrapper& xdma, int samples, uint64_t overhead) {
+    static const size_t sizes[] = {64, 256, 1024, 4096, 65536};
+    std::vector<uint8_t> buf(65536);
+    for (size_t i = 0; i < buf.size(); i++) buf[i] = static_cast<uint8_t>(i);
+
+    std::vector<uint64_t> ns(samples);
+    for (size_t size : sizes) {
+        int n = (size >= 65536) ? std::max(samples / 16, 100) : samples;
+        ns.resize(n);
+        for (int i = 0; i < n; i++) {
+            uint64_t t0 = bench::now_ns();
+            PCIeError err = xdma.write_data(buf.data(), size, 0);
+            uint64_t t1 = bench::now_ns();
+            if (err != PCIeError::SUCCESS) {
+                printf("write_data(%zu) %s\n", size, pcie_error_string(err));
+                return;
+            }
+            ns[i] = (t1 - t0 > overhead) ? t1 - t0 - overhead : 0;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "write_data (%zu B)", size);
+        bench::print_row(name, bench::summarize(ns), size);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool force_mock = false;
+    bool generator = false;
+    int samples = 10000;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "mgn:h")) != -1) {
+        switch (opt) {
+            case 'm': force_mock = true; break;
+            case 'g': generator = true; break;
+            case 'n': samples = atoi(optarg); break;
+            case 'h':
+            default:
+                printf("Usage: %s [-m | -g] [-n samples]\n", argv[0]);
+                printf("  -m          Force mock device (file-backed BAR, pipe-backed C2H)\n");
+                printf("  -g          In-process generator transport (emulated BAR, no C2H syscalls)\n");
+                printf("  -n <count>  Samples per measurement (default: 10000)\n");
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if (samples < 1) samples = 1;
+
+    // The mock writer sees EPIPE when we close the FIFO
+    signal(SIGPIPE, SIG_IGN);
+
+    bool use_mock = !generator && (force_mock || !XDMADeviceDiscovery::is_driver_loaded());
+    MockDevice mock;
+    XDMAWrapper xdma;
+    PCIeError err;
+
+    printf("=== MMIO / DMA Microbenchmark ===\n");
+    if (generator) {
+        XDMADeviceConfig config;
+        config.transport = TransportKind::GENERATOR;
+        printf("Device: generator (emulated BAR, in-process C2H)\n");
+        err = xdma.open(config);
+    } else if (use_mock) {
+        if (!mock.create()) return 1;
+        printf("Device: mock (file-backed BAR, pipe-backed C2H)\n");
+        err = xdma.open(mock.config());
+    } else {
+        printf("Device: %s\n", XDMADevicePaths::C2H_0);
+        err = xdma.open();
+    }
+    if (err != PCIeError::SUCCESS) {
+        printf("ERROR: Failed to open device: %s\n", pcie_error_string(err));
+        mock.destroy();
+        return 1;
+    }
+
+    uint64_t overhead = bench::timer_overhead_ns();
+    printf("Samples: %d | Timer overhead: %lu ns (subtracted)\n\n", samples, overhead);
+
+    bench::print_header();
+    bench_registers(xdma, samples, overhead);
+    bench_c2h(xdma, samples, overhead);
+    bench_h2c(xdma, samples, overhead);
+
+    xdma.close();
+    mock.destroy();
+    return 0;
+}
@@ -0,0 +1,175 @@
+/**
+ * Mock XDMA Device
+ * Shared by the tests and benchmarks that run without a card
+ */
+
+#pragma once
+
+#include "pcie_types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pcie {
+
+/**
+ * Mock XDMA device in a temp directory
+ *   user    - 4KB regular file, mmapped by the wrapper as the BAR
+ *   c2h     - FIFO fed with BBO records by a writer thread
+ *   h2c     - regular file absorbing writes
+ *
+ * The writer repeats one set of records forever: by default 113 MOCKAAPL
+ * updates, or whatever set_records() installed before create(). With
+ * set_timestamps() the repeats carry ever-increasing T1/T4 instead.
+ */
+class MockDevice {
+public:
+    MockDevice() {
+        records_.resize(MAX_RECORDS);
+        for (size_t i = 0; i < MAX_RECORDS; i++) {
+            BBOData& b = records_[i];
+            std::memcpy(b.symbol, "MOCKAAPL", 8);
+            b.bid_price = __builtin_bswap32(1500000 + static_cast<uint32_t>(i));
+            b.bid_size = __builtin_bswap32(100);
+            b.ask_price = __builtin_bswap32(1500100 + static_cast<uint32_t>(i));
+            b.ask_size = __builtin_bswap32(200);
+            b.spread = __builtin_bswap32(100);
+            b.rx_timestamp = __builtin_bswap32(static_cast<uint32_t>(i * 100));
+            b.tx_timestamp = __builtin_bswap32(static_cast<uint32_t>(i * 100 + 25));
+        }
+    }
+
+    ~MockDevice() { destroy(); }
+
+    MockDevice(const MockDevice&) = delete;
+    MockDevice& operator=(const MockDevice&) = delete;
+
+    // Whole records per FIFO write must fit in PIPE_BUF (4096 / 36)
+    static constexpr size_t MAX_RECORDS = 113;
+
+    /**
+     * Replace the record set (before create(); at most MAX_RECORDS)
+     */
+    void set_records(const std::vector<BBOData>& records) {
+        records_.assign(records.begin(),
+                        records.begin() + std::min(records.size(), MAX_RECORDS));
+    }
+
+    /**
+     * Number the records' tx_timestamp (T4) start, start + step, ... across
+     * repeats, with rx_timestamp (T1) 25 cycles earlier (before create())
+     */
+    void set_timestamps(uint32_t start, uint32_t step) {
+        ts_next_ = start;
+        ts_step_ = step;
+    }
+
+    bool create() {
+        char tmpl[] = "/tmp/xdma_mock_XXXXXX";
+        if (!mkdtemp(tmpl)) {
+            perror("mkdtemp");
+            return false;
+        }
+        dir_ = tmpl;
+        config_.c2h_path = dir_ + "/c2h_0";
+        config_.h2c_path = dir_ + "/h2c_0";
+        config_.user_path = dir_ + "/user";
+        config_.events_path = "";
+        config_.require_driver = false;
+
+        // BAR backing file with VERSION and STATUS populated
+        int fd = ::open(config_.user_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0 || ftruncate(fd, static_cast<off_t>(config_.user_map_size)) < 0) {
+            perror("mock BAR");
+            if (fd >= 0) ::close(fd);
+            return false;
+        }
+        uint32_t version = 0x21000001;
+        uint32_t status = ControlRegisters::STATUS_RUNNING | ControlRegisters::STATUS_LINK_UP;
+        pwrite(fd, &version, 4, ControlRegisters::VERSION_OFFSET);
+        pwrite(fd, &status, 4, ControlRegisters::STATUS_OFFSET);
+        ::close(fd);
+
+        fd = ::open(config_.h2c_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0) {
+            perror("mock H2C");
+            return false;
+        }
+        ::close(fd);
+
+        if (mkfifo(config_.c2h_path.c_str(), 0600) < 0) {
+            perror("mock C2H");
+            return false;
+        }
+
+        // Opening a FIFO for write blocks until the reader opens it, so the
+        // writer must already be running when XDMAWrapper::open() is called
+        writer_ = std::thread([this]() { feed_c2h(); });
+        return true;
+    }
+
+    void destroy() {
+        stop_ = true;
+        if (writer_.joinable()) {
+            // A writer still blocked opening the FIFO (the wrapper never
+            // opened it) needs a reader to return; it then sees stop_
+            int fd = -1;
+            if (!writer_open_) {
+                fd = ::open(config_.c2h_path.c_str(), O_RDONLY | O_NONBLOCK);
+            }
+            writer_.join();
+            if (fd >= 0) ::close(fd);
+        }
+        if (!dir_.empty()) {
+            unlink(config_.c2h_path.c_str());
+            unlink(config_.h2c_path.c_str());
+            unlink(config_.user_path.c_str());
+            rmdir(dir_.c_str());
+            dir_.clear();
+        }
+    }
+
+    const XDMADeviceConfig& config() const { return config_; }
+
+private:
+    void feed_c2h() {
+        int fd = ::open(config_.c2h_path.c_str(), O_WRONLY);
+        if (fd < 0) return;
+        writer_open_ = true;
+
+        // Whole records per write (<= PIPE_BUF) so the reader never sees
+        // a torn record
+        size_t bytes = records_.size() * sizeof(BBOData);
+        while (!stop_ && bytes > 0) {
+            if (ts_step_ != 0) {
+                for (BBOData& b : records_) {
+                    b.tx_timestamp = __builtin_bswap32(ts_next_);
+                    b.rx_timestamp = __builtin_bswap32(ts_next_ - 25);
+                    ts_next_ += ts_step_;
+                }
+            }
+            if (write(fd, records_.data(), bytes) < 0) break;  // Reader gone
+        }
+        ::close(fd);
+    }
+
+    std::vector<BBOData> records_;
+    uint32_t ts_next_ = 0;
+    uint32_t ts_step_ = 0;        // 0 = repeat records unchanged
+    std::string dir_;
+    XDMADeviceConfig config_;
+    std::thread writer_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> writer_open_{false};
+};
+
+}  // namespace pcie
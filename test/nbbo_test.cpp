@@ -0,0 +1,319 @@
+/**
+ * NBBO Engine Test
+ * 1. Random updates from several devices checked after every step against
+ *    a brute-force consolidation (best price, earliest to reach it)
+ * 2. Concurrent writers and readers: snapshots are never torn
+ * 3. Several mock devices streaming through XDMAWrapper into one engine
+ * Needs no hardware.
+ *
+ * Usage: ./nbbo_test [options]
+ *   -n <count>  Random updates for the model check (default: 200000)
+ *   -h          Show this help
+ */
+
+#include "nbbo_engine.h"
+#include "xdma_wrapper.h"
+#include "mock_device.h"
+#include "bench_util.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+#include <getopt.h>
+#include <signal.h>
+
+using namespace pcie;
+using bench::check;
+using bench::make_bbo;
+
+static const char* TICKERS[] = {"AAPL", "MSFT", "GOOGL", "AMZN", "NVDA", "META", "TSLA", "SPY"};
+
+/**
+ * Brute-force reference: every device's quote, rescanned on every query
+ */
+struct ReferenceBook {
+    struct Venue {
+        uint32_t bid = 0, bid_size = 0, ask = 0, ask_size = 0;
+        uint64_t bid_since = 0, ask_since = 0;
+    };
+
+    explicit ReferenceBook(uint32_t devices) : venues(devices) {}
+
+    void update(uint32_t d, uint32_t bid, uint32_t bid_size, uint32_t ask, uint32_t ask_size) {
+        arrivals++;
+        Venue& v = venues[d];
+        if (bid != v.bid) v.bid_since = arrivals;
+        if (ask != v.ask) v.ask_since = arrivals;
+        v = Venue{bid, bid_size, ask, ask_size, v.bid_since, v.ask_since};
+    }
+
+    void clear(uint32_t d) { venues[d] = Venue{}; }
+
+    void quote(NBBOQuote& q) const {
+        q.bid_device = q.ask_device = NBBOQuote::NO_DEVICE;
+        q.bid_price = q.bid_size = q.ask_price = q.ask_size = 0;
+        for (uint32_t d = 0; d < venues.size(); d++) {
+            const Venue& v = venues[d];
+            if (v.bid != 0 && (q.bid_device == NBBOQuote::NO_DEVICE || v.bid > q.bid_price ||
+                               (v.bid == q.bid_price && v.bid_since < venues[q.bid_device].bid_since))) {
+                q.bid_device = d;
+                q.bid_price = v.bid;
+                q.bid_size = v.bid_size;
+            }
+            if (v.ask != 0 && (q.ask_device == NBBOQuote::NO_DEVICE || v.ask < q.ask_price ||
+                               (v.ask == q.ask_price && v.ask_since < venues[q.ask_device].ask_since))) {
+                q.ask_device = d;
+                q.ask_price = v.ask;
+                q.ask_size = v.ask_size;
+            }
+        }
+    }
+
+    std::vector<Venue> venues;
+    uint64_t arrivals = 0;
+};
+
+static bool same_quote(const NBBOQuote& a, const NBBOQuote& b) {
+    return a.bid_price == b.bid_price && a.bid_size == b.bid_size && a.bid_device == b.bid_device &&
+           a.ask_price == b.ask_price && a.ask_size == b.ask_size && a.ask_device == b.ask_device;
+}
+
+static bool test_model(size_t updates) {
+    const uint32_t devices = 4;
+    const size_t symbols = 8;
+    NBBOEngine engine(devices, 64);
+    std::vector<ReferenceBook> ref(symbols, ReferenceBook(devices));
+    std::vector<NBBOQuote> last(symbols);
+    std::vector<bool> seen(symbols, false);
+    std::mt19937 rng(2024);
+
+    bool match = true, changed_ok = true;
+    for (size_t i = 0; i < updates && match; i++) {
+        size_t s = rng() % symbols;
+        uint32_t d = rng() % devices;
+        SymbolKey key(TICKERS[s]);
+
+        if (rng() % 500 == 0) {
+            // Feed lost: withdraw all of the device's quotes
+            engine.clear_device(d);
+            for (ReferenceBook& book : ref) book.clear(d);
+        } else {
+            // Narrow price band so ties and backing off are common; 0 = no quote
+            uint32_t bid = (rng() % 8 == 0) ? 0 : 1000000 + (rng() % 6) * 100;
+            uint32_t ask = (rng() % 8 == 0) ? 0 : 1000500 + (rng() % 6) * 100;
+            uint32_t bid_size = 1 + rng() % 3;
+            uint32_t ask_size = 1 + rng() % 3;
+
+            BBORecord rec{};
+            rec.symbol = key;
+            rec.bid_price = bid;
+            rec.bid_size = bid_size;
+            rec.ask_price = ask;
+            rec.ask_size = ask_size;
+            bool changed = engine.update(d, rec);
+            ref[s].update(d, bid, bid_size, ask, ask_size);
+
+            NBBOQuote expect;
+            ref[s].quote(expect);
+            changed_ok &= changed == (!seen[s] || !same_quote(expect, last[s]));
+            seen[s] = true;
+        }
+
+        // Every symbol, since clear_device() touches them all
+        for (size_t k = 0; k < symbols; k++) {
+            if (!seen[k]) continue;
+            NBBOQuote expect, got;
+            ref[k].quote(expect);
+            engine.get(SymbolKey(TICKERS[k]), got);
+            if (!same_quote(expect, got)) {
+                printf("  update %zu, %s: got %u@%u (dev %u) / %u@%u (dev %u), "
+                       "expected %u@%u (dev %u) / %u@%u (dev %u)\n",
+                       i, TICKERS[k], got.bid_size, got.bid_price, got.bid_device,
+                       got.ask_size, got.ask_price, got.ask_device,
+                       expect.bid_size, expect.bid_price, expect.bid_device,
+                       expect.ask_size, expect.ask_price, expect.ask_device);
+                match = false;
+                break;
+            }
+            last[k] = got;
+        }
+    }
+
+    bool ok = check(match, "matches brute-force consolidation");
+    ok &= check(changed_ok, "update() reports consolidated changes");
+
+    NBBOQuote q;
+    ok &= check(!engine.get(SymbolKey("NONE"), q), "unknown symbol not found");
+    ok &= check(!engine.update(devices, make_bbo("AAPL", 1, 1, 2, 1)) && engine.dropped() == 1,
+                "out-of-range device dropped");
+    return ok;
+}
+
+/**
+ * One writer thread per device, readers check that sizes always match
+ * prices (every device quotes size == price), so a torn read shows up
+ */
+static bool test_concurrent() {
+    const uint32_t devices = 4;
+    NBBOEngine engine(devices, 64);
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> torn{0}, reads{0};
+
+    std::vector<std::thread> threads;
+    for (uint32_t d = 0; d < devices; d++) {
+        threads.emplace_back([&, d]() {
+            std::mt19937 rng(d);
+            while (!stop.load(std::memory_order_relaxed)) {
+                uint32_t bid = 1000 + rng() % 100;
+                uint32_t ask = 2000 + rng() % 100;
+                BBORecord rec{};
+                rec.symbol = SymbolKey(TICKERS[rng() % 4]);
+                rec.bid_price = bid;
+                rec.bid_size = bid;
+                rec.ask_price = ask;
+                rec.ask_size = ask;
+                engine.update(d, rec);
+            }
+        });
+    }
+    for (int r = 0; r < 2; r++) {
+        threads.emplace_back([&]() {
+            NBBOQuote q;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (size_t s = 0; s < 4; s++) {
+                    if (!engine.get(SymbolKey(TICKERS[s]), q)) continue;
+                    reads.fetch_add(1, std::memory_order_relaxed);
+                    if (q.bid_size != q.bid_price || q.ask_size != q.ask_price ||
+                        q.bid_device >= devices || q.ask_device >= devices) {
+                        torn.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    stop = true;
+    for (auto& t : threads) t.join();
+
+    printf("  %lu reads, %lu consolidated changes\n", reads.load(), engine.changes());
+    return check(torn.load() == 0 && reads.load() > 0, "no torn snapshots");
+}
+
+/**
+ * Three mock cards, each quoting AAPL and MSFT at its own prices
+ */
+static bool test_mock_devices() {
+    struct Feed {
+        uint32_t aapl_bid, aapl_ask, msft_bid, msft_ask;
+    };
+    const Feed feeds[] = {
+        {1500000, 1501000, 4000000, 4002000},
+        {1500200, 1501200, 3999000, 4001500},   // Best AAPL bid, best MSFT ask
+        {1499900, 1500500, 4000100, 4003000},   // Best AAPL ask, best MSFT bid
+    };
+    const uint32_t devices = 3;
+
+    NBBOEngine engine(devices);
+    MockDevice mocks[devices];
+    XDMAWrapper wrappers[devices];
+    bool ok = true;
+
+    for (uint32_t d = 0; d < devices; d++) {
+        mocks[d].set_records({
+            make_bbo("AAPL", feeds[d].aapl_bid, 100 + d, feeds[d].aapl_ask, 200 + d),
+            make_bbo("MSFT", feeds[d].msft_bid, 300 + d, feeds[d].msft_ask, 400 + d),
+        });
+        if (!mocks[d].create()) return check(false, "mock devices created");
+        PCIeError err = wrappers[d].open(mocks[d].config());
+        if (err != PCIeError::SUCCESS) {
+            printf("  open mock %u: %s\n", d, pcie_error_string(err));
+            return check(false, "mock devices opened");
+        }
+    }
+
+    for (uint32_t d = 0; d < devices; d++) {
+        wrappers[d].start_streaming([&engine, d](const BBOData& bbo) { engine.update(d, bbo); });
+    }
+
+    // All three feeds must have reached the engine
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    NBBOQuote aapl{}, msft{};
+    while (std::chrono::steady_clock::now() < deadline) {
+        engine.get(SymbolKey("AAPL"), aapl);
+        engine.get(SymbolKey("MSFT"), msft);
+        if (aapl.bid_device == 1 && aapl.ask_device == 2 &&
+            msft.bid_device == 2 && msft.ask_device == 1) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    for (uint32_t d = 0; d < devices; d++) {
+        wrappers[d].stop_streaming();
+        wrappers[d].close();
+        mocks[d].destroy();
+    }
+
+    char px[2][24];
+    aapl.get_bid_px().format(px[0], sizeof(px[0]));
+    aapl.get_ask_px().format(px[1], sizeof(px[1]));
+    printf("  AAPL %s (dev %u) / %s (dev %u)\n", px[0], aapl.bid_device, px[1], aapl.ask_device);
+    msft.get_bid_px().format(px[0], sizeof(px[0]));
+    msft.get_ask_px().format(px[1], sizeof(px[1]));
+    printf("  MSFT %s (dev %u) / %s (dev %u)\n", px[0], msft.bid_device, px[1], msft.ask_device);
+
+    ok &= check(aapl.bid_price == 1500200 && aapl.bid_size == 101 && aapl.bid_device == 1 &&
+                aapl.ask_price == 1500500 && aapl.ask_size == 202 && aapl.ask_device == 2,
+                "AAPL consolidated across devices");
+    ok &= check(msft.bid_price == 4000100 && msft.bid_size == 302 && msft.bid_device == 2 &&
+                msft.ask_price == 4001500 && msft.ask_size == 401 && msft.ask_device == 1,
+                "MSFT consolidated across devices");
+
+    // Losing device 1 hands its sides to the next best venue
+    engine.clear_device(1);
+    engine.get(SymbolKey("AAPL"), aapl);
+    engine.get(SymbolKey("MSFT"), msft);
+    ok &= check(aapl.bid_device == 0 && aapl.bid_price == 1500000 &&
+                msft.ask_device == 0 && msft.ask_price == 4002000,
+                "clear_device() falls back to next venue");
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    size_t updates = 200000;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+            case 'n': updates = std::strtoul(optarg, nullptr, 10); break;
+            case 'h':
+            default:
+                printf("Usage: %s [-n updates]\n", argv[0]);
+                printf("  -n <count>  Random updates for the model check (default: 200000)\n");
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    // Mock writers see EPIPE when the wrappers close their FIFOs
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("========================================\n");
+    printf("NBBO Engine Test\n");
+    printf("========================================\n");
+
+    printf("Model check (%zu updates, 4 devices):\n", updates);
+    bool ok = test_model(updates);
+
+    printf("\nConcurrent writers/readers:\n");
+    ok &= test_concurrent();
+
+    printf("\nMock devices:\n");
+    ok &= test_mock_devices();
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
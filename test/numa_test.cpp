@@ -0,0 +1,199 @@
+/**
+ * NUMA Placement Test
+ * Checks cpulist parsing, the placement decision against a fake two-node
+ * topology (follow the card, explicit remote node or CPUs, unknown node),
+ * node-local allocation and thread pinning on this machine, and the
+ * placement XDMAWrapper applies to a mock device.
+ * Needs no hardware.
+ */
+
+#include "numa_placement.h"
+#include "xdma_wrapper.h"
+#include "mock_device.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <sched.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pcie;
+using bench::check;
+
+static bool test_cpulist() {
+    bool ok = true;
+    auto cpus = NumaTopology::parse_cpulist("0-3,8,10-11");
+    ok &= check(cpus == std::vector<int>({0, 1, 2, 3, 8, 10, 11}), "parse ranges and singles");
+    ok &= check(NumaTopology::format_cpulist(cpus) == "0-3,8,10-11", "format round trip");
+    ok &= check(NumaTopology::parse_cpulist("").empty() && NumaTopology::format_cpulist({}).empty(),
+                "empty list");
+    ok &= check(NumaTopology::parse_cpulist("5,1-2,2\n") == std::vector<int>({1, 2, 5}),
+                "unsorted, duplicate, trailing newline");
+    return ok;
+}
+
+static void write_file(const std::string& path, const char* content) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return;
+    fputs(content, f);
+    fclose(f);
+}
+
+static bool test_placement() {
+    bool ok = true;
+
+    // Two nodes: 0 = CPUs 0-7,16-23, 1 = CPUs 8-15,24-31
+    char root_template[] = "/tmp/numa_test_XXXXXX";
+    if (!mkdtemp(root_template)) return check(false, "temp dir");
+    std::string root = root_template;
+    mkdir((root + "/node0").c_str(), 0755);
+    mkdir((root + "/node1").c_str(), 0755);
+    write_file(root + "/node0/cpulist", "0-7,16-23\n");
+    write_file(root + "/node1/cpulist", "8-15,24-31\n");
+
+    NumaTopology topo(root);
+    ok &= check(topo.nodes() == 2 && topo.node_of_cpu(24) == 1 && topo.node_of_cpu(99) == -1,
+                "fake topology read");
+
+    std::vector<int> card_cpus = NumaTopology::parse_cpulist("8-15,24-31");
+
+    NumaPlacement p = topo.place(1, card_cpus, NumaTopology::NUMA_AUTO, {});
+    ok &= check(p.node == 1 && p.cpus == card_cpus && !p.remote && p.warnings.empty() &&
+                strcmp(p.source, "device") == 0,
+                "default follows the card");
+
+    p = topo.place(1, card_cpus, 0, {});
+    ok &= check(p.node == 0 && p.cpus == topo.cpus(0) && p.remote && p.warnings.size() == 1,
+                "remote node kept, flagged, warned");
+
+    p = topo.place(1, card_cpus, NumaTopology::NUMA_AUTO, {2, 9});
+    ok &= check(p.node == 1 && p.cpus == std::vector<int>({2, 9}) && p.remote &&
+                p.warnings.size() == 1,
+                "remote CPU in explicit affinity warned");
+
+    p = topo.place(1, card_cpus, 1, {9, 10});
+    ok &= check(!p.remote && p.warnings.empty() && strcmp(p.source, "config") == 0,
+                "explicit local choice is quiet");
+
+    p = topo.place(-1, {}, NumaTopology::NUMA_AUTO, {});
+    ok &= check(p.node == -1 && p.cpus.empty() && !p.remote, "unknown card node: no placement");
+
+    p = topo.place(1, card_cpus, NumaTopology::NUMA_NONE, {});
+    ok &= check(p.node == -1 && p.cpus.empty(), "NUMA_NONE opts out");
+
+    std::string cleanup = "rm -rf '" + root + "'";
+    if (system(cleanup.c_str()) != 0) printf("  (could not remove %s)\n", root.c_str());
+    return ok;
+}
+
+static bool test_local() {
+    bool ok = true;
+    NumaTopology topo;
+    if (topo.nodes() == 0) {
+        printf("  no NUMA information, skipped\n");
+        return true;
+    }
+    int node = static_cast<int>(topo.nodes()) - 1;   // Highest node: not just the default
+
+    size_t size = 8 << 20;
+    std::unique_ptr<char[]> buf;
+    {
+        ScopedMemoryNode local(node);
+        ok &= check(local.active(), "memory policy set");
+        buf.reset(new char[size]);
+        memset(buf.get(), 1, size);
+    }
+    bool all_local = true;
+    for (size_t off = 0; off < size; off += 1 << 20) {
+        all_local &= memory_node(buf.get() + off) == node;
+    }
+    printf("  node %d of %zu\n", node, topo.nodes());
+    ok &= check(all_local, "pages allocated on the node");
+
+    // Pin a thread to one CPU of that node
+    int cpu = topo.cpus(node).front();
+    int seen = -1;
+    bool pinned = false;
+    std::thread t([&]() {
+        pinned = pin_current_thread({cpu});
+        std::this_thread::yield();
+        seen = sched_getcpu();
+    });
+    t.join();
+    ok &= check(pinned && seen == cpu, "thread pinned to CPU");
+    return ok;
+}
+
+static bool test_wrapper() {
+    bool ok = true;
+    NumaTopology topo;
+    if (topo.nodes() == 0) {
+        printf("  no NUMA information, skipped\n");
+        return true;
+    }
+
+    // A mock device has no sysfs entry: nothing is placed by default
+    MockDevice mock;
+    if (!mock.create()) return check(false, "mock device created");
+    {
+        XDMAWrapper xdma;
+        if (xdma.open(mock.config()) != PCIeError::SUCCESS) return check(false, "mock device opened");
+        NumaPlacement p = xdma.get_numa_placement();
+        ok &= check(p.node == -1 && p.cpus.empty(), "mock device: OS default placement");
+        xdma.close();
+    }
+
+    // Explicit node and CPU: tables allocated there, streaming thread pinned
+    MockDevice mock2;
+    if (!mock2.create()) return check(false, "mock device created");
+    XDMADeviceConfig config = mock2.config();
+    config.numa_node = 0;
+    config.stream_cpus = {topo.cpus(0).back()};
+
+    XDMAWrapper xdma;
+    if (xdma.open(config) != PCIeError::SUCCESS) return check(false, "mock device opened");
+    NumaPlacement p = xdma.get_numa_placement();
+    ok &= check(p.node == 0 && p.cpus == config.stream_cpus && strcmp(p.source, "config") == 0,
+                "config placement reported");
+
+    std::atomic<int> cpu{-1};
+    xdma.start_streaming([&](const BBOData&) { cpu = sched_getcpu(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    xdma.stop_streaming();
+    ok &= check(cpu == config.stream_cpus[0], "streaming thread on the chosen CPU");
+
+    BBOQuote q;
+    ok &= check(xdma.get_latest(SymbolKey("MOCKAAPL"), q), "stream still delivers");
+    xdma.close();
+    return ok;
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("========================================\n");
+    printf("NUMA Placement Test\n");
+    printf("========================================\n");
+
+    printf("CPU lists:\n");
+    bool ok = test_cpulist();
+
+    printf("\nPlacement decision:\n");
+    ok &= test_placement();
+
+    printf("\nLocal allocation and pinning:\n");
+    ok &= test_local();
+
+    printf("\nWrapper:\n");
+    ok &= test_wrapper();
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
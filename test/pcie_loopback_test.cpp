@@ -8,6 +8,7 @@
  *   -b          Bidirectional test
  *   -n <count>  Number of iterations (default: 100)
  *   -t <ms>     Timeout in milliseconds (default: 1000)
+ *   -c          Conflated streaming (slow consumer)
  *   -v          Verbose output
  */
 
@@ -39,16 +40,25 @@ void print_usage(const char* prog) {
     printf("  -n <count>  Number of iterations (default: 100)\n");
     printf("  -t <ms>     Timeout in milliseconds (default: 1000)\n");
     printf("  -s          Streaming mode (continuous read)\n");
+    printf("  -c          Conflated streaming (slow consumer, drains every 100ms)\n");
     printf("  -v          Verbose output\n");
     printf("  -h          Show this help\n");
 }
 
 void print_bbo(const BBOData& bbo, bool verbose) {
-    printf("BBO: %s | Bid: $%.4f (%u) | Ask: $%.4f (%u) | Spread: $%.4f | Latency: %.3f μs\n",
-           bbo.get_symbol().c_str(),
-           bbo.get_bid_price(), bbo.get_bid_size(),
-           bbo.get_ask_price(), bbo.get_ask_size(),
-           bbo.get_spread(),
+    SymbolKey symbol = bbo.get_symbol_key();
+    std::string_view sym = symbol.view();
+
+    char bid[24], ask[24], spread[24];
+    bbo.get_bid_px().format(bid, sizeof(bid));
+    bbo.get_ask_px().format(ask, sizeof(ask));
+    bbo.get_spread_px().format(spread, sizeof(spread));
+
+    printf("BBO: %.*s | Bid: $%s (%u) | Ask: $%s (%u) | Spread: $%s | Latency: %.3f μs\n",
+           static_cast<int>(sym.size()), sym.data(),
+           bid, bbo.get_bid_size(),
+           ask, bbo.get_ask_size(),
+           spread,
            bbo.get_fpga_latency_us());
 
     if (verbose) {
@@ -95,18 +105,20 @@ int test_read_bbo(XDMAWrapper& xdma, int count, int timeout_ms, bool verbose) {
     }
 
     auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    double seconds = std::chrono::duration<double>(end - start).count();
 
     printf("\n=== Results ===\n");
     printf("Success: %d | Timeout: %d | Failed: %d\n", success, timeout, failed);
-    printf("Duration: %ld ms\n", duration);
+    printf("Duration: %.3f ms\n", seconds * 1e3);
 
     if (success > 0) {
         auto stats = xdma.get_stats();
         printf("Latency: avg=%.3f μs, min=%.3f μs, max=%.3f μs\n",
                stats.avg_latency_us, stats.min_latency_us, stats.max_latency_us);
-        printf("Throughput: %.2f KB/s\n",
-               static_cast<double>(stats.bytes_transferred) / duration);
+        if (seconds > 0) {
+            printf("Throughput: %.0f BBOs/sec, %.3f MB/s\n", success / seconds,
+                   static_cast<double>(stats.bytes_transferred) / 1e6 / seconds);
+        }
     }
 
     return (failed == 0) ? 0 : 1;
@@ -145,13 +157,15 @@ int test_write_loopback(XDMAWrapper& xdma, int count, bool verbose) {
     }
 
     auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    double seconds = std::chrono::duration<double>(end - start).count();
 
     printf("\n=== Results ===\n");
     printf("Success: %d | Failed: %d\n", success, failed);
-    printf("Duration: %ld ms\n", duration);
-    printf("Throughput: %.2f MB/s\n",
-           static_cast<double>(success * sizeof(pattern)) / 1024.0 / duration);
+    printf("Duration: %.3f ms\n", seconds * 1e3);
+    if (seconds > 0) {
+        printf("Throughput: %.3f MB/s\n",
+               static_cast<double>(success) * sizeof(pattern) / 1e6 / seconds);
+    }
 
     return (failed == 0) ? 0 : 1;
 }
@@ -180,20 +194,76 @@ int test_streaming(XDMAWrapper& xdma, bool verbose) {
     xdma.stop_streaming();
 
     auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
+    double seconds = std::chrono::duration<double>(end - start).count();
 
     printf("\n=== Results ===\n");
     printf("Total BBOs received: %lu\n", count);
-    printf("Duration: %ld seconds\n", duration);
-    if (duration > 0) {
+    printf("Duration: %.3f seconds\n", seconds);
+    if (seconds > 0) {
         printf("Average rate: %.2f BBOs/sec\n",
-               static_cast<double>(count) / duration);
+               static_cast<double>(count) / seconds);
     }
 
     auto stats = xdma.get_stats();
     printf("Latency: avg=%.3f μs, min=%.3f μs, max=%.3f μs\n",
            stats.avg_latency_us, stats.min_latency_us, stats.max_latency_us);
 
+    // Top of book per symbol, straight from the library cache
+    if (const BBOCache* cache = xdma.get_cache()) {
+        printf("Symbols cached: %zu\n", cache->size());
+        for (uint32_t slot = 0; slot < cache->size() && slot < 10; slot++) {
+            BBOQuote q;
+            cache->read_slot(slot, q);
+            std::string_view sym = q.symbol.view();
+            char bid[24], ask[24];
+            q.get_bid_px().format(bid, sizeof(bid));
+            q.get_ask_px().format(ask, sizeof(ask));
+            printf("  %-8.*s %12s x %-8u %12s x %-8u (%lu updates)\n",
+                   static_cast<int>(sym.size()), sym.data(),
+                   bid, q.bid_size, ask, q.ask_size, q.updates);
+        }
+    }
+
+    return 0;
+}
+
+int test_conflated(XDMAWrapper& xdma, bool verbose) {
+    printf("\n=== Conflated Streaming Test ===\n");
+    printf("Draining every 100ms, press Ctrl+C to stop...\n\n");
+
+    PCIeError err = xdma.start_conflated_streaming();
+    if (err != PCIeError::SUCCESS) {
+        printf("ERROR: %s\n", pcie_error_string(err));
+        return 1;
+    }
+
+    std::vector<BBOData> bbos;
+    uint64_t drains = 0;
+
+    while (running && xdma.is_streaming()) {
+        usleep(100000);  // Deliberately slow consumer
+        size_t n = xdma.drain_conflated(bbos, SIZE_MAX);
+        drains++;
+        if (verbose || drains <= 5) {
+            printf("[drain %lu] %zu symbols\n", drains, n);
+            for (size_t i = 0; i < n && i < 3; i++) {
+                printf("  ");
+                print_bbo(bbos[i], false);
+            }
+        }
+    }
+
+    xdma.stop_streaming();
+
+    ConflationStats stats = xdma.get_conflation_stats();
+    printf("\n=== Results ===\n");
+    printf("Published: %lu | Delivered: %lu | Conflated: %lu | Rejected: %lu\n",
+           stats.published, stats.delivered, stats.conflated, stats.rejected);
+    if (stats.published > 0) {
+        printf("Conflation ratio: %.1f%%\n",
+               100.0 * static_cast<double>(stats.conflated) / stats.published);
+    }
+
     return 0;
 }
 
@@ -222,11 +292,19 @@ int test_registers(XDMAWrapper& xdma, bool verbose) {
     xdma.set_enabled(false);
     printf("  Disabled: %s\n", !xdma.get_enabled() ? "Yes" : "No");
 
+    // Test reset sequence
+    printf("\nTesting reset sequence...\n");
+    ResetReport rr = xdma.reset_async().get();
+    printf("  Reset: %s | Core up: %.1f μs | Blackout: %.1f μs | Drained: %lu records\n",
+           pcie_error_string(rr.error), rr.reset_us, rr.blackout_us, rr.drained_records);
+
     // Test symbol filter
     printf("\nTesting symbol filter...\n");
-    xdma.set_symbol_filter(0, "AAPL");
+    constexpr SymbolKey AAPL("AAPL");
+    xdma.set_symbol_filter(0, AAPL);
     std::string filter = xdma.get_symbol_filter(0);
-    printf("  Filter 0: '%s' (expected 'AAPL')\n", filter.c_str());
+    printf("  Filter 0: '%s' (expected 'AAPL')%s\n", filter.c_str(),
+           xdma.get_symbol_filter_key(0) == AAPL ? "" : " MISMATCH");
 
     // Test latency registers
     printf("\nLatency registers:\n");
@@ -242,18 +320,20 @@ int main(int argc, char* argv[]) {
     bool write_mode = false;
     bool bidirectional = false;
     bool streaming = false;
+    bool conflated = false;
     bool verbose = false;
     int count = 100;
     int timeout_ms = 1000;
 
     // Parse options
     int opt;
-    while ((opt = getopt(argc, argv, "rwbsn:t:vh")) != -1) {
+    while ((opt = getopt(argc, argv, "rwbscn:t:vh")) != -1) {
         switch (opt) {
             case 'r': read_mode = true; break;
             case 'w': write_mode = true; break;
             case 'b': bidirectional = true; break;
             case 's': streaming = true; break;
+            case 'c': conflated = true; break;
             case 'n': count = atoi(optarg); break;
             case 't': timeout_ms = atoi(optarg); break;
             case 'v': verbose = true; break;
@@ -265,7 +345,7 @@ int main(int argc, char* argv[]) {
     }
 
     // Default to read mode if nothing specified
-    if (!read_mode && !write_mode && !bidirectional && !streaming) {
+    if (!read_mode && !write_mode && !bidirectional && !streaming && !conflated) {
         read_mode = true;
     }
 
@@ -274,11 +354,12 @@ int main(int argc, char* argv[]) {
     signal(SIGTERM, signal_handler);
 
     printf("=== PCIe Loopback Test ===\n");
-    printf("Mode: %s%s%s%s\n",
+    printf("Mode: %s%s%s%s%s\n",
            read_mode ? "Read " : "",
            write_mode ? "Write " : "",
            bidirectional ? "Bidirectional " : "",
-           streaming ? "Streaming " : "");
+           streaming ? "Streaming " : "",
+           conflated ? "Conflated " : "");
 
     // Check if driver is loaded
     if (!XDMADeviceDiscovery::is_driver_loaded()) {
@@ -300,8 +381,15 @@ int main(int argc, char* argv[]) {
 
     printf("\nFound %zu XDMA device(s):\n", devices.size());
     for (const auto& dev : devices) {
-        printf("  %s (VID:0x%04X DID:0x%04X)\n",
-               dev.device_path.c_str(), dev.vendor_id, dev.device_id);
+        printf("  %s (VID:0x%04X DID:0x%04X) %s\n",
+               dev.device_path.empty() ? "(no driver nodes)" : dev.device_path.c_str(),
+               dev.vendor_id, dev.device_id, dev.pci_slot.c_str());
+        if (dev.pci_slot.empty()) continue;
+        printf("    Link: %s x%u Gen%u (max x%u Gen%u)%s, NUMA node %d, CPUs %s\n",
+               dev.link_up ? "UP" : "DOWN", dev.link_width, dev.link_speed,
+               dev.max_link_width, dev.max_link_speed,
+               dev.link_degraded() ? " DEGRADED" : "",
+               dev.numa_node, dev.local_cpus.empty() ? "?" : dev.local_cpus.c_str());
     }
 
     // Open XDMA device
@@ -333,6 +421,10 @@ int main(int argc, char* argv[]) {
         result |= test_streaming(xdma, verbose);
     }
 
+    if (running && conflated) {
+        result |= test_conflated(xdma, verbose);
+    }
+
     xdma.close();
 
     printf("\n=== Test %s ===\n", (result == 0) ? "PASSED" : "FAILED");
@@ -0,0 +1,105 @@
+/**
+ * Price4 Test
+ * Fixed-point formatting (sign, padding of the fraction, INT64_MIN,
+ * truncation to the buffer), from_double() rounding including negative
+ * values, decimal halves and out-of-range input, and mid().
+ */
+
+#include "price4.h"
+#include "bench_util.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+
+using namespace pcie;
+using bench::check;
+
+static bool test_format() {
+    bool ok = true;
+    ok &= check(Price4::from_parts(150, 2500).to_string() == "150.2500", "150.2500");
+    ok &= check(Price4::from_raw(0).to_string() == "0.0000", "zero");
+    ok &= check(Price4::from_raw(1).to_string() == "0.0001", "one tick");
+    ok &= check(Price4::from_raw(-1).to_string() == "-0.0001", "minus one tick");
+    ok &= check(Price4::from_raw(-1234500).to_string() == "-123.4500", "negative price");
+    ok &= check(Price4::from_raw(10000).to_string() == "1.0000", "whole dollar");
+    ok &= check(Price4::from_raw(std::numeric_limits<int64_t>::min()).to_string() == "-922337203685477.5808",
+                "INT64_MIN");
+    ok &= check(Price4::from_raw(std::numeric_limits<int64_t>::max()).to_string() == "922337203685477.5807",
+                "INT64_MAX");
+
+    // format() truncates to the buffer and always terminates
+    char buf[8];
+    std::memset(buf, 'x', sizeof(buf));
+    size_t n = Price4::from_parts(150, 2500).format(buf, 5);
+    ok &= check(n == 4 && std::strcmp(buf, "150.") == 0, "truncated to the buffer");
+    n = Price4::from_parts(150, 2500).format(buf, 1);
+    ok &= check(n == 0 && buf[0] == '\0', "one-byte buffer: terminator only");
+    ok &= check(Price4::from_parts(150, 2500).format(buf, 0) == 0, "zero-length buffer untouched");
+    return ok;
+}
+
+static bool test_from_double() {
+    bool ok = true;
+    ok &= check(Price4::from_double(150.25).raw() == 1502500, "exact price");
+    ok &= check(Price4::from_double(-150.25).raw() == -1502500, "exact negative price");
+    ok &= check(Price4::from_double(0.00004).raw() == 0 && Price4::from_double(0.00006).raw() == 1,
+                "below / above half a tick");
+    ok &= check(Price4::from_double(-0.00004).raw() == 0 && Price4::from_double(-0.00006).raw() == -1,
+                "negative below / above half a tick");
+
+    // Decimal halves round away from zero, including those whose product
+    // lands just short of .5 in binary (0.00015 -> 1.4999999999999998)
+    ok &= check(Price4::from_double(0.00005).raw() == 1 && Price4::from_double(-0.00005).raw() == -1,
+                "half a tick away from zero");
+    ok &= check(Price4::from_double(0.00015).raw() == 2 && Price4::from_double(0.00025).raw() == 3,
+                "0.00015 -> 2, 0.00025 -> 3");
+    ok &= check(Price4::from_double(150.00005).raw() == 1500001 &&
+                    Price4::from_double(-150.00005).raw() == -1500001,
+                "150.00005 -> +/-1500001");
+    ok &= check(Price4::from_double(100.12345).raw() == 1001235, "100.12345 -> 1001235");
+
+    // Round trip through to_double() for every tick of a few dollars
+    bool round_trip = true;
+    for (int64_t raw = -50000; raw <= 50000; raw++) {
+        round_trip &= Price4::from_double(Price4::from_raw(raw).to_double()).raw() == raw;
+    }
+    ok &= check(round_trip, "to_double() -> from_double() round trip");
+
+    ok &= check(Price4::from_double(1e300).raw() == std::numeric_limits<int64_t>::max() &&
+                    Price4::from_double(-1e300).raw() == std::numeric_limits<int64_t>::min(),
+                "out of range saturates");
+    ok &= check(Price4::from_double(std::nan("")).raw() == 0, "NaN -> 0");
+    return ok;
+}
+
+static bool test_mid() {
+    bool ok = true;
+    ok &= check(Price4::mid(Price4::from_raw(1500000), Price4::from_raw(1500100)).raw() == 1500050, "even spread");
+    ok &= check(Price4::mid(Price4::from_raw(1500000), Price4::from_raw(1500001)).raw() == 1500000,
+                "odd spread truncates");
+    ok &= check(Price4::mid(Price4::from_raw(-3), Price4::from_raw(0)).raw() == -1, "negative truncates toward zero");
+    ok &= check(Price4::mid(Price4::from_raw(0xFFFFFFFF), Price4::from_raw(0xFFFFFFFF)).raw() == 0xFFFFFFFF,
+                "32-bit wire prices do not overflow");
+    return ok;
+}
+
+int main() {
+    printf("========================================\n");
+    printf("Price4 Test\n");
+    printf("========================================\n");
+
+    printf("Formatting:\n");
+    bool ok = test_format();
+
+    printf("\nfrom_double():\n");
+    ok &= test_from_double();
+
+    printf("\nmid():\n");
+    ok &= test_mid();
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
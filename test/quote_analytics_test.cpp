@@ -0,0 +1,165 @@
+/**
+ * Quote Analytics Test
+ * Checks the fixed-point derived values against hand-worked cases and a
+ * double-precision reference, the per-symbol EWMAs, and delivery through
+ * XDMAWrapper::start_analytics_streaming() on a mock device.
+ * Needs no hardware.
+ */
+
+#include "quote_analytics.h"
+#include "xdma_wrapper.h"
+#include "mock_device.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <signal.h>
+
+using namespace pcie;
+using bench::check;
+using bench::make_record;
+
+static bool test_derive() {
+    bool ok = true;
+    DerivedQuote q;
+
+    // 150.0000 x 100 / 150.1000 x 300
+    QuoteAnalytics::derive(SymbolKey("AAPL"), 1500000, 100, 1501000, 300, q);
+    ok &= check(q.two_sided && q.mid.raw() == 1500500 && q.microprice.raw() == 1500250 &&
+                q.spread_cbps == 666 && q.imbalance == -5000,
+                "hand-worked quote");
+
+    // One-sided: only imbalance is meaningful
+    QuoteAnalytics::derive(SymbolKey("AAPL"), 0, 0, 1501000, 300, q);
+    ok &= check(!q.two_sided && q.mid.raw() == 0 && q.microprice.raw() == 0 &&
+                q.spread_cbps == 0 && q.imbalance == -10000,
+                "one-sided quote");
+
+    // No size on either side: microprice falls back to mid
+    QuoteAnalytics::derive(SymbolKey("AAPL"), 1500000, 0, 1500100, 0, q);
+    ok &= check(q.microprice == q.mid && q.imbalance == 0, "zero sizes");
+
+    // Crossed book: negative spread
+    QuoteAnalytics::derive(SymbolKey("AAPL"), 1500100, 10, 1500000, 10, q);
+    ok &= check(q.spread_cbps < 0, "crossed book spread negative");
+
+    // Against doubles: integer results are the truncated exact values
+    std::mt19937 rng(99);
+    bool match = true;
+    for (int i = 0; i < 100000 && match; i++) {
+        uint32_t bid = 1 + rng() % 50000000;
+        uint32_t ask = bid + rng() % 100000;
+        uint32_t bid_size = rng() % 1000000;
+        uint32_t ask_size = rng() % 1000000;
+        QuoteAnalytics::derive(SymbolKey("X"), bid, bid_size, ask, ask_size, q);
+
+        double mid = std::trunc((static_cast<double>(bid) + ask) / 2.0);
+        double total = static_cast<double>(bid_size) + ask_size;
+        double micro = total > 0 ? std::floor((static_cast<double>(bid) * ask_size +
+                                               static_cast<double>(ask) * bid_size) / total)
+                                 : mid;
+        double cbps = mid > 0 ? std::trunc((static_cast<double>(ask) - bid) * 1e6 / mid) : 0;
+        double imb = total > 0 ? std::trunc((static_cast<double>(bid_size) - ask_size) * 1e4 / total) : 0;
+
+        // Doubles may land a hair either side of an integer boundary
+        match = std::fabs(q.mid.raw() - mid) <= 1 && std::fabs(q.microprice.raw() - micro) <= 1 &&
+                std::fabs(q.spread_cbps - cbps) <= 1 && std::fabs(q.imbalance - imb) <= 1;
+        if (!match) {
+            printf("  bid %u x %u ask %u x %u: mid %ld micro %ld cbps %d imb %d\n",
+                   bid, bid_size, ask, ask_size, q.mid.raw(), q.microprice.raw(),
+                   q.spread_cbps, q.imbalance);
+        }
+    }
+    ok &= check(match, "matches double reference");
+    return ok;
+}
+
+static bool test_ewma() {
+    bool ok = true;
+    QuoteAnalytics analytics;
+    DerivedQuote q;
+    uint64_t t = 1'000'000'000;
+
+    // Constant spread of 0.0100 every 1 ms
+    for (int i = 0; i < 100; i++, t += 1'000'000) {
+        analytics.update(make_record("AAPL", 1500000, 100, 1500100, 100), t, q);
+    }
+    ok &= check(q.ewma_spread.raw() == 100 && q.ewma_interval_ns == 1'000'000 &&
+                q.quote_rate_x100 == 100000 && q.updates == 100,
+                "steady spread and 1 kHz rate");
+
+    // Step to 0.0500: EWMA moves toward it and converges
+    analytics.update(make_record("AAPL", 1500000, 100, 1500500, 100), t, q);
+    int64_t first_step = q.ewma_spread.raw();
+    for (int i = 0; i < 300; i++) {
+        t += 1'000'000;
+        analytics.update(make_record("AAPL", 1500000, 100, 1500500, 100), t, q);
+    }
+    ok &= check(first_step == 125 && q.ewma_spread.raw() >= 499 && q.ewma_spread.raw() <= 500,
+                "spread step converges (alpha 1/16)");
+
+    // Symbols keep separate state; one-sided updates skip the spread EWMA
+    analytics.update(make_record("MSFT", 4000000, 10, 4001000, 10), t, q);
+    analytics.update(make_record("MSFT", 0, 0, 4002000, 10), t + 500'000, q);
+    ok &= check(q.ewma_spread.raw() == 1000 && q.ewma_interval_ns == 500'000 && q.updates == 2,
+                "per-symbol state, one-sided skips spread");
+    ok &= check(analytics.size() == 2, "two symbols tracked");
+    return ok;
+}
+
+static bool test_streaming() {
+    MockDevice mock;
+    XDMAWrapper xdma;
+    if (!mock.create() || xdma.open(mock.config()) != PCIeError::SUCCESS) {
+        return check(false, "mock device opened");
+    }
+
+    std::atomic<uint64_t> delivered{0}, mismatched{0};
+    std::atomic<uint32_t> last_rate{0};
+    xdma.start_analytics_streaming([&](const BBOData& bbo, const DerivedQuote& q) {
+        DerivedQuote ref;
+        QuoteAnalytics::derive(bbo.get_symbol_key(), __builtin_bswap32(bbo.bid_price),
+                               bbo.get_bid_size(), __builtin_bswap32(bbo.ask_price),
+                               bbo.get_ask_size(), ref);
+        if (q.symbol != bbo.get_symbol_key() || q.mid != ref.mid ||
+            q.microprice != ref.microprice || q.spread_cbps != ref.spread_cbps) {
+            mismatched++;
+        }
+        last_rate = q.quote_rate_x100;
+        delivered++;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    xdma.stop_streaming();
+    xdma.close();
+    mock.destroy();
+
+    printf("  %lu quotes delivered, last rate %.0f/s\n",
+           delivered.load(), last_rate.load() / 100.0);
+    return check(delivered > 0 && mismatched == 0 && last_rate > 0,
+                 "start_analytics_streaming() delivers quotes");
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("========================================\n");
+    printf("Quote Analytics Test\n");
+    printf("========================================\n");
+
+    printf("Derived values:\n");
+    bool ok = test_derive();
+
+    printf("\nEWMAs:\n");
+    ok &= test_ewma();
+
+    printf("\nStreaming:\n");
+    ok &= test_streaming();
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
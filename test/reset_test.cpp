@@ -0,0 +1,141 @@
+/**
+ * Reset Sequence Test
+ * Runs reset() and reset_async() against a mock device whose C2H never
+ * runs dry: pause, bounded drain, CTRL_RESET pulse, filter and enable
+ * restore, resume. Checks the report, the registers left behind, that
+ * records stay aligned after resume, and that reset() from the streaming
+ * callback is refused with BUSY.
+ * Needs no hardware.
+ */
+
+#include "xdma_wrapper.h"
+#include "mock_device.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <signal.h>
+
+using namespace pcie;
+using bench::check;
+
+// Mock records are MOCKAAPL with bids 1500000..1500112
+static bool aligned(const BBOData& bbo) {
+    uint32_t bid = __builtin_bswap32(bbo.bid_price);
+    return std::memcmp(bbo.symbol, "MOCKAAPL", 8) == 0 && bid >= 1500000 && bid < 1500113 &&
+           __builtin_bswap32(bbo.ask_price) == bid + 100;
+}
+
+static bool check_registers(XDMAWrapper& xdma) {
+    bool ok = true;
+    uint32_t ctrl = xdma.read_register(ControlRegisters::CONTROL_OFFSET);
+    ok &= check(ctrl == ControlRegisters::CTRL_ENABLE, "CONTROL back to ENABLE, RESET clear");
+    ok &= check(xdma.get_symbol_filter(0) == "AAPL" && xdma.get_symbol_filter(3) == "MSFT",
+                "symbol filters restored");
+    return ok;
+}
+
+static bool test_idle(XDMAWrapper& xdma) {
+    bool ok = true;
+
+    // Nothing reads C2H while idle, so the mock fills the FIFO
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto t0 = std::chrono::steady_clock::now();
+    ResetReport report = xdma.reset_async(2000).get();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    printf("  drained %lu bytes in %.2f ms\n", static_cast<unsigned long>(report.drained_bytes), ms);
+
+    ok &= check(report.error == PCIeError::SUCCESS && !report.was_streaming, "idle reset succeeds");
+    ok &= check(report.drained_bytes > 0 && report.drained_bytes % sizeof(BBOData) == 0,
+                "drain ends on a record boundary");
+    ok &= check(report.drained_bytes <= 256 * 1024 + 4096, "drain bounded on an endless feed");
+    ok &= check(ms < 1000.0, "no wait for the deadline");
+    ok &= check_registers(xdma);
+    ok &= check(xdma.get_last_reset_report().drained_bytes == report.drained_bytes,
+                "last report kept");
+    return ok;
+}
+
+static bool test_streaming(XDMAWrapper& xdma) {
+    bool ok = true;
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> misaligned{0};
+    ok &= check(xdma.start_streaming([&](const BBOData& bbo) {
+                    received++;
+                    if (!aligned(bbo)) misaligned++;
+                }) == PCIeError::SUCCESS,
+                "streaming started");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    ResetReport report = xdma.reset_async(2000).get();
+    printf("  blackout %.1f us, reset %.1f us, drained %lu records, %u polls\n",
+           report.blackout_us, report.reset_us,
+           static_cast<unsigned long>(report.drained_records), report.status_polls);
+
+    ok &= check(report.error == PCIeError::SUCCESS, "reset while streaming succeeds");
+    ok &= check(report.was_streaming, "stream paused and resumed");
+    ok &= check(report.running_confirmed, "STATUS_RUNNING confirmed");
+    ok &= check(report.drained_bytes <= 256 * 1024 + 4096, "drain bounded on an endless feed");
+    ok &= check(report.blackout_us < 1000000.0, "blackout well under the deadline");
+    ok &= check_registers(xdma);
+
+    uint64_t before = received;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ok &= check(received > before && xdma.is_streaming(), "dispatch resumes after reset");
+    xdma.stop_streaming();
+    ok &= check(misaligned == 0, "records aligned across the reset");
+    return ok;
+}
+
+static bool test_busy(XDMAWrapper& xdma) {
+    bool ok = true;
+    std::atomic<int> calls{0};
+    std::atomic<PCIeError> result{PCIeError::SUCCESS};
+    xdma.start_streaming([&](const BBOData&) {
+        if (calls++ == 0) result = xdma.reset();
+    });
+    for (int i = 0; i < 200 && calls == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    xdma.stop_streaming();
+
+    ok &= check(calls > 1 && result == PCIeError::BUSY, "reset() from the callback is BUSY");
+    ok &= check(xdma.reset() == PCIeError::SUCCESS, "reset() from another thread succeeds");
+    return ok;
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);  // Mock writer outlives the wrapper's reader
+
+    printf("========================================\n");
+    printf("Reset Sequence Test\n");
+    printf("========================================\n");
+
+    MockDevice mock;
+    if (!mock.create()) return 1;
+    XDMAWrapper xdma;
+    bool ok = check(xdma.open(mock.config()) == PCIeError::SUCCESS, "mock device opened");
+    if (ok) {
+        xdma.set_enabled(true);
+        xdma.set_symbol_filter(0, "AAPL");
+        xdma.set_symbol_filter(3, "MSFT");
+
+        printf("\nIdle reset:\n");
+        ok &= test_idle(xdma);
+
+        printf("\nReset while streaming:\n");
+        ok &= test_streaming(xdma);
+
+        printf("\nReset from the streaming thread:\n");
+        ok &= test_busy(xdma);
+    }
+    xdma.close();
+    mock.destroy();
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/**
+ * Sharded Dispatch Scaling Benchmark
+ * Feeds a synthetic BBO stream through ShardedDispatcher with 1, 2, 4, 8
+ * and 16 workers and reports throughput, speedup over one worker and how
+ * evenly the symbols loaded the workers. The handler burns a fixed amount
+ * of CPU per record to stand in for a heavy consumer.
+ *
+ * Symbols are drawn uniformly, or with -z from a skewed distribution
+ * where a few symbols carry most of the updates (the case sharding cannot
+ * spread: one symbol never uses more than one worker).
+ *
+ * Usage: ./sharded_dispatch_bench [options]
+ *   -n <count>  Records per run (default: 2000000)
+ *   -s <count>  Distinct symbols (default: 1000)
+ *   -w <iters>  Handler work per record, loop iterations (default: 200)
+ *   -z          Skewed symbol distribution
+ *   -h          Show this help
+ */
+
+#include "sharded_dispatch.h"
+#include "bench_util.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <getopt.h>
+
+using namespace pcie;
+
+// Stand-in for handler work that does not vectorise away
+static uint64_t burn(uint64_t seed, int iters) {
+    uint64_t x = seed | 1;
+    for (int i = 0; i < iters; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    return x;
+}
+
+static std::vector<BBORecord> make_stream(size_t records, uint32_t symbols, bool skewed) {
+    std::vector<SymbolKey> keys(symbols);
+    for (uint32_t i = 0; i < symbols; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "SYM%05u", i % 100000);
+        keys[i] = SymbolKey(name);
+    }
+
+    // Skewed: weight 1/rank (Zipf, s = 1), sampled by inverting the CDF
+    std::vector<double> cdf;
+    if (skewed) {
+        double total = 0.0;
+        for (uint32_t i = 0; i < symbols; i++) {
+            total += 1.0 / (i + 1);
+            cdf.push_back(total);
+        }
+        for (double& c : cdf) c /= total;
+    }
+
+    std::vector<BBORecord> stream(records);
+    uint64_t x = 88172645463325252ULL;
+    for (size_t i = 0; i < records; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        uint32_t id;
+        if (skewed) {
+            double u = static_cast<double>(x >> 11) * (1.0 / 9007199254740992.0);
+            id = static_cast<uint32_t>(std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+            if (id >= symbols) id = symbols - 1;
+        } else {
+            id = static_cast<uint32_t>(x % symbols);
+        }
+        BBORecord& rec = stream[i];
+        rec = BBORecord{};
+        rec.symbol = keys[id];
+        rec.bid_price = 1000000 + static_cast<uint32_t>(x & 0xFFF);
+        rec.ask_price = rec.bid_price + 100;
+        rec.ts_t4 = static_cast<uint32_t>(i);
+    }
+    return stream;
+}
+
+int main(int argc, char** argv) {
+    size_t records = 2'000'000;
+    uint32_t symbols = 1000;
+    int work = 200;
+    bool skewed = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:w:zh")) != -1) {
+        switch (opt) {
+            case 'n': records = strtoull(optarg, nullptr, 10); break;
+            case 's': symbols = static_cast<uint32_t>(std::max(1, atoi(optarg))); break;
+            case 'w': work = atoi(optarg); break;
+            case 'z': skewed = true; break;
+            case 'h':
+            default:
+                printf("Usage: %s [-n records] [-s symbols] [-w work_iters] [-z]\n", argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    printf("========================================\n");
+    printf("Sharded Dispatch Scaling Benchmark\n");
+    printf("========================================\n");
+    printf("%zu records, %u symbols (%s), %d work iterations, %u hardware threads\n\n",
+           records, symbols, skewed ? "skewed" : "uniform", work,
+           std::thread::hardware_concurrency());
+
+    std::vector<BBORecord> stream = make_stream(records, symbols, skewed);
+
+    // Handler cost alone, on this thread
+    uint64_t sink = 0;
+    uint64_t t0 = bench::now_ns();
+    for (size_t i = 0; i < std::min<size_t>(records, 100000); i++) {
+        sink += burn(stream[i].bid_price, work);
+    }
+    uint64_t t1 = bench::now_ns();
+    bench::do_not_optimize(sink);
+    double handler_ns = static_cast<double>(t1 - t0) / std::min<size_t>(records, 100000);
+    printf("Handler alone: %.1f ns/record (%.2f M records/s on one core)\n\n",
+           handler_ns, 1000.0 / handler_ns);
+
+    printf("%8s %12s %12s %9s %12s %12s\n",
+           "workers", "time (ms)", "M rec/s", "speedup", "load max/avg", "producer waits");
+
+    double base_rate = 0.0;
+    for (uint32_t workers : {1u, 2u, 4u, 8u, 16u}) {
+        std::vector<uint64_t> sinks(workers * 8, 0);   // One cache line per worker
+        ShardedDispatchConfig config;
+        config.workers = workers;
+        ShardedDispatcher dispatch(config, [&](uint32_t worker, const BBORecord& rec) {
+            sinks[worker * 8] += burn(rec.bid_price, work);
+        });
+
+        uint64_t start = bench::now_ns();
+        for (const BBORecord& rec : stream) dispatch.submit(rec);
+        dispatch.flush();
+        uint64_t end = bench::now_ns();
+        dispatch.stop();
+
+        ShardedDispatchStats stats = dispatch.stats();
+        uint64_t max_load = 0, waits = 0;
+        for (const auto& w : stats.workers) {
+            max_load = std::max(max_load, w.records);
+            waits += w.ring_full;
+        }
+        double avg_load = static_cast<double>(records) / workers;
+        double ms = static_cast<double>(end - start) / 1e6;
+        double rate = static_cast<double>(records) / ms / 1000.0;
+        if (workers == 1) base_rate = rate;
+        printf("%8u %12.1f %12.2f %8.2fx %12.2f %12lu\n",
+               workers, ms, rate, rate / base_rate, max_load / avg_load, waits);
+        bench::do_not_optimize(sinks);
+    }
+    return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * Symbol Key Test
+ * Checks the properties every symbol table relies on: NUL and space
+ * padding give the same key, view()/size() trim correctly from empty to
+ * a full 8 characters, ordering matches string order, and the byte
+ * round trip through from_bytes()/to_bytes() is exact.
+ */
+
+#include "symbol_key.h"
+#include "bench_util.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pcie;
+using bench::check;
+
+static bool test_padding() {
+    bool ok = true;
+
+    const uint8_t spaces[8] = {'A', 'A', 'P', 'L', ' ', ' ', ' ', ' '};
+    const uint8_t nuls[8] = {'A', 'A', 'P', 'L', 0, 0, 0, 0};
+    SymbolKey a = SymbolKey::from_bytes(spaces);
+    SymbolKey b = SymbolKey::from_bytes(nuls);
+    ok &= check(a == b && a.hash() == b.hash(), "NUL and space padding equal, same hash");
+    ok &= check(a == SymbolKey("AAPL") && a.raw() == SymbolKey("AAPL    ").raw(),
+                "literal and padded literal equal");
+
+    // Mixed padding, as a 48-byte packet with stray spaces might carry
+    const uint8_t mixed[8] = {'S', 'P', 'Y', ' ', 0, ' ', 0, 0};
+    ok &= check(SymbolKey::from_bytes(mixed) == SymbolKey("SPY"), "mixed NUL/space padding");
+
+    ok &= check(SymbolKey("ABCDEFGHIJ") == SymbolKey("ABCDEFGH"), "truncated at 8 characters");
+    ok &= check(SymbolKey() == SymbolKey("") && SymbolKey().empty(), "default key is the empty key");
+    ok &= check(SymbolKey("AAPL") != SymbolKey("AAPM") && SymbolKey("A") != SymbolKey("AA"),
+                "different symbols differ");
+    return ok;
+}
+
+static bool test_view() {
+    bool ok = true;
+    bool sizes = true;
+    const char* names[] = {"", "A", "AB", "ABC", "ABCD", "ABCDE", "ABCDEF", "ABCDEFG", "ABCDEFGH"};
+    for (const char* name : names) {
+        SymbolKey key(name);
+        sizes &= key.size() == strlen(name) && key.view() == name;
+    }
+    ok &= check(sizes, "size()/view() for 0..8 characters");
+
+    SymbolKey empty;
+    ok &= check(empty.size() == 0 && empty.view().empty(), "empty key trims to nothing");
+
+    SymbolKey full("ZZZZZZZZ");
+    ok &= check(full.size() == 8 && full.view() == "ZZZZZZZZ" && !full.empty(), "8-character key untrimmed");
+
+    // Only trailing padding is trimmed
+    SymbolKey inner("BRK A");
+    ok &= check(inner.size() == 5 && inner.view() == "BRK A", "inner space kept");
+    return ok;
+}
+
+static bool test_order() {
+    bool ok = true;
+    std::mt19937 rng(7);
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789.";
+
+    std::vector<std::string> names;
+    for (int i = 0; i < 2000; i++) {
+        std::string s;
+        size_t len = 1 + rng() % 8;
+        for (size_t k = 0; k < len; k++) s += alphabet[rng() % (sizeof(alphabet) - 1)];
+        names.push_back(s);
+    }
+    // Prefixes and near neighbours, where padding decides the order
+    names.insert(names.end(), {"A", "AA", "AAA", "AAPL", "AAPL.", "AAPLA", "AB", "Z", "ZZZZZZZZ"});
+
+    bool pairwise = true;
+    for (size_t i = 0; i < names.size(); i++) {
+        const std::string& x = names[i];
+        const std::string& y = names[(i * 7919 + 1) % names.size()];
+        pairwise &= (SymbolKey(x) < SymbolKey(y)) == (x < y);
+    }
+    ok &= check(pairwise, "operator< matches string order");
+
+    std::vector<SymbolKey> keys;
+    for (const std::string& s : names) keys.emplace_back(s);
+    std::sort(names.begin(), names.end());
+    std::sort(keys.begin(), keys.end());
+    bool sorted = true;
+    for (size_t i = 0; i < names.size(); i++) sorted &= keys[i].view() == names[i];
+    ok &= check(sorted, "sorted keys match sorted strings");
+    return ok;
+}
+
+static bool test_bytes() {
+    bool ok = true;
+    bool round_trip = true;
+    const char* names[] = {"", "A", "MSFT", "GOOGL", "ABCDEFGH"};
+    for (const char* name : names) {
+        SymbolKey key(name);
+        uint8_t bytes[8];
+        key.to_bytes(bytes);
+        round_trip &= SymbolKey::from_bytes(bytes) == key;
+
+        // to_bytes() writes the space-padded wire image
+        char padded[9];
+        snprintf(padded, sizeof(padded), "%-8s", name);
+        round_trip &= std::memcmp(bytes, padded, 8) == 0;
+    }
+    ok &= check(round_trip, "to_bytes() -> from_bytes() round trip");
+
+    const uint8_t wire[8] = {'N', 'V', 'D', 'A', 0, 0, 0, 0};
+    uint8_t out[8];
+    SymbolKey::from_bytes(wire).to_bytes(out);
+    ok &= check(std::memcmp(out, "NVDA    ", 8) == 0, "NUL-padded input written back space-padded");
+    ok &= check(SymbolKey::from_raw(SymbolKey("IBM").raw()) == SymbolKey("IBM"), "from_raw(raw()) round trip");
+    return ok;
+}
+
+int main() {
+    printf("========================================\n");
+    printf("Symbol Key Test\n");
+    printf("========================================\n");
+
+    printf("Padding:\n");
+    bool ok = test_padding();
+
+    printf("\nTrimming:\n");
+    ok &= test_view();
+
+    printf("\nOrdering:\n");
+    ok &= test_order();
+
+    printf("\nByte round trip:\n");
+    ok &= test_bytes();
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -1,6 +1,7 @@
 /*
  * Test Pattern Verification Tool
- * Reads from XDMA C2H channel and verifies incrementing counter pattern
+ * Streams the XDMA C2H channel and verifies the incrementing counter
+ * pattern continuously, reporting sustained throughput
  *
  * Expected pattern: 64-bit little-endian incrementing counter
  *   Bytes: 00 00 00 00 00 00 00 00  (counter = 0)
@@ -8,121 +9,505 @@
  *          02 00 00 00 00 00 00 00  (counter = 2)
  *          ...
  *
- * Usage: ./test_pattern_verify [device] [count]
+ * The reader thread keeps read() in flight back to back, filling a ring of
+ * buffers (two by default: double-buffered); a checker thread verifies
+ * each filled buffer with SIMD compares (AVX2 when the CPU has it, else
+ * SSE2) while the next read runs. The check follows the counter from the
+ * first word read, so a stream that did not start at 0 still verifies;
+ * on a mismatch it reports the gap and resyncs to the value found.
+ *
+ * Sweep mode (-s) reads for -t seconds at each read size from 4 KB to
+ * 8 MB in turn and tabulates MB/s, to find the transfer size that gets
+ * the most out of the driver. A step whose reader spent much of its time
+ * waiting for the checker measured the checker, not the link; it is
+ * flagged.
+ *
+ * Any readable path works in place of the device (a file or FIFO holding
+ * the pattern); a regular file ends the run at end of file.
+ *
+ * Usage: ./test_pattern_verify [options] [device] [words]
  *   device: XDMA device path (default: /dev/xdma0_c2h_0)
- *   count: Number of 64-bit words to read and verify (default: 1024)
+ *   words: Number of 64-bit words to verify (same as -n words*8)
+ *   -b <size>   Bytes per read() (default: 1M)
+ *   -n <size>   Bytes to verify, 0 = until interrupted (default: 4G)
+ *   -k <count>  Buffers in the reader/checker ring, 2-8 (default: 2)
+ *   -i <sec>    Seconds between progress reports (default: 1)
+ *   -s          Sweep read sizes 4K-8M instead of a single run
+ *   -t <sec>    Seconds per sweep step (default: 2)
+ *   -h          Show this help
+ * Sizes take a K, M or G suffix (powers of 1024).
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdatomic.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <string.h>
-#include <sys/time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <getopt.h>
 #include <errno.h>
+#include <immintrin.h>
 
 #define DEFAULT_DEVICE "/dev/xdma0_c2h_0"
-#define DEFAULT_COUNT 1024
+#define DEFAULT_READ_SIZE (1UL << 20)
+#define DEFAULT_TOTAL (4ULL << 30)
+#define SWEEP_MIN (4UL << 10)
+#define SWEEP_MAX (8UL << 20)
+#define MAX_BUFFERS 8
+#define MAX_REPORTED_ERRORS 10
+
+struct slot {
+    uint8_t *buf;
+    size_t len;
+    atomic_int full;        // Set by the reader, cleared by the checker
+};
+
+struct ring {
+    struct slot slots[MAX_BUFFERS];
+    size_t count;
+    atomic_int done;        // Reader has filled its last slot
+};
+
+struct checker {
+    struct ring *ring;
+    uint64_t expected;      // Next counter value
+    uint64_t words;         // Words checked so far
+    int synced;             // Seen the first word
+    uint8_t carry[8];       // Word split across two reads
+    size_t carry_len;
+    atomic_uint_least64_t bytes_checked;
+    atomic_uint_least64_t discontinuities;
+    uint64_t first_value;
+};
+
+typedef size_t (*verify_fn)(const uint64_t *w, size_t n, uint64_t expected);
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    g_stop = 1;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Wait while a slot flag differs from want: spin briefly, then yield
+static int wait_flag(atomic_int *flag, int want, atomic_int *done) {
+    for (unsigned spin = 0; atomic_load_explicit(flag, memory_order_acquire) != want; spin++) {
+        if (done && atomic_load_explicit(done, memory_order_acquire) &&
+            atomic_load_explicit(flag, memory_order_acquire) != want) {
+            return 0;
+        }
+        if (g_stop && !done) return 0;
+        if (spin < 256) {
+            _mm_pause();
+        } else {
+            sched_yield();
+        }
+    }
+    return 1;
+}
+
+// Verify kernels: index of the first word that is not expected + index, n if none
+
+static size_t verify_scalar(const uint64_t *w, size_t n, uint64_t expected) {
+    for (size_t i = 0; i < n; i++) {
+        if (w[i] != expected + i) return i;
+    }
+    return n;
+}
+
+// SSE2 has no 64-bit compare: a word matches when both 32-bit halves do
+static size_t verify_sse2(const uint64_t *w, size_t n, uint64_t expected) {
+    __m128i exp = _mm_set_epi64x((long long)(expected + 1), (long long)expected);
+    const __m128i step = _mm_set1_epi64x(2);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(w + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(w + i + 2));
+        __m128i exp2 = _mm_add_epi64(exp, step);
+        __m128i eq = _mm_and_si128(_mm_cmpeq_epi32(a, exp), _mm_cmpeq_epi32(b, exp2));
+        if (_mm_movemask_epi8(eq) != 0xFFFF) break;
+        exp = _mm_add_epi64(exp2, step);
+    }
+    return i + verify_scalar(w + i, n - i, expected + i);
+}
+
+__attribute__((target("avx2")))
+static size_t verify_avx2(const uint64_t *w, size_t n, uint64_t expected) {
+    __m256i exp = _mm256_set_epi64x((long long)(expected + 3), (long long)(expected + 2),
+                                    (long long)(expected + 1), (long long)expected);
+    const __m256i step = _mm256_set1_epi64x(4);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(w + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(w + i + 4));
+        __m256i exp2 = _mm256_add_epi64(exp, step);
+        __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi64(a, exp), _mm256_cmpeq_epi64(b, exp2));
+        if (_mm256_movemask_epi8(eq) != -1) break;
+        exp = _mm256_add_epi64(exp2, step);
+    }
+    return i + verify_scalar(w + i, n - i, expected + i);
+}
+
+static verify_fn g_verify = verify_sse2;
+static const char *g_verify_name = "SSE2";
+
+// Words at w: report mismatches and follow the counter through them
+static void check_words(struct checker *c, const uint64_t *w, size_t n) {
+    if (n == 0) return;
+    if (!c->synced) {
+        c->synced = 1;
+        c->expected = w[0];
+        c->first_value = w[0];
+    }
+    while (n > 0) {
+        size_t ok = g_verify(w, n, c->expected);
+        if (ok == n) {
+            c->expected += n;
+            c->words += n;
+            return;
+        }
+        uint64_t got = w[ok];
+        uint64_t want = c->expected + ok;
+        uint64_t n_err = atomic_fetch_add(&c->discontinuities, 1) + 1;
+        if (n_err <= MAX_REPORTED_ERRORS) {
+            uint64_t at = c->words + ok;
+            if (got > want) {
+                printf("  Error at word %lu: expected 0x%016lx, got 0x%016lx (%lu words missing)\n",
+                       at, want, got, got - want);
+            } else {
+                printf("  Error at word %lu: expected 0x%016lx, got 0x%016lx\n", at, want, got);
+            }
+        }
+        // Resync to what the stream holds now
+        c->expected = got + 1;
+        c->words += ok + 1;
+        w += ok + 1;
+        n -= ok + 1;
+    }
+}
+
+static void check_buffer(struct checker *c, const uint8_t *buf, size_t len) {
+    size_t start = 0;
+    if (c->carry_len > 0) {
+        size_t need = 8 - c->carry_len;
+        if (len < need) {
+            memcpy(c->carry + c->carry_len, buf, len);
+            c->carry_len += len;
+            atomic_fetch_add(&c->bytes_checked, len);
+            return;
+        }
+        memcpy(c->carry + c->carry_len, buf, need);
+        uint64_t word;
+        memcpy(&word, c->carry, 8);
+        check_words(c, &word, 1);
+        c->carry_len = 0;
+        start = need;
+    }
+    size_t words = (len - start) / 8;
+    check_words(c, (const uint64_t *)(buf + start), words);
+    size_t rest = len - start - words * 8;
+    memcpy(c->carry, buf + start + words * 8, rest);
+    c->carry_len = rest;
+    atomic_fetch_add(&c->bytes_checked, len);
+}
+
+static void *checker_thread(void *arg) {
+    struct checker *c = arg;
+    struct ring *r = c->ring;
+    for (size_t next = 0;; next++) {
+        struct slot *s = &r->slots[next % r->count];
+        if (!wait_flag(&s->full, 1, &r->done)) break;
+        check_buffer(c, s->buf, s->len);
+        atomic_store_explicit(&s->full, 0, memory_order_release);
+    }
+    return NULL;
+}
+
+/*
+ * Reader side: back-to-back reads of read_size into the ring
+ */
+struct reader {
+    int fd;
+    struct ring *ring;
+    size_t next;            // Next slot to fill
+    uint64_t bytes;
+    uint64_t reads;
+    double wait_s;          // Time spent waiting for the checker to free a slot
+    int eof;
+    int failed;
+};
+
+// One read into the next free slot; returns bytes read, 0 at end, -1 on error
+static ssize_t read_one(struct reader *rd, size_t size) {
+    struct slot *s = &rd->ring->slots[rd->next % rd->ring->count];
+    if (atomic_load_explicit(&s->full, memory_order_acquire)) {
+        double t0 = now_s();
+        if (!wait_flag(&s->full, 0, NULL)) return 0;
+        rd->wait_s += now_s() - t0;
+    }
+
+    ssize_t n;
+    do {
+        n = read(rd->fd, s->buf, size);
+    } while (n < 0 && (errno == EINTR || errno == EAGAIN) && !g_stop);
+
+    if (n < 0) {
+        if (g_stop) return 0;
+        fprintf(stderr, "Read failed after %lu bytes: %s\n", rd->bytes, strerror(errno));
+        rd->failed = 1;
+        return -1;
+    }
+    if (n == 0) {
+        rd->eof = 1;
+        return 0;
+    }
+    s->len = (size_t)n;
+    atomic_store_explicit(&s->full, 1, memory_order_release);
+    rd->next++;
+    rd->bytes += (uint64_t)n;
+    rd->reads++;
+    return n;
+}
+
+static uint64_t parse_size(const char *text) {
+    char *end;
+    uint64_t v = strtoull(text, &end, 10);
+    switch (*end) {
+        case 'k': case 'K': v <<= 10; break;
+        case 'm': case 'M': v <<= 20; break;
+        case 'g': case 'G': v <<= 30; break;
+        default: break;
+    }
+    return v;
+}
+
+static void format_size(char *out, size_t len, uint64_t bytes) {
+    if (bytes >= (1UL << 20) && bytes % (1UL << 20) == 0) {
+        snprintf(out, len, "%luM", bytes >> 20);
+    } else if (bytes >= (1UL << 10) && bytes % (1UL << 10) == 0) {
+        snprintf(out, len, "%luK", bytes >> 10);
+    } else {
+        snprintf(out, len, "%lu", bytes);
+    }
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [options] [device] [words]\n", prog);
+    printf("  device: XDMA device path (default: %s)\n", DEFAULT_DEVICE);
+    printf("  words: Number of 64-bit words to verify (same as -n words*8)\n");
+    printf("  -b <size>   Bytes per read() (default: 1M)\n");
+    printf("  -n <size>   Bytes to verify, 0 = until interrupted (default: 4G)\n");
+    printf("  -k <count>  Buffers in the reader/checker ring, 2-8 (default: 2)\n");
+    printf("  -i <sec>    Seconds between progress reports (default: 1)\n");
+    printf("  -s          Sweep read sizes 4K-8M instead of a single run\n");
+    printf("  -t <sec>    Seconds per sweep step (default: 2)\n");
+    printf("Sizes take a K, M or G suffix (powers of 1024).\n");
+}
+
+// Single run: read_size until total bytes, end of stream or interrupt
+static void run_stream(struct reader *rd, struct checker *c, size_t read_size,
+                       uint64_t total, double interval) {
+    double start = now_s();
+    double last = start;
+    uint64_t last_bytes = 0;
+
+    while (!g_stop && (total == 0 || rd->bytes < total)) {
+        size_t size = read_size;
+        if (total != 0 && total - rd->bytes < size) size = (size_t)(total - rd->bytes);
+        if (read_one(rd, size) <= 0) break;
+
+        double now = now_s();
+        if (now - last >= interval) {
+            printf("[%7.1f s] %9.1f MB/s  (avg %9.1f MB/s)  read %8.2f GB  checked %8.2f GB  errors %lu\n",
+                   now - start, (rd->bytes - last_bytes) / 1e6 / (now - last),
+                   rd->bytes / 1e6 / (now - start), rd->bytes / 1e9,
+                   atomic_load(&c->bytes_checked) / 1e9,
+                   (unsigned long)atomic_load(&c->discontinuities));
+            last = now;
+            last_bytes = rd->bytes;
+        }
+    }
+
+    double elapsed = now_s() - start;
+    printf("\nRead %lu bytes in %.3f seconds (%.2f MB/s, %lu reads, %.1f%% waiting on the checker)\n",
+           rd->bytes, elapsed, elapsed > 0 ? rd->bytes / 1e6 / elapsed : 0.0, rd->reads,
+           elapsed > 0 ? 100.0 * rd->wait_s / elapsed : 0.0);
+}
+
+// Sweep: step_s seconds at each read size, one table row per size
+static void run_sweep(struct reader *rd, double step_s) {
+    double best_rate = 0.0;
+    size_t best_size = 0;
+    char name[24];
+
+    printf("%10s %12s %12s %12s %10s\n", "read size", "MB/s", "reads/s", "us/read", "waiting");
+    for (size_t size = SWEEP_MIN; size <= SWEEP_MAX && !g_stop && !rd->eof && !rd->failed; size <<= 1) {
+        uint64_t bytes0 = rd->bytes;
+        uint64_t reads0 = rd->reads;
+        double wait0 = rd->wait_s;
+        double start = now_s();
+        double elapsed = 0.0;
+        while (!g_stop && elapsed < step_s) {
+            if (read_one(rd, size) <= 0) break;
+            elapsed = now_s() - start;
+        }
+        elapsed = now_s() - start;
+        if (elapsed <= 0.0) break;
+
+        uint64_t reads = rd->reads - reads0;
+        double rate = (rd->bytes - bytes0) / 1e6 / elapsed;
+        double waiting = (rd->wait_s - wait0) / elapsed;
+        format_size(name, sizeof(name), size);
+        printf("%10s %12.1f %12.0f %12.2f %9.1f%%%s\n", name, rate, reads / elapsed,
+               reads ? elapsed * 1e6 / reads : 0.0, 100.0 * waiting,
+               waiting > 0.25 ? "  checker-bound" : "");
+        if (rate > best_rate) {
+            best_rate = rate;
+            best_size = size;
+        }
+    }
+    if (best_size) {
+        format_size(name, sizeof(name), best_size);
+        printf("\nBest read size: %s (%.1f MB/s)\n", name, best_rate);
+    }
+}
 
 int main(int argc, char **argv) {
     const char *device = DEFAULT_DEVICE;
-    uint64_t count = DEFAULT_COUNT;
+    size_t read_size = DEFAULT_READ_SIZE;
+    uint64_t total = DEFAULT_TOTAL;
+    size_t buffers = 2;
+    double interval = 1.0;
+    double step_s = 2.0;
+    int sweep = 0;
 
-    if (argc > 1) device = argv[1];
-    if (argc > 2) count = strtoull(argv[2], NULL, 10);
+    int o;
+    while ((o = getopt(argc, argv, "b:n:k:i:st:h")) != -1) {
+        switch (o) {
+            case 'b': read_size = parse_size(optarg); break;
+            case 'n': total = parse_size(optarg); break;
+            case 'k': buffers = strtoul(optarg, NULL, 10); break;
+            case 'i': interval = atof(optarg); break;
+            case 's': sweep = 1; break;
+            case 't': step_s = atof(optarg); break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return (o == 'h') ? 0 : 1;
+        }
+    }
+    if (optind < argc) device = argv[optind++];
+    if (optind < argc) total = strtoull(argv[optind++], NULL, 10) * sizeof(uint64_t);
+    if (read_size == 0) read_size = DEFAULT_READ_SIZE;
+    if (buffers < 2) buffers = 2;
+    if (buffers > MAX_BUFFERS) buffers = MAX_BUFFERS;
+    if (interval <= 0.0) interval = 1.0;
+
+    if (__builtin_cpu_supports("avx2")) {
+        g_verify = verify_avx2;
+        g_verify_name = "AVX2";
+    }
 
     printf("Test Pattern Verification\n");
     printf("==========================\n");
     printf("Device: %s\n", device);
-    printf("Words to read: %lu (%.2f KB)\n", count, count * 8.0 / 1024.0);
+    if (sweep) {
+        printf("Mode: read-size sweep, 4K-8M, %g s per size\n", step_s);
+    } else if (total) {
+        printf("Bytes to verify: %lu (%.2f GB), %zu per read\n", total, total / 1e9, read_size);
+    } else {
+        printf("Bytes to verify: until interrupted, %zu per read\n", read_size);
+    }
+    printf("Buffers: %zu | Check: %s\n", buffers, g_verify_name);
+    if (sysconf(_SC_NPROCESSORS_ONLN) < 2) {
+        printf("Warning: one CPU, so the reader and checker take turns and rates are CPU-bound\n");
+    }
     printf("\n");
 
-    // Open device
     int fd = open(device, O_RDONLY);
     if (fd < 0) {
         perror("Failed to open device");
         return 1;
     }
 
-    // Allocate buffer (aligned for DMA)
-    uint64_t *buf = aligned_alloc(4096, count * sizeof(uint64_t));
-    if (!buf) {
-        perror("Failed to allocate buffer");
-        close(fd);
-        return 1;
+    // Buffers aligned for DMA, each big enough for the largest read
+    size_t buf_size = sweep ? SWEEP_MAX : (read_size + 4095) & ~(size_t)4095;
+    struct ring ring;
+    memset(&ring, 0, sizeof(ring));
+    ring.count = buffers;
+    for (size_t i = 0; i < buffers; i++) {
+        ring.slots[i].buf = aligned_alloc(4096, buf_size);
+        if (!ring.slots[i].buf) {
+            perror("Failed to allocate buffer");
+            return 1;
+        }
+        // Fault the pages in now rather than inside the first reads
+        memset(ring.slots[i].buf, 0, buf_size);
     }
 
-    // Read data
-    printf("Reading data from FPGA...\n");
-    struct timeval start, end;
-    gettimeofday(&start, NULL);
-
-    ssize_t bytes_read = read(fd, buf, count * sizeof(uint64_t));
-
-    gettimeofday(&end, NULL);
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
 
-    if (bytes_read < 0) {
-        perror("Read failed");
-        free(buf);
-        close(fd);
+    struct checker checker;
+    memset(&checker, 0, sizeof(checker));
+    checker.ring = &ring;
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, checker_thread, &checker) != 0) {
+        fprintf(stderr, "Failed to start checker thread\n");
         return 1;
     }
 
-    double elapsed = (end.tv_sec - start.tv_sec) +
-                     (end.tv_usec - start.tv_usec) / 1000000.0;
-    double throughput = (bytes_read / 1024.0 / 1024.0) / elapsed;
-
-    printf("Read %zd bytes in %.3f seconds (%.2f MB/s)\n\n",
-           bytes_read, elapsed, throughput);
-
-    // Verify pattern
-    uint64_t words_read = bytes_read / sizeof(uint64_t);
-    uint64_t errors = 0;
-    uint64_t first_error_idx = 0;
-    uint64_t first_error_expected = 0;
-    uint64_t first_error_got = 0;
-
-    printf("Verifying incrementing counter pattern...\n");
+    struct reader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.fd = fd;
+    reader.ring = &ring;
 
-    for (uint64_t i = 0; i < words_read; i++) {
-        if (buf[i] != i) {
-            if (errors == 0) {
-                first_error_idx = i;
-                first_error_expected = i;
-                first_error_got = buf[i];
-            }
-            errors++;
-
-            // Print first 10 errors
-            if (errors <= 10) {
-                printf("  Error at word %lu: expected 0x%016lx, got 0x%016lx\n",
-                       i, i, buf[i]);
-            }
-        }
+    if (sweep) {
+        run_sweep(&reader, step_s);
+    } else {
+        run_stream(&reader, &checker, read_size, total, interval);
     }
 
+    atomic_store_explicit(&ring.done, 1, memory_order_release);
+    pthread_join(tid, NULL);
+    close(fd);
+    for (size_t i = 0; i < buffers; i++) free(ring.slots[i].buf);
+
+    uint64_t checked = atomic_load(&checker.bytes_checked);
+    uint64_t errors = atomic_load(&checker.discontinuities);
     printf("\n");
     printf("Results:\n");
     printf("========\n");
-    printf("Words verified: %lu\n", words_read);
+    printf("Words verified: %lu\n", checked / 8);
+    if (checked >= 8) {
+        printf("Counter: 0x%016lx .. 0x%016lx\n", checker.first_value, checker.expected - 1);
+    }
+    if (checker.carry_len) printf("Trailing bytes not checked: %zu\n", checker.carry_len);
     printf("Errors: %lu\n", errors);
 
+    if (reader.failed || checked < 8) {
+        printf("Status: FAIL ✗ - %s\n", reader.failed ? "read error" : "no data read");
+        return 1;
+    }
     if (errors == 0) {
         printf("Status: PASS ✓ - Pattern is correct!\n");
-        printf("\nFirst 16 values:\n");
-        for (int i = 0; i < 16 && i < words_read; i++) {
-            printf("  [%2d] = %lu (0x%016lx)\n", i, buf[i], buf[i]);
-        }
-        free(buf);
-        close(fd);
         return 0;
-    } else {
-        printf("Status: FAIL ✗ - Pattern errors detected\n");
-        printf("First error at word %lu: expected 0x%016lx, got 0x%016lx\n",
-               first_error_idx, first_error_expected, first_error_got);
-        free(buf);
-        close(fd);
-        return 1;
     }
+    printf("Status: FAIL ✗ - Pattern errors detected\n");
+    return 1;
 }
@@ -0,0 +1,322 @@
+/**
+ * Transport Backend Test
+ * Opens XDMAWrapper on each backend that needs no card - a replayed
+ * file, a FIFO, a shared-memory feed and the in-process generator - and
+ * checks that records, registers and H2C writes arrive intact, that each
+ * stream ends cleanly, and that multi-channel streaming and reset work
+ * the same on them. Needs no hardware.
+ */
+
+#include "transport.h"
+#include "bbo_decode.h"
+#include "xdma_wrapper.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pcie;
+using bench::check;
+using bench::make_record;
+
+static std::vector<BBORecord> make_records(size_t count) {
+    std::vector<BBORecord> records(count);
+    for (size_t i = 0; i < count; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "TR%02zu", i % 16);
+        uint32_t bid = 1000000 + static_cast<uint32_t>(i);
+        uint32_t t1 = static_cast<uint32_t>(i * 10);
+        records[i] = make_record(name, bid, 100, bid + 100, 200, t1, t1 + 25);
+    }
+    return records;
+}
+
+static std::vector<uint8_t> encode(const std::vector<BBORecord>& records, WireFormat format) {
+    std::vector<uint8_t> wire(records.size() * wire_record_size(format));
+    encode_bbo_batch(records.data(), records.size(), wire.data(), format);
+    return wire;
+}
+
+// Read until end of stream; false on a gap or reordering in bid_price
+static bool read_all(XDMAWrapper& xdma, size_t& total, uint32_t first_bid) {
+    std::vector<BBORecord> records(64);
+    bool in_order = true;
+    total = 0;
+    for (;;) {
+        int n = xdma.read_records(records.data(), records.size(), 1000);
+        if (n < 0) break;
+        for (int i = 0; i < n; i++) {
+            in_order &= records[i].bid_price == first_bid + total;
+            total++;
+        }
+    }
+    return in_order;
+}
+
+static bool test_file(const std::string& dir) {
+    bool ok = true;
+    constexpr size_t COUNT = 1000;
+    std::string path = dir + "/replay.bin";
+    std::vector<uint8_t> wire = encode(make_records(COUNT), WireFormat::BBO36);
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f || fwrite(wire.data(), 1, wire.size(), f) != wire.size()) {
+        if (f) fclose(f);
+        return check(false, "replay file written");
+    }
+    fclose(f);
+
+    XDMADeviceConfig config;
+    config.transport = TransportKind::FILE;
+    config.c2h_path = path;
+    config.h2c_path = "";
+    config.user_path = "";
+    XDMAWrapper xdma;
+    ok &= check(xdma.open(config) == PCIeError::SUCCESS, "file transport opened");
+    ok &= check(xdma.is_link_up(), "emulated BAR reports link up");
+
+    size_t total = 0;
+    bool in_order = read_all(xdma, total, 1000000);
+    ok &= check(in_order && total == COUNT, "replayed every record in order");
+
+    BBOQuote q;
+    ok &= check(xdma.get_latest(SymbolKey("TR15"), q), "cache updated");
+    ok &= check(xdma.set_enabled(true) == PCIeError::SUCCESS && xdma.get_enabled(),
+                "emulated register write reads back");
+    ok &= check(xdma.write_data(wire.data(), 64) == PCIeError::SUCCESS, "H2C without a sink discarded");
+    ok &= check(xdma.set_symbol_filter(0, "AAPL") == PCIeError::SUCCESS, "filter slot 0 set");
+    ok &= check(xdma.reset() == PCIeError::SUCCESS, "reset on emulated BAR");
+    ok &= check(xdma.get_symbol_filter(0) == "AAPL", "filter restored after reset");
+    xdma.close();
+    unlink(path.c_str());
+    return ok;
+}
+
+static bool test_fifo(const std::string& dir) {
+    bool ok = true;
+    constexpr size_t COUNT = 500;
+    std::string c2h = dir + "/c2h";
+    std::string h2c = dir + "/h2c";
+    if (mkfifo(c2h.c_str(), 0600) < 0) {
+        return check(false, "FIFO created");
+    }
+
+    // Chunks larger than PIPE_BUF: records arrive split across reads
+    std::vector<uint8_t> wire = encode(make_records(COUNT), WireFormat::BBO48);
+    std::thread writer([&]() {
+        int fd = ::open(c2h.c_str(), O_WRONLY);
+        if (fd < 0) return;
+        for (size_t off = 0; off < wire.size(); off += 4800) {
+            size_t len = std::min<size_t>(4800, wire.size() - off);
+            if (write(fd, wire.data() + off, len) < 0) break;
+        }
+        ::close(fd);
+    });
+
+    XDMADeviceConfig config;
+    config.transport = TransportKind::FILE;
+    config.c2h_path = c2h;
+    config.h2c_path = h2c;
+    config.user_path = "";
+    config.wire_format = WireFormat::BBO48;
+    XDMAWrapper xdma;
+    ok &= check(xdma.open(config) == PCIeError::SUCCESS, "FIFO transport opened");
+
+    BBOColumns cols;
+    while (xdma.read_columns(cols, 64, 1000) >= 0) {}
+    writer.join();
+    bool in_order = cols.size() == COUNT;
+    for (size_t i = 0; in_order && i < cols.size(); i++) {
+        in_order = cols.bid_price[i] == 1000000 + i;
+    }
+    ok &= check(in_order, "FIFO stream decoded across split reads");
+
+    const char msg[] = "h2c-capture";
+    ok &= check(xdma.write_data(msg, sizeof(msg), 16) == PCIeError::SUCCESS, "H2C written to capture file");
+    xdma.close();
+
+    char got[sizeof(msg)] = {};
+    int fd = ::open(h2c.c_str(), O_RDONLY);
+    bool captured = fd >= 0 && pread(fd, got, sizeof(got), 16) == static_cast<ssize_t>(sizeof(got)) &&
+                    std::memcmp(got, msg, sizeof(msg)) == 0;
+    if (fd >= 0) ::close(fd);
+    ok &= check(captured, "H2C landed at its offset");
+    unlink(c2h.c_str());
+    unlink(h2c.c_str());
+    return ok;
+}
+
+static bool test_shm() {
+    bool ok = true;
+    constexpr size_t COUNT = 20000;
+    std::string name = "/pcie_transport_test_" + std::to_string(getpid());
+
+    // Ring smaller than the stream: wraps and back-pressures the producer
+    ShmFeed feed;
+    if (feed.create(name, 4096) != PCIeError::SUCCESS) {
+        return check(false, "shared-memory feed created");
+    }
+
+    XDMADeviceConfig config;
+    config.transport = TransportKind::SHM;
+    config.shm_name = name;
+    XDMAWrapper xdma;
+    ok &= check(xdma.open(config) == PCIeError::SUCCESS, "shm transport opened");
+
+    feed.registers()[ControlRegisters::VERSION_OFFSET / 4] = 0x22000001;
+    ok &= check(xdma.get_version() == 0x22000001, "feed register visible to the host");
+    xdma.set_symbol_filter(0, SymbolKey("SHMTEST"));
+    ok &= check(feed.registers()[ControlRegisters::SYMBOL_FILTER_0_OFFSET / 4] ==
+                    static_cast<uint32_t>(SymbolKey("SHMTEST").raw()),
+                "host register write visible to the feed");
+
+    const char msg[] = "to-card";
+    ok &= check(xdma.write_data(msg, sizeof(msg), 100) == PCIeError::SUCCESS &&
+                    std::memcmp(feed.h2c() + 100, msg, sizeof(msg)) == 0,
+                "H2C lands in the feed window");
+    ok &= check(xdma.write_data(msg, sizeof(msg), 1 << 20) == PCIeError::INVALID_PARAMETER,
+                "H2C past the window: INVALID_PARAMETER");
+
+    std::vector<uint8_t> wire = encode(make_records(COUNT), WireFormat::BBO36);
+    std::atomic<bool> fed{true};
+    std::thread producer([&]() {
+        size_t chunk = 50 * sizeof(BBOData);
+        for (size_t off = 0; off < wire.size(); off += chunk) {
+            size_t len = std::min(chunk, wire.size() - off);
+            if (!feed.write(wire.data() + off, len, 1000)) {
+                fed = false;
+                break;
+            }
+        }
+        feed.close_stream();
+    });
+
+    size_t total = 0;
+    bool in_order = read_all(xdma, total, 1000000);
+    producer.join();
+    ok &= check(fed && in_order && total == COUNT, "ring delivered every record in order");
+    ok &= check(feed.pending() == 0, "ring drained");
+    xdma.close();
+    feed.destroy();
+
+    XDMAWrapper gone;
+    ok &= check(gone.open(config) == PCIeError::OPEN_FAILED && !gone.is_open(),
+                "missing segment: OPEN_FAILED");
+    config.shm_name = "";
+    ok &= check(gone.open(config) == PCIeError::INVALID_PARAMETER, "no segment name: INVALID_PARAMETER");
+    return ok;
+}
+
+static bool test_generator() {
+    bool ok = true;
+
+    // Reads that split records reassemble to the same bytes
+    GeneratorConfig gen;
+    gen.records = 100;
+    gen.symbols = 3;
+    GeneratorSource whole(gen, WireFormat::BBO48);
+    GeneratorSource pieces(gen, WireFormat::BBO48);
+    std::vector<uint8_t> a(100 * sizeof(BBOPacket)), b(a.size());
+    ssize_t n = whole.read(a.data(), a.size(), 0);
+    size_t got = 0;
+    while (got < b.size()) {
+        ssize_t k = pieces.read(b.data() + got, std::min<size_t>(13, b.size() - got), 0);
+        if (k <= 0) break;
+        got += static_cast<size_t>(k);
+    }
+    ok &= check(n == static_cast<ssize_t>(a.size()) && got == b.size() && a == b,
+                "odd-sized reads reassemble records");
+    ok &= check(whole.read(a.data(), a.size(), 0) == -1, "record limit ends the stream");
+
+    XDMADeviceConfig config;
+    config.transport = TransportKind::GENERATOR;
+    config.wire_format = WireFormat::BBO48;
+    config.generator.records = 1000;
+    config.generator.symbols = 4;
+    XDMAWrapper xdma;
+    ok &= check(xdma.open(config) == PCIeError::SUCCESS, "generator transport opened");
+
+    std::vector<BBORecord> records(64);
+    size_t total = 0;
+    uint32_t last_t4 = 0;
+    bool clean = true;
+    for (;;) {
+        int k = xdma.read_records(records.data(), records.size(), 0);
+        if (k < 0) break;
+        for (int i = 0; i < k; i++) {
+            clean &= (records[i].flags & BBORecord::FLAG_BAD_PADDING) == 0;
+            clean &= total == 0 || records[i].ts_t4 > last_t4;
+            last_t4 = records[i].ts_t4;
+            total++;
+        }
+    }
+    ok &= check(clean && total == 1000, "1000 records, T4 increasing, good padding");
+    BBOQuote q;
+    ok &= check(xdma.get_latest(SymbolKey("GEN00003"), q) && !xdma.get_latest(SymbolKey("GEN00004"), q),
+                "every configured symbol, no more");
+    xdma.close();
+
+    // GEN%05u names would repeat past 100000 symbols
+    XDMADeviceConfig wide = config;
+    wide.generator.symbols = BBOGenerator::MAX_SYMBOLS + 1;
+    ok &= check(xdma.open(wide) == PCIeError::INVALID_PARAMETER, "oversized universe rejected");
+
+    // Two generated channels, merged in T4 order until both end
+    config.generator.records = 300;
+    config.c2h_channels = {"gen-a", "gen-b"};
+    ok &= check(xdma.open(config) == PCIeError::SUCCESS, "generator reopened");
+    std::atomic<uint64_t> delivered{0};
+    ok &= check(xdma.start_multichannel_streaming([&](uint32_t, const BBORecord&) {
+        delivered.fetch_add(1, std::memory_order_relaxed);
+    }) == PCIeError::SUCCESS, "multi-channel streaming started");
+    for (int i = 0; i < 200 && xdma.is_streaming(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ok &= check(!xdma.is_streaming(), "streaming ends with the channels");
+    xdma.stop_streaming();
+    MultiChannelStats stats = xdma.get_multichannel_stats();
+    ok &= check(delivered == 600 && stats.channels.size() == 2 && stats.channels[0].records == 300 &&
+                    stats.channels[1].records == 300,
+                "both channels delivered in full");
+    xdma.close();
+    return ok;
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("========================================\n");
+    printf("Transport Backend Test\n");
+    printf("========================================\n");
+
+    char tmpl[] = "/tmp/transport_test_XXXXXX";
+    if (!mkdtemp(tmpl)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    std::string dir = tmpl;
+
+    printf("File replay:\n");
+    bool ok = test_file(dir);
+
+    printf("\nFIFO:\n");
+    ok &= test_fifo(dir);
+
+    printf("\nShared memory:\n");
+    ok &= test_shm();
+
+    printf("\nGenerator:\n");
+    ok &= test_generator();
+
+    rmdir(dir.c_str());
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
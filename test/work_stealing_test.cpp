@@ -0,0 +1,192 @@
+/**
+ * Work-Stealing Executor Test
+ * Checks that every task runs exactly once, that idle workers steal when
+ * the expensive batches all land on one queue, flush/stop draining,
+ * utilisation reporting, and XDMAWrapper parallel streaming over a mock
+ * device including a reset while streaming.
+ * Needs no hardware.
+ */
+
+#include "work_stealing.h"
+#include "xdma_wrapper.h"
+#include "mock_device.h"
+#include "bench_util.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <signal.h>
+
+using namespace pcie;
+using bench::check;
+
+static uint64_t burn(uint64_t seed, int iters) {
+    uint64_t x = seed | 1;
+    for (int i = 0; i < iters; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    return x;
+}
+
+static void print_stats(const WorkStealingStats& stats) {
+    for (size_t i = 0; i < stats.workers.size(); i++) {
+        const WorkerStats& w = stats.workers[i];
+        printf("  worker %zu: %5lu tasks %4lu stolen, %4.1f%% busy\n",
+               i, w.tasks, w.steals, w.utilisation * 100.0);
+    }
+}
+
+static bool test_exactly_once() {
+    bool ok = true;
+    constexpr uint32_t TASKS = 20000;
+    constexpr uint32_t BATCH = 64;
+    auto seen = std::make_unique<std::atomic<uint8_t>[]>(TASKS * BATCH);
+
+    WorkStealingConfig config;
+    config.workers = 4;
+    config.batch_records = BATCH;
+    config.max_pending = 16;   // Small: exercise back-pressure
+    WorkStealingExecutor executor(config, [&](uint32_t, const BBORecord* records, size_t count) {
+        for (size_t i = 0; i < count; i++) seen[records[i].bid_size]++;
+    });
+
+    for (uint32_t t = 0; t < TASKS; t++) {
+        std::vector<BBORecord> batch = executor.acquire();
+        for (uint32_t i = 0; i < BATCH; i++) {
+            BBORecord rec{};
+            rec.bid_size = t * BATCH + i;
+            batch.push_back(rec);
+        }
+        executor.submit(std::move(batch));
+        if (t == TASKS / 2) {
+            executor.flush();
+            uint64_t ran = 0;
+            for (const auto& w : executor.stats().workers) ran += w.tasks;
+            ok &= check(ran == t + 1, "flush waits for every task");
+        }
+    }
+    executor.submit(executor.acquire());   // Empty batch: ignored
+    executor.stop();
+
+    bool once = true;
+    for (uint32_t i = 0; i < TASKS * BATCH; i++) once &= seen[i] == 1;
+    WorkStealingStats stats = executor.stats();
+    uint64_t tasks = 0, records = 0;
+    for (const auto& w : stats.workers) {
+        tasks += w.tasks;
+        records += w.records;
+    }
+    ok &= check(once, "every record handled exactly once");
+    ok &= check(tasks == TASKS && records == TASKS * BATCH && stats.submitted == TASKS,
+                "stats count every task");
+    return ok;
+}
+
+static bool test_uneven() {
+    bool ok = true;
+    constexpr uint32_t WORKERS = 4;
+    constexpr uint32_t TASKS = 400;
+
+    // Tasks are dealt round-robin: every one that lands on worker 0's queue
+    // is ~50x the cost of the rest
+    WorkStealingConfig config;
+    config.workers = WORKERS;
+    config.batch_records = 1;
+    config.max_pending = TASKS;
+    std::atomic<uint64_t> sink{0};
+    WorkStealingExecutor executor(config, [&](uint32_t, const BBORecord* records, size_t) {
+        int iters = records[0].ask_size ? 200000 : 4000;
+        sink.fetch_add(burn(records[0].bid_size, iters), std::memory_order_relaxed);
+    });
+
+    for (uint32_t t = 0; t < TASKS; t++) {
+        std::vector<BBORecord> batch = executor.acquire();
+        BBORecord rec{};
+        rec.bid_size = t;
+        rec.ask_size = (t % WORKERS == 0) ? 1 : 0;
+        batch.push_back(rec);
+        executor.submit(std::move(batch));
+    }
+    executor.flush();
+    WorkStealingStats stats = executor.stats();
+    executor.stop();
+    print_stats(stats);
+
+    uint64_t steals = 0, tasks = 0;
+    bool sane = true;
+    for (const auto& w : stats.workers) {
+        steals += w.steals;
+        tasks += w.tasks;
+        sane &= w.utilisation >= 0.0 && w.utilisation <= 1.0 && w.busy_ns <= stats.elapsed_ns;
+    }
+    ok &= check(steals > 0, "idle workers stole from the busy one");
+    ok &= check(stats.workers[0].tasks < TASKS / WORKERS, "busy worker ran fewer than it was dealt");
+    ok &= check(tasks == TASKS && sane, "utilisation within [0, 1]");
+    return ok;
+}
+
+static bool test_wrapper() {
+    bool ok = true;
+    MockDevice mock;
+    XDMAWrapper xdma;
+    if (!mock.create() || xdma.open(mock.config()) != PCIeError::SUCCESS) {
+        return check(false, "mock device opened");
+    }
+
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> max_batch{0};
+    WorkStealingConfig config;
+    config.workers = 3;
+    config.batch_records = 32;
+    ok &= check(xdma.start_parallel_streaming([&](uint32_t, const BBORecord*, size_t count) {
+        total.fetch_add(count, std::memory_order_relaxed);
+        uint64_t seen = max_batch.load(std::memory_order_relaxed);
+        while (count > seen && !max_batch.compare_exchange_weak(seen, count)) {}
+    }, config) == PCIeError::SUCCESS, "parallel streaming started");
+    ok &= check(xdma.start_parallel_streaming(nullptr, config) == PCIeError::BUSY, "second start: BUSY");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    ResetReport report = xdma.reset_async(200).get();
+    ok &= check(report.error == PCIeError::SUCCESS && report.was_streaming, "reset while parallel streaming");
+    uint64_t after_reset = total;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ok &= check(total > after_reset, "delivery resumes after reset");
+
+    xdma.stop_streaming();
+    WorkStealingStats stats = xdma.get_parallel_stats();
+    print_stats(stats);
+    uint64_t records = 0;
+    for (const auto& w : stats.workers) records += w.records;
+    ok &= check(records == total && total > 0, "stop ran every queued task");
+    ok &= check(max_batch <= 32, "batches bounded by batch_records");
+
+    BBOQuote q;
+    ok &= check(xdma.get_latest(SymbolKey("MOCKAAPL"), q), "cache updated");
+    xdma.close();
+    return ok;
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("========================================\n");
+    printf("Work-Stealing Executor Test\n");
+    printf("========================================\n");
+
+    printf("Exactly once:\n");
+    bool ok = test_exactly_once();
+
+    printf("\nUneven task cost:\n");
+    ok &= test_uneven();
+
+    printf("\nWrapper:\n");
+    ok &= test_wrapper();
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+/**
+ * XDMA Discovery Test
+ * Builds a fake /sys/bus/pci/devices tree and /dev directory in a temp
+ * dir and checks what XDMADeviceDiscovery::enumerate_devices() reports:
+ * IDs, negotiated vs advertised link, NUMA node, BAR sizes, node
+ * mapping, which functions count as XDMA devices, and the open config
+ * left for absent nodes. Needs no hardware.
+ */
+
+#include "xdma_wrapper.h"
+#include "bench_util.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pcie;
+using bench::check;
+
+static void write_file(const std::string& path, const std::string& content) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return;
+    fputs(content.c_str(), f);
+    fclose(f);
+}
+
+/**
+ * One PCI function in the fake tree
+ */
+struct FakeFunction {
+    std::string slot;
+    std::string vendor = "0x10ee";
+    std::string device = "0x7024";
+    std::string cur_speed = "5.0 GT/s PCIe";
+    std::string cur_width = "4";
+    std::string max_speed = "5.0 GT/s PCIe";
+    std::string max_width = "4";
+    std::string numa = "-1";
+    std::string cpus = "0-7";
+    std::string driver;                 // Empty = unbound
+    std::vector<std::string> nodes;     // Class devices under <slot>/xdma
+};
+
+static void add_function(const std::string& root, const FakeFunction& fn) {
+    std::string dir = root + "/sys/bus/pci/devices/" + fn.slot;
+    mkdir(dir.c_str(), 0755);
+    write_file(dir + "/vendor", fn.vendor + "\n");
+    write_file(dir + "/device", fn.device + "\n");
+    write_file(dir + "/subsystem_vendor", "0x10ee\n");
+    write_file(dir + "/subsystem_device", "0x0007\n");
+    write_file(dir + "/current_link_speed", fn.cur_speed + "\n");
+    write_file(dir + "/current_link_width", fn.cur_width + "\n");
+    write_file(dir + "/max_link_speed", fn.max_speed + "\n");
+    write_file(dir + "/max_link_width", fn.max_width + "\n");
+    write_file(dir + "/numa_node", fn.numa + "\n");
+    write_file(dir + "/local_cpulist", fn.cpus + "\n");
+
+    // BAR0 1 MB, BAR1 64 KB, BAR2 unused, BAR3..5 absent, then ROM
+    write_file(dir + "/resource",
+               "0x00000000f7000000 0x00000000f70fffff 0x0000000000040200\n"
+               "0x00000000f7100000 0x00000000f710ffff 0x0000000000040200\n"
+               "0x0000000000000000 0x0000000000000000 0x0000000000000000\n");
+
+    if (!fn.driver.empty()) {
+        std::string drivers = root + "/sys/bus/pci/drivers/" + fn.driver;
+        mkdir(drivers.c_str(), 0755);
+        symlink(("../../../bus/pci/drivers/" + fn.driver).c_str(), (dir + "/driver").c_str());
+    }
+    if (!fn.nodes.empty()) {
+        mkdir((dir + "/xdma").c_str(), 0755);
+        for (const std::string& node : fn.nodes) {
+            mkdir((dir + "/xdma/" + node).c_str(), 0755);
+            write_file(root + "/dev/" + node, "");
+        }
+    }
+}
+
+static const XDMADeviceDiscovery::DeviceInfo* find_slot(
+        const std::vector<XDMADeviceDiscovery::DeviceInfo>& devices, const std::string& slot) {
+    for (const auto& d : devices) {
+        if (d.pci_slot == slot) return &d;
+    }
+    return nullptr;
+}
+
+int main() {
+    printf("========================================\n");
+    printf("XDMA Discovery Test\n");
+    printf("========================================\n");
+
+    char root_template[] = "/tmp/xdma_discovery_XXXXXX";
+    if (!mkdtemp(root_template)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    std::string root = root_template;
+    for (const char* dir : {"/sys", "/sys/bus", "/sys/bus/pci", "/sys/bus/pci/devices",
+                            "/sys/bus/pci/drivers", "/dev"}) {
+        mkdir((root + dir).c_str(), 0755);
+    }
+
+    // Card 0: healthy x4 Gen2 on node 1, two channel pairs
+    FakeFunction card0;
+    card0.slot = "0000:01:00.0";
+    card0.numa = "1";
+    card0.cpus = "8-15,24-31";
+    card0.driver = "xdma";
+    card0.nodes = {"xdma0_user", "xdma0_control", "xdma0_c2h_0", "xdma0_c2h_1",
+                   "xdma0_h2c_0", "xdma0_h2c_1", "xdma0_events_0", "xdma0_events_10",
+                   "xdma0_events_2"};
+    add_function(root, card0);
+
+    // Card 1: trained x1 Gen1 in an x8 Gen3-capable card
+    FakeFunction card1;
+    card1.slot = "0000:41:00.0";
+    card1.device = "0x9038";
+    card1.cur_speed = "2.5 GT/s PCIe";
+    card1.cur_width = "1";
+    card1.max_speed = "8.0 GT/s PCIe";
+    card1.max_width = "8";
+    card1.numa = "0";
+    card1.driver = "xdma";
+    card1.nodes = {"xdma1_user", "xdma1_c2h_0", "xdma1_h2c_0"};
+    add_function(root, card1);
+
+    // xdma bound, link down, no nodes created
+    FakeFunction down;
+    down.slot = "0000:81:00.0";
+    down.cur_speed = "Unknown";
+    down.cur_width = "0";
+    down.driver = "xdma";
+    add_function(root, down);
+
+    // Xilinx function with no driver bound (some other FPGA design): ignored
+    FakeFunction unbound;
+    unbound.slot = "0000:82:00.0";
+    unbound.device = "0x9031";
+    add_function(root, unbound);
+
+    // Someone else's NIC: ignored
+    FakeFunction nic;
+    nic.slot = "0000:02:00.0";
+    nic.vendor = "0x8086";
+    nic.device = "0x1572";
+    nic.driver = "i40e";
+    add_function(root, nic);
+
+    // Node with no sysfs parent (bind-mounted /dev in a container)
+    write_file(root + "/dev/xdma7_c2h_0", "");
+    write_file(root + "/dev/xdma7_user", "");
+    write_file(root + "/dev/null", "");
+
+    auto devices = XDMADeviceDiscovery::enumerate_devices(root + "/sys/bus/pci/devices",
+                                                          root + "/dev");
+    bool ok = check(devices.size() == 4, "4 devices found (NIC, unbound ignored)");
+
+    printf("\nHealthy card:\n");
+    const auto* d0 = find_slot(devices, card0.slot);
+    ok &= check(d0 != nullptr, "found by slot");
+    if (d0) {
+        ok &= check(d0->vendor_id == 0x10EE && d0->device_id == 0x7024 &&
+                    d0->subsystem_vendor_id == 0x10EE && d0->subsystem_device_id == 0x0007,
+                    "IDs");
+        ok &= check(d0->link_up && d0->link_width == 4 && d0->link_speed == 2 &&
+                    d0->max_link_width == 4 && d0->max_link_speed == 2 && !d0->link_degraded(),
+                    "link x4 Gen2, not degraded");
+        ok &= check(d0->numa_node == 1 && d0->local_cpus == "8-15,24-31", "NUMA node and CPU list");
+        ok &= check(d0->bar_size[0] == 1 << 20 && d0->bar_size[1] == 64 << 10 &&
+                    d0->bar_size[2] == 0 && d0->bar_size[5] == 0,
+                    "BAR sizes");
+        ok &= check(d0->driver == "xdma" && d0->device_path == root + "/dev/xdma0", "driver and device");
+        ok &= check(d0->user_path == root + "/dev/xdma0_user" &&
+                    d0->control_path == root + "/dev/xdma0_control" &&
+                    d0->c2h_paths.size() == 2 && d0->h2c_paths.size() == 2,
+                    "node mapping");
+        ok &= check(d0->events_paths.size() == 3 &&
+                    d0->events_paths[1] == root + "/dev/xdma0_events_2" &&
+                    d0->events_paths[2] == root + "/dev/xdma0_events_10",
+                    "channels in numeric order");
+
+        XDMADeviceConfig config = d0->config(1);
+        ok &= check(config.c2h_path == root + "/dev/xdma0_c2h_1" &&
+                    config.h2c_path == root + "/dev/xdma0_h2c_1" &&
+                    config.user_path == d0->user_path,
+                    "config(1) opens channel 1");
+    }
+
+    printf("\nDegraded card:\n");
+    const auto* d1 = find_slot(devices, card1.slot);
+    ok &= check(d1 && d1->link_up && d1->link_width == 1 && d1->link_speed == 1 &&
+                d1->max_link_width == 8 && d1->max_link_speed == 3,
+                "trained x1 Gen1 of x8 Gen3");
+    ok &= check(d1 && d1->link_degraded(), "reported as degraded");
+    ok &= check(d1 && d1->numa_node == 0 && d1->device_path == root + "/dev/xdma1", "node 0, xdma1");
+
+    printf("\nOther entries:\n");
+    ok &= check(find_slot(devices, unbound.slot) == nullptr,
+                "unbound Xilinx function not listed");
+
+    const auto* d2 = find_slot(devices, down.slot);
+    ok &= check(d2 && !d2->link_up && d2->driver == "xdma" && d2->device_path.empty() &&
+                !d2->link_degraded(),
+                "bound function, link down, no nodes");
+    if (d2) {
+        XDMADeviceConfig config = d2->config();
+        ok &= check(config.c2h_path.empty() && config.h2c_path.empty() &&
+                    config.user_path.empty() && config.events_path.empty(),
+                    "config() without nodes: no xdma0 defaults");
+        config.require_driver = false;
+        XDMAWrapper xdma;
+        ok &= check(xdma.open(config) == PCIeError::OPEN_FAILED, "open() of it fails");
+    }
+
+    const auto* d3 = find_slot(devices, "");
+    ok &= check(d3 && d3->device_path == root + "/dev/xdma7" && d3->c2h_paths.size() == 1 &&
+                d3->numa_node == -1 && d3->vendor_id == 0,
+                "/dev-only device listed without PCI info");
+    ok &= check(d3 && d3->config().h2c_path.empty() && d3->config(1).c2h_path.empty(),
+                "absent channel left empty");
+
+    ok &= check(XDMADeviceDiscovery::link_speed_gen("16.0 GT/s PCIe") == 4 &&
+                XDMADeviceDiscovery::link_speed_gen("5 GT/s") == 2 &&
+                XDMADeviceDiscovery::link_speed_gen("Unknown") == 0,
+                "link speed to generation");
+
+    ok &= check(XDMADeviceDiscovery::enumerate_devices(root + "/missing", root + "/missing").empty(),
+                "missing tree finds nothing");
+
+    std::string cleanup = "rm -rf '" + root + "'";
+    if (system(cleanup.c_str()) != 0) {
+        printf("  (could not remove %s)\n", root.c_str());
+    }
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}